@@ -0,0 +1,116 @@
+//
+// Created by 陶子杨 on 25-12-9.
+//
+
+#include "FuzzWatchdog.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    // 每块内存前面留出一个对齐的头部记录大小，释放时才能知道要减去多少
+    constexpr size_t kHeader = alignof(std::max_align_t);
+
+    std::atomic<size_t> live_bytes{0};
+    std::atomic<size_t> peak_bytes{0};
+
+    void* allocate(size_t size) {
+        auto* block = static_cast<unsigned char*>(std::malloc(size + kHeader));
+        if (block == nullptr) {
+            throw std::bad_alloc();
+        }
+        *reinterpret_cast<size_t*>(block) = size;
+        size_t live = live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+        if (live > CC::FuzzWatchdog::kMemoryLimit) {
+            std::fprintf(stderr, "==FuzzWatchdog== 存活内存 %zu 字节，超过上限 %zu\n",
+                         live, CC::FuzzWatchdog::kMemoryLimit);
+            std::abort();
+        }
+        size_t peak = peak_bytes.load(std::memory_order_relaxed);
+        while (live > peak && !peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        }
+        return block + kHeader;
+    }
+
+    void release(void* pointer) {
+        if (pointer == nullptr) {
+            return;
+        }
+        auto* block = static_cast<unsigned char*>(pointer) - kHeader;
+        live_bytes.fetch_sub(*reinterpret_cast<size_t*>(block), std::memory_order_relaxed);
+        std::free(block);
+    }
+}
+
+// 替换全局的 operator new/delete 来统计内存峰值。超过 16 字节对齐的分配不经过这里，前端也没有这样的分配
+void* operator new(size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](size_t size) {
+    return allocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    release(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    release(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    release(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    release(pointer);
+}
+
+namespace CC {
+
+    FuzzWatchdog::FuzzWatchdog(const char* target, void (*run)(std::string_view source))
+        : target(target), run(run) {
+    }
+
+    ResourceUsage FuzzWatchdog::measure(std::string_view source) const {
+        size_t baseline = live_bytes.load(std::memory_order_relaxed);
+        peak_bytes.store(baseline, std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        run(source);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return {elapsed.count(), peak_bytes.load(std::memory_order_relaxed) - baseline};
+    }
+
+    void FuzzWatchdog::check(const uint8_t* data, size_t size) const {
+        std::string_view source(reinterpret_cast<const char*>(data), size);
+        ResourceUsage single = measure(source);
+        if (size == 0) {
+            return;
+        }
+
+        std::string repeated;
+        repeated.reserve(size * kRepeat);
+        for (size_t i = 0; i < kRepeat; ++i) {
+            repeated.append(source);
+        }
+        ResourceUsage scaled = measure(repeated);
+
+        double time_limit = std::max(single.seconds, kTimeFloor / kRepeat) * kRepeat * kGrowthSlack;
+        size_t memory_limit = std::max(single.peak_bytes, kMemoryFloor / kRepeat) * kRepeat *
+                              static_cast<size_t>(kGrowthSlack);
+        if (scaled.seconds > time_limit || scaled.peak_bytes > memory_limit) {
+            std::fprintf(stderr,
+                         "==FuzzWatchdog== %s: 开销随输入超线性增长\n"
+                         "  %zu 字节: %.3f 秒, %zu 字节内存\n"
+                         "  %zu 字节: %.3f 秒, %zu 字节内存\n",
+                         target, size, single.seconds, single.peak_bytes,
+                         repeated.size(), scaled.seconds, scaled.peak_bytes);
+            std::abort();
+        }
+    }
+}
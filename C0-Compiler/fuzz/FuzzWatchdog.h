@@ -0,0 +1,54 @@
+//
+// Created by 陶子杨 on 25-12-9.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace CC {
+
+    /**
+     * @brief 一次运行的耗时和内存峰值
+     */
+    struct ResourceUsage {
+        double seconds = 0;
+        size_t peak_bytes = 0;  ///< 运行期间通过 operator new 分配的存活字节数峰值
+    };
+
+    /**
+     * @brief 检查前端的开销是否随输入规模线性增长
+     *
+     * 先运行原始输入，再把输入重复 kRepeat 次运行一遍。线性的实现两次开销之比约为 kRepeat，
+     * 超过 kRepeat * kGrowthSlack（并且超过噪声下限）就认为增长是超线性的，打印两次的开销后 abort，
+     * 让 libFuzzer 把输入保存下来。单次运行的存活内存超过 kMemoryLimit 时在分配处直接 abort
+     */
+    class FuzzWatchdog {
+    public:
+        static constexpr size_t kRepeat = 8;
+        static constexpr double kGrowthSlack = 4;
+        static constexpr double kTimeFloor = 0.05;          ///< 秒，低于它的耗时只是噪声
+        static constexpr size_t kMemoryFloor = 1 << 20;     ///< 字节，低于它的内存峰值不作比较
+        static constexpr size_t kMemoryLimit = 1ull << 30;  ///< 字节，单次运行允许的存活内存上限
+
+        /**
+         * @param target 目标名，出现在报错中
+         * @param run 对一段源码运行一次被测代码
+         */
+        FuzzWatchdog(const char* target, void (*run)(std::string_view source));
+
+        /**
+         * @brief 运行一个模糊测试输入并检查开销的增长
+         */
+        void check(const uint8_t* data, size_t size) const;
+
+        [[nodiscard]] ResourceUsage measure(std::string_view source) const;
+
+    private:
+        const char* target;
+        void (*run)(std::string_view source);
+    };
+}
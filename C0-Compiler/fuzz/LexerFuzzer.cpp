@@ -0,0 +1,56 @@
+//
+// Created by 陶子杨 on 25-12-9.
+//
+
+#include "FuzzWatchdog.h"
+#include "Lexer/C0Lexer.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+    using namespace CC;
+
+    [[noreturn]] void fail(const char* level, const char* message, size_t offset) {
+        std::fprintf(stderr, "==LexerFuzzer== %s: %s（偏移 %zu）\n", level, message, offset);
+        std::abort();
+    }
+
+    // 把整段源码切成 token，检查每个 token 都落在源码内、偏移不回退，并且总数有界。
+    // 除了长度为 0 的 ANNOT_END，每个 token 至少消耗一个字节，所以 token 数不会超过源码长度的两倍
+    template <typename Lang>
+    void lex(std::string_view source, const char* level) {
+        BasicC0Lexer<Lang> lexer("fuzz", source);
+        size_t limit = source.size() * 2 + 2;
+        size_t previous = 0;
+        for (size_t count = 0;; ++count) {
+            if (count > limit) {
+                fail(level, "token 数超过源码长度的两倍，词法分析器没有前进", previous);
+            }
+            Token token = lexer.nextToken();
+            size_t end = static_cast<size_t>(token.offset) + token.length;
+            if (token.offset < previous || end > source.size()) {
+                fail(level, "token 越界或偏移回退", token.offset);
+            }
+            previous = token.offset;
+            if (token.type == TokenType::END_OF_FILE) {
+                return;
+            }
+        }
+    }
+
+    void lexAllLevels(std::string_view source) {
+        lex<LangL1>(source, "L1");
+        lex<LangL2>(source, "L2");
+        lex<LangL3>(source, "L3");
+        lex<LangL4>(source, "L4");
+        lex<LangC0>(source, "C0");
+    }
+
+    const FuzzWatchdog watchdog("C0Lexer", lexAllLevels);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    watchdog.check(data, size);
+    return 0;
+}
@@ -0,0 +1,50 @@
+//
+// Created by 陶子杨 on 25-12-9.
+//
+
+#include "FuzzWatchdog.h"
+#include "Compiler/CompilerInstance.h"
+
+namespace {
+    using namespace CC;
+
+    class DiscardConsumer : public FunctionConsumer {
+    public:
+        void consume(const std::shared_ptr<FunctionDecl>&, const GlobalDeclarations&) override {
+        }
+    };
+
+    // 由输入的第一个字节选出，watchdog 重复输入时保持不变
+    CompilerOptions options;
+    bool streaming = false;
+
+    void parse(std::string_view source) {
+        CompilerInstance compiler(options);
+        SourceBuffer buffer{"fuzz", source, {}, {}};
+        if (streaming) {
+            DiscardConsumer consumer;
+            (void) compiler.compileStreaming(buffer, consumer);
+        } else {
+            (void) compiler.compile(buffer);
+        }
+    }
+
+    const FuzzWatchdog watchdog("C0Parser", parse);
+}
+
+/**
+ * 第一个字节选择编译方式：低 3 位是语言层级（对 5 取模），第 4 位开启动态检查，第 5 位使用流式编译，
+ * 最高 2 位不为 0 时把函数降低成 IR，再按它减 1 选择优化级别。其余字节是源码
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    options.language_level = static_cast<LanguageLevel>((data[0] & 7) % 5);
+    options.dynamic_checks = (data[0] & 8) != 0;
+    streaming = (data[0] & 16) != 0;
+    options.lower_to_ir = (data[0] >> 6) != 0;
+    options.optimization_level = options.lower_to_ir ? (data[0] >> 6) - 1 : 0;
+    watchdog.check(data + 1, size - 1);
+    return 0;
+}
@@ -0,0 +1,74 @@
+//
+// Created by 陶子杨 on 25-12-9.
+//
+
+// 没有 libFuzzer 的编译器（例如 GCC）用这个入口回放语料：逐个运行命令行给出的文件或目录中的文件，
+// 单个输入超过 kTimeoutSeconds 秒就当作死循环报错退出
+
+#include <algorithm>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace {
+    constexpr unsigned kTimeoutSeconds = 10;
+
+    // 信号处理函数里只能用 async-signal-safe 的函数，文件名预先存在这里
+    char current_input[4096];
+
+    void onTimeout(int) {
+        const char prefix[] = "==Replay== 超时: ";
+        (void) write(STDERR_FILENO, prefix, sizeof(prefix) - 1);
+        (void) write(STDERR_FILENO, current_input, strnlen(current_input, sizeof(current_input)));
+        (void) write(STDERR_FILENO, "\n", 1);
+        _exit(1);
+    }
+
+    bool replay(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            std::fprintf(stderr, "==Replay== 无法打开 %s\n", path.c_str());
+            return false;
+        }
+        std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        std::snprintf(current_input, sizeof(current_input), "%s", path.c_str());
+
+        alarm(kTimeoutSeconds);
+        LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+        alarm(0);
+        std::printf("%s: ok\n", path.c_str());
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::signal(SIGALRM, onTimeout);
+    bool ok = true;
+    for (int i = 1; i < argc; ++i) {
+        std::filesystem::path path(argv[i]);
+        if (std::filesystem::is_directory(path)) {
+            std::vector<std::filesystem::path> inputs;
+            for (const auto& entry : std::filesystem::directory_iterator(path)) {
+                if (entry.is_regular_file()) {
+                    inputs.push_back(entry.path());
+                }
+            }
+            std::sort(inputs.begin(), inputs.end());
+            for (const auto& input : inputs) {
+                ok &= replay(input);
+            }
+        } else {
+            ok &= replay(path);
+        }
+    }
+    return ok ? 0 : 1;
+}
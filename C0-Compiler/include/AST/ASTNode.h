@@ -2,6 +2,8 @@
 
 #include "Lexer/Lexer.h"
 #include <memory>
+#include <memory_resource>
+#include <utility>
 
 namespace CC {
 
@@ -28,4 +30,13 @@ namespace CC {
     // 定义智能指针类型
     template<typename T>
     using ASTNodePtr = std::shared_ptr<T>;
+
+    /**
+     * @brief 从指定的内存资源上分配AST节点（节点和控制块一起分配）
+     */
+    template <typename T, typename... Args>
+    ASTNodePtr<T> makeNode(std::pmr::memory_resource* resource, Args&&... args) {
+        return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(resource),
+                                       std::forward<Args>(args)...);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,41 @@
+//
+// Created by 陶子杨 on 25-12-8.
+//
+
+#pragma once
+
+#include "ExprisionNode.h"
+#include <cstdint>
+#include <memory>
+
+namespace CC {
+
+    // 规约注解的种类
+    enum class ContractKind : uint8_t {
+        REQUIRES,        // //@requires，函数入口
+        ENSURES,         // //@ensures，函数返回前，可以使用 \result
+        LOOP_INVARIANT,  // //@loop_invariant，每次判断循环条件之前
+        ASSERT,          // //@assert，注解所在的位置
+    };
+
+    /**
+     * @brief 动态检查模式（-d）下一条规约最终的检查方式
+     */
+    enum class ContractCheck : uint8_t {
+        UNCHECKED,       // 没有开启动态检查
+        ELIDED,          // 可证明成立或已经检查过，不生成检查
+        EXPANDED,        // 已经展开成函数体中的 AssertStmt
+        HOISTED,         // 循环不变式只在进入循环之前检查一次
+        EACH_ITERATION,  // 循环不变式在每次判断循环条件之前检查，由后端在循环头生成
+    };
+
+    /**
+     * @brief 附着在函数声明或循环语句上的一条规约
+     */
+    struct Contract {
+        ContractKind kind;
+        std::shared_ptr<Expression> condition;
+        Location location;                        ///< 注解关键字的位置，用于运行时报错
+        ContractCheck check = ContractCheck::UNCHECKED;
+    };
+}
@@ -7,6 +7,8 @@
 #include "ASTNode.h"
 #include "ExprisionNode.h"
 #include "StatementNode.h"
+#include "Contract.h"
+#include "Library/LibraryInterface.h"
 #include <string>
 #include <utility>
 #include <vector>
@@ -21,12 +23,15 @@ namespace CC {
         FUNCTION_DECL,
         VARIABLE_DECL,
         PARAMETER_DECL,
-        STRUCT_DECL
+        STRUCT_DECL,
+        TYPEDEF_DECL,
+        USE_DECL
     };
 
     class Declaration : public INFRA::EnableShared<Declaration>{
     public:
         DeclarationType type;
+        uint32_t offset = 0;  ///< 在源码中的起始字节偏移，报错时才换算成行列号
     };
 
     // 声明基类
@@ -69,6 +74,7 @@ namespace CC {
         std::string returnType;
         std::vector<std::shared_ptr<VariableDecl>> parameters;
         std::shared_ptr<CompoundStmt> body;
+        std::vector<Contract> contracts;  ///< //@requires 和 //@ensures，按出现顺序
 
         FunctionDecl(std::string  name,
                     std::string  returnType,
@@ -90,14 +96,51 @@ namespace CC {
     public:
         std::string name;
         std::vector<std::shared_ptr<VariableDecl>> members;
-        StructDecl(std::string  name, std::vector<std::shared_ptr<VariableDecl>> members)
+        bool isDefinition;  ///< false 表示只有前置声明 struct name;
+        StructDecl(std::string  name, std::vector<std::shared_ptr<VariableDecl>> members,
+                   bool isDefinition = true)
             : DeclarationNode<StructDecl>(DeclarationType::STRUCT_DECL),
               name(std::move(name)),
-              members(std::move(members)) {}
+              members(std::move(members)),
+              isDefinition(isDefinition) {}
 
         static bool classof(const Declaration* decl) {
             return decl->type == DeclarationType::STRUCT_DECL;
         }
     };
 
-}
\ No newline at end of file
+    // 类型别名 typedef type name;
+    class TypedefDecl : public DeclarationNode<TypedefDecl> {
+    public:
+        std::string name;
+        std::string type;
+
+        TypedefDecl(std::string name, std::string type)
+            : DeclarationNode<TypedefDecl>(DeclarationType::TYPEDEF_DECL),
+              name(std::move(name)),
+              type(std::move(type)) {}
+
+        static bool classof(const Declaration* decl) {
+            return decl->type == DeclarationType::TYPEDEF_DECL;
+        }
+    };
+
+    // 编译指令 #use <库名> 或 #use "文件名"
+    class UseDecl : public DeclarationNode<UseDecl> {
+    public:
+        std::string name;
+        bool isLibrary;
+        std::shared_ptr<const LibraryInterface> library;  ///< 找到的库接口，文件引用时为空
+
+        UseDecl(std::string name, bool isLibrary, std::shared_ptr<const LibraryInterface> library)
+            : DeclarationNode<UseDecl>(DeclarationType::USE_DECL),
+              name(std::move(name)),
+              isLibrary(isLibrary),
+              library(std::move(library)) {}
+
+        static bool classof(const Declaration* decl) {
+            return decl->type == DeclarationType::USE_DECL;
+        }
+    };
+
+}
@@ -23,11 +23,39 @@ namespace CC {
         CHAR_LITERAL_EXPR,
         BOOL_LITERAL_EXPR,
         FLOAT_LITERAL_EXPR,
+        MEMBER_EXPR,
+        CONDITIONAL_EXPR,
+        ALLOC_EXPR,
+        NULL_LITERAL_EXPR,
+        RESULT_EXPR,
+        LENGTH_EXPR,
     };
 
     class Expression : public INFRA::EnableShared<Expression> {
     public:
         ExpressionType type;
+        uint32_t offset = 0;  ///< 在源码中的起始字节偏移，报错时才换算成行列号
+
+    protected:
+        /**
+         * @brief 释放子表达式。深层的表达式树改为用显式栈逐个析构，
+         * 避免 shared_ptr 链式析构时递归爆栈
+         */
+        template <typename... Children>
+        static void releaseChildren(Children&... children) {
+            std::vector<std::shared_ptr<Expression>> pending;
+            (collectChild(pending, children), ...);
+            releaseTree(pending);
+        }
+
+    private:
+        static void collectChild(std::vector<std::shared_ptr<Expression>>& pending,
+                                 std::shared_ptr<Expression>& child);
+
+        static void collectChild(std::vector<std::shared_ptr<Expression>>& pending,
+                                 std::vector<std::shared_ptr<Expression>>& children);
+
+        static void releaseTree(std::vector<std::shared_ptr<Expression>>& pending);
     };
 
     // 表达式基类
@@ -58,6 +86,10 @@ namespace CC {
               right(std::move(right)),
               op(op) {}
 
+        ~BinaryExpr() {
+            releaseChildren(left, right);
+        }
+
         static bool classof(const Expression* node) {
             return node->type == ExpressionType::BINARY_EXPR;
         }
@@ -74,6 +106,10 @@ namespace CC {
               operand(std::move(operand)),
               op(op){}
 
+        ~UnaryExpr() {
+            releaseChildren(operand);
+        }
+
         static bool classof(const Expression* node) {
             return node->type == ExpressionType::UNARY_EXPR;
         }
@@ -94,6 +130,10 @@ namespace CC {
               right(std::move(right)),
               op(op) {}
 
+        ~AssignmentExpr() {
+            releaseChildren(left, right);
+        }
+
         static bool classof(const Expression* node) {
             return node->type == ExpressionType::ASSIGNMENT_EXPR;
         }
@@ -111,6 +151,10 @@ namespace CC {
               base(std::move(base)),
               index(std::move(index)) {}
 
+        ~ArraySubscriptExpr() {
+            releaseChildren(base, index);
+        }
+
         static bool classof(const Expression* node) {
             return node->type == ExpressionType::ARRAY_SUBSCRIPT_EXPR;
         }
@@ -128,11 +172,121 @@ namespace CC {
               callee(std::move(callee)),
               arguments(std::move(arguments)) {}
 
+        ~CallExpr() {
+            releaseChildren(callee, arguments);
+        }
+
         static bool classof(const Expression* node) {
             return node->type == ExpressionType::CALL_EXPR;
         }
     };
 
+    // 成员访问表达式 base.member 或 base->member
+    class MemberExpr : public ExpressionNode<MemberExpr> {
+    public:
+        std::shared_ptr<Expression> base;
+        std::string member;
+        bool arrow;
+
+        MemberExpr(std::shared_ptr<Expression> base, std::string member, bool arrow)
+            : ExpressionNode<MemberExpr>(ExpressionType::MEMBER_EXPR),
+              base(std::move(base)),
+              member(std::move(member)),
+              arrow(arrow) {}
+
+        ~MemberExpr() {
+            releaseChildren(base);
+        }
+
+        static bool classof(const Expression* node) {
+            return node->type == ExpressionType::MEMBER_EXPR;
+        }
+    };
+
+    // 条件表达式 cond ? then : else
+    class ConditionalExpr : public ExpressionNode<ConditionalExpr> {
+    public:
+        std::shared_ptr<Expression> condition;
+        std::shared_ptr<Expression> thenExpr;
+        std::shared_ptr<Expression> elseExpr;
+
+        ConditionalExpr(std::shared_ptr<Expression> condition,
+                        std::shared_ptr<Expression> thenExpr,
+                        std::shared_ptr<Expression> elseExpr)
+            : ExpressionNode<ConditionalExpr>(ExpressionType::CONDITIONAL_EXPR),
+              condition(std::move(condition)),
+              thenExpr(std::move(thenExpr)),
+              elseExpr(std::move(elseExpr)) {}
+
+        ~ConditionalExpr() {
+            releaseChildren(condition, thenExpr, elseExpr);
+        }
+
+        static bool classof(const Expression* node) {
+            return node->type == ExpressionType::CONDITIONAL_EXPR;
+        }
+    };
+
+    // 堆分配表达式 alloc(T)，count 不为空时是 alloc_array(T, count)
+    class AllocExpr : public ExpressionNode<AllocExpr> {
+    public:
+        std::string elementType;
+        std::shared_ptr<Expression> count;
+
+        AllocExpr(std::string elementType, std::shared_ptr<Expression> count)
+            : ExpressionNode<AllocExpr>(ExpressionType::ALLOC_EXPR),
+              elementType(std::move(elementType)),
+              count(std::move(count)) {}
+
+        ~AllocExpr() {
+            releaseChildren(count);
+        }
+
+        static bool classof(const Expression* node) {
+            return node->type == ExpressionType::ALLOC_EXPR;
+        }
+    };
+
+    // 空指针字面量 NULL
+    class NullLiteralExpr : public ExpressionNode<NullLiteralExpr> {
+    public:
+        NullLiteralExpr()
+            : ExpressionNode<NullLiteralExpr>(ExpressionType::NULL_LITERAL_EXPR) {}
+
+        static bool classof(const Expression* node) {
+            return node->type == ExpressionType::NULL_LITERAL_EXPR;
+        }
+    };
+
+    // 规约中的 \result，即函数的返回值
+    class ResultExpr : public ExpressionNode<ResultExpr> {
+    public:
+        ResultExpr()
+            : ExpressionNode<ResultExpr>(ExpressionType::RESULT_EXPR) {}
+
+        static bool classof(const Expression* node) {
+            return node->type == ExpressionType::RESULT_EXPR;
+        }
+    };
+
+    // 规约中的 \length(array)
+    class LengthExpr : public ExpressionNode<LengthExpr> {
+    public:
+        std::shared_ptr<Expression> array;
+
+        explicit LengthExpr(std::shared_ptr<Expression> array)
+            : ExpressionNode<LengthExpr>(ExpressionType::LENGTH_EXPR),
+              array(std::move(array)) {}
+
+        ~LengthExpr() {
+            releaseChildren(array);
+        }
+
+        static bool classof(const Expression* node) {
+            return node->type == ExpressionType::LENGTH_EXPR;
+        }
+    };
+
     // 标识符表达式
     class IdentifierExpr : public ExpressionNode<IdentifierExpr> {
     public:
@@ -2,6 +2,7 @@
 
 #include "ASTNode.h"
 #include "ExprisionNode.h"
+#include "Contract.h"
 #include "DeclarationNode.h"
 
 #include <memory>
@@ -23,11 +24,13 @@ namespace CC {
         CONTINUE_STMT,
         DECL_STMT,
         NULL_STMT,
+        ASSERT_STMT,
     };
 
     class Statement : public INFRA::EnableShared<Statement> {
     public:
         StatementType type;
+        uint32_t offset = 0;  ///< 在源码中的起始字节偏移，报错时才换算成行列号
     };
 
     // 语句基类
@@ -96,6 +99,7 @@ namespace CC {
     public:
         std::shared_ptr<Expression> condition;
         std::shared_ptr<Statement> body;
+        std::vector<Contract> invariants;  ///< //@loop_invariant
         
         WhileStmt(std::shared_ptr<Expression> condition,
                   std::shared_ptr<Statement> body)
@@ -129,6 +133,7 @@ namespace CC {
         std::shared_ptr<Expression> condition;
         std::shared_ptr<Expression> increment;
         std::shared_ptr<Statement> body;
+        std::vector<Contract> invariants;  ///< //@loop_invariant
         
         ForStmt(std::shared_ptr<Statement> init,
                 std::shared_ptr<Expression> condition,
@@ -205,4 +210,26 @@ namespace CC {
             return node->type == StatementType::NULL_STMT;
         }
     };
+
+    // 运行时检查：//@assert，或者动态检查模式下由其他规约展开而来。
+    // 和其他规约一样只在动态检查模式（-d）下生成，没有经过 ContractLowering 的保持 UNCHECKED
+    class AssertStmt : public StatementNode<AssertStmt> {
+    public:
+        std::shared_ptr<Expression> condition;
+        ContractKind kind;   ///< 检查来自哪种规约，用于运行时报错
+        Location source;     ///< 规约注解的位置
+        ContractCheck check;
+
+        AssertStmt(std::shared_ptr<Expression> condition, ContractKind kind, Location source,
+                   ContractCheck check = ContractCheck::UNCHECKED)
+            : StatementNode<AssertStmt>(StatementType::ASSERT_STMT),
+              condition(std::move(condition)),
+              kind(kind),
+              source(source),
+              check(check) {}
+
+        static bool classof(const Statement* node) {
+            return node->type == StatementType::ASSERT_STMT;
+        }
+    };
 }
\ No newline at end of file
@@ -4,4 +4,5 @@
 
 #pragma once
 
-
+// C0 编译器库的公共头文件
+#include "Compiler/CompilerInstance.h"
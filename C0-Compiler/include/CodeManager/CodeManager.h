@@ -4,29 +4,75 @@
 
 #pragma once
 
+#include "Infra/MappedFile.h"
+
 #include <cstdint>
 #include <string>
-#include <fstream>
+#include <string_view>
 #include <vector>
 
 namespace CC {
 
+    /**
+     * @brief 源码中的位置，行列号都从 1 开始
+     */
     struct Location {
         size_t line, column;
     };
 
+    /**
+     * @brief 不对应源码中任何位置的诊断（例如文件无法打开）使用的位置
+     */
+    inline constexpr Location kNoLocation{0, 0};
+
+    struct Diagnostic {
+        Location location;
+        std::string message;
+    };
+
     class CodeManager {
     public:
         explicit CodeManager(const std::string& file_path);
 
-        Location location;
+        /**
+         * @brief 直接在内存中的源码上工作，不复制也不访问文件系统
+         * @param name 源码的名字，用于报错
+         * @param source 源码文本，调用者需保证其在 CodeManager 存活期间有效
+         */
+        CodeManager(std::string name, std::string_view source);
 
+        const std::string& getName() const;
+
+        /**
+         * @brief 当前读取位置对应的行列号
+         */
         Location getLocation() const;
 
-        char lookChar() const;
+        /**
+         * @brief 把字节偏移换算成行列号（均从 1 开始）
+         *
+         * 词法分析时只推进字节偏移，行首偏移表在第一次需要行列号时才建立，
+         * 之后每次查询都是一次二分查找
+         */
+        Location getLocation(size_t offset) const;
+
+        /**
+         * @brief 查看当前位置之后第 k 个字符，不移动当前位置
+         */
+        char lookChar(size_t k = 0) const;
         char getChar();
         void ungetChar();
 
+        /**
+         * @brief 跳过 n 个字符
+         */
+        void skip(size_t n);
+
+        size_t getOffset() const;
+        size_t remaining() const;
+        const char* current() const;
+        std::string_view getText(size_t offset, size_t length) const;
+
         bool eofReached() const;
 
         void updateBuffer(std::vector<char>& new_buffer);
@@ -34,11 +80,16 @@ namespace CC {
         void restar();
 
     protected:
-        std::ifstream file_stream;
+        void buildLineStarts() const;
+
+        INFRA::MappedFile file;    ///< 从文件读入时映射的源码
 
-        std::vector<char> buffer;
+        std::string name;
+        std::vector<char> buffer;  ///< updateBuffer 替换进来的源码
+        std::string_view text;     ///< 实际被分析的源码
         bool eof_reached = false;
         size_t current_pos = 0;
-        size_t last_column = 0;
+
+        mutable std::vector<uint32_t> line_starts;  ///< 每一行行首的字节偏移，按需建立
     };
 }
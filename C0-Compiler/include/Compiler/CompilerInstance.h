@@ -0,0 +1,127 @@
+//
+// Created by 陶子杨 on 25-11-24.
+//
+
+#pragma once
+
+#include "AST/UnitNode.h"
+#include "CodeManager/CodeManager.h"
+#include "Compiler/GlobalDeclarations.h"
+#include "IR/IR.h"
+#include "IR/PassManager.h"
+#include "Lexer/LanguageLevel.h"
+#include "Library/LibraryRegistry.h"
+#include "Transform/ContractLowering.h"
+
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace CC {
+
+    /**
+     * @brief 一段待编译的源码，文本由调用者持有，编译期间需保持有效
+     */
+    struct SourceBuffer {
+        std::string name;       ///< 用于报错的名字，例如文件名
+        std::string_view text;  ///< 源码文本
+        /// 通过 #use "文件" 引入的类型别名，解析前就视为已声明
+        std::vector<std::string> imported_typedefs;
+        /// 通过 #use "文件" 引入的结构体、类型别名、函数和库，降低到 IR 时可见
+        std::vector<std::shared_ptr<Declaration>> imported_declarations;
+    };
+
+    /**
+     * @brief 读出源码开头的 #use "文件"，按出现顺序返回去重后的规范路径，相对路径从 path 所在的目录找起
+     */
+    std::vector<std::string> scanUseFiles(const std::string& path, std::string_view text);
+
+    /**
+     * @brief 同上，直接映射文件，只读到第一个不是 #use 的 token
+     */
+    std::vector<std::string> scanUseFiles(const std::string& path);
+
+    /**
+     * @brief 规范化路径，同一个文件经由不同的相对路径引入时得到相同的结果
+     */
+    std::string normalizeSourcePath(const std::string& file_path);
+
+    struct CompilerOptions {
+        /// AST节点的内存来源；在多个线程间共享同一个实例时，它本身必须是线程安全的
+        std::pmr::memory_resource* memory_resource = std::pmr::get_default_resource();
+        /// 接受的语言层级，选择对应的词法/语法分析器实例
+        LanguageLevel language_level = LanguageLevel::C0;
+        /// #use <库名> 查找 .c0i 的目录，为空时使用构建时生成的标准库目录
+        std::vector<std::string> library_paths;
+        /// 动态检查模式（-d）：把规约展开成运行时检查，并删掉可证明冗余的部分
+        bool dynamic_checks = false;
+        /// 解析成功后把函数定义降低成 SSA 形式的 IR，类型检查和明确赋值检查都在这一步，
+        /// 关闭时只做语法检查。流式编译时每个函数单独降低、优化，结果交给 FunctionConsumer::consumeModule
+        bool lower_to_ir = false;
+        /// IR 的优化级别（-O0/-O1/-O2），选择默认的 pass 流水线，只在 lower_to_ir 时有效
+        int optimization_level = 0;
+        /// 非空时代替默认流水线，逗号分隔的 pass 名称
+        std::string pass_pipeline;
+        /// 最多执行多少次 pass，用于二分定位出问题的 pass；负数表示不限
+        int64_t pass_limit = -1;
+    };
+
+    struct CompileResult {
+        std::string name;
+        std::shared_ptr<TranslationUnit> translation_unit;  ///< 流式编译时为空
+        std::vector<Diagnostic> diagnostics;
+        ContractStats contract_stats;  ///< 开启动态检查时规约的处理情况
+        std::shared_ptr<IR::Module> module;  ///< 开启 lower_to_ir 且没有错误时的 IR，流式编译时为空
+        IR::PipelineStats pass_stats;        ///< 优化流水线中各 pass 和分析的统计
+
+        [[nodiscard]] bool success() const {
+            return diagnostics.empty();
+        }
+    };
+
+    /**
+     * @brief 编译器的库接口
+     *
+     * 每次 compile 都在自己的栈上创建词法/语法分析器，不读写任何全局可变状态，
+     * 因此同一个 CompilerInstance 可以被多个线程同时使用
+     */
+    class CompilerInstance {
+    public:
+        explicit CompilerInstance(CompilerOptions options = {});
+
+        /**
+         * @brief 编译内存中的源码，不访问文件系统，#use "文件" 引入的内容由 source 给出
+         */
+        [[nodiscard]] CompileResult compile(const SourceBuffer& source) const;
+
+        /**
+         * @brief 读取并编译文件，无法打开文件时通过诊断信息报告
+         *
+         * #use "文件" 相对于引入它的文件查找，间接引入的文件也一样。被引入的文件只做语法分析，
+         * 其中的类型别名、结构体和函数签名对本文件可见，它们的错误带上文件名一起报告
+         */
+        [[nodiscard]] CompileResult compileFile(const std::string& file_path) const;
+
+        /**
+         * @brief 流式编译：每解析完一个函数定义就交给 consumer 处理，然后释放它的内存池
+         *
+         * 只有结构体定义和函数签名常驻内存，峰值内存取决于最大的函数而不是整个文件
+         */
+        CompileResult compileStreaming(const SourceBuffer& source, FunctionConsumer& consumer) const;
+
+        CompileResult compileFileStreaming(const std::string& file_path, FunctionConsumer& consumer) const;
+
+        [[nodiscard]] const CompilerOptions& getOptions() const;
+
+        /**
+         * @brief 所有编译任务共享的库接口缓存
+         */
+        [[nodiscard]] LibraryRegistry& getLibraries() const;
+
+    private:
+        CompilerOptions options;
+        std::shared_ptr<LibraryRegistry> libraries;
+    };
+}
@@ -0,0 +1,124 @@
+//
+// Created by 陶子杨 on 25-11-26.
+//
+
+#pragma once
+
+#include "AST/DeclarationNode.h"
+#include "Library/LibraryInterface.h"
+
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace CC {
+
+    namespace IR {
+        class Module;
+    }
+
+    /**
+     * @brief 整个编译过程中常驻内存的全局声明：结构体定义、类型别名和函数签名
+     *
+     * 流式编译时函数体处理完就被释放，后续阶段只能通过这里查询其他函数和结构体
+     */
+    class GlobalDeclarations {
+    public:
+        explicit GlobalDeclarations(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+        /**
+         * @brief 按种类记录一个顶层声明：结构体、类型别名、函数签名和 #use 引入的库，其他声明被忽略
+         */
+        void addDeclaration(const std::shared_ptr<Declaration>& decl);
+
+        void addStruct(std::shared_ptr<StructDecl> decl);
+
+        /**
+         * @brief 记录函数签名，只复制名字、返回类型和参数，不引用原函数的AST
+         */
+        void addFunctionSignature(const FunctionDecl& decl);
+
+        void addVariable(std::shared_ptr<VariableDecl> decl);
+
+        void addTypedef(std::shared_ptr<TypedefDecl> decl);
+
+        /**
+         * @brief 记录 #use 引入的库，同一个库只记一次
+         */
+        void addLibrary(std::shared_ptr<const LibraryInterface> library);
+
+        [[nodiscard]] const StructDecl* findStruct(std::string_view name) const;
+        [[nodiscard]] const FunctionDecl* findFunction(std::string_view name) const;
+        [[nodiscard]] const TypedefDecl* findTypedef(std::string_view name) const;
+
+        /**
+         * @brief 在引入的库中按名字查找函数，按 #use 的顺序找第一个
+         */
+        [[nodiscard]] std::optional<LibraryFunction> findLibraryFunction(std::string_view name) const;
+
+        [[nodiscard]] std::optional<LibraryStruct> findLibraryStruct(std::string_view name) const;
+
+        /**
+         * @brief 在引入的库中查找类型别名，返回它代表的类型
+         */
+        [[nodiscard]] std::optional<std::string_view> findLibraryTypedef(std::string_view name) const;
+
+        [[nodiscard]] const std::vector<std::shared_ptr<StructDecl>>& getStructs() const {
+            return structs;
+        }
+
+        [[nodiscard]] const std::vector<std::shared_ptr<FunctionDecl>>& getFunctions() const {
+            return functions;
+        }
+
+        [[nodiscard]] const std::vector<std::shared_ptr<VariableDecl>>& getVariables() const {
+            return variables;
+        }
+
+        [[nodiscard]] const std::vector<std::shared_ptr<TypedefDecl>>& getTypedefs() const {
+            return typedefs;
+        }
+
+        [[nodiscard]] const std::vector<std::shared_ptr<const LibraryInterface>>& getLibraries() const {
+            return libraries;
+        }
+
+    private:
+        std::pmr::memory_resource* memory_resource;
+        std::vector<std::shared_ptr<StructDecl>> structs;
+        std::vector<std::shared_ptr<FunctionDecl>> functions;   ///< 只有签名，没有函数体
+        std::vector<std::shared_ptr<VariableDecl>> variables;
+        std::vector<std::shared_ptr<TypedefDecl>> typedefs;
+        std::vector<std::shared_ptr<const LibraryInterface>> libraries;
+        std::unordered_map<std::string, size_t> struct_index;
+        std::unordered_map<std::string, size_t> function_index;
+        std::unordered_map<std::string, size_t> typedef_index;
+    };
+
+    /**
+     * @brief 流式编译中每个函数定义的后续处理
+     */
+    class FunctionConsumer {
+    public:
+        virtual ~FunctionConsumer() = default;
+
+        /**
+         * @brief 函数定义解析完成后立即调用
+         *
+         * 返回之后该函数的AST连同它所在的内存池都会被释放，实现中不能保留对它的引用
+         */
+        virtual void consume(const std::shared_ptr<FunctionDecl>& function, const GlobalDeclarations& globals) = 0;
+
+        /**
+         * @brief 开启 lower_to_ir 时，函数降低并优化成功之后调用
+         *
+         * module 中只有这一个函数的定义，它调用的函数都是声明。返回之后 module 即被销毁
+         */
+        virtual void consumeModule(IR::Module& /*module*/) {
+        }
+    };
+}
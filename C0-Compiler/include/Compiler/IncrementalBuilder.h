@@ -0,0 +1,96 @@
+//
+// Created by 陶子杨 on 25-12-5.
+//
+
+#pragma once
+
+#include "Compiler/CompilerInstance.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace CC {
+
+    /**
+     * @brief 一次增量构建的统计
+     */
+    struct BuildStats {
+        std::vector<std::string> compiled_files;  ///< 本次重新编译的文件
+        size_t reused = 0;                        ///< 直接复用缓存结果的文件数
+    };
+
+    /**
+     * @brief 按 #use "文件" 的依赖图做增量编译，缓存每个文件的前端结果
+     *
+     * 文件内容没变时直接复用上次的结果；内容变了只重新编译它自己。
+     * 编译只依赖被引入文件的接口（类型别名、结构体和函数签名），所以只有接口变了时才会继续重新编译引入它的文件
+     */
+    class IncrementalBuilder {
+    public:
+        explicit IncrementalBuilder(const CompilerInstance& compiler);
+
+        /**
+         * @brief 添加入口文件，它通过 #use 引入的文件在构建时自动加入
+         */
+        void addRoot(const std::string& file_path);
+
+        /**
+         * @brief 标记文件可能已被修改，下次 build 时重新检查；不在依赖图中的文件被忽略
+         */
+        void invalidate(const std::string& file_path);
+
+        /**
+         * @brief 重新检查被标记的文件，按依赖顺序重新编译受影响的文件
+         */
+        BuildStats build();
+
+        /**
+         * @brief 依赖图中所有文件的规范路径
+         */
+        [[nodiscard]] std::vector<std::string> getFiles() const;
+
+        /**
+         * @brief 文件最近一次的编译结果，不在依赖图中时返回空
+         */
+        [[nodiscard]] const CompileResult* getResult(const std::string& file_path) const;
+
+        /**
+         * @brief 规范化路径，依赖图中的文件都以这种形式存储
+         */
+        static std::string normalizePath(const std::string& file_path);
+
+    private:
+        struct FileNode {
+            std::vector<std::string> dependencies;   ///< #use "文件" 引入的文件
+            std::vector<std::string> exported_typedefs;///< 对引入它的文件可见的类型别名，包括间接引入的
+            std::vector<std::shared_ptr<Declaration>> exported_declarations;///< 对引入它的文件可见的声明，包括间接引入的
+            std::vector<std::string> exported_interface;///< exported_declarations 的文字形式，用来判断接口是否变化
+            std::vector<std::string> cyclic_uses;    ///< 形成循环引用而被忽略的 #use
+            uint64_t content_hash = 0;
+            bool loaded = false;          ///< 是否至少编译过一次
+            bool dirty = true;            ///< 需要重新读取文件
+            bool needs_compile = false;   ///< 本次构建需要重新编译
+            bool exports_changed = false; ///< 本次构建中导出的接口有变化
+            CompileResult result;
+        };
+
+        /**
+         * @brief 读取被标记的文件，内容有变化时重新扫描它的 #use 依赖
+         * @return 文件能否读取
+         */
+        bool refresh(const std::string& path, FileNode& node, std::string& text);
+
+        /**
+         * @brief 从入口文件出发按依赖在前的顺序排列文件，发现循环引用时报错
+         */
+        std::vector<std::string> sortFiles();
+
+        void compileNode(const std::string& path, FileNode& node, const std::string& text);
+
+        const CompilerInstance& compiler;
+        std::vector<std::string> roots;
+        std::unordered_map<std::string, FileNode> nodes;
+    };
+}
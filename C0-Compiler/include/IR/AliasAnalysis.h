@@ -0,0 +1,134 @@
+//
+// Created by 陶子杨 on 25-12-20.
+//
+
+#pragma once
+
+#include "IR/IR.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace CC::IR {
+
+    enum class AliasResult : uint8_t {
+        NO_ALIAS,
+        MAY_ALIAS,
+        MUST_ALIAS,
+    };
+
+    /**
+     * @brief 访问路径上的一步：字段是 FIELD_ADDR 的偏移，连续的几步合成一步；
+     * 元素是 ELEMENT_ADDR 的下标 index + offset，下标是常量时 index 为空，值全在 offset 里
+     */
+    struct AccessStep {
+        bool is_element;
+        const Value* index;
+        int64_t offset;
+    };
+
+    /**
+     * @brief 一次 LOAD 或 STORE 访问的内存位置：从基对象出发的访问路径和访问的类型。
+     * 类型为 VOID 时表示 object 指向的整个对象
+     */
+    struct MemoryLocation {
+        const Value* address;
+        Type type;
+        const Value* object;            ///< 去掉 FIELD_ADDR 和 ELEMENT_ADDR 之后的基址
+        std::vector<AccessStep> path;   ///< 从基址往外，最后一步总是字段偏移
+    };
+
+    /**
+     * @brief 基于类型和分配点的别名分析
+     *
+     * C0 没有指针运算和类型转换，也不能取地址，所以：
+     * - 一个内存单元只会以同一种类型读写，类型不同的访问不会重叠；
+     * - 指针总是指向某次分配的开头，路径的形状（字段和元素的排列）由对象的类型决定，
+     *   基址可能相同时，形状不同或者路径上有一步能证明不同就不会重叠；
+     * - 两个不同的分配点得到不同的对象；没有逃逸（没有写进内存、传给函数、返回或汇入 PHI）
+     *   的分配只能通过它自己访问，和其他基址不重叠，被调函数也访问不到。
+     *
+     * 基址是由 FIELD_ADDR 或 ELEMENT_ADDR 汇入的 PHI 时，它不指向对象开头，只按类型判断。
+     *
+     * 函数中 LOAD 和 STORE 访问的位置按 (地址, 类型) 编号，每个分配点的整个对象也占一个编号，
+     * 数据流分析可以用编号的集合表示内存状态
+     */
+    class AliasAnalysis {
+    public:
+        static constexpr uint32_t kNone = UINT32_MAX;
+
+        explicit AliasAnalysis(const Function& function);
+
+        [[nodiscard]] MemoryLocation getLocation(const Value* address, Type type) const;
+
+        /**
+         * @brief LOAD 或 STORE 访问的位置
+         */
+        [[nodiscard]] MemoryLocation getLocation(const Instruction* access) const;
+
+        [[nodiscard]] AliasResult alias(const MemoryLocation& a, const MemoryLocation& b) const;
+
+        /**
+         * @brief 位置可能落在 object 指向的对象里
+         */
+        [[nodiscard]] bool mayAccessObject(const MemoryLocation& location, const Value* object) const;
+
+        [[nodiscard]] uint32_t getLocationCount() const {
+            return static_cast<uint32_t>(locations.size());
+        }
+
+        /**
+         * @brief LOAD、STORE 访问的位置或者 ALLOC、ALLOC_ARRAY 分配的对象的编号，其他指令返回 kNone
+         */
+        [[nodiscard]] uint32_t getLocationId(const Instruction* instruction) const {
+            auto it = location_ids.find(instruction);
+            return it == location_ids.end() ? kNone : it->second;
+        }
+
+        [[nodiscard]] const MemoryLocation& getLocation(uint32_t id) const {
+            return locations[id];
+        }
+
+        /**
+         * @brief 位置所在的整个对象的编号，基址不是分配指令时返回 kNone
+         */
+        [[nodiscard]] uint32_t getObjectId(const MemoryLocation& location) const;
+
+        /**
+         * @brief 两个编号的位置可能重叠，结果按编号对缓存
+         */
+        [[nodiscard]] bool mayAlias(uint32_t a, uint32_t b) const;
+
+        /**
+         * @brief 没有逃逸的 ALLOC 或 ALLOC_ARRAY
+         */
+        [[nodiscard]] bool isLocalObject(const Value* object) const {
+            return local_objects.contains(object);
+        }
+
+        /**
+         * @brief 调用可能读写这个位置：除了纯函数，被调函数能访问所有逃逸了的对象
+         */
+        [[nodiscard]] bool isAccessibleFromCall(const MemoryLocation& location) const {
+            return !isLocalObject(location.object);
+        }
+
+        /**
+         * @brief 调用是否可能读写内存；纯函数不会
+         */
+        static bool callAccessesMemory(const Instruction* call) {
+            return !call->getCallee()->isPure();
+        }
+
+    private:
+        [[nodiscard]] bool isObjectStart(const Value* object) const;
+
+        std::unordered_set<const Value*> local_objects;
+        std::unordered_set<const Value*> interior_phis;   ///< 可能指向对象内部的 PHI
+        std::vector<MemoryLocation> locations;
+        std::unordered_map<const Instruction*, uint32_t> location_ids;
+        mutable std::unordered_map<uint64_t, bool> alias_cache;
+    };
+}
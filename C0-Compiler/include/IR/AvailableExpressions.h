@@ -0,0 +1,67 @@
+//
+// Created by 陶子杨 on 25-12-12.
+//
+
+#pragma once
+
+#include "IR/CFG.h"
+#include "Infra/BitVector.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace CC::IR {
+
+    /**
+     * @brief 可用表达式：到达某一点的每条路径上都已经计算过的表达式
+     *
+     * 表达式按 (操作码, 类型, 立即数, 操作数) 哈希归并，可交换运算的操作数先排序，
+     * 只有出现至少两次的表达式才分配编号。操作数都是 SSA 值，不会被重新定义，
+     * 只有 LOAD 会被 STORE 和 CALL 注销。
+     * 这是必然问题，初值为全集，集合用稠密位集合。要求函数已经 renumber
+     */
+    class AvailableExpressions {
+    public:
+        static constexpr uint32_t kNone = UINT32_MAX;
+
+        explicit AvailableExpressions(const Function& function);
+
+        [[nodiscard]] uint32_t getExpressionCount() const {
+            return static_cast<uint32_t>(representatives.size());
+        }
+
+        /**
+         * @brief 指令计算的表达式编号，不是可归并的表达式或者只出现一次时返回 kNone
+         */
+        [[nodiscard]] uint32_t getExpression(const Instruction* instruction) const {
+            return expression_of[instruction->getNumber()];
+        }
+
+        /**
+         * @brief 按布局顺序第一条计算该表达式的指令
+         */
+        [[nodiscard]] Instruction* getRepresentative(uint32_t expression) const {
+            return representatives[expression];
+        }
+
+        [[nodiscard]] const INFRA::BitVector& getAvailableIn(const BasicBlock* block) const {
+            return available_in[block->getNumber()];
+        }
+
+        [[nodiscard]] const INFRA::BitVector& getAvailableOut(const BasicBlock* block) const {
+            return available_out[block->getNumber()];
+        }
+
+        /**
+         * @brief instruction 计算的表达式在它之前是否已经可用，即它是冗余的
+         */
+        [[nodiscard]] bool isAvailableBefore(const Instruction* instruction) const;
+
+    private:
+        std::vector<uint32_t> expression_of;   ///< 按指令编号
+        std::vector<Instruction*> representatives;
+        INFRA::BitVector loads;                ///< 哪些表达式是 LOAD
+        std::vector<INFRA::BitVector> available_in;
+        std::vector<INFRA::BitVector> available_out;
+    };
+}
@@ -0,0 +1,112 @@
+//
+// Created by 陶子杨 on 25-12-11.
+//
+
+#pragma once
+
+#include "IR/IR.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace CC::IR {
+
+    class DominatorTree;
+
+    /**
+     * @brief 函数控制流图的只读快照
+     *
+     * 基本块按 Function 中的稠密编号索引，前驱和后继存成两张连续的邻接数组（CSR），
+     * 分析时遍历边不再追指针。快照建立之后修改 CFG 需要重新构造
+     */
+    class CFG {
+    public:
+        static constexpr uint32_t kUnreachable = UINT32_MAX;
+
+        explicit CFG(const Function& function);
+
+        [[nodiscard]] uint32_t size() const {
+            return static_cast<uint32_t>(blocks.size());
+        }
+
+        [[nodiscard]] BasicBlock* getBlock(uint32_t index) const {
+            return blocks[index];
+        }
+
+        [[nodiscard]] std::span<const uint32_t> getSuccessors(uint32_t index) const {
+            return {successors.data() + successor_offsets[index], successors.data() + successor_offsets[index + 1]};
+        }
+
+        /**
+         * @brief 前驱，一个块用两条边跳过来时出现两次
+         */
+        [[nodiscard]] std::span<const uint32_t> getPredecessors(uint32_t index) const {
+            return {predecessors.data() + predecessor_offsets[index],
+                    predecessors.data() + predecessor_offsets[index + 1]};
+        }
+
+        /**
+         * @brief 从入口可达的基本块的逆后序
+         */
+        [[nodiscard]] const std::vector<uint32_t>& getReversePostOrder() const {
+            return reverse_post_order;
+        }
+
+        /**
+         * @brief 基本块在逆后序中的位置，不可达时为 kUnreachable
+         */
+        [[nodiscard]] uint32_t getRPONumber(uint32_t index) const {
+            return rpo_number[index];
+        }
+
+        [[nodiscard]] bool isReachable(uint32_t index) const {
+            return rpo_number[index] != kUnreachable;
+        }
+
+    private:
+        std::vector<BasicBlock*> blocks;
+        std::vector<uint32_t> successor_offsets;
+        std::vector<uint32_t> successors;
+        std::vector<uint32_t> predecessor_offsets;
+        std::vector<uint32_t> predecessors;
+        std::vector<uint32_t> reverse_post_order;
+        std::vector<uint32_t> rpo_number;
+    };
+
+    /**
+     * @brief from 有多个后继且 to 有多个前驱时，这条边上无处放置只属于它的指令
+     */
+    bool isCriticalEdge(const BasicBlock* from, const BasicBlock* to);
+
+    /**
+     * @brief 在 from 到 to 的一条边中间插入一个只有跳转的新块，to 中 PHI 的来源改为新块
+     *
+     * 新块取最大的编号，已有块的编号不变
+     */
+    BasicBlock* splitEdge(BasicBlock* from, BasicBlock* to);
+
+    /**
+     * @brief 把 before 及其后面的指令（包括终结指令）移到一个新块中，后继中 PHI 的来源随之改为新块。
+     * 原来的块留下没有终结指令的前半部分，由调用者补上跳转
+     */
+    BasicBlock* splitBlock(BasicBlock* block, Instruction* before);
+
+    /**
+     * @brief 把条件已知的 COND_BR 换成跳到 successor(taken) 的 BR，另一个目标中的 PHI 去掉来自本块的一个值
+     */
+    void foldBranch(Instruction* branch, uint32_t taken);
+
+    /**
+     * @brief 新建一个块，把 predecessors 中各块跳到 block 的边都改到新块，新块再跳到 block。
+     * block 中 PHI 来自这些前驱的值在新块中合并：相同时直接沿用，否则在新块中新建 PHI。
+     * 用于建立循环的前置块和专用出口
+     */
+    BasicBlock* splitPredecessors(BasicBlock* block, std::span<BasicBlock* const> predecessors);
+
+    /**
+     * @brief 拆分函数中的所有关键边，返回新建的基本块数。传入的支配树和后支配树随之增量更新
+     */
+    size_t splitCriticalEdges(Function& function, DominatorTree* dominators = nullptr,
+                              DominatorTree* post_dominators = nullptr);
+}
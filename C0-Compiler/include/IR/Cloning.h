@@ -0,0 +1,49 @@
+//
+// Created by 陶子杨 on 25-12-19.
+//
+
+#pragma once
+
+#include "IR/IR.h"
+#include "Infra/casting.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace CC::IR {
+
+    /**
+     * @brief 复制基本块时旧值到新值、旧块到新块的映射，调用者可以预先放入参数等的替换
+     */
+    struct CloneMap {
+        std::unordered_map<const Value*, Value*> values;
+        std::unordered_map<const BasicBlock*, BasicBlock*> blocks;
+        bool foreign = false;   ///< 源块属于另一个函数（内联），常量要在目标函数中重新取
+
+        /**
+         * @brief 映射过的值返回新值，其余（复制范围外的定义、参数、常量）原样返回
+         */
+        [[nodiscard]] Value* lookup(Function& function, Value* value) const;
+
+        /**
+         * @brief 复制范围内一条指令的副本
+         */
+        [[nodiscard]] Instruction* getClone(const Instruction* instruction) const {
+            return &INFRA::cast<Instruction>(*values.at(instruction));
+        }
+
+        [[nodiscard]] BasicBlock* lookup(BasicBlock* block) const {
+            auto it = blocks.find(block);
+            return it == blocks.end() ? block : it->second;
+        }
+    };
+
+    /**
+     * @brief 把 blocks 复制到 function 的末尾，返回按相同顺序排列的新块
+     *
+     * 操作数、跳转目标和 PHI 的来源块都经过 map 映射，不在复制范围内的保持原样：
+     * 跳出复制范围的边让目标多出一个前驱，目标中 PHI 的值由调用者补上；
+     * 来源块在范围外的 PHI 项（例如循环头从前置块进来的值）同样由调用者处理
+     */
+    std::vector<BasicBlock*> cloneBlocks(Function& function, const std::vector<BasicBlock*>& blocks, CloneMap& map);
+}
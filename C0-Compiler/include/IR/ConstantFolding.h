@@ -0,0 +1,26 @@
+//
+// Created by 陶子杨 on 25-12-13.
+//
+
+#pragma once
+
+#include "IR/IR.h"
+
+#include <cstdint>
+#include <optional>
+
+namespace CC::IR {
+
+    /**
+     * @brief 按 C0 的语义计算二元运算或比较的常量结果
+     *
+     * 整数运算是 32 位补码回绕；除数为 0、INT_MIN / -1 以及移位量不在 [0, 32) 内时程序会中止，
+     * 这些情况返回 nullopt，调用者必须保留原来的指令。比较的结果是 0 或 1
+     */
+    std::optional<int32_t> foldBinary(Opcode opcode, int32_t left, int32_t right);
+
+    /**
+     * @brief 执行时是否会中止程序，foldBinary 对这些组合返回 nullopt
+     */
+    bool binaryTraps(Opcode opcode, int32_t left, int32_t right);
+}
@@ -0,0 +1,34 @@
+//
+// Created by 陶子杨 on 25-12-14.
+//
+
+#pragma once
+
+#include "IR/Dominators.h"
+
+#include <span>
+#include <vector>
+
+namespace CC::IR {
+
+    /**
+     * @brief 控制依赖：B 控制依赖于 A，当且仅当 A 的某个后继被 B 后支配而 A 本身不被 B 严格后支配，
+     * 即 A 的分支决定了 B 是否执行。A 的集合就是 B 的后支配边界。
+     * 死循环按后支配树的处理挂在虚拟出口下，循环里的块同样控制依赖于进入循环的分支
+     */
+    class ControlDependence {
+    public:
+        explicit ControlDependence(const PostDominatorTree& tree);
+
+        /**
+         * @brief block 控制依赖的块，也就是决定它是否执行的那些分支所在的块
+         */
+        [[nodiscard]] std::span<BasicBlock* const> getControllingBlocks(const BasicBlock* block) const {
+            const auto& blocks = controlling[block->getNumber()];
+            return {blocks.data(), blocks.size()};
+        }
+
+    private:
+        std::vector<std::vector<BasicBlock*>> controlling;
+    };
+}
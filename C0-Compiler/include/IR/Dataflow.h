@@ -0,0 +1,191 @@
+//
+// Created by 陶子杨 on 25-12-12.
+//
+
+#pragma once
+
+#include "IR/CFG.h"
+#include "Infra/BitVector.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace CC::IR {
+
+    enum class DataflowDirection : uint8_t {
+        FORWARD,    // 块入口的值由前驱的出口值交汇得到
+        BACKWARD,   // 块出口的值由后继的入口值交汇得到
+    };
+
+    enum class MeetOperator : uint8_t {
+        UNION,          // 可能问题：某条路径上成立即可
+        INTERSECTION,   // 必然问题：所有路径上都成立
+    };
+
+    /**
+     * @brief 基于位集合的迭代数据流求解器
+     *
+     * Problem 描述一个具体的分析，需要提供：
+     * - using Set：集合类型，INFRA::BitVector 或 INFRA::SparseBitVector
+     * - static constexpr DataflowDirection direction 和 MeetOperator meet
+     * - const Set& getBoundary() const：正向问题入口块的入口值，反向问题出口块（没有后继）的出口值
+     * - const Set& getInitial() const：其余各点的初值，也是不参与计算的块最后的值；并问题中应为空集
+     * - bool transfer(uint32_t block, const Set& input, Set& output) const：
+     *   由块的输入（正向是入口值，反向是出口值）计算输出，返回输出是否变化
+     *
+     * 工作表按逆后序（反向问题按后序）的位置排成一个位集合，每次取当前位置之后的第一个待处理块，
+     * 扫到末尾再从头开始。无环的部分一遍就收敛，循环只需要按嵌套深度多扫几遍。
+     *
+     * 还没有计算过的块的值视为交汇运算的单位元，交汇时直接跳过，所以交问题也不需要把全集
+     * 物化出来，可以用稀疏位集合。交问题中没有任何已计算的来源的块先不处理，等来源第一次算出值时
+     * 再排进来，反向问题中到不了出口的块（死循环）因此保持初值；并问题直接从空集开始算。
+     * 不可达的块不参与计算，结果保持初值
+     */
+    template <typename Problem>
+    class DataflowSolver {
+    public:
+        using Set = typename Problem::Set;
+
+        DataflowSolver(const CFG& cfg, const Problem& problem) : cfg(cfg), problem(problem) {}
+
+        void solve() {
+            uint32_t count = cfg.size();
+            in.assign(count, problem.getInitial());
+            out.assign(count, problem.getInitial());
+            visits = 0;
+
+            const auto& rpo = cfg.getReversePostOrder();
+            auto reachable = static_cast<uint32_t>(rpo.size());
+            std::vector<uint32_t> order(reachable);
+            std::vector<uint32_t> position(count, CFG::kUnreachable);
+            for (uint32_t i = 0; i < reachable; ++i) {
+                order[i] = forward ? rpo[i] : rpo[reachable - 1 - i];
+                position[order[i]] = i;
+            }
+
+            INFRA::BitVector pending(reachable, true);
+            INFRA::BitVector visited(count);
+            size_t cursor = 0;
+            while (true) {
+                size_t next = pending.findNext(cursor);
+                if (next == INFRA::BitVector::npos) {
+                    next = pending.findNext(0);
+                    if (next == INFRA::BitVector::npos) {
+                        break;
+                    }
+                }
+                pending.reset(next);
+                cursor = next + 1;
+                ++visits;
+
+                uint32_t block = order[next];
+                Set& input = forward ? in[block] : out[block];
+                Set& output = forward ? out[block] : in[block];
+                if (!meetInto(block, input, visited)) {
+                    continue;
+                }
+                bool first_visit = !visited.test(block);
+                visited.set(block);
+                // 第一次计算时输出从单位元变成了具体的值，即使和初值相同也要通知依赖它的块
+                if (!problem.transfer(block, input, output) && !first_visit) {
+                    continue;
+                }
+                auto dependents = forward ? cfg.getSuccessors(block) : cfg.getPredecessors(block);
+                for (uint32_t dependent : dependents) {
+                    if (position[dependent] != CFG::kUnreachable) {
+                        pending.set(position[dependent]);
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief 块入口处的值
+         */
+        [[nodiscard]] const Set& getIn(uint32_t block) const {
+            return in[block];
+        }
+
+        /**
+         * @brief 块出口处的值
+         */
+        [[nodiscard]] const Set& getOut(uint32_t block) const {
+            return out[block];
+        }
+
+        /**
+         * @brief 求解过程中计算传递函数的次数
+         */
+        [[nodiscard]] uint64_t getVisitCount() const {
+            return visits;
+        }
+
+    private:
+        static constexpr bool forward = Problem::direction == DataflowDirection::FORWARD;
+
+        /**
+         * @brief 交汇已计算的来源，返回是否有输入：边界块、至少一个来源已计算，或者是并问题
+         */
+        bool meetInto(uint32_t block, Set& input, const INFRA::BitVector& visited) const {
+            auto sources = forward ? cfg.getPredecessors(block) : cfg.getSuccessors(block);
+            bool boundary = forward ? block == cfg.getReversePostOrder().front() : sources.empty();
+            bool first = true;
+            if (boundary) {
+                input = problem.getBoundary();
+                first = false;
+            }
+            for (uint32_t source : sources) {
+                if (!visited.test(source)) {
+                    continue;
+                }
+                const Set& value = forward ? out[source] : in[source];
+                if (first) {
+                    input = value;
+                    first = false;
+                } else if constexpr (Problem::meet == MeetOperator::UNION) {
+                    input.unionWith(value);
+                } else {
+                    input.intersectWith(value);
+                }
+            }
+            if (first && Problem::meet == MeetOperator::UNION) {
+                input = problem.getInitial();
+                first = false;
+            }
+            return !first;
+        }
+
+        const CFG& cfg;
+        const Problem& problem;
+        std::vector<Set> in;
+        std::vector<Set> out;
+        uint64_t visits = 0;
+    };
+
+    /**
+     * @brief 传递函数为 output = gen | (input & ~kill) 的问题，只需要填好各块的 gen/kill
+     */
+    template <typename SetType, DataflowDirection Direction, MeetOperator Meet>
+    struct GenKillProblem {
+        using Set = SetType;
+        static constexpr DataflowDirection direction = Direction;
+        static constexpr MeetOperator meet = Meet;
+
+        [[nodiscard]] const Set& getBoundary() const {
+            return boundary;
+        }
+
+        [[nodiscard]] const Set& getInitial() const {
+            return initial;
+        }
+
+        bool transfer(uint32_t block, const Set& input, Set& output) const {
+            return output.assignTransfer(gen[block], input, kill[block]);
+        }
+
+        std::vector<Set> gen;
+        std::vector<Set> kill;
+        Set boundary;
+        Set initial;
+    };
+}
@@ -0,0 +1,100 @@
+//
+// Created by 陶子杨 on 25-12-22.
+//
+
+#pragma once
+
+#include "IR/InductionVariables.h"
+
+#include <cstdint>
+#include <optional>
+#include <unordered_set>
+#include <vector>
+
+namespace CC::IR {
+
+    /**
+     * @brief 仿射下标 constant + coefficient * variable + symbol
+     *
+     * variable 是循环中取值非负的基本归纳变量，系数只能是 0、1 或 -1；symbol 是除此之外的任意一个值。
+     * 常量的绝对值不超过 2^30，于是两个下标按 32 位回绕相等当且仅当它们作为整数相等
+     */
+    struct Subscript {
+        const Instruction* variable = nullptr;
+        int32_t coefficient = 0;
+        const Value* symbol = nullptr;
+        int32_t constant = 0;
+    };
+
+    /**
+     * @brief 读写数组元素的 LOAD 或 STORE：array[s0]，或者 array[s0][s1]，即先从 array[s0] 读出行再取元素
+     */
+    struct ArrayAccess {
+        Instruction* instruction;
+        const Value* array;
+        std::vector<Subscript> subscripts;
+        Type type;   ///< 元素类型
+        bool write;
+    };
+
+    /**
+     * @brief 两个访问之间可能的依赖：对嵌套中由外到内的每一层循环，给出后一个访问所在的迭代
+     * 相对于前一个访问的先后，是 kLess、kEqual、kGreater 的组合
+     */
+    struct Dependence {
+        static constexpr uint8_t kLess = 1;      ///< 前一个访问的迭代更早
+        static constexpr uint8_t kEqual = 2;
+        static constexpr uint8_t kGreater = 4;
+        static constexpr uint8_t kAll = kLess | kEqual | kGreater;
+
+        std::vector<uint8_t> directions;
+    };
+
+    /**
+     * @brief 数组下标的依赖分析
+     *
+     * 数组的数组中各行是独立分配的对象，不同的行可能是同一个对象，所以一般只能比较最后一维的下标；
+     * 行不会重复的数组（见 hasDistinctRows）才逐维比较，它的元素也不会通过别的数组访问到。
+     * 每一维的下标相等列出关于各层归纳变量的方程：同一个归纳变量、系数相同时得到确定的距离，
+     * 换算成迭代的先后；其余情况对应层上的方向都可能出现。元素类型不同的访问不会重叠
+     */
+    class DependenceAnalysis {
+    public:
+        DependenceAnalysis(const Function& function, const InductionVariables& induction);
+
+        /**
+         * @brief LOAD 或 STORE 的地址是数组元素时返回它的描述
+         */
+        [[nodiscard]] std::optional<ArrayAccess> getAccess(Instruction* instruction) const;
+
+        /**
+         * @brief array 是本函数分配的指针数组，各行只会是紧接着存进去的新分配的数组，
+         * 读出来的行只用来访问元素或取长度，所以不同下标上的行一定是不同的对象，也不会出现在别处
+         */
+        [[nodiscard]] bool hasDistinctRows(const Value* array) const {
+            return distinct_rows.count(array) != 0;
+        }
+
+        /**
+         * @brief a 和 b 在 nest（由外到内的循环）的某两次迭代中可能访问同一个元素时返回各层的方向，
+         * 不可能时返回 nullopt。两个访问都要在 nest 的最内层循环中
+         */
+        [[nodiscard]] std::optional<Dependence> depends(const ArrayAccess& a, const ArrayAccess& b,
+                                                        const std::vector<const Loop*>& nest) const;
+
+    private:
+        /**
+         * @brief 把下标拆成仿射形式，拆不开的部分整个作为 symbol
+         */
+        Subscript getSubscript(const Value* value, uint32_t depth) const;
+
+        /**
+         * @brief 一维下标相等时各层可能的方向，不可能相等时返回 false
+         */
+        bool compare(const Subscript& a, const Subscript& b, const std::vector<const Loop*>& nest,
+                     std::vector<uint8_t>& directions) const;
+
+        const InductionVariables& induction;
+        std::unordered_set<const Value*> distinct_rows;
+    };
+}
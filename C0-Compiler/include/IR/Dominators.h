@@ -0,0 +1,244 @@
+//
+// Created by 陶子杨 on 25-12-11.
+//
+
+#pragma once
+
+#include "IR/IR.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace CC::IR {
+
+    /**
+     * @brief 支配树，用 Semi-NCA 算法计算
+     *
+     * 先在 DFS 生成树上求半支配点（带路径压缩的 eval），再沿生成树父节点向上找与半支配点的
+     * 最近公共祖先得到直接支配点。整个过程只用按 DFS 序号索引的数组和显式栈，
+     * 十万个基本块以上的机器生成函数也接近线性，不会递归爆栈。
+     *
+     * 节点按基本块的稠密编号索引。修改 CFG 之后用 insertEdge/deleteEdge 增量更新：
+     * 受影响的节点都在两端最近公共支配点的子树中，只在这棵子树里重新运行 Semi-NCA；
+     * 删边使一片区域变得不可达时，这片区域跳出去的边也等于被删掉，重建的范围再向上扩大到
+     * 这些边的目标与原子树的最近公共支配点。
+     * 删除基本块会改变其他块的编号，之后必须 recalculate
+     */
+    class DominatorTree {
+    public:
+        explicit DominatorTree(const Function& function) : DominatorTree(function, false) {}
+
+        virtual ~DominatorTree() = default;
+
+        DominatorTree(const DominatorTree&) = delete;
+        DominatorTree& operator=(const DominatorTree&) = delete;
+
+        /**
+         * @brief 按函数当前的 CFG 从头计算
+         */
+        void recalculate();
+
+        [[nodiscard]] const Function& getFunction() const {
+            return function;
+        }
+
+        [[nodiscard]] bool isPostDominator() const {
+            return post;
+        }
+
+        /**
+         * @brief 树根对应的基本块；后支配树的根是虚拟出口，返回 nullptr
+         */
+        [[nodiscard]] BasicBlock* getRoot() const;
+
+        /**
+         * @brief 直接支配点，树根和不可达的块返回 nullptr；后支配树中直接后支配点是虚拟出口时也返回 nullptr
+         */
+        [[nodiscard]] BasicBlock* getIdom(const BasicBlock* block) const;
+
+        [[nodiscard]] bool isReachable(const BasicBlock* block) const {
+            return contains(node(block));
+        }
+
+        /**
+         * @brief 在树中的深度，树根为 0
+         */
+        [[nodiscard]] uint32_t getLevel(const BasicBlock* block) const {
+            return levels[node(block)];
+        }
+
+        /**
+         * @brief 支配树中的子节点
+         */
+        [[nodiscard]] std::vector<BasicBlock*> getChildren(const BasicBlock* block) const;
+
+        /**
+         * @brief 支配树的先序遍历，父节点总在子节点之前；后支配树不含虚拟出口
+         */
+        [[nodiscard]] std::vector<BasicBlock*> getPreorder() const;
+
+        /**
+         * @brief a 是否支配 b（自己支配自己）；不可达的块不被任何块支配
+         */
+        [[nodiscard]] bool dominates(const BasicBlock* a, const BasicBlock* b) const;
+
+        [[nodiscard]] bool properlyDominates(const BasicBlock* a, const BasicBlock* b) const {
+            return a != b && dominates(a, b);
+        }
+
+        /**
+         * @brief 指令 def 是否支配指令 user；同一块中按位置比较。user 是 PHI 时应改为判断 def 是否支配来源块
+         */
+        [[nodiscard]] bool dominates(const Instruction* def, const Instruction* user) const;
+
+        /**
+         * @brief 最近公共支配点，任一块不可达时返回 nullptr
+         */
+        [[nodiscard]] BasicBlock* findNearestCommonDominator(const BasicBlock* a, const BasicBlock* b) const;
+
+        /**
+         * @brief CFG 中新增了 from 到 to 的边之后调用；to 可以是新建的基本块
+         */
+        void insertEdge(BasicBlock* from, BasicBlock* to);
+
+        /**
+         * @brief CFG 中删除了 from 到 to 的一条边之后调用
+         */
+        void deleteEdge(BasicBlock* from, BasicBlock* to);
+
+        /**
+         * @brief splitEdge 在 from 和 to 之间插入 middle 之后调用，只需要常数时间
+         */
+        void splitEdge(BasicBlock* from, BasicBlock* middle, BasicBlock* to);
+
+        /**
+         * @brief splitPredecessors 把 predecessors 到 block 的边改接到新块 middle 之后调用，
+         * 逐条按加边、删边更新
+         */
+        void splitPredecessors(BasicBlock* block, BasicBlock* middle, std::span<BasicBlock* const> predecessors);
+
+        /**
+         * @brief 和从头计算的结果比较，用于检查增量更新，返回是否一致
+         */
+        [[nodiscard]] bool verify() const;
+
+    protected:
+        static constexpr uint32_t kNone = UINT32_MAX;
+
+        DominatorTree(const Function& function, bool post);
+
+    private:
+        friend class DominanceFrontier;
+
+        // 后支配树的 0 号节点是虚拟出口，基本块依次后移一位，新建的基本块不会改变已有节点的编号
+        [[nodiscard]] uint32_t node(const BasicBlock* block) const {
+            return block->getNumber() + (post ? 1 : 0);
+        }
+
+        [[nodiscard]] BasicBlock* block(uint32_t node) const;
+
+        [[nodiscard]] bool contains(uint32_t node) const {
+            return node < levels.size() && (node == root || idoms[node] != kNone);
+        }
+
+        /**
+         * @brief 本树方向上的后继/前驱：支配树就是 CFG 的边，后支配树是反向边加上虚拟出口
+         */
+        template <typename Visitor>
+        void forEachSuccessor(uint32_t node, Visitor&& visitor) const;
+
+        template <typename Visitor>
+        void forEachPredecessor(uint32_t node, Visitor&& visitor) const;
+
+        void resize();
+
+        /**
+         * @brief 从 start 出发，在 marks 等于 stamp 的节点上运行 Semi-NCA，把结果挂到 start 下面
+         * @return 被访问到的节点数（含 start）
+         */
+        uint32_t computeFrom(uint32_t start, uint32_t stamp);
+
+        void insertReachable(uint32_t from, uint32_t to);
+        void insertUnreachable(uint32_t from, uint32_t to);
+        void splitNode(uint32_t from, uint32_t middle, uint32_t to);
+
+        /**
+         * @brief 在 top 的子树中重新计算
+         * @return 子树中变得不可达的节点
+         */
+        std::vector<uint32_t> rebuildSubtree(uint32_t top);
+
+        void link(uint32_t child, uint32_t parent);
+        void unlink(uint32_t child);
+        void updateLevels(uint32_t top);
+
+        uint32_t nearestCommonDominator(uint32_t a, uint32_t b) const;
+        void computeDFSNumbers() const;
+
+        // 后支配树：判断各块能否到达出口，对到不了出口的区域（死循环）选一个块当作额外的根
+        void computeRoots();
+
+        const Function& function;
+        bool post;
+        uint32_t root = 0;
+        std::vector<uint32_t> idoms;
+        std::vector<uint32_t> levels;
+        std::vector<uint32_t> first_child;
+        std::vector<uint32_t> next_sibling;
+        std::vector<uint32_t> prev_sibling;
+
+        // 后支配树：直接连到虚拟出口的块，以及计算时各块是否以自己为出口
+        std::vector<uint32_t> roots;
+        std::vector<char> is_root;
+        std::vector<char> was_exit;
+        std::vector<char> reaches_exit;
+
+        // 增量更新和 Semi-NCA 共用的临时数组，按节点编号索引，用完只清掉访问过的项
+        std::vector<uint32_t> marks;
+        uint32_t mark_stamp = 0;
+        std::vector<uint32_t> dfs_number;
+
+        // 支配树上的 DFS 进出序号，dominates 用它做常数时间判断；增量更新之后延迟重算
+        mutable std::vector<uint32_t> dfs_in;
+        mutable std::vector<uint32_t> dfs_out;
+        mutable bool dfs_valid = false;
+        mutable uint32_t slow_queries = 0;
+    };
+
+    /**
+     * @brief 后支配树：在反向 CFG 上计算，根是连接所有出口（RET/ABORT）的虚拟出口
+     *
+     * 死循环中的块到不了出口，每个这样的区域选编号最大的块直接连到虚拟出口。
+     * 增量更新改变了出口集合或这些区域时退化为从头计算
+     */
+    class PostDominatorTree final : public DominatorTree {
+    public:
+        explicit PostDominatorTree(const Function& function) : DominatorTree(function, true) {}
+    };
+
+    /**
+     * @brief 支配边界，按 Cooper、Harvey 和 Kennedy 的方法从支配树直接得出
+     *
+     * 对每个有多个前驱的汇合块，从各前驱沿支配树向上走到汇合块的直接支配点为止，
+     * 途经的块的支配边界都包含它。建立在后支配树上时得到的是后支配边界，即控制依赖。
+     * 这是建立时的快照，支配树更新之后需要重新构造
+     */
+    class DominanceFrontier {
+    public:
+        explicit DominanceFrontier(const DominatorTree& tree);
+
+        [[nodiscard]] std::span<BasicBlock* const> getFrontier(const BasicBlock* block) const {
+            const auto& frontier = frontiers[block->getNumber()];
+            return {frontier.data(), frontier.size()};
+        }
+
+        /**
+         * @brief 迭代支配边界 DF+(blocks)，即在这些块中定义的变量需要放 PHI 的位置
+         */
+        [[nodiscard]] std::vector<BasicBlock*> getIteratedFrontier(std::span<BasicBlock* const> blocks) const;
+
+    private:
+        std::vector<std::vector<BasicBlock*>> frontiers;
+    };
+}
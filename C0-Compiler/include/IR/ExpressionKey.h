@@ -0,0 +1,46 @@
+//
+// Created by 陶子杨 on 25-12-15.
+//
+
+#pragma once
+
+#include "IR/IR.h"
+
+#include <cstdint>
+#include <functional>
+
+namespace CC::IR {
+
+    /**
+     * @brief 按 (操作码, 类型, 立即数, 操作数) 归并表达式的键。
+     * 可交换运算的操作数按地址排序，GT/GE 交换操作数写成 LT/LE，写法不同但值相同的表达式得到同一个键
+     */
+    struct ExpressionKey {
+        Opcode opcode;
+        Type type;
+        int64_t immediate;
+        Value* operands[2];
+
+        bool operator==(const ExpressionKey& other) const {
+            return opcode == other.opcode && type == other.type && immediate == other.immediate &&
+                   operands[0] == other.operands[0] && operands[1] == other.operands[1];
+        }
+    };
+
+    struct ExpressionKeyHash {
+        size_t operator()(const ExpressionKey& key) const {
+            size_t hash = std::hash<int64_t>()(key.immediate);
+            hash = hash * 31 + static_cast<size_t>(key.opcode) * 8 + static_cast<size_t>(key.type);
+            hash = hash * 31 + std::hash<const void*>()(key.operands[0]);
+            hash = hash * 31 + std::hash<const void*>()(key.operands[1]);
+            return hash;
+        }
+    };
+
+    /**
+     * @brief 是否是可以按键归并的表达式：算术、比较、地址计算、数组长度和 LOAD（至多两个操作数）
+     */
+    bool isExpression(const Instruction* instruction);
+
+    ExpressionKey makeExpressionKey(const Instruction* instruction);
+}
@@ -0,0 +1,698 @@
+//
+// Created by 陶子杨 on 25-12-10.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace CC::IR {
+
+    class BasicBlock;
+    class Function;
+    class Instruction;
+
+    /**
+     * @brief IR 值的类型。C0 的值都是标量，结构体只存在于堆上，通过指针访问
+     */
+    enum class Type : uint8_t {
+        VOID,
+        BOOL,
+        CHAR,
+        INT,   // 32 位有符号整数，运算按补码回绕
+        PTR,   // 指针、数组和字符串
+    };
+
+    /**
+     * @brief 类型在内存中的大小（字节）
+     */
+    size_t sizeOf(Type type);
+
+    const char* getTypeName(Type type);
+
+    enum class ValueKind : uint8_t {
+        CONSTANT,
+        UNDEF,        // 未初始化的变量，C0 程序中不应出现
+        STRING,       // 字符串字面量
+        ARGUMENT,
+        INSTRUCTION,
+    };
+
+    class Value;
+
+    /**
+     * @brief 指令对一个值的一次使用，同时是该值使用链表中的节点
+     *
+     * 链表是侵入式的：Use 就存放在使用者的操作数数组里，增删使用不需要额外分配
+     */
+    class Use {
+    public:
+        [[nodiscard]] Value* get() const {
+            return value;
+        }
+
+        [[nodiscard]] Instruction* getUser() const {
+            return user;
+        }
+
+        [[nodiscard]] Use* getNext() const {
+            return next;
+        }
+
+        /**
+         * @brief 改为使用另一个值，自动维护两边的使用链表
+         */
+        void set(Value* new_value);
+
+    private:
+        friend class Value;
+        friend class Instruction;
+
+        void link();
+        void unlink();
+
+        Value* value = nullptr;
+        Instruction* user = nullptr;
+        Use* next = nullptr;
+        Use** prev = nullptr;   ///< 指向前一个节点的 next（或值的链表头）
+    };
+
+    class Value {
+    public:
+        Value(const Value&) = delete;
+        Value& operator=(const Value&) = delete;
+
+        [[nodiscard]] ValueKind getKind() const {
+            return kind;
+        }
+
+        [[nodiscard]] Type getType() const {
+            return type;
+        }
+
+        [[nodiscard]] bool hasUses() const {
+            return use_head != nullptr;
+        }
+
+        [[nodiscard]] bool hasOneUse() const {
+            return use_head != nullptr && use_head->next == nullptr;
+        }
+
+        [[nodiscard]] size_t getUseCount() const;
+
+        /**
+         * @brief 使用链表的表头，用 Use::getNext 遍历；遍历时修改链表需要先取出 next
+         */
+        [[nodiscard]] Use* getFirstUse() const {
+            return use_head;
+        }
+
+        /**
+         * @brief 把所有对本值的使用改为使用 replacement
+         */
+        void replaceAllUsesWith(Value* replacement);
+
+    protected:
+        Value(ValueKind kind, Type type) : kind(kind), type(type) {}
+        ~Value() = default;
+
+    private:
+        friend class Use;
+
+        ValueKind kind;
+        Type type;
+        Use* use_head = nullptr;
+    };
+
+    // 整数、布尔、字符常量以及 NULL（PTR 类型的 0），同一个函数中按 (类型, 值) 唯一
+    class Constant : public Value {
+    public:
+        Constant(Type type, int32_t value) : Value(ValueKind::CONSTANT, type), value(value) {}
+
+        [[nodiscard]] int32_t getValue() const {
+            return value;
+        }
+
+        static bool classof(const Value* value) {
+            return value->getKind() == ValueKind::CONSTANT;
+        }
+
+    private:
+        int32_t value;
+    };
+
+    class Undef : public Value {
+    public:
+        explicit Undef(Type type) : Value(ValueKind::UNDEF, type) {}
+
+        static bool classof(const Value* value) {
+            return value->getKind() == ValueKind::UNDEF;
+        }
+    };
+
+    // 字符串字面量，内容复制在函数的内存池中
+    class StringConstant : public Value {
+    public:
+        explicit StringConstant(std::string_view text) : Value(ValueKind::STRING, Type::PTR), text(text) {}
+
+        [[nodiscard]] std::string_view getText() const {
+            return text;
+        }
+
+        static bool classof(const Value* value) {
+            return value->getKind() == ValueKind::STRING;
+        }
+
+    private:
+        std::string_view text;
+    };
+
+    class Argument : public Value {
+    public:
+        Argument(Type type, uint32_t index, std::string_view name)
+            : Value(ValueKind::ARGUMENT, type), index(index), name(name) {}
+
+        [[nodiscard]] uint32_t getIndex() const {
+            return index;
+        }
+
+        [[nodiscard]] std::string_view getName() const {
+            return name;
+        }
+
+        static bool classof(const Value* value) {
+            return value->getKind() == ValueKind::ARGUMENT;
+        }
+
+    private:
+        uint32_t index;
+        std::string_view name;
+    };
+
+    enum class Opcode : uint8_t {
+        // 整数运算，操作数和结果都是 INT
+        ADD, SUB, MUL,
+        MULH,              // 有符号 64 位乘积的高 32 位
+        DIV, MOD,          // 除数为 0 或 INT_MIN / -1 时中止程序；immediate 非 0 表示已证明不会中止
+        SHL, SHR,          // 算术右移；移位量不在 [0, 32) 内时中止程序
+        AND, OR, XOR,      // XOR 也用于 BOOL 取反
+        // 比较，结果是 BOOL
+        EQ, NE, LT, LE, GT, GE,
+        PHI,
+        // 内存
+        ALLOC,             // 在堆上分配 immediate 字节并清零
+        ALLOC_ARRAY,       // 分配 operand(0) 个 immediate 字节的元素，长度为负时中止程序
+        LOAD,              // 从 operand(0) 读取 type 类型的值，地址为 NULL 时中止程序
+        STORE,             // 把 operand(0) 写到 operand(1)
+        FIELD_ADDR,        // operand(0) + immediate
+        ELEMENT_ADDR,      // 数组 operand(0) 第 operand(1) 个元素的地址，越界时中止程序
+        ARRAY_LENGTH,      // 数组 operand(0) 的长度
+        CALL,              // immediate 非 0 表示尾调用
+        // 终结指令
+        BR,
+        COND_BR,           // operand(0) 为真跳到 successor(0)，否则跳到 successor(1)
+        RET,               // 没有操作数时返回 void
+        ABORT,             // 运行时检查失败，immediate 是 ContractKind
+    };
+
+    const char* getOpcodeName(Opcode opcode);
+
+    /**
+     * @brief 指令，从所属函数的内存池中分配
+     *
+     * 操作数是一个 Use 数组，PHI 还有一个并行的来源基本块数组；
+     * 跳转指令的目标不是操作数，单独存放在 successors 里
+     */
+    class Instruction : public Value {
+    public:
+        Instruction(Opcode opcode, Type type) : Value(ValueKind::INSTRUCTION, type), opcode(opcode) {}
+
+        [[nodiscard]] Opcode getOpcode() const {
+            return opcode;
+        }
+
+        [[nodiscard]] BasicBlock* getParent() const {
+            return parent;
+        }
+
+        [[nodiscard]] Instruction* getPrev() const {
+            return prev;
+        }
+
+        [[nodiscard]] Instruction* getNext() const {
+            return next;
+        }
+
+        [[nodiscard]] uint32_t getOperandCount() const {
+            return operand_count;
+        }
+
+        [[nodiscard]] Value* getOperand(uint32_t index) const {
+            return operands[index].get();
+        }
+
+        void setOperand(uint32_t index, Value* value) {
+            operands[index].set(value);
+        }
+
+        [[nodiscard]] Use& getOperandUse(uint32_t index) const {
+            return operands[index];
+        }
+
+        [[nodiscard]] int64_t getImmediate() const {
+            return immediate;
+        }
+
+        void setImmediate(int64_t value) {
+            immediate = value;
+        }
+
+        [[nodiscard]] Function* getCallee() const {
+            return callee;
+        }
+
+        void setCallee(Function* function) {
+            callee = function;
+        }
+
+        /**
+         * @brief 紧跟着返回它结果的 CALL，后端可以复用调用者的栈帧，把调用改成跳转。
+         * 由 tail-recursion 标记，把指令移到它和 RET 之间的变换要先清除标记
+         */
+        [[nodiscard]] bool isTailCall() const {
+            return opcode == Opcode::CALL && immediate != 0;
+        }
+
+        void setTailCall(bool value) {
+            immediate = value ? 1 : 0;
+        }
+
+        /**
+         * @brief 已经证明不会中止程序的 DIV 或 MOD：除数不为 0，也不会出现 INT_MIN / -1。
+         * 由 lower-division 根据支配它的条件和值域标记，只在原来的位置上成立，
+         * 后端可以省掉运行时检查
+         */
+        [[nodiscard]] bool isTrapFreeDivision() const {
+            return (opcode == Opcode::DIV || opcode == Opcode::MOD) && immediate != 0;
+        }
+
+        void setTrapFreeDivision(bool value) {
+            immediate = value ? 1 : 0;
+        }
+
+        // ---- 跳转目标 ----
+
+        [[nodiscard]] uint32_t getSuccessorCount() const;
+
+        [[nodiscard]] BasicBlock* getSuccessor(uint32_t index) const {
+            return successors[index];
+        }
+
+        /**
+         * @brief 修改跳转目标，同时维护新旧目标的前驱列表
+         */
+        void setSuccessor(uint32_t index, BasicBlock* block);
+
+        // ---- PHI ----
+
+        [[nodiscard]] BasicBlock* getIncomingBlock(uint32_t index) const {
+            return incoming[index];
+        }
+
+        void setIncomingBlock(uint32_t index, BasicBlock* block) {
+            incoming[index] = block;
+        }
+
+        /**
+         * @brief 来自 block 的值，没有这条边时返回 nullptr
+         */
+        [[nodiscard]] Value* getIncomingValueFor(const BasicBlock* block) const;
+
+        /**
+         * @brief 追加一个操作数，PHI 还要给出它来自哪个前驱
+         */
+        void addOperand(Value* value, BasicBlock* from = nullptr);
+
+        /**
+         * @brief 删除第 index 个操作数，后面的操作数前移
+         */
+        void removeOperand(uint32_t index);
+
+        /**
+         * @brief 断开所有操作数的使用，指令删除之前调用
+         */
+        void dropOperands();
+
+        // ---- 性质 ----
+
+        [[nodiscard]] bool isTerminator() const {
+            return opcode >= Opcode::BR;
+        }
+
+        [[nodiscard]] bool isPhi() const {
+            return opcode == Opcode::PHI;
+        }
+
+        [[nodiscard]] bool isBinary() const {
+            return opcode <= Opcode::XOR;
+        }
+
+        [[nodiscard]] bool isComparison() const {
+            return opcode >= Opcode::EQ && opcode <= Opcode::GE;
+        }
+
+        [[nodiscard]] bool isCommutative() const;
+
+        /**
+         * @brief 执行时是否可能中止程序（除零、越界、空指针等）。除数和移位量是不会出错的常量，
+         * 或者除法被标记为不会中止时返回 false
+         */
+        [[nodiscard]] bool mayTrap() const;
+
+        /**
+         * @brief 放到任何位置执行都不会中止程序。DIV、MOD、SHL、SHR 只看操作数，
+         * 不看 isTrapFreeDivision 的标记
+         */
+        [[nodiscard]] bool isSafeToSpeculate() const;
+
+        [[nodiscard]] bool mayReadMemory() const;
+
+        [[nodiscard]] bool mayWriteMemory() const;
+
+        /**
+         * @brief 结果没有被使用时能否直接删掉：不写内存、不会中止程序、不是终结指令
+         */
+        [[nodiscard]] bool isRemovableIfUnused() const;
+
+        /**
+         * @brief 从基本块中摘下并断开所有操作数，结果必须已经没有使用
+         */
+        void eraseFromParent();
+
+        /**
+         * @brief 函数内的稠密编号，由 Function::renumber 分配，供分析按下标建表
+         */
+        [[nodiscard]] uint32_t getNumber() const {
+            return number;
+        }
+
+        static bool classof(const Value* value) {
+            return value->getKind() == ValueKind::INSTRUCTION;
+        }
+
+    private:
+        friend class BasicBlock;
+        friend class Function;
+
+        void growOperands(uint32_t capacity);
+
+        Opcode opcode;
+        uint32_t number = 0;
+        Function* function = nullptr;        ///< 所属函数，操作数数组从它的内存池中分配
+        BasicBlock* parent = nullptr;
+        Instruction* prev = nullptr;
+        Instruction* next = nullptr;
+        Use* operands = nullptr;
+        uint32_t operand_count = 0;
+        uint32_t operand_capacity = 0;
+        BasicBlock** incoming = nullptr;     ///< PHI 各操作数的来源前驱
+        BasicBlock* successors[2] = {nullptr, nullptr};
+        int64_t immediate = 0;
+        Function* callee = nullptr;
+    };
+
+    /**
+     * @brief 基本块：侵入式双向链表组织的指令序列，最后一条是终结指令
+     *
+     * 前驱列表随终结指令的插入、修改和删除自动维护；
+     * 一个前驱用两条边（COND_BR 的两个目标相同）跳过来时会出现两次
+     */
+    class BasicBlock {
+    public:
+        explicit BasicBlock(Function* parent, std::pmr::memory_resource* resource)
+            : parent(parent), predecessors(resource) {}
+
+        [[nodiscard]] Function* getParent() const {
+            return parent;
+        }
+
+        [[nodiscard]] uint32_t getNumber() const {
+            return number;
+        }
+
+        [[nodiscard]] Instruction* front() const {
+            return first;
+        }
+
+        [[nodiscard]] Instruction* back() const {
+            return last;
+        }
+
+        [[nodiscard]] bool empty() const {
+            return first == nullptr;
+        }
+
+        /**
+         * @brief 最后一条指令是终结指令时返回它，否则返回 nullptr
+         */
+        [[nodiscard]] Instruction* getTerminator() const;
+
+        /**
+         * @brief 第一条不是 PHI 的指令
+         */
+        [[nodiscard]] Instruction* getFirstNonPhi() const;
+
+        [[nodiscard]] const std::pmr::vector<BasicBlock*>& getPredecessors() const {
+            return predecessors;
+        }
+
+        [[nodiscard]] uint32_t getSuccessorCount() const;
+
+        [[nodiscard]] BasicBlock* getSuccessor(uint32_t index) const;
+
+        /**
+         * @brief 在 before 之前插入，before 为空时追加到末尾
+         */
+        void insert(Instruction* instruction, Instruction* before);
+
+        void append(Instruction* instruction) {
+            insert(instruction, nullptr);
+        }
+
+        /**
+         * @brief 摘下指令但不断开它的操作数，用于在块之间移动指令
+         */
+        void remove(Instruction* instruction);
+
+        /**
+         * @brief predecessor 的一条边不再跳到本块时调用，删掉每个 PHI 中来自它的一个值
+         *
+         * 前驱列表本身由终结指令维护，这里不修改
+         */
+        void removePredecessor(BasicBlock* predecessor);
+
+        /**
+         * @brief 把前驱 from 换成 to（例如拆分边之后），PHI 的来源块一起替换
+         */
+        void replacePredecessor(BasicBlock* from, BasicBlock* to);
+
+        /**
+         * @brief 前驱列表中 predecessor 出现的次数
+         */
+        [[nodiscard]] size_t countPredecessor(const BasicBlock* predecessor) const;
+
+    private:
+        friend class Function;
+        friend class Instruction;
+
+        void addPredecessor(BasicBlock* predecessor) {
+            predecessors.push_back(predecessor);
+        }
+
+        void erasePredecessorEntry(BasicBlock* predecessor);
+
+        Function* parent;
+        uint32_t number = 0;
+        Instruction* first = nullptr;
+        Instruction* last = nullptr;
+        std::pmr::vector<BasicBlock*> predecessors;
+    };
+
+    /**
+     * @brief 函数：参数、基本块和它们使用的常量
+     *
+     * 指令、基本块和常量都分配在函数自己的单调内存池里，删除时只是摘下来，函数析构时整体释放。
+     * 这些对象都不持有需要析构的资源
+     */
+    class Function {
+    public:
+        Function(std::string name, Type return_type, const std::vector<Type>& parameter_types,
+                 const std::vector<std::string>& parameter_names);
+
+        Function(const Function&) = delete;
+        Function& operator=(const Function&) = delete;
+
+        [[nodiscard]] const std::string& getName() const {
+            return name;
+        }
+
+        [[nodiscard]] Type getReturnType() const {
+            return return_type;
+        }
+
+        [[nodiscard]] const std::vector<Argument*>& getArguments() const {
+            return arguments;
+        }
+
+        /**
+         * @brief 没有基本块的函数只是声明，例如库函数
+         */
+        [[nodiscard]] bool isDeclaration() const {
+            return blocks.empty();
+        }
+
+        [[nodiscard]] BasicBlock* getEntryBlock() const {
+            return blocks.front();
+        }
+
+        /**
+         * @brief 纯函数不读写内存、不分配内存，结果只取决于参数。可能中止程序或不终止，
+         * 所以只能合并被支配的重复调用，不能删掉没有用到的调用。由 function-attrs 推断
+         */
+        [[nodiscard]] bool isPure() const {
+            return pure;
+        }
+
+        void setPure(bool value) {
+            pure = value;
+        }
+
+        /**
+         * @brief 函数定义在源码中的字节偏移，报告和这个函数有关的问题时换算成行列号
+         */
+        [[nodiscard]] uint32_t getSourceOffset() const {
+            return source_offset;
+        }
+
+        void setSourceOffset(uint32_t offset) {
+            source_offset = offset;
+        }
+
+        /**
+         * @brief 基本块按布局顺序排列，第一个是入口
+         */
+        [[nodiscard]] const std::vector<BasicBlock*>& getBlocks() const {
+            return blocks;
+        }
+
+        BasicBlock* createBlock();
+
+        /**
+         * @brief 删除一个已经没有前驱的基本块，连同其中的指令
+         */
+        void eraseBlock(BasicBlock* block);
+
+        /**
+         * @brief 删除从入口出发不可达的基本块，返回删除的个数
+         */
+        size_t removeUnreachableBlocks();
+
+        /**
+         * @brief 按布局顺序重新给基本块和指令分配从 0 开始的稠密编号
+         */
+        void renumber();
+
+        /**
+         * @brief 指令编号的上界。新建的指令编号依次递增，删除指令后要 renumber 才重新变得稠密
+         */
+        [[nodiscard]] uint32_t getInstructionCount() const {
+            return instruction_count;
+        }
+
+        // ---- 值 ----
+
+        Constant* getConstant(Type type, int32_t value);
+
+        Constant* getBool(bool value) {
+            return getConstant(Type::BOOL, value ? 1 : 0);
+        }
+
+        Constant* getInt(int32_t value) {
+            return getConstant(Type::INT, value);
+        }
+
+        Undef* getUndef(Type type);
+
+        StringConstant* getString(std::string_view text);
+
+        /**
+         * @brief 在函数的内存池中构造对象
+         */
+        template <typename T, typename... Args>
+        T* create(Args&&... args) {
+            void* memory = arena.allocate(sizeof(T), alignof(T));
+            return new (memory) T(std::forward<Args>(args)...);
+        }
+
+        /**
+         * @brief 创建一条不属于任何基本块的指令
+         */
+        Instruction* createInstruction(Opcode opcode, Type type, std::initializer_list<Value*> operands = {});
+
+        [[nodiscard]] std::pmr::memory_resource* getMemoryResource() {
+            return &arena;
+        }
+
+    private:
+        friend class Instruction;
+
+        std::string name;
+        Type return_type;
+        std::pmr::monotonic_buffer_resource arena;
+        std::vector<Argument*> arguments;
+        std::vector<BasicBlock*> blocks;
+        uint32_t instruction_count = 0;
+        uint32_t source_offset = 0;
+        bool pure = false;
+        std::unordered_map<uint64_t, Constant*> constants;
+        Undef* undefs[5] = {};
+    };
+
+    /**
+     * @brief 一个编译单元的所有函数，包括只有声明的库函数
+     */
+    class Module {
+    public:
+        Function* getFunction(std::string_view name) const;
+
+        /**
+         * @brief 创建函数，同名函数已经存在时返回已有的
+         */
+        Function* getOrCreateFunction(const std::string& name, Type return_type,
+                                      const std::vector<Type>& parameter_types,
+                                      const std::vector<std::string>& parameter_names);
+
+        [[nodiscard]] const std::vector<std::unique_ptr<Function>>& getFunctions() const {
+            return functions;
+        }
+
+        /**
+         * @brief 删除函数，调用方要保证其他函数中已经没有对它的调用
+         */
+        void eraseFunction(Function* function);
+
+    private:
+        std::vector<std::unique_ptr<Function>> functions;
+        std::unordered_map<std::string, Function*> function_index;
+    };
+}
@@ -0,0 +1,86 @@
+//
+// Created by 陶子杨 on 25-12-10.
+//
+
+#pragma once
+
+#include "IR/IR.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace CC::IR {
+
+    /**
+     * @brief 在插入点创建指令
+     *
+     * 插入点是某个基本块的末尾，或者某条指令之前
+     */
+    class IRBuilder {
+    public:
+        explicit IRBuilder(Function& function) : function(function) {}
+
+        [[nodiscard]] Function& getFunction() const {
+            return function;
+        }
+
+        [[nodiscard]] BasicBlock* getInsertBlock() const {
+            return block;
+        }
+
+        void setInsertPoint(BasicBlock* insert_block) {
+            block = insert_block;
+            before = nullptr;
+        }
+
+        void setInsertPoint(Instruction* insert_before) {
+            block = insert_before->getParent();
+            before = insert_before;
+        }
+
+        /**
+         * @brief 插入块已经有终结指令，之后的指令不可达
+         */
+        [[nodiscard]] bool isTerminated() const {
+            return block == nullptr || (before == nullptr && block->getTerminator() != nullptr);
+        }
+
+        Instruction* createBinary(Opcode opcode, Value* left, Value* right);
+
+        /**
+         * @brief 比较两个同类型的值，结果是 BOOL
+         */
+        Instruction* createCompare(Opcode opcode, Value* left, Value* right);
+
+        /**
+         * @brief 布尔取反，用 XOR true 表示
+         */
+        Instruction* createNot(Value* operand);
+
+        /**
+         * @brief 在插入块的开头（已有的 PHI 之后）创建一个空的 PHI
+         */
+        Instruction* createPhi(Type type, BasicBlock* at);
+
+        Instruction* createAlloc(uint32_t size);
+        Instruction* createAllocArray(Value* count, uint32_t element_size);
+        Instruction* createLoad(Type type, Value* address);
+        Instruction* createStore(Value* value, Value* address);
+        Instruction* createFieldAddr(Value* base, uint32_t offset);
+        Instruction* createElementAddr(Value* array, Value* index, uint32_t element_size);
+        Instruction* createArrayLength(Value* array);
+        Instruction* createCall(Function* callee, const std::vector<Value*>& arguments);
+
+        Instruction* createBr(BasicBlock* target);
+        Instruction* createCondBr(Value* condition, BasicBlock* if_true, BasicBlock* if_false);
+        Instruction* createRet(Value* value);
+        Instruction* createAbort(int64_t reason);
+
+    private:
+        Instruction* insert(Instruction* instruction);
+
+        Function& function;
+        BasicBlock* block = nullptr;
+        Instruction* before = nullptr;
+    };
+}
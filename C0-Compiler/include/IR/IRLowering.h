@@ -0,0 +1,91 @@
+//
+// Created by 陶子杨 on 25-12-10.
+//
+
+#pragma once
+
+#include "AST/DeclarationNode.h"
+#include "AST/UnitNode.h"
+#include "CodeManager/CodeManager.h"
+#include "Compiler/GlobalDeclarations.h"
+#include "IR/IR.h"
+#include "IR/TypeTable.h"
+
+#include <memory>
+#include <vector>
+
+namespace CC::IR {
+
+    /**
+     * @brief 把函数定义的AST降低成 SSA 形式的 IR
+     *
+     * 局部变量在降低的同时提升为 SSA 值（Braun 等人的按需构造算法）：C0 没有取地址运算，
+     * 所有局部变量都可以提升，不需要先生成栈槽再做 mem2reg。每个基本块在所有前驱都确定之后"封闭"，
+     * 在未封闭的块中读取变量先放一个不完整的 PHI，封闭时再补上操作数；最后删掉所有平凡的 PHI
+     * 和不可达的基本块。读取变量和补 PHI 都用显式工作表，深层嵌套的控制流不会递归爆栈。
+     *
+     * 结构体按 TypeTable 的布局通过 FIELD_ADDR 访问。降低时顺带检查类型，出错的函数不生成 IR
+     */
+    class IRLowering {
+    public:
+        /**
+         * @param globals 结构体、类型别名、函数签名和引入的库，需覆盖被降低的函数用到的全部声明
+         * @param source 被降低的 AST 所在的源码，用来把节点上的字节偏移换算成诊断的行列号
+         */
+        IRLowering(Module& module, const GlobalDeclarations& globals, const CodeManager& source);
+
+        /**
+         * @brief 降低一个函数定义，出错时记录诊断信息并返回 nullptr
+         */
+        Function* lower(const FunctionDecl& decl);
+
+        /**
+         * @brief 按名字找到被调用的函数，没有定义的函数（包括库函数）创建为声明
+         * @return 找不到签名时返回 nullptr
+         */
+        Function* declare(std::string_view name);
+
+        /**
+         * @brief 函数签名中的返回类型，找不到时返回 nullptr
+         */
+        const C0Type* getReturnType(std::string_view name);
+
+        [[nodiscard]] TypeTable& getTypes() {
+            return types;
+        }
+
+        [[nodiscard]] Module& getModule() {
+            return module;
+        }
+
+        [[nodiscard]] const GlobalDeclarations& getGlobals() const {
+            return globals;
+        }
+
+        [[nodiscard]] const std::vector<Diagnostic>& getDiagnostics() const {
+            return diagnostics;
+        }
+
+        /**
+         * @param offset 出错的 AST 节点在源码中的字节偏移
+         */
+        void addDiagnostic(uint32_t offset, std::string message) {
+            diagnostics.push_back({source.getLocation(offset), std::move(message)});
+        }
+
+    private:
+        Module& module;
+        const GlobalDeclarations& globals;
+        const CodeManager& source;
+        TypeTable types;
+        std::vector<Diagnostic> diagnostics;
+    };
+
+    /**
+     * @brief 降低整个翻译单元中的函数定义，诊断信息追加到 diagnostics
+     * @param imported #use "文件" 引入的声明，其中的函数只取签名，不降低函数体
+     */
+    std::shared_ptr<Module> lowerTranslationUnit(const TranslationUnit& unit,
+                                                 const std::vector<std::shared_ptr<Declaration>>& imported,
+                                                 const CodeManager& source, std::vector<Diagnostic>& diagnostics);
+}
@@ -0,0 +1,26 @@
+//
+// Created by 陶子杨 on 25-12-10.
+//
+
+#pragma once
+
+#include "IR/IR.h"
+
+#include <ostream>
+
+namespace CC::IR {
+
+    /**
+     * @brief 以文本形式输出 IR，用于 --emit-ir 和调试
+     *
+     * 指令结果写作 %编号，基本块写作 bb编号，参数用源码中的名字
+     */
+    void print(const Function& function, std::ostream& out);
+
+    void print(const Module& module, std::ostream& out);
+
+    /**
+     * @brief 输出一个操作数的引用形式，例如 %3、42、true、null
+     */
+    void printOperand(const Value* value, std::ostream& out);
+}
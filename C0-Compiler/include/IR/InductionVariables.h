@@ -0,0 +1,85 @@
+//
+// Created by 陶子杨 on 25-12-16.
+//
+
+#pragma once
+
+#include "IR/LoopInfo.h"
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace CC::IR {
+
+    /**
+     * @brief 基本归纳变量：头结点中的 PHI，从前置块进来 start，从回边进来 phi ± step，
+     * 即第 k 次迭代开始时的值为 start ± k * step（32 位回绕）。step 是循环不变量
+     */
+    struct InductionVariable {
+        Instruction* phi;
+        Value* start;
+        Value* step;
+        Instruction* increment;   ///< 回边上的 phi + step 或 phi - step
+        bool negated;             ///< increment 是减法
+        const Loop* loop;
+
+        /**
+         * @brief 步长是常量时返回带符号的步长
+         */
+        [[nodiscard]] std::optional<int32_t> getConstantStep() const;
+    };
+
+    /**
+     * @brief 归纳变量在循环中（通过头结点的退出检查之后）的取值范围 [lower, upper]
+     */
+    struct InductionRange {
+        int64_t lower;
+        int64_t upper;
+    };
+
+    /**
+     * @brief 循环不变量：常量、参数，或者定义在循环外的指令
+     */
+    bool isLoopInvariant(const Loop* loop, const Value* value);
+
+    /**
+     * @brief 归纳变量分析，相当于只处理一阶仿射递推 {start, +, step} 的标量演化
+     *
+     * 只识别有前置块和唯一回边的循环。除了各循环的基本归纳变量，还给出常量的回边次数：
+     * 循环只有一个出口块，它是头结点或唯一的回边源，退出条件是归纳变量（或它的下一个值）
+     * 与常量比较，初值和步长也是常量。计算按 32 位补码进行，归纳变量在退出前会回绕时不给出结果
+     */
+    class InductionVariables {
+    public:
+        explicit InductionVariables(const LoopInfo& loops);
+
+        [[nodiscard]] const std::vector<InductionVariable>& getInductionVariables(const Loop* loop) const;
+
+        /**
+         * @brief phi 是基本归纳变量时返回它的描述
+         */
+        [[nodiscard]] const InductionVariable* getInductionVariable(const Instruction* phi) const;
+
+        /**
+         * @brief 回边被执行的次数，也就是循环体完整执行的次数；头结点执行的次数再多一次。
+         * 不能确定时返回 nullopt
+         */
+        [[nodiscard]] std::optional<uint32_t> getBackedgeTakenCount(const Loop* loop) const;
+
+        /**
+         * @brief 头结点用 phi 本身和界比较、成立时留在循环里，并且通过比较之后加上常量步长不会回绕时，
+         * phi 在循环中单调变化：一侧是初值，另一侧由比较给出（不是常量时取 INT 的边界）。
+         * 这样的循环一定会结束。不满足时返回 nullopt
+         */
+        [[nodiscard]] std::optional<InductionRange> getRangeInLoop(const Instruction* phi) const;
+
+    private:
+        std::optional<uint32_t> computeBackedgeTakenCount(const Loop* loop) const;
+
+        std::unordered_map<const Loop*, std::vector<InductionVariable>> variables;
+        std::unordered_map<const Instruction*, const InductionVariable*> by_phi;
+        std::unordered_map<const Loop*, std::optional<uint32_t>> backedge_taken;
+    };
+}
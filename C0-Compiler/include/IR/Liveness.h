@@ -0,0 +1,78 @@
+//
+// Created by 陶子杨 on 25-12-12.
+//
+
+#pragma once
+
+#include "IR/CFG.h"
+#include "Infra/BitVector.h"
+#include "Infra/SparseBitVector.h"
+
+#include <cstdint>
+#include <variant>
+#include <vector>
+
+namespace CC::IR {
+
+    /**
+     * @brief SSA 值的活跃性
+     *
+     * 跟踪有结果的指令和参数，编号为指令编号，参数排在所有指令之后，所以要求函数已经 renumber。
+     * PHI 的操作数算作在对应前驱末尾的使用，不在 PHI 所在块的入口活跃。
+     * 块数乘以值数不大时用稠密位集合；机器生成的大函数每块只有少数活跃值，改用稀疏位集合
+     */
+    class Liveness {
+    public:
+        explicit Liveness(const Function& function);
+
+        /**
+         * @brief 活跃性是否跟踪这个值：常量、字符串和 void 指令不跟踪
+         */
+        [[nodiscard]] static bool isTracked(const Value* value);
+
+        [[nodiscard]] uint32_t getValueIndex(const Value* value) const;
+
+        [[nodiscard]] Value* getValue(uint32_t index) const {
+            return values[index];
+        }
+
+        [[nodiscard]] bool isLiveIn(const Value* value, const BasicBlock* block) const;
+
+        [[nodiscard]] bool isLiveOut(const Value* value, const BasicBlock* block) const;
+
+        /**
+         * @brief 按编号从小到大访问在块入口活跃的值
+         */
+        template <typename Visitor>
+        void forEachLiveIn(const BasicBlock* block, Visitor&& visitor) const {
+            std::visit([&](const auto& sets) {
+                sets.live_in[block->getNumber()].forEach([&](size_t index) { visitor(values[index]); });
+            }, sets);
+        }
+
+        template <typename Visitor>
+        void forEachLiveOut(const BasicBlock* block, Visitor&& visitor) const {
+            std::visit([&](const auto& sets) {
+                sets.live_out[block->getNumber()].forEach([&](size_t index) { visitor(values[index]); });
+            }, sets);
+        }
+
+        [[nodiscard]] bool isSparse() const {
+            return sets.index() == 1;
+        }
+
+    private:
+        template <typename Set>
+        struct LiveSets {
+            std::vector<Set> live_in;
+            std::vector<Set> live_out;
+        };
+
+        template <typename Set>
+        LiveSets<Set> compute(const CFG& cfg) const;
+
+        uint32_t instruction_count;
+        std::vector<Value*> values;   ///< 编号到值，不跟踪的编号为 nullptr
+        std::variant<LiveSets<INFRA::BitVector>, LiveSets<INFRA::SparseBitVector>> sets;
+    };
+}
@@ -0,0 +1,147 @@
+//
+// Created by 陶子杨 on 25-12-15.
+//
+
+#pragma once
+
+#include "IR/Dominators.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace CC::IR {
+    class LoopInfo;
+
+    /**
+     * @brief 自然循环：由回边（源被目标支配）确定，头结点支配循环中所有的块
+     */
+    class Loop {
+    public:
+        [[nodiscard]] BasicBlock* getHeader() const {
+            return header;
+        }
+
+        /**
+         * @brief 直接外层循环，最外层的循环返回 nullptr
+         */
+        [[nodiscard]] Loop* getParent() const {
+            return parent;
+        }
+
+        [[nodiscard]] const std::vector<Loop*>& getSubLoops() const {
+            return sub_loops;
+        }
+
+        /**
+         * @brief 循环中的所有块，包括内层循环的，按支配树先序排列，头结点在最前面
+         */
+        [[nodiscard]] const std::vector<BasicBlock*>& getBlocks() const {
+            return blocks;
+        }
+
+        /**
+         * @brief 嵌套深度，最外层为 1
+         */
+        [[nodiscard]] uint32_t getDepth() const {
+            return depth;
+        }
+
+        [[nodiscard]] bool contains(const BasicBlock* block) const;
+
+        [[nodiscard]] bool contains(const Loop* loop) const {
+            while (loop != nullptr && loop->depth > depth) {
+                loop = loop->parent;
+            }
+            return loop == this;
+        }
+
+        /**
+         * @brief 循环外唯一的前驱，并且它只跳到头结点；不存在时返回 nullptr
+         */
+        [[nodiscard]] BasicBlock* getPreheader() const;
+
+        /**
+         * @brief 有回边跳到头结点的块
+         */
+        [[nodiscard]] std::vector<BasicBlock*> getLatches() const;
+
+        /**
+         * @brief 循环中有边跳出循环的块
+         */
+        [[nodiscard]] std::vector<BasicBlock*> getExitingBlocks() const;
+
+        /**
+         * @brief 循环外被循环中的块跳到的块，不重复
+         */
+        [[nodiscard]] std::vector<BasicBlock*> getExitBlocks() const;
+
+        /**
+         * @brief 每个出口块的前驱都在循环中
+         */
+        [[nodiscard]] bool hasDedicatedExits() const;
+
+    private:
+        friend class LoopInfo;
+
+        Loop(const LoopInfo& info, BasicBlock* header) : info(info), header(header) {}
+
+        const LoopInfo& info;
+        BasicBlock* header;
+        Loop* parent = nullptr;
+        std::vector<Loop*> sub_loops;
+        std::vector<BasicBlock*> blocks;
+        uint32_t depth = 1;
+    };
+
+    /**
+     * @brief 函数中所有自然循环组成的森林
+     *
+     * 按支配树先序的逆序处理每个有回边的块，逆着 CFG 从回边的源走回头结点，
+     * 遇到已经属于某个循环的块就把它最外层的循环挂到当前循环下面、直接跳到那个循环的头结点，
+     * 因此内层循环先于外层循环建立，每个块只被访问常数次。
+     * C0 的控制流都是结构化的，不会出现不可归约的循环
+     */
+    class LoopInfo {
+    public:
+        explicit LoopInfo(const DominatorTree& dominators);
+
+        LoopInfo(const LoopInfo&) = delete;
+        LoopInfo& operator=(const LoopInfo&) = delete;
+
+        /**
+         * @brief 包含 block 的最内层循环，不在任何循环中时返回 nullptr
+         */
+        [[nodiscard]] Loop* getLoopFor(const BasicBlock* block) const {
+            return block->getNumber() < loop_of.size() ? loop_of[block->getNumber()] : nullptr;
+        }
+
+        [[nodiscard]] uint32_t getLoopDepth(const BasicBlock* block) const {
+            Loop* loop = getLoopFor(block);
+            return loop == nullptr ? 0 : loop->getDepth();
+        }
+
+        [[nodiscard]] const std::vector<Loop*>& getTopLevelLoops() const {
+            return top_level;
+        }
+
+        /**
+         * @brief 所有循环，内层循环在外层之前
+         */
+        [[nodiscard]] std::vector<Loop*> getLoopsInnermostFirst() const;
+
+        [[nodiscard]] bool empty() const {
+            return loops.empty();
+        }
+
+        /**
+         * @brief 把新建的块加入 loop（以及它所有外层循环）的末尾，loop 为 nullptr 时只记录它不在循环中
+         */
+        void addBlock(BasicBlock* block, Loop* loop);
+
+    private:
+        std::vector<std::unique_ptr<Loop>> loops;
+        std::vector<Loop*> top_level;
+        std::vector<Loop*> loop_of;   ///< 按基本块编号
+    };
+}
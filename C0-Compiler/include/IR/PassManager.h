@@ -0,0 +1,400 @@
+//
+// Created by 陶子杨 on 25-12-13.
+//
+
+#pragma once
+
+#include "IR/AliasAnalysis.h"
+#include "IR/AvailableExpressions.h"
+#include "IR/CFG.h"
+#include "IR/ControlDependence.h"
+#include "IR/DependenceAnalysis.h"
+#include "IR/Dominators.h"
+#include "IR/InductionVariables.h"
+#include "IR/Liveness.h"
+#include "IR/LoopInfo.h"
+#include "IR/ReachingDefinitions.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace CC::IR {
+
+    /**
+     * @brief 分析管理器能缓存的分析
+     */
+    enum class AnalysisKind : uint8_t {
+        CFG,
+        DOMINATOR_TREE,
+        POST_DOMINATOR_TREE,
+        DOMINANCE_FRONTIER,
+        LIVENESS,
+        REACHING_DEFINITIONS,
+        AVAILABLE_EXPRESSIONS,
+        CONTROL_DEPENDENCE,
+        LOOPS,
+        INDUCTION_VARIABLES,
+        ALIAS_ANALYSIS,
+        DEPENDENCES,
+    };
+
+    constexpr size_t kAnalysisKindCount = 12;
+
+    const char* getAnalysisName(AnalysisKind kind);
+
+    /**
+     * @brief 一组分析，用于声明 pass 需要和保留哪些分析
+     */
+    class AnalysisSet {
+    public:
+        constexpr AnalysisSet() = default;
+
+        constexpr AnalysisSet(std::initializer_list<AnalysisKind> kinds) {
+            for (AnalysisKind kind : kinds) {
+                bits |= bit(kind);
+            }
+        }
+
+        static constexpr AnalysisSet all() {
+            AnalysisSet set;
+            set.bits = (1u << kAnalysisKindCount) - 1;
+            return set;
+        }
+
+        /**
+         * @brief 只取决于基本块和边的分析，不改动 CFG 的 pass 可以全部保留
+         */
+        static constexpr AnalysisSet cfgShape() {
+            return {AnalysisKind::CFG, AnalysisKind::DOMINATOR_TREE, AnalysisKind::POST_DOMINATOR_TREE,
+                    AnalysisKind::DOMINANCE_FRONTIER, AnalysisKind::CONTROL_DEPENDENCE, AnalysisKind::LOOPS};
+        }
+
+        [[nodiscard]] constexpr bool contains(AnalysisKind kind) const {
+            return (bits & bit(kind)) != 0;
+        }
+
+        [[nodiscard]] constexpr bool empty() const {
+            return bits == 0;
+        }
+
+        constexpr AnalysisSet operator|(AnalysisSet other) const {
+            AnalysisSet set;
+            set.bits = bits | other.bits;
+            return set;
+        }
+
+    private:
+        static constexpr uint32_t bit(AnalysisKind kind) {
+            return 1u << static_cast<uint32_t>(kind);
+        }
+
+        uint32_t bits = 0;
+    };
+
+    /**
+     * @brief 分析类型到 AnalysisKind 的映射，每种可缓存的分析特化一次。
+     * 分析用 T(Function&) 构造，支配边界、循环森林和控制依赖用缓存中的支配树或后支配树构造，
+     * 归纳变量用缓存中的循环森林构造
+     */
+    template <typename T>
+    struct AnalysisTraits;
+
+    template <>
+    struct AnalysisTraits<CFG> {
+        static constexpr AnalysisKind kind = AnalysisKind::CFG;
+    };
+
+    template <>
+    struct AnalysisTraits<DominatorTree> {
+        static constexpr AnalysisKind kind = AnalysisKind::DOMINATOR_TREE;
+    };
+
+    template <>
+    struct AnalysisTraits<PostDominatorTree> {
+        static constexpr AnalysisKind kind = AnalysisKind::POST_DOMINATOR_TREE;
+    };
+
+    template <>
+    struct AnalysisTraits<DominanceFrontier> {
+        static constexpr AnalysisKind kind = AnalysisKind::DOMINANCE_FRONTIER;
+    };
+
+    template <>
+    struct AnalysisTraits<Liveness> {
+        static constexpr AnalysisKind kind = AnalysisKind::LIVENESS;
+    };
+
+    template <>
+    struct AnalysisTraits<ReachingDefinitions> {
+        static constexpr AnalysisKind kind = AnalysisKind::REACHING_DEFINITIONS;
+    };
+
+    template <>
+    struct AnalysisTraits<AvailableExpressions> {
+        static constexpr AnalysisKind kind = AnalysisKind::AVAILABLE_EXPRESSIONS;
+    };
+
+    template <>
+    struct AnalysisTraits<ControlDependence> {
+        static constexpr AnalysisKind kind = AnalysisKind::CONTROL_DEPENDENCE;
+    };
+
+    template <>
+    struct AnalysisTraits<LoopInfo> {
+        static constexpr AnalysisKind kind = AnalysisKind::LOOPS;
+    };
+
+    template <>
+    struct AnalysisTraits<InductionVariables> {
+        static constexpr AnalysisKind kind = AnalysisKind::INDUCTION_VARIABLES;
+    };
+
+    template <>
+    struct AnalysisTraits<AliasAnalysis> {
+        static constexpr AnalysisKind kind = AnalysisKind::ALIAS_ANALYSIS;
+    };
+
+    template <>
+    struct AnalysisTraits<DependenceAnalysis> {
+        static constexpr AnalysisKind kind = AnalysisKind::DEPENDENCES;
+    };
+
+    struct AnalysisStats {
+        uint64_t computed = 0;        ///< 实际计算的次数
+        uint64_t hits = 0;            ///< 命中缓存的次数
+        double milliseconds = 0;      ///< 计算用时，包括其中用到的其他分析
+    };
+
+    /**
+     * @brief 按函数缓存分析结果
+     *
+     * 分析第一次被请求时计算，之后一直复用，直到修改了函数的 pass 没有声明保留它。
+     * 依赖指令编号的分析（活跃性、可用表达式）计算前要求函数已经 renumber，PassManager 在每个
+     * 修改了函数的 pass 之后负责重新编号
+     */
+    class AnalysisManager {
+    public:
+        template <typename T>
+        T& get(Function& function) {
+            constexpr size_t index = static_cast<size_t>(AnalysisTraits<T>::kind);
+            auto& slot = cache[&function][index];
+            AnalysisStats& entry = stats[index];
+            if (slot) {
+                ++entry.hits;
+                return *static_cast<T*>(slot.get());
+            }
+            auto start = std::chrono::steady_clock::now();
+            std::shared_ptr<T> result;
+            if constexpr (std::is_same_v<T, DominanceFrontier> || std::is_same_v<T, LoopInfo>) {
+                result = std::make_shared<T>(get<DominatorTree>(function));
+            } else if constexpr (std::is_same_v<T, InductionVariables>) {
+                result = std::make_shared<T>(get<LoopInfo>(function));
+            } else if constexpr (std::is_same_v<T, DependenceAnalysis>) {
+                result = std::make_shared<T>(function, get<InductionVariables>(function));
+            } else if constexpr (std::is_same_v<T, ControlDependence>) {
+                result = std::make_shared<T>(get<PostDominatorTree>(function));
+            } else {
+                result = std::make_shared<T>(function);
+            }
+            slot = result;
+            ++entry.computed;
+            entry.milliseconds +=
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            return *result;
+        }
+
+        /**
+         * @brief 已经缓存的结果，没有时返回 nullptr，不会触发计算
+         */
+        template <typename T>
+        T* getCached(const Function& function) const {
+            auto it = cache.find(&function);
+            if (it == cache.end()) {
+                return nullptr;
+            }
+            return static_cast<T*>(it->second[static_cast<size_t>(AnalysisTraits<T>::kind)].get());
+        }
+
+        /**
+         * @brief 按类别计算一个分析，用于预先准备 pass 声明需要的分析
+         */
+        void compute(Function& function, AnalysisKind kind);
+
+        /**
+         * @brief 函数被修改之后丢掉没有保留的分析
+         */
+        void invalidate(const Function& function, AnalysisSet preserved = {});
+
+        /**
+         * @brief 丢掉所有函数的缓存，例如模块级的 pass 修改或删除了函数之后
+         */
+        void clear();
+
+        [[nodiscard]] const AnalysisStats& getStats(AnalysisKind kind) const {
+            return stats[static_cast<size_t>(kind)];
+        }
+
+    private:
+        using Slots = std::array<std::shared_ptr<void>, kAnalysisKindCount>;
+
+        std::unordered_map<const Function*, Slots> cache;
+        std::array<AnalysisStats, kAnalysisKindCount> stats{};
+    };
+
+    /**
+     * @brief 优化 pass 的公共接口
+     *
+     * run 返回修改的次数，0 表示什么也没改，这时所有分析都保留；
+     * 否则 getPreserved 之外的分析全部作废
+     */
+    class Pass {
+    public:
+        virtual ~Pass() = default;
+
+        [[nodiscard]] virtual const char* getName() const = 0;
+
+        /**
+         * @brief 运行前由 PassManager 准备好的分析
+         */
+        [[nodiscard]] virtual AnalysisSet getRequired() const {
+            return {};
+        }
+
+        /**
+         * @brief 修改了函数之后仍然有效的分析，在 run 之后调用，可以取决于这次运行改了什么
+         */
+        [[nodiscard]] virtual AnalysisSet getPreserved() const {
+            return {};
+        }
+
+        [[nodiscard]] virtual bool isModulePass() const {
+            return false;
+        }
+
+        /**
+         * @brief 设置流水线中以 name<key=value;...> 给出的参数，不认识的参数返回 false
+         */
+        virtual bool setParameter(std::string_view, int64_t) {
+            return false;
+        }
+    };
+
+    /**
+     * @brief 逐个函数运行的 pass，只处理有函数体的函数
+     */
+    class FunctionPass : public Pass {
+    public:
+        virtual size_t run(Function& function, AnalysisManager& analyses) = 0;
+    };
+
+    /**
+     * @brief 需要看到整个模块的 pass，例如内联和删除无用函数。
+     * 修改之后所有函数的缓存都作废，getRequired 不起作用
+     */
+    class ModulePass : public Pass {
+    public:
+        virtual size_t run(Module& module, AnalysisManager& analyses) = 0;
+
+        [[nodiscard]] bool isModulePass() const final {
+            return true;
+        }
+    };
+
+    struct PassStats {
+        std::string name;
+        uint64_t runs = 0;            ///< 执行次数（函数 pass 每个函数算一次）
+        uint64_t changed_runs = 0;    ///< 有修改的执行次数
+        uint64_t changes = 0;         ///< pass 报告的修改总数
+        double milliseconds = 0;      ///< 不含预先准备分析的时间
+    };
+
+    struct PipelineStats {
+        std::vector<PassStats> passes;   ///< 按流水线顺序，同一个 pass 出现多次时分开统计
+        std::array<AnalysisStats, kAnalysisKindCount> analyses{};
+        double total_milliseconds = 0;
+        bool truncated = false;          ///< 执行次数达到上限，后面的 pass 没有执行
+    };
+
+    /**
+     * @brief 流水线发现的问题，位置是出问题的函数在源码中的字节偏移
+     */
+    struct PassDiagnostic {
+        uint32_t offset;
+        std::string message;
+    };
+
+    /**
+     * @brief 以"名称 次数 修改 用时"的表格输出统计
+     */
+    void printStatistics(const PipelineStats& stats, std::ostream& out);
+
+    /**
+     * @brief 按顺序运行一串 pass
+     *
+     * 相邻的函数 pass 编成一组，逐个函数跑完整组再处理下一个函数，分析的缓存在组内一直有效。
+     * 执行次数上限用于二分定位出问题的 pass：只执行前 N 次，之后的全部跳过
+     */
+    class PassManager {
+    public:
+        void addPass(std::unique_ptr<Pass> pass);
+
+        [[nodiscard]] bool empty() const {
+            return passes.empty();
+        }
+
+        /**
+         * @brief 最多执行多少次 pass，负数表示不限
+         */
+        void setExecutionLimit(int64_t limit) {
+            execution_limit = limit;
+        }
+
+        /**
+         * @brief 每个修改了函数的 pass 之后检查 IR，发现的问题带上 pass 名记入诊断
+         */
+        void setVerifyEach(bool enabled) {
+            verify_each = enabled;
+        }
+
+        /**
+         * @brief 运行整条流水线，返回修改总数
+         */
+        size_t run(Module& module);
+
+        [[nodiscard]] AnalysisManager& getAnalyses() {
+            return analyses;
+        }
+
+        [[nodiscard]] PipelineStats getStatistics() const;
+
+        [[nodiscard]] const std::vector<PassDiagnostic>& getDiagnostics() const {
+            return diagnostics;
+        }
+
+    private:
+        // 还能执行时计数并返回 true
+        bool consumeExecution();
+
+        size_t runFunctionPasses(Module& module, size_t begin, size_t end);
+        void afterChange(Function& function, const Pass& pass, size_t index);
+
+        std::vector<std::unique_ptr<Pass>> passes;
+        std::vector<PassStats> stats;
+        AnalysisManager analyses;
+        int64_t execution_limit = -1;
+        int64_t executions = 0;
+        bool truncated = false;
+        bool verify_each = false;
+        double total_milliseconds = 0;
+        std::vector<PassDiagnostic> diagnostics;
+    };
+}
@@ -0,0 +1,57 @@
+//
+// Created by 陶子杨 on 25-12-12.
+//
+
+#pragma once
+
+#include "IR/CFG.h"
+#include "Infra/SparseBitVector.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace CC::IR {
+
+    /**
+     * @brief 到达定值：每一点上可能还没有被覆盖的 STORE
+     *
+     * 局部变量已经提升成 SSA 值，剩下的定值只有堆上的写入。地址是同一个 SSA 值的 STORE
+     * 一定写同一个位置，后面的覆盖前面的；地址不同的写入可能重叠，不能互相注销，CALL 也不注销任何写入。
+     * 每一点能到达的 STORE 通常只有几条，集合用稀疏位集合
+     */
+    class ReachingDefinitions {
+    public:
+        explicit ReachingDefinitions(const Function& function);
+
+        [[nodiscard]] uint32_t getStoreCount() const {
+            return static_cast<uint32_t>(stores.size());
+        }
+
+        [[nodiscard]] Instruction* getStore(uint32_t index) const {
+            return stores[index];
+        }
+
+        /**
+         * @brief 在块入口可能到达的 STORE 编号
+         */
+        [[nodiscard]] const INFRA::SparseBitVector& getReachingIn(const BasicBlock* block) const {
+            return reaching_in[block->getNumber()];
+        }
+
+        [[nodiscard]] const INFRA::SparseBitVector& getReachingOut(const BasicBlock* block) const {
+            return reaching_out[block->getNumber()];
+        }
+
+        /**
+         * @brief 在 point 之前可能到达、地址恰好是 address 的 STORE
+         */
+        [[nodiscard]] std::vector<Instruction*> getReachingStores(const Instruction* point, const Value* address) const;
+
+    private:
+        std::vector<Instruction*> stores;
+        std::unordered_map<const Instruction*, uint32_t> store_index;
+        std::vector<INFRA::SparseBitVector> reaching_in;
+        std::vector<INFRA::SparseBitVector> reaching_out;
+    };
+}
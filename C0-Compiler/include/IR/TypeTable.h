@@ -0,0 +1,129 @@
+//
+// Created by 陶子杨 on 25-12-10.
+//
+
+#pragma once
+
+#include "Compiler/GlobalDeclarations.h"
+#include "IR/IR.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace CC::IR {
+
+    struct StructLayout;
+
+    /**
+     * @brief 源语言层面的 C0 类型，由 TypeTable 唯一创建，可以直接比较指针
+     */
+    struct C0Type {
+        enum class Kind : uint8_t {
+            VOID,
+            INT,
+            BOOL,
+            CHAR,
+            STRING,
+            POINTER,   // element 为空时是 NULL 的类型，可以赋给任何指针
+            ARRAY,
+            STRUCT,
+            OPAQUE,    // 从 #use "文件" 引入、只知道名字的类型别名，按指针处理
+        };
+
+        Kind kind;
+        const C0Type* element = nullptr;   ///< POINTER/ARRAY 的元素类型
+        StructLayout* layout = nullptr;    ///< STRUCT 的布局，首次使用时才计算
+        std::string spelling;              ///< 用于报错
+
+        [[nodiscard]] Type getIRType() const;
+
+        /**
+         * @brief 能否保存在变量中；结构体只能通过指针或数组元素访问
+         */
+        [[nodiscard]] bool isSmall() const {
+            return kind != Kind::STRUCT && kind != Kind::VOID;
+        }
+
+        [[nodiscard]] bool isPointerLike() const {
+            return kind == Kind::POINTER || kind == Kind::ARRAY || kind == Kind::STRING || kind == Kind::OPAQUE;
+        }
+    };
+
+    struct FieldLayout {
+        std::string name;
+        const C0Type* type;
+        uint32_t offset;
+    };
+
+    struct StructLayout {
+        std::string name;
+        std::vector<FieldLayout> fields;
+        uint32_t size = 0;
+        uint32_t align = 1;
+        bool defined = false;      ///< 找到了定义并且布局已经计算好
+        bool in_progress = false;  ///< 正在计算布局，用于发现直接包含自身的结构体
+
+        [[nodiscard]] const FieldLayout* findField(std::string_view field) const;
+    };
+
+    /**
+     * @brief 把声明中的类型字符串（"int*"、"struct s[]"、类型别名等）解析成 C0Type，并计算结构体布局
+     *
+     * 结构体按 C 的规则布局：成员按声明顺序排列、对齐到自身大小，整体对齐到最大的成员。
+     * 结构体类型的成员直接内嵌
+     */
+    class TypeTable {
+    public:
+        explicit TypeTable(const GlobalDeclarations& globals);
+
+        /**
+         * @brief 解析类型字符串，未知的类型返回 nullptr
+         */
+        const C0Type* resolve(std::string_view spelling);
+
+        const C0Type* getVoid() const { return void_type; }
+        const C0Type* getInt() const { return int_type; }
+        const C0Type* getBool() const { return bool_type; }
+        const C0Type* getChar() const { return char_type; }
+        const C0Type* getString() const { return string_type; }
+        const C0Type* getNull() const { return null_type; }
+
+        const C0Type* getPointer(const C0Type* element);
+        const C0Type* getArray(const C0Type* element);
+
+        /**
+         * @brief 计算结构体的布局，没有定义或者包含自身时返回 nullptr
+         */
+        const StructLayout* getLayout(const C0Type* type);
+
+        /**
+         * @brief 类型在内存中的大小，结构体没有定义时返回 0
+         */
+        uint32_t sizeOf(const C0Type* type);
+
+        uint32_t alignOf(const C0Type* type);
+
+    private:
+        C0Type* make(C0Type::Kind kind, std::string spelling);
+        const C0Type* resolveBase(std::string_view name, int depth);
+        const C0Type* resolve(std::string_view spelling, int depth);
+
+        const GlobalDeclarations& globals;
+        std::vector<std::unique_ptr<C0Type>> types;
+        std::vector<std::unique_ptr<StructLayout>> layouts;
+        std::unordered_map<std::string, const C0Type*> resolved;
+        std::unordered_map<std::string, C0Type*> structs;
+        std::unordered_map<const C0Type*, const C0Type*> pointers;
+        std::unordered_map<const C0Type*, const C0Type*> arrays;
+        const C0Type* void_type;
+        const C0Type* int_type;
+        const C0Type* bool_type;
+        const C0Type* char_type;
+        const C0Type* string_type;
+        const C0Type* null_type;
+    };
+}
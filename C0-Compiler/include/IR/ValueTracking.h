@@ -0,0 +1,16 @@
+//
+// Created by 陶子杨 on 25-12-15.
+//
+
+#pragma once
+
+#include "IR/IR.h"
+
+namespace CC::IR {
+
+    /**
+     * @brief 地址一定不是 NULL：新分配的内存、字符串常量以及由它们偏移得到的地址。
+     * ELEMENT_ADDR 能执行完说明下标没有越界，数组不可能是 NULL
+     */
+    bool isKnownNonNull(const Value* address);
+}
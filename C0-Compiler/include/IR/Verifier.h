@@ -0,0 +1,22 @@
+//
+// Created by 陶子杨 on 25-12-10.
+//
+
+#pragma once
+
+#include "IR/IR.h"
+
+#include <string>
+#include <vector>
+
+namespace CC::IR {
+
+    /**
+     * @brief 检查函数的结构是否完整，返回发现的问题，没有问题时为空
+     *
+     * 检查每个基本块恰好以一条终结指令结尾、PHI 都在块的开头且与前驱一一对应、
+     * 前驱列表与跳转指令一致、使用链表与操作数一致、操作数都属于本函数，
+     * 结构完整时再检查每个值的定义支配它的使用
+     */
+    std::vector<std::string> verify(const Function& function);
+}
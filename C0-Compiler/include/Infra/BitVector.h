@@ -0,0 +1,188 @@
+//
+// Created by 陶子杨 on 25-12-12.
+//
+
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace INFRA {
+
+    /**
+     * @brief 定长的稠密位集合
+     *
+     * 位存放在连续的 64 位字中，集合运算都是逐字的简单循环，编译器可以直接向量化。
+     * 最后一个字中超出 size 的位始终为 0
+     */
+    class BitVector {
+    public:
+        static constexpr size_t npos = SIZE_MAX;
+
+        BitVector() = default;
+
+        explicit BitVector(size_t size, bool value = false) : bits(size), words(wordCount(size), value ? ~0ULL : 0) {
+            clearUnusedBits();
+        }
+
+        [[nodiscard]] size_t size() const {
+            return bits;
+        }
+
+        void resize(size_t size, bool value = false) {
+            size_t old_bits = bits;
+            words.resize(wordCount(size), value ? ~0ULL : 0);
+            bits = size;
+            if (value && old_bits < size && old_bits % 64 != 0) {
+                words[old_bits / 64] |= ~0ULL << (old_bits % 64);
+            }
+            clearUnusedBits();
+        }
+
+        [[nodiscard]] bool test(size_t index) const {
+            assert(index < bits);
+            return (words[index / 64] >> (index % 64)) & 1;
+        }
+
+        void set(size_t index) {
+            assert(index < bits);
+            words[index / 64] |= 1ULL << (index % 64);
+        }
+
+        void reset(size_t index) {
+            assert(index < bits);
+            words[index / 64] &= ~(1ULL << (index % 64));
+        }
+
+        void setAll() {
+            for (uint64_t& word : words) {
+                word = ~0ULL;
+            }
+            clearUnusedBits();
+        }
+
+        void clear() {
+            for (uint64_t& word : words) {
+                word = 0;
+            }
+        }
+
+        [[nodiscard]] bool any() const {
+            for (uint64_t word : words) {
+                if (word != 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        [[nodiscard]] size_t count() const {
+            size_t total = 0;
+            for (uint64_t word : words) {
+                total += static_cast<size_t>(std::popcount(word));
+            }
+            return total;
+        }
+
+        /**
+         * @brief this |= other，返回是否有变化
+         */
+        bool unionWith(const BitVector& other) {
+            assert(other.bits == bits);
+            uint64_t changed = 0;
+            for (size_t i = 0; i < words.size(); ++i) {
+                uint64_t merged = words[i] | other.words[i];
+                changed |= merged ^ words[i];
+                words[i] = merged;
+            }
+            return changed != 0;
+        }
+
+        /**
+         * @brief this &= other，返回是否有变化
+         */
+        bool intersectWith(const BitVector& other) {
+            assert(other.bits == bits);
+            uint64_t changed = 0;
+            for (size_t i = 0; i < words.size(); ++i) {
+                uint64_t merged = words[i] & other.words[i];
+                changed |= merged ^ words[i];
+                words[i] = merged;
+            }
+            return changed != 0;
+        }
+
+        /**
+         * @brief this &= ~other
+         */
+        void subtract(const BitVector& other) {
+            assert(other.bits == bits);
+            for (size_t i = 0; i < words.size(); ++i) {
+                words[i] &= ~other.words[i];
+            }
+        }
+
+        /**
+         * @brief 数据流的传递函数 this = gen | (input & ~kill)，返回是否有变化
+         */
+        bool assignTransfer(const BitVector& gen, const BitVector& input, const BitVector& kill) {
+            assert(gen.bits == bits && input.bits == bits && kill.bits == bits);
+            uint64_t changed = 0;
+            for (size_t i = 0; i < words.size(); ++i) {
+                uint64_t result = gen.words[i] | (input.words[i] & ~kill.words[i]);
+                changed |= result ^ words[i];
+                words[i] = result;
+            }
+            return changed != 0;
+        }
+
+        /**
+         * @brief 第一个不小于 from 的置位下标，没有时返回 npos
+         */
+        [[nodiscard]] size_t findNext(size_t from) const {
+            if (from >= bits) {
+                return npos;
+            }
+            size_t index = from / 64;
+            uint64_t word = words[index] & (~0ULL << (from % 64));
+            while (word == 0) {
+                if (++index == words.size()) {
+                    return npos;
+                }
+                word = words[index];
+            }
+            return index * 64 + static_cast<size_t>(std::countr_zero(word));
+        }
+
+        /**
+         * @brief 按下标从小到大访问每个置位
+         */
+        template <typename Visitor>
+        void forEach(Visitor&& visitor) const {
+            for (size_t i = 0; i < words.size(); ++i) {
+                for (uint64_t word = words[i]; word != 0; word &= word - 1) {
+                    visitor(i * 64 + static_cast<size_t>(std::countr_zero(word)));
+                }
+            }
+        }
+
+        bool operator==(const BitVector& other) const = default;
+
+    private:
+        static size_t wordCount(size_t size) {
+            return (size + 63) / 64;
+        }
+
+        void clearUnusedBits() {
+            if (bits % 64 != 0) {
+                words.back() &= ~0ULL >> (64 - bits % 64);
+            }
+        }
+
+        size_t bits = 0;
+        std::vector<uint64_t> words;
+    };
+}
@@ -0,0 +1,54 @@
+//
+// Created by 陶子杨 on 25-12-5.
+//
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace INFRA {
+
+    /**
+     * @brief 监视一组文件的修改
+     *
+     * Linux 上用 inotify 监视文件所在的目录，这样编辑器“写临时文件再改名”的保存方式也能捕获；
+     * 其他平台退化为定时比较修改时间
+     */
+    class FileWatcher {
+    public:
+        FileWatcher();
+
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+        ~FileWatcher();
+
+        /**
+         * @brief 开始监视文件，重复添加没有影响
+         * @param file_path 规范化后的绝对路径
+         */
+        void watch(const std::string& file_path);
+
+        /**
+         * @brief 阻塞直到被监视的文件有变化，再等到 quiet_period 内没有新事件为止
+         * @return 变化过的文件，不重复
+         */
+        std::vector<std::string> waitForChanges(std::chrono::milliseconds quiet_period);
+
+    private:
+        /**
+         * @brief 等待最多 timeout 并收集这段时间内的变化，timeout 为负数时一直等待
+         */
+        void collect(std::chrono::milliseconds timeout, std::unordered_set<std::string>& changed);
+
+        int inotify_fd = -1;
+        std::unordered_map<int, std::string> directories;   ///< inotify watch 描述符 -> 目录
+        std::unordered_set<std::string> watched_directories;
+        std::unordered_set<std::string> files;
+        std::unordered_map<std::string, std::filesystem::file_time_type> modified_times;///< 没有 inotify 时使用
+    };
+}
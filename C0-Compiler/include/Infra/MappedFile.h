@@ -0,0 +1,55 @@
+//
+// Created by 陶子杨 on 25-11-26.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace INFRA {
+
+    /**
+     * @brief 只读地映射整个文件
+     *
+     * 支持 mmap 的平台上文件内容由页缓存提供，不占用进程的私有内存，
+     * 多个进程/编译任务映射同一文件时共享物理页；其余平台退化为一次性读入
+     */
+    class MappedFile {
+    public:
+        MappedFile() = default;
+
+        /**
+         * @brief 映射文件，失败时抛出 std::runtime_error
+         */
+        explicit MappedFile(const std::string& file_path);
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        ~MappedFile();
+
+        [[nodiscard]] std::string_view getText() const {
+            return {data, size};
+        }
+
+        [[nodiscard]] const char* getData() const {
+            return data;
+        }
+
+        [[nodiscard]] size_t getSize() const {
+            return size;
+        }
+
+    private:
+        void reset();
+
+        const char* data = nullptr;
+        size_t size = 0;
+        bool mapped = false;           ///< data 是否来自 mmap
+        std::vector<char> fallback;    ///< 不支持 mmap 时的文件内容
+    };
+}
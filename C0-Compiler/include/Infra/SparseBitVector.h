@@ -0,0 +1,202 @@
+//
+// Created by 陶子杨 on 25-12-12.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace INFRA {
+
+    /**
+     * @brief 稀疏的位集合：只保存非零的 64 位字，按字的下标排序
+     *
+     * 接口和 BitVector 相同，可以互换地用在数据流分析中。元素很少而全集很大时
+     * （例如十万个基本块、每块只有几个活跃值），内存和集合运算都只和实际元素数成正比。
+     * 没有全集的概念，不适合以全集为初值的交汇问题
+     */
+    class SparseBitVector {
+    public:
+        SparseBitVector() = default;
+
+        /**
+         * @brief 与 BitVector 保持相同的构造方式；稀疏集合不需要知道全集大小
+         */
+        explicit SparseBitVector(size_t /*size*/) {}
+
+        [[nodiscard]] bool test(size_t index) const {
+            auto it = find(index / 64);
+            return it != chunks.end() && it->index == index / 64 && ((it->bits >> (index % 64)) & 1);
+        }
+
+        void set(size_t index) {
+            auto key = static_cast<uint32_t>(index / 64);
+            auto it = find(key);
+            if (it == chunks.end() || it->index != key) {
+                it = chunks.insert(it, {key, 0});
+            }
+            it->bits |= 1ULL << (index % 64);
+        }
+
+        void reset(size_t index) {
+            auto key = static_cast<uint32_t>(index / 64);
+            auto it = find(key);
+            if (it != chunks.end() && it->index == key) {
+                it->bits &= ~(1ULL << (index % 64));
+                if (it->bits == 0) {
+                    chunks.erase(it);
+                }
+            }
+        }
+
+        void clear() {
+            chunks.clear();
+        }
+
+        [[nodiscard]] bool any() const {
+            return !chunks.empty();
+        }
+
+        [[nodiscard]] size_t count() const {
+            size_t total = 0;
+            for (const Chunk& chunk : chunks) {
+                total += static_cast<size_t>(std::popcount(chunk.bits));
+            }
+            return total;
+        }
+
+        /**
+         * @brief this |= other，返回是否有变化
+         */
+        bool unionWith(const SparseBitVector& other) {
+            if (other.chunks.empty()) {
+                return false;
+            }
+            std::vector<Chunk> merged;
+            merged.reserve(chunks.size() + other.chunks.size());
+            bool changed = false;
+            size_t i = 0;
+            size_t j = 0;
+            while (i < chunks.size() || j < other.chunks.size()) {
+                if (j == other.chunks.size() || (i < chunks.size() && chunks[i].index < other.chunks[j].index)) {
+                    merged.push_back(chunks[i++]);
+                } else if (i == chunks.size() || other.chunks[j].index < chunks[i].index) {
+                    merged.push_back(other.chunks[j++]);
+                    changed = true;
+                } else {
+                    uint64_t bits = chunks[i].bits | other.chunks[j].bits;
+                    changed |= bits != chunks[i].bits;
+                    merged.push_back({chunks[i].index, bits});
+                    ++i;
+                    ++j;
+                }
+            }
+            if (changed) {
+                chunks = std::move(merged);
+            }
+            return changed;
+        }
+
+        /**
+         * @brief this &= other，返回是否有变化
+         */
+        bool intersectWith(const SparseBitVector& other) {
+            size_t out = 0;
+            size_t j = 0;
+            bool changed = false;
+            for (size_t i = 0; i < chunks.size(); ++i) {
+                while (j < other.chunks.size() && other.chunks[j].index < chunks[i].index) {
+                    ++j;
+                }
+                uint64_t bits = 0;
+                if (j < other.chunks.size() && other.chunks[j].index == chunks[i].index) {
+                    bits = chunks[i].bits & other.chunks[j].bits;
+                }
+                changed |= bits != chunks[i].bits;
+                if (bits != 0) {
+                    chunks[out++] = {chunks[i].index, bits};
+                }
+            }
+            chunks.resize(out);
+            return changed;
+        }
+
+        /**
+         * @brief this &= ~other
+         */
+        void subtract(const SparseBitVector& other) {
+            size_t out = 0;
+            size_t j = 0;
+            for (size_t i = 0; i < chunks.size(); ++i) {
+                while (j < other.chunks.size() && other.chunks[j].index < chunks[i].index) {
+                    ++j;
+                }
+                uint64_t bits = chunks[i].bits;
+                if (j < other.chunks.size() && other.chunks[j].index == chunks[i].index) {
+                    bits &= ~other.chunks[j].bits;
+                }
+                if (bits != 0) {
+                    chunks[out++] = {chunks[i].index, bits};
+                }
+            }
+            chunks.resize(out);
+        }
+
+        /**
+         * @brief 数据流的传递函数 this = gen | (input & ~kill)，返回是否有变化
+         */
+        bool assignTransfer(const SparseBitVector& gen, const SparseBitVector& input, const SparseBitVector& kill) {
+            SparseBitVector result = input;
+            result.subtract(kill);
+            result.unionWith(gen);
+            if (result == *this) {
+                return false;
+            }
+            chunks = std::move(result.chunks);
+            return true;
+        }
+
+        template <typename Visitor>
+        void forEach(Visitor&& visitor) const {
+            for (const Chunk& chunk : chunks) {
+                for (uint64_t word = chunk.bits; word != 0; word &= word - 1) {
+                    visitor(static_cast<size_t>(chunk.index) * 64 + static_cast<size_t>(std::countr_zero(word)));
+                }
+            }
+        }
+
+        bool operator==(const SparseBitVector& other) const {
+            if (chunks.size() != other.chunks.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < chunks.size(); ++i) {
+                if (chunks[i].index != other.chunks[i].index || chunks[i].bits != other.chunks[i].bits) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+        struct Chunk {
+            uint32_t index;   ///< 字的下标，即元素下标 / 64
+            uint64_t bits;
+        };
+
+        [[nodiscard]] std::vector<Chunk>::iterator find(size_t key) {
+            return std::lower_bound(chunks.begin(), chunks.end(), key,
+                                    [](const Chunk& chunk, size_t value) { return chunk.index < value; });
+        }
+
+        [[nodiscard]] std::vector<Chunk>::const_iterator find(size_t key) const {
+            return std::lower_bound(chunks.begin(), chunks.end(), key,
+                                    [](const Chunk& chunk, size_t value) { return chunk.index < value; });
+        }
+
+        std::vector<Chunk> chunks;
+    };
+}
@@ -0,0 +1,81 @@
+//
+// Created by 陶子杨 on 25-12-12.
+//
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace INFRA {
+
+    /**
+     * @brief Briggs 和 Torczon 的稀疏集合：全集为 [0, universe) 的无符号整数
+     *
+     * dense 按插入顺序存放元素，sparse 记录每个元素在 dense 中的位置。插入、删除、查询和清空
+     * 都是常数时间，清空不需要遍历全集，适合在大函数中逐块反复使用的临时集合
+     */
+    class SparseSet {
+    public:
+        explicit SparseSet(uint32_t universe = 0) : sparse(universe, 0) {}
+
+        void setUniverse(uint32_t universe) {
+            sparse.assign(universe, 0);
+            dense.clear();
+        }
+
+        [[nodiscard]] bool contains(uint32_t value) const {
+            assert(value < sparse.size());
+            uint32_t position = sparse[value];
+            return position < dense.size() && dense[position] == value;
+        }
+
+        /**
+         * @brief 返回是否新插入
+         */
+        bool insert(uint32_t value) {
+            if (contains(value)) {
+                return false;
+            }
+            sparse[value] = static_cast<uint32_t>(dense.size());
+            dense.push_back(value);
+            return true;
+        }
+
+        void erase(uint32_t value) {
+            if (!contains(value)) {
+                return;
+            }
+            uint32_t position = sparse[value];
+            uint32_t last = dense.back();
+            dense[position] = last;
+            sparse[last] = position;
+            dense.pop_back();
+        }
+
+        void clear() {
+            dense.clear();
+        }
+
+        [[nodiscard]] bool empty() const {
+            return dense.empty();
+        }
+
+        [[nodiscard]] size_t size() const {
+            return dense.size();
+        }
+
+        [[nodiscard]] std::vector<uint32_t>::const_iterator begin() const {
+            return dense.begin();
+        }
+
+        [[nodiscard]] std::vector<uint32_t>::const_iterator end() const {
+            return dense.end();
+        }
+
+    private:
+        std::vector<uint32_t> sparse;
+        std::vector<uint32_t> dense;
+    };
+}
@@ -4,24 +4,63 @@
 #pragma once
 
 #include "Lexer/Lexer.h"
+#include "Lexer/LanguageLevel.h"
 
-#include <unordered_map>
+#include <string_view>
 
 namespace CC {
-    class C0Lexer : public Lexer<C0Lexer> {
+    /**
+     * @brief 按语言层级 Lang 裁剪的 C0 词法分析器
+     *
+     * 关键字表在编译期按 Lang 过滤，关闭的特性（字符串、数组下标等）不会生成对应的分支
+     */
+    template <typename Lang>
+    class BasicC0Lexer : public Lexer<BasicC0Lexer<Lang>> {
+        using Base = Lexer<BasicC0Lexer<Lang>>;
     public:
-        explicit C0Lexer(const std::string& file_path) ;
+        explicit BasicC0Lexer(const std::string& file_path) ;
+
+        /**
+         * @brief 分析内存中的源码
+         * @param name 源码的名字，用于报错
+         * @param source 源码文本，需在词法分析器存活期间保持有效
+         */
+        BasicC0Lexer(std::string name, std::string_view source);
 
         Token nextToken();
     private:
-        static std::unordered_map<std::string, TokenType> keywords;
-
-        static bool isKeyword(const std::string& word);
+        using Base::code_manager;
 
         Token readKeywordOrIdentifier();
 
         Token readOperator();
 
         Token readDelimiter();
+
+        /**
+         * @brief 读取 #use <库名> 或 #use "文件名"，其余以 '#' 开头的内容都是 UNKNOWN
+         */
+        Token readDirective();
+
+        /**
+         * @brief 读取注解中的 \\result 或 \\length，其余以 '\\' 开头的内容都是 UNKNOWN
+         */
+        Token readAnnotationKeyword();
+
+        // 当前是否处于规约注解内部，以及注解以什么结束
+        enum class AnnotationState : uint8_t {
+            NONE,   // 不在注解中
+            LINE,   // //@ ... 到行尾结束
+            BLOCK,  // /*@ ... @*/
+        };
+        AnnotationState annotation = AnnotationState::NONE;
     };
-}
\ No newline at end of file
+
+    using C0Lexer = BasicC0Lexer<LangC0>;
+
+    extern template class BasicC0Lexer<LangL1>;
+    extern template class BasicC0Lexer<LangL2>;
+    extern template class BasicC0Lexer<LangL3>;
+    extern template class BasicC0Lexer<LangL4>;
+    extern template class BasicC0Lexer<LangC0>;
+}
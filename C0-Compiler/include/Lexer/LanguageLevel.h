@@ -0,0 +1,59 @@
+//
+// Created by 陶子杨 on 25-11-28.
+//
+
+#pragma once
+
+#include <cstdint>
+
+namespace CC {
+
+    /**
+     * @brief 语言层级的运行时标识，用于在编译选项中选择对应的词法/语法分析器实例
+     */
+    enum class LanguageLevel : uint8_t {
+        L1,   // 整数、赋值、return 的直线代码
+        L2,   // + 布尔、比较/逻辑/位运算、if/while/for、?:
+        L3,   // + void、typedef、多个函数
+        L4,   // + 结构体、指针、数组
+        C0,   // + char、string、#use、//@ 规约注解，完整的 C0
+    };
+
+    // 各层级的编译期特性开关。关闭的特性在词法/语法分析器中以 if constexpr 整段编译掉，
+    // 关键字表和运算符表也只包含开启的部分
+    struct LangL1 {
+        static constexpr LanguageLevel level = LanguageLevel::L1;
+        static constexpr bool control_flow = false;
+        static constexpr bool functions = false;
+        static constexpr bool structs = false;
+        static constexpr bool pointers = false;
+        static constexpr bool arrays = false;
+        static constexpr bool strings = false;
+        static constexpr bool libraries = false;   // #use 指令
+        static constexpr bool contracts = false;   // //@requires 等规约注解，关闭时只是普通注释
+    };
+
+    struct LangL2 : LangL1 {
+        static constexpr LanguageLevel level = LanguageLevel::L2;
+        static constexpr bool control_flow = true;
+    };
+
+    struct LangL3 : LangL2 {
+        static constexpr LanguageLevel level = LanguageLevel::L3;
+        static constexpr bool functions = true;
+    };
+
+    struct LangL4 : LangL3 {
+        static constexpr LanguageLevel level = LanguageLevel::L4;
+        static constexpr bool structs = true;
+        static constexpr bool pointers = true;
+        static constexpr bool arrays = true;
+    };
+
+    struct LangC0 : LangL4 {
+        static constexpr LanguageLevel level = LanguageLevel::C0;
+        static constexpr bool strings = true;
+        static constexpr bool libraries = true;
+        static constexpr bool contracts = true;
+    };
+}
@@ -5,12 +5,18 @@
 #pragma once
 
 #include "CodeManager/CodeManager.h"
+#include "Lexer/LanguageLevel.h"
 
+#include <bit>
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <memory>
+#include <vector>
 
 namespace CC {
-    enum class TokenType {
+    enum class TokenType : uint8_t {
         // 关键字
         KW_INT, KW_BOOL, KW_VOID, KW_IF, KW_ELSE, KW_WHILE,
         KW_RETURN, KW_TRUE, KW_FALSE, KW_STRUCT, KW_TYPEDEF,
@@ -27,33 +33,106 @@ namespace CC {
         OP_PLUS, OP_MINUS, OP_MULTIPLY, OP_DIVIDE, OP_MODULO,
         OP_ASSIGN, OP_EQ, OP_NE, OP_LT, OP_GT, OP_LE, OP_GE,
         OP_AND, OP_OR, OP_NOT, OP_XOR,
+        OP_BIT_NOT, OP_SHL, OP_SHR, OP_INCREMENT, OP_DECREMENT, OP_ARROW,
 
         // 复合赋值运算符
         OP_PLUS_ASSIGN, OP_MINUS_ASSIGN, OP_MULTIPLY_ASSIGN,
         OP_DIVIDE_ASSIGN, OP_MODULO_ASSIGN,
+        OP_AND_ASSIGN, OP_OR_ASSIGN, OP_XOR_ASSIGN, OP_SHL_ASSIGN, OP_SHR_ASSIGN,
         // 逻辑运算符
         OP_LOGICAL_AND, OP_LOGICAL_OR,
 
         // 分隔符
         SEMICOLON, COMMA, DOT,
-        LPAREN, RPAREN, LBRACE, RBRACE,
+        LPAREN, RPAREN, LBRACE, RBRACE, LBRACKET, RBRACKET,
+        QUESTION, COLON,
+
+        // 编译指令，token 的范围只覆盖 <> 或 "" 里的名字
+        USE_LIBRARY, USE_FILE,
+
+        // 规约注解：//@ 或 /*@ 开始，行尾或 @*/ 结束；其中的关键字只在注解内部有效
+        ANNOT_BEGIN, ANNOT_END,
+        KW_REQUIRES, KW_ENSURES, KW_LOOP_INVARIANT, KW_ASSERT,
+        KW_RESULT, KW_LENGTH,  // \result、\length
 
         // 特殊符号
         END_OF_FILE, UNKNOWN,
     };
 
+    /**
+     * @brief UNKNOWN token 的 payload：词法错误的原因，报错时据此给出具体的信息
+     */
+    enum class LexError : uint32_t {
+        UNRECOGNIZED,          // 不能开始任何 token 的字符
+        INTEGER_OUT_OF_RANGE,  // 整数字面量超出 C0 的范围
+    };
+
+    /**
+     * @brief 词法单元，固定 16 字节
+     *
+     * 词素不再单独保存，需要时通过 offset/length 回到源码缓冲区中取；
+     * 字面量的值由词法分析器一次性算好放在 payload 里
+     */
     struct Token {
         TokenType type;
-        std::string lexeme;      // 原始的字符串
-        Location location;
-
-        // 对于字面量，存储解析后的值
-        union {
-            int int_value;
-            bool bool_value;
-        };
+        uint32_t offset;   // 词素在源码中的起始字节偏移
+        uint32_t length;   // 词素的字节长度
+        uint32_t payload;  // INT_LITERAL/CHAR_LITERAL: 字面量的值；STRING_LITERAL: 字符串表下标；UNKNOWN: LexError
+
+        [[nodiscard]] int32_t intValue() const {
+            return static_cast<int32_t>(payload);
+        }
+
+        [[nodiscard]] char charValue() const {
+            return static_cast<char>(payload);
+        }
     };
 
+    static_assert(sizeof(Token) == 16, "Token 应保持 16 字节，便于解析器预读时的缓存命中");
+
+    /**
+     * @brief 某种 token 在语言层级 Lang 中是否存在，关闭的特性对应的 token 一律按 UNKNOWN 处理
+     */
+    template <typename Lang>
+    constexpr bool isTokenEnabled(TokenType type) {
+        switch (type) {
+        case TokenType::KW_BOOL: case TokenType::KW_TRUE: case TokenType::KW_FALSE:
+        case TokenType::KW_IF: case TokenType::KW_ELSE: case TokenType::KW_WHILE:
+        case TokenType::KW_FOR: case TokenType::KW_CONTINUE: case TokenType::KW_BREAK:
+        case TokenType::KW_DO:
+        case TokenType::OP_EQ: case TokenType::OP_NE: case TokenType::OP_LT:
+        case TokenType::OP_GT: case TokenType::OP_LE: case TokenType::OP_GE:
+        case TokenType::OP_AND: case TokenType::OP_OR: case TokenType::OP_NOT:
+        case TokenType::OP_XOR: case TokenType::OP_BIT_NOT: case TokenType::OP_SHL:
+        case TokenType::OP_SHR: case TokenType::OP_INCREMENT: case TokenType::OP_DECREMENT:
+        case TokenType::OP_AND_ASSIGN: case TokenType::OP_OR_ASSIGN: case TokenType::OP_XOR_ASSIGN:
+        case TokenType::OP_SHL_ASSIGN: case TokenType::OP_SHR_ASSIGN:
+        case TokenType::OP_LOGICAL_AND: case TokenType::OP_LOGICAL_OR:
+        case TokenType::QUESTION: case TokenType::COLON:
+            return Lang::control_flow;
+        case TokenType::KW_VOID: case TokenType::KW_TYPEDEF:
+            return Lang::functions;
+        case TokenType::KW_STRUCT: case TokenType::DOT:
+            return Lang::structs;
+        case TokenType::KW_NULL: case TokenType::KW_ALLOC: case TokenType::OP_ARROW:
+            return Lang::pointers;
+        case TokenType::KW_ALLOC_ARRAY: case TokenType::LBRACKET: case TokenType::RBRACKET:
+            return Lang::arrays;
+        case TokenType::KW_CHAR: case TokenType::KW_STRING:
+        case TokenType::STRING_LITERAL: case TokenType::CHAR_LITERAL:
+            return Lang::strings;
+        case TokenType::USE_LIBRARY: case TokenType::USE_FILE:
+            return Lang::libraries;
+        case TokenType::ANNOT_BEGIN: case TokenType::ANNOT_END:
+        case TokenType::KW_REQUIRES: case TokenType::KW_ENSURES:
+        case TokenType::KW_LOOP_INVARIANT: case TokenType::KW_ASSERT:
+        case TokenType::KW_RESULT: case TokenType::KW_LENGTH:
+            return Lang::contracts;
+        default:
+            return true;
+        }
+    }
+
     template<typename Derived>
     class Lexer {
     public:
@@ -61,10 +140,53 @@ namespace CC {
             return static_cast<Derived*>(this)->nextToken();
         }
 
+        /**
+         * @brief 取出 token 在源码中的原始文本
+         */
+        [[nodiscard]] std::string_view getLexeme(const Token& token) const {
+            return code_manager->getText(token.offset, token.length);
+        }
+
+        /**
+         * @brief token 起始位置的行列号，只在报错等确实需要时才计算
+         */
+        [[nodiscard]] Location getLocation(const Token& token) const {
+            return code_manager->getLocation(token.offset);
+        }
+
+        /**
+         * @brief 正在分析的源码，AST 节点上记录的字节偏移通过它换算成行列号
+         */
+        [[nodiscard]] const CodeManager& getCodeManager() const {
+            return *code_manager;
+        }
+
+        /**
+         * @brief 取出字符串字面量转义处理之后的内容
+         */
+        [[nodiscard]] const std::string& getStringLiteral(const Token& token) const {
+            return string_literals[token.payload];
+        }
+
+        /**
+         * @brief 丢弃字符串表，调用者需保证此后不再查询之前的字符串字面量
+         */
+        void releaseStringLiterals() {
+            string_literals.clear();
+        }
+
     protected:
-        void skipWhitespace() {
+        /**
+         * @brief 跳过空白字符和注释
+         * @param stop_at_annotation 遇到 //@ 或斜杠星号后紧跟 @ 的注解时停下，由调用者读成规约注解
+         * @param stop_at_newline 停在换行符之前，用于识别单行注解的结束
+         */
+        void skipWhitespace(bool stop_at_annotation = false, bool stop_at_newline = false) {
             while (!code_manager->eofReached()) {
                 char c = code_manager->lookChar();
+                if (c == '\n' && stop_at_newline) {
+                    break;
+                }
                 if (c == ' ' ||
                     c == '\t' ||
                     c == '\n' ||
@@ -75,6 +197,29 @@ namespace CC {
                         ) {
                     code_manager->getChar();
                 }
+                else if (stop_at_annotation && c == '/' && code_manager->lookChar(2) == '@' &&
+                         (code_manager->lookChar(1) == '/' || code_manager->lookChar(1) == '*')) {
+                    break;
+                }
+                else if (c == '/' && code_manager->lookChar(1) == '/') {
+                    //单行注释，换行符留给下一轮处理
+                    while (!code_manager->eofReached() && code_manager->lookChar() != '\n') {
+                        code_manager->getChar();
+                    }
+                }
+                else if (c == '/' && code_manager->lookChar(1) == '*') {
+                    //多行注释，没有闭合时一直吃到文件末尾
+                    code_manager->getChar();
+                    code_manager->getChar();
+                    char last = '\0';
+                    while (!code_manager->eofReached()) {
+                        c = code_manager->getChar();
+                        if (last == '*' && c == '/') {
+                            break;
+                        }
+                        last = c;
+                    }
+                }
                 else {
                     break;
                 }
@@ -85,6 +230,10 @@ namespace CC {
             return ch >= '0' && ch <= '9';
         }
 
+        static bool isHexDigit(const char& ch) {
+            return isDigit(ch) || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F');
+        }
+
         static bool isLetter(const char& ch) {
             return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
         }
@@ -103,6 +252,7 @@ namespace CC {
                 case '&':
                 case '|':
                 case '^':
+                case '~':
                     return true;
                 default:
                     return false;
@@ -113,60 +263,181 @@ namespace CC {
             switch (ch) {
                 case ';':
                 case ',':
+                case '.':
                 case '(':
                 case ')':
                 case '{':
                 case '}':
+                case '[':
+                case ']':
+                case '?':
+                case ':':
                     return true;
                 default:
                     return false;
             }
         }
 
-        [[nodiscard]] std::string readNumber() const  {
-            std::string number;
+        /**
+         * @brief SWAR：判断小端序读入的 8 个字节是否全是十进制数字
+         */
+        static bool isEightDigits(uint64_t chunk) {
+            return ((chunk & 0xF0F0F0F0F0F0F0F0ULL) |
+                    (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+                   0x3333333333333333ULL;
+        }
+
+        /**
+         * @brief SWAR：一次把 8 个十进制数字字符转换成整数
+         */
+        static uint32_t parseEightDigits(uint64_t chunk) {
+            chunk -= 0x3030303030303030ULL;
+            chunk = (chunk * 10) + (chunk >> 8);
+            chunk = (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+                     (((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+            return static_cast<uint32_t>(chunk);
+        }
+
+        /**
+         * @brief 读取整数字面量并按 C0 的 32 位规则求值
+         *
+         * 十进制字面量必须在 [0, 2^31] 内（2^31 即 -2^31 的补码），且不能有前导 0；
+         * 十六进制字面量 0x... 必须在 [0, 2^32) 内。越界时返回 payload 为 INTEGER_OUT_OF_RANGE 的 UNKNOWN
+         */
+        Token readNumber() const {
+            uint32_t start = static_cast<uint32_t>(code_manager->getOffset());
+            uint64_t value = 0;
+            bool overflow = false;
+
+            if (code_manager->lookChar() == '0' &&
+                (code_manager->lookChar(1) == 'x' || code_manager->lookChar(1) == 'X')) {
+                code_manager->getChar();
+                code_manager->getChar();
+                size_t digits = 0;
+                while (isHexDigit(code_manager->lookChar())) {
+                    char ch = code_manager->getChar();
+                    uint32_t digit = isDigit(ch) ? ch - '0' : (ch | 0x20) - 'a' + 10;
+                    value = (value << 4) | digit;
+                    overflow |= value > 0xFFFFFFFFULL;
+                    value = overflow ? 0 : value;
+                    ++digits;
+                }
+                uint32_t length = static_cast<uint32_t>(code_manager->getOffset()) - start;
+                if (overflow) {
+                    return {TokenType::UNKNOWN, start, length, static_cast<uint32_t>(LexError::INTEGER_OUT_OF_RANGE)};
+                }
+                if (digits == 0) {
+                    return {TokenType::UNKNOWN, start, length, 0};
+                }
+                return {TokenType::INT_LITERAL, start, length, static_cast<uint32_t>(value)};
+            }
+
+            bool leading_zero = code_manager->lookChar() == '0';
+            if constexpr (std::endian::native == std::endian::little) {
+                uint64_t chunk;
+                while (code_manager->remaining() >= sizeof(chunk)) {
+                    std::memcpy(&chunk, code_manager->current(), sizeof(chunk));
+                    if (!isEightDigits(chunk)) {
+                        break;
+                    }
+                    value = value * 100000000ULL + parseEightDigits(chunk);
+                    overflow |= value > (1ULL << 31);
+                    value = overflow ? 0 : value;
+                    code_manager->skip(sizeof(chunk));
+                }
+            }
             while (isDigit(code_manager->lookChar())) {
-                number += code_manager->getChar();
+                value = value * 10 + (code_manager->getChar() - '0');
+                overflow |= value > (1ULL << 31);
+                value = overflow ? 0 : value;
+            }
+
+            uint32_t length = static_cast<uint32_t>(code_manager->getOffset()) - start;
+            if (overflow) {
+                return {TokenType::UNKNOWN, start, length, static_cast<uint32_t>(LexError::INTEGER_OUT_OF_RANGE)};
+            }
+            if (leading_zero && length > 1) {
+                return {TokenType::UNKNOWN, start, length, 0};
+            }
+            return {TokenType::INT_LITERAL, start, length, static_cast<uint32_t>(value)};
+        }
+
+        /**
+         * @brief 解析转义序列，调用时 '\\' 已经被读掉
+         * @return 转义后的字符，非法转义返回 -1
+         */
+        int readEscape() const {
+            if (code_manager->eofReached() || code_manager->lookChar() == '\n') {
+                return -1;
+            }
+            switch (code_manager->getChar()) {
+            case 'n': return '\n';
+            case 't': return '\t';
+            case 'v': return '\v';
+            case 'b': return '\b';
+            case 'r': return '\r';
+            case 'f': return '\f';
+            case 'a': return '\a';
+            case '\\': return '\\';
+            case '\'': return '\'';
+            case '"': return '"';
+            case '0': return '\0';
+            default: return -1;
             }
-            return number;
         }
 
-        Token readString() const {
+        Token readString() {
+            uint32_t start = static_cast<uint32_t>(code_manager->getOffset());
             std::string string;
+            bool valid = true;
             code_manager->getChar();
-            while (code_manager->lookChar() != '"' && !code_manager->eofReached()) {
+            while (!code_manager->eofReached() && code_manager->lookChar() != '"') {
                 char ch = code_manager->getChar();
                 if (ch == '\\') { // 处理转义字符
-                    char nextCh = code_manager->getChar();
-                    switch(nextCh) {
-                    case 'n': string += '\n'; break;
-                    case 't': string += '\t'; break;
-                    case '"': string += '"'; break;
-                        // 可以添加更多转义字符支持
-                    default: string += nextCh; break;
-                    }
+                    int escaped = readEscape();
+                    // C0 的字符串中不能出现 \0
+                    valid &= escaped > 0;
+                    string += static_cast<char>(escaped);
                 } else if (ch == '\n') {
-                    return {TokenType::UNKNOWN, "unknown", code_manager->getLocation()};
+                    return {TokenType::UNKNOWN, start, static_cast<uint32_t>(code_manager->getOffset()) - start, 0};
                 } else {
                     string += ch;
                 }
             }
             if (code_manager->eofReached()) {
-                return {TokenType::UNKNOWN, "unknown", code_manager->getLocation()};
+                return {TokenType::UNKNOWN, start, static_cast<uint32_t>(code_manager->getOffset()) - start, 0};
             }
             code_manager->getChar();
-            return {TokenType::STRING_LITERAL, string, code_manager->getLocation()};
+            uint32_t length = static_cast<uint32_t>(code_manager->getOffset()) - start;
+            if (!valid) {
+                return {TokenType::UNKNOWN, start, length, 0};
+            }
+            string_literals.push_back(std::move(string));
+            return {TokenType::STRING_LITERAL, start, length, static_cast<uint32_t>(string_literals.size() - 1)};
         }
 
-        std::string readChar() const {
+        Token readChar() const {
+            uint32_t start = static_cast<uint32_t>(code_manager->getOffset());
             code_manager->getChar();
-            std::string c(1, code_manager->getChar());
-            code_manager->getChar();
-            return c;
+            int value = -1;
+            if (!code_manager->eofReached() && code_manager->lookChar() != '\'' && code_manager->lookChar() != '\n') {
+                char ch = code_manager->getChar();
+                value = ch == '\\' ? readEscape() : static_cast<unsigned char>(ch);
+            }
+            bool closed = code_manager->lookChar() == '\'';
+            if (closed) {
+                code_manager->getChar();
+            }
+            uint32_t length = static_cast<uint32_t>(code_manager->getOffset()) - start;
+            if (!closed || value < 0) {
+                return {TokenType::UNKNOWN, start, length, 0};
+            }
+            return {TokenType::CHAR_LITERAL, start, length, static_cast<uint32_t>(value)};
         }
 
 
         std::unique_ptr<CodeManager> code_manager;
+        std::vector<std::string> string_literals;  ///< 转义处理后的字符串字面量
     };
 
 
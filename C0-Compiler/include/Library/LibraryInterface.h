@@ -0,0 +1,166 @@
+//
+// Created by 陶子杨 on 25-12-2.
+//
+
+#pragma once
+
+#include "Infra/MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace CC {
+
+    class TranslationUnit;
+
+    /**
+     * @brief 预编译库接口文件（.c0i）的磁盘格式
+     *
+     * 文件依次是 Header、各类记录数组和字符串表，全部是定长的 uint32 字段，
+     * 映射进内存后无需反序列化即可直接查询。函数、结构体和类型别名都按名字排好序，用二分查找
+     */
+    namespace LibraryFormat {
+        inline constexpr char kMagic[4] = {'C', '0', 'I', 'F'};
+        inline constexpr uint32_t kVersion = 1;
+
+        struct StringRef {
+            uint32_t offset;
+            uint32_t length;
+        };
+
+        struct Header {
+            char magic[4];
+            uint32_t version;
+            uint32_t function_count;
+            uint32_t parameter_count;
+            uint32_t struct_count;
+            uint32_t field_count;
+            uint32_t typedef_count;
+            uint32_t string_size;
+        };
+
+        struct FunctionRecord {
+            StringRef name;
+            StringRef return_type;
+            uint32_t first_parameter;
+            uint32_t parameter_count;
+        };
+
+        struct StructRecord {
+            StringRef name;
+            uint32_t first_field;
+            uint32_t field_count;
+        };
+
+        // 函数参数、结构体成员和类型别名都是 (名字, 类型) 对
+        struct NamedTypeRecord {
+            StringRef name;
+            StringRef type;
+        };
+    }
+
+    class LibraryInterface;
+
+    struct LibraryVariable {
+        std::string_view name;
+        std::string_view type;
+    };
+
+    /**
+     * @brief 库函数签名的只读视图，指向映射的文件，生命周期不超过所属的 LibraryInterface
+     */
+    class LibraryFunction {
+    public:
+        LibraryFunction(const LibraryInterface* owner, const LibraryFormat::FunctionRecord* record)
+            : owner(owner), record(record) {}
+
+        [[nodiscard]] std::string_view getName() const;
+        [[nodiscard]] std::string_view getReturnType() const;
+        [[nodiscard]] size_t getParameterCount() const;
+        [[nodiscard]] LibraryVariable getParameter(size_t index) const;
+
+    private:
+        const LibraryInterface* owner;
+        const LibraryFormat::FunctionRecord* record;
+    };
+
+    /**
+     * @brief 库结构体定义的只读视图
+     */
+    class LibraryStruct {
+    public:
+        LibraryStruct(const LibraryInterface* owner, const LibraryFormat::StructRecord* record)
+            : owner(owner), record(record) {}
+
+        [[nodiscard]] std::string_view getName() const;
+        [[nodiscard]] size_t getFieldCount() const;
+        [[nodiscard]] LibraryVariable getField(size_t index) const;
+
+    private:
+        const LibraryInterface* owner;
+        const LibraryFormat::StructRecord* record;
+    };
+
+    /**
+     * @brief 映射进内存的预编译库接口
+     *
+     * 加载时只做一次边界检查，之后所有查询都直接读映射的页，
+     * 同一个实例可以被多个编译任务只读地共享
+     */
+    class LibraryInterface {
+    public:
+        /**
+         * @brief 映射并校验 .c0i 文件，文件不存在或格式不对时抛出 std::runtime_error
+         * @param name 库名，例如 "conio"
+         */
+        static std::shared_ptr<const LibraryInterface> load(std::string name, const std::string& file_path);
+
+        /**
+         * @brief 把头文件解析出的函数原型、结构体定义和类型别名写成 .c0i，失败时抛出 std::runtime_error
+         */
+        static void write(const TranslationUnit& unit, const std::string& file_path);
+
+        [[nodiscard]] const std::string& getName() const {
+            return name;
+        }
+
+        [[nodiscard]] size_t getFunctionCount() const;
+        [[nodiscard]] LibraryFunction getFunction(size_t index) const;
+        [[nodiscard]] std::optional<LibraryFunction> findFunction(std::string_view function_name) const;
+
+        [[nodiscard]] size_t getStructCount() const;
+        [[nodiscard]] LibraryStruct getStruct(size_t index) const;
+        [[nodiscard]] std::optional<LibraryStruct> findStruct(std::string_view struct_name) const;
+
+        [[nodiscard]] size_t getTypedefCount() const;
+        [[nodiscard]] LibraryVariable getTypedef(size_t index) const;
+
+    private:
+        friend class LibraryFunction;
+        friend class LibraryStruct;
+
+        LibraryInterface(std::string name, INFRA::MappedFile file);
+
+        [[nodiscard]] std::string_view getString(LibraryFormat::StringRef ref) const {
+            return {strings + ref.offset, ref.length};
+        }
+
+        [[nodiscard]] LibraryVariable getVariable(const LibraryFormat::NamedTypeRecord& record) const {
+            return {getString(record.name), getString(record.type)};
+        }
+
+        std::string name;
+        INFRA::MappedFile file;
+        const LibraryFormat::Header* header = nullptr;
+        const LibraryFormat::FunctionRecord* functions = nullptr;
+        const LibraryFormat::NamedTypeRecord* parameters = nullptr;
+        const LibraryFormat::StructRecord* structs = nullptr;
+        const LibraryFormat::NamedTypeRecord* fields = nullptr;
+        const LibraryFormat::NamedTypeRecord* typedefs = nullptr;
+        const char* strings = nullptr;
+    };
+}
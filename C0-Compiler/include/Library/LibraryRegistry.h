@@ -0,0 +1,45 @@
+//
+// Created by 陶子杨 on 25-12-2.
+//
+
+#pragma once
+
+#include "Library/LibraryInterface.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace CC {
+
+    /**
+     * @brief 按库名查找并缓存预编译的库接口
+     *
+     * 每个库在第一次 #use 时映射一次，之后所有编译任务共享同一份只读映射。
+     * 查找过程加锁，可以被多个线程同时调用
+     */
+    class LibraryRegistry {
+    public:
+        /**
+         * @param search_paths 依次查找 <目录>/<库名>.c0i
+         */
+        explicit LibraryRegistry(std::vector<std::string> search_paths);
+
+        /**
+         * @brief 查找库接口，找不到时返回空；文件存在但已损坏时抛出 std::runtime_error
+         */
+        std::shared_ptr<const LibraryInterface> find(std::string_view name);
+
+        [[nodiscard]] const std::vector<std::string>& getSearchPaths() const {
+            return search_paths;
+        }
+
+    private:
+        std::vector<std::string> search_paths;
+        std::mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<const LibraryInterface>> loaded;
+    };
+}
@@ -6,24 +6,47 @@
 
 #include "AST/UnitNode.h"
 #include "Lexer/C0Lexer.h"
+#include "Lexer/LanguageLevel.h"
+#include "Library/LibraryRegistry.h"
 #include "Parser/parser.h"
 
+#include <array>
+#include <cassert>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_set>
+
 namespace CC {
 
-    class C0Parser : public Parser<C0Parser> {
+    /**
+     * @brief 按语言层级 Lang 裁剪的 C0 语法分析器
+     *
+     * 关闭的特性（结构体、指针、数组等）对应的语法分支在编译期被 if constexpr 去掉
+     */
+    template <typename Lang>
+    class BasicC0Parser : public Parser<BasicC0Parser<Lang>> {
     public:
         /**
-         * @brief 构造函数，初始化词法分析器并读取所有token
+         * @brief 构造函数，初始化词法分析器，token 在解析过程中按需读取
          * @param file_path 要解析的源文件路径
+         * @param resource AST节点的内存来源
          */
-        explicit C0Parser(const std::string& file_path) {
-            lexer = std::make_unique<C0Lexer>(file_path);
-            while (true) {
-                tokens_.push_back(lexer->nextToken());
-                if (tokens_.back().type == TokenType::END_OF_FILE) {
-                    break;
-                }
-            }
+        explicit BasicC0Parser(const std::string& file_path,
+                          std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : memory_resource(resource) {
+            lexer = std::make_unique<BasicC0Lexer<Lang>>(file_path);
+        }
+
+        /**
+         * @brief 解析内存中的源码
+         * @param name 源码的名字，用于报错
+         * @param source 源码文本，需在解析器存活期间保持有效
+         * @param resource AST节点的内存来源
+         */
+        BasicC0Parser(std::string name, std::string_view source,
+                 std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : memory_resource(resource) {
+            lexer = std::make_unique<BasicC0Lexer<Lang>>(std::move(name), source);
         }
 
         /**
@@ -31,32 +54,150 @@ namespace CC {
          */
         void parse() {
             std::vector<std::shared_ptr<Declaration>> declarations;
-            while (peek(1).type != TokenType::END_OF_FILE) {
+            while (peek(0).type != TokenType::END_OF_FILE) {
                 declarations.push_back(parseDeclaration());
             }
-            AST_root = std::make_unique<TranslationUnit>(std::move(declarations));
+            AST_root = make<TranslationUnit>(std::move(declarations));
+        }
+
+        /**
+         * @brief 流式解析：只解析下一个顶层声明，不构造 TranslationUnit
+         */
+        std::shared_ptr<Declaration> parseNextDeclaration() {
+            return parseDeclaration();
+        }
+
+        [[nodiscard]] bool atEnd() {
+            return peek(0).type == TokenType::END_OF_FILE;
+        }
+
+        /**
+         * @brief 下一个顶层声明是否只声明类型（typedef、结构体定义或前置声明）或引入库
+         */
+        [[nodiscard]] bool nextIsTypeDeclaration() {
+            if constexpr (Lang::libraries) {
+                if (peek(0).type == TokenType::USE_LIBRARY || peek(0).type == TokenType::USE_FILE) {
+                    return true;
+                }
+            }
+            if constexpr (Lang::functions) {
+                if (peek(0).type == TokenType::KW_TYPEDEF) {
+                    return true;
+                }
+            }
+            if constexpr (Lang::structs) {
+                return peek(0).type == TokenType::KW_STRUCT &&
+                       (peek(2).type == TokenType::LBRACE || peek(2).type == TokenType::SEMICOLON);
+            }
+            return false;
+        }
+
+        /**
+         * @brief 切换之后新建的AST节点所用的内存来源
+         */
+        void setMemoryResource(std::pmr::memory_resource* resource) {
+            memory_resource = resource;
+        }
+
+        /**
+         * @brief 设置 #use <库名> 查找预编译库接口的位置，为空时所有库都找不到
+         */
+        void setLibraryRegistry(LibraryRegistry* registry) {
+            libraries = registry;
+        }
+
+        /**
+         * @brief 把其他文件中声明的类型别名当作已声明，names 需在解析器存活期间保持有效
+         */
+        void addTypedefNames(const std::vector<std::string>& names) {
+            for (const auto& name : names) {
+                typedef_names.insert(name);
+            }
+        }
+
+        /**
+         * @brief 释放已经被消费掉的字符串字面量，预读窗口中还有字符串时什么也不做
+         */
+        void releaseStringLiterals() {
+            for (size_t i = 0; i < lookahead_count; ++i) {
+                if (lookahead[(lookahead_head + i) & (kLookahead - 1)].type == TokenType::STRING_LITERAL) {
+                    return;
+                }
+            }
+            lexer->releaseStringLiterals();
+        }
+
+        [[nodiscard]] const std::shared_ptr<TranslationUnit>& getTranslationUnit() const {
+            return AST_root;
+        }
+
+        [[nodiscard]] const std::vector<Diagnostic>& getDiagnostics() const {
+            return diagnostics;
         }
+
+        [[nodiscard]] const CodeManager& getCodeManager() const {
+            return lexer->getCodeManager();
+        }
+
     private:
+        template <typename T, typename... Args>
+        std::shared_ptr<T> make(Args&&... args) {
+            return makeNode<T>(memory_resource, std::forward<Args>(args)...);
+        }
+
+        /**
+         * @brief 构造节点并记下它在源码中的位置
+         */
+        template <typename T, typename... Args>
+        std::shared_ptr<T> makeAt(const Token& token, Args&&... args) {
+            auto node = make<T>(std::forward<Args>(args)...);
+            node->offset = token.offset;
+            return node;
+        }
+
+        /**
+         * @brief 当前token是期望的类型时吃掉它，否则报错且不移动位置
+         * @param what 报错时对期望内容的描述
+         */
+        bool expect(TokenType type, const char* what);
+
+        void error(const Token& token, std::string message);
+
         /**
          * @brief 查看向前k个位置的token，不移动当前位置
          * @param k 向前查看的位置数
          * @return 对应位置的token
          */
         Token peek(int k) {
-            if (position + k >= tokens_.size()) {
-                return {TokenType::END_OF_FILE, "EOF", Location()};
+            assert(k >= 0 && static_cast<size_t>(k) < kLookahead && "预读距离超过了预读窗口");
+            // 文件结束后词法分析器会一直返回 END_OF_FILE
+            while (lookahead_count <= static_cast<size_t>(k)) {
+                lookahead[(lookahead_head + lookahead_count) & (kLookahead - 1)] = lexer->nextToken();
+                ++lookahead_count;
             }
-            return tokens_[position + k];
+            return lookahead[(lookahead_head + k) & (kLookahead - 1)];
         }
 
         /**
-         * @brief 向前移动k个位置并返回新位置的token
+         * @brief 向前移动k个位置，并返回移动前当前位置的token
          * @param k 移动的位置数，默认为1
          * @return 新位置的token
          */
         Token advance(int k = 1) {
-            position = position + k;
-            return tokens_[position-k];
+            Token token = peek(0);
+            for (; k > 0; --k) {
+                peek(0);
+                lookahead_head = (lookahead_head + 1) & (kLookahead - 1);
+                --lookahead_count;
+            }
+            return token;
+        }
+
+        /**
+         * @brief 取出 token 在源码中的原始文本，用于构造AST中的名字
+         */
+        std::string getSpelling(const Token& token) const {
+            return std::string(lexer->getLexeme(token));
         }
 
         bool match(TokenType type) {
@@ -67,35 +208,53 @@ namespace CC {
             return false;
         }
 
-        static bool isTypeSpecifier(const Token& token) {
+        /**
+         * @brief token 是否能开始一个类型，typedef 过的名字也算
+         */
+        bool isTypeSpecifier(const Token& token) const {
             switch (token.type) {
             case TokenType::KW_VOID:
             case TokenType::KW_INT:
+            case TokenType::KW_BOOL:
             case TokenType::KW_CHAR:
             case TokenType::KW_STRUCT:
             case TokenType::KW_STRING:
                 return true;
+            case TokenType::IDENTIFIER:
+                if constexpr (Lang::functions) {
+                    return !typedef_names.empty() && typedef_names.count(lexer->getLexeme(token)) != 0;
+                }
+                return false;
             default:
                 return false;
             }
-
         }
 
         /**
-         * @brief 解析表达式
-         * @return 表达式的AST节点
+         * @brief 解析类型：基本类型、struct 名或 typedef 名，后接任意个 '*' 和 '[]'
+         * @return 类型的规范拼写，例如 "struct node*"、"int[]"
          */
-        std::shared_ptr<Expression> parseExpression(int minPrec = 0);
-
-        std::shared_ptr<Expression> parsePrefixExpression();
+        std::string parseType();
 
-        std::shared_ptr<Expression> parsePrimary();
-
-        std::shared_ptr<Expression> parsePostfixExpression();
+        /**
+         * @brief 语句末尾的 x++ / x-- 改写成 x += 1 / x -= 1
+         */
+        std::shared_ptr<Expression> parsePostfixIncrement(std::shared_ptr<Expression> expr);
 
-        static int getInfixPrecedence(TokenType type);
+        /**
+         * @brief 解析表达式
+         *
+         * 基于 kOperatorTable 的显式栈算符优先分析，不随表达式深度递归，
+         * 括号和函数调用的嵌套深度只受堆内存限制
+         * @return 表达式的AST节点，出错时返回 nullptr
+         */
+        std::shared_ptr<Expression> parseExpression();
 
-        static bool isRightAssociative(TokenType type);
+        /**
+         * @brief 解析不含运算符的基本元素（标识符、字面量）
+         * @return 基本元素的AST节点，出错时返回 nullptr
+         */
+        std::shared_ptr<Expression> parsePrimary();
 
         /**
          * 通过看第三个符号来判断当前声明语句的类型
@@ -104,10 +263,10 @@ namespace CC {
         std::shared_ptr<Declaration> parseDeclaration();
 
         /**
-         *
+         * @brief 解析函数名之后的参数列表和函数体
          * @return 返回函数声明语句
          */
-        std::shared_ptr<Declaration> parseFunctionDeclaration();
+        std::shared_ptr<Declaration> parseFunctionDeclaration(std::string returnType, const Token& name);
         
         /**
          * @brief 解析参数声明
@@ -119,16 +278,33 @@ namespace CC {
          * @brief 解析变量声明
          * @return 变量声明的AST节点
          */
-        std::shared_ptr<Declaration> parseVariableDeclaration();
+        std::shared_ptr<Declaration> parseVariableDeclaration(std::string type, const Token& name);
 
         std::shared_ptr<Declaration> parseStructDeclaration();
 
+        std::shared_ptr<Declaration> parseTypedefDeclaration();
+
+        /**
+         * @brief 解析 #use 指令，库的类型别名随即对后面的声明可见
+         */
+        std::shared_ptr<Declaration> parseUseDirective();
+
         /**
          * @brief 解析语句
          * @return 语句的AST节点
          */
         std::shared_ptr<Statement> parseStatement();
 
+        /**
+         * @brief parseStatement 在检查嵌套深度之后的实际解析
+         */
+        std::shared_ptr<Statement> parseStatementBody(const Token& token);
+
+        /**
+         * @brief 不递归地跳过一条语句（包括其中成对的花括号），不吃掉外层的 '}'
+         */
+        void skipStatement();
+
         /**
          * @brief 解析复合语句（代码块）
          * @return 复合语句的AST节点
@@ -141,9 +317,47 @@ namespace CC {
         std::shared_ptr<Statement> parseDowhileStmt();
         std::shared_ptr<Statement> parseReturnStmt();
 
-        std::unique_ptr<C0Lexer> lexer;           ///< 词法分析器
-        std::unique_ptr<TranslationUnit> AST_root;///< 抽象语法树根节点
-        std::vector<Token> tokens_;               ///< token序列
-        size_t position = 0;                      ///< 当前解析位置
+        /**
+         * @brief 解析连续的若干个规约注解
+         * @param allowed 此处允许的规约种类，按 1 << ContractKind 组成的位集合
+         * @param where 报错时对当前位置的描述
+         */
+        std::vector<Contract> parseAnnotations(unsigned allowed, const char* where);
+
+        /**
+         * @brief 语句位置上的 //@assert，展开成 AssertStmt
+         */
+        std::shared_ptr<Statement> parseAnnotationStmt();
+
+        /**
+         * @brief 出错后跳到当前注解的末尾
+         */
+        void skipAnnotation();
+
+        std::unique_ptr<BasicC0Lexer<Lang>> lexer;///< 词法分析器
+        std::shared_ptr<TranslationUnit> AST_root;///< 抽象语法树根节点
+        static constexpr size_t kLookahead = 4;   ///< 预读窗口大小，必须是 2 的幂
+        std::array<Token, kLookahead> lookahead{};///< 按需读取的 token 环形缓冲
+        size_t lookahead_head = 0;                ///< 窗口中第一个 token 的下标
+        size_t lookahead_count = 0;               ///< 窗口中已读取的 token 个数
+        std::pmr::memory_resource* memory_resource;///< AST节点的内存来源
+        std::vector<Diagnostic> diagnostics;      ///< 语法错误
+        uint32_t last_error_offset = 0;           ///< 最近一次报错的位置
+        std::unordered_set<std::string_view> typedef_names;///< 已声明的类型别名，指向源码文本或库接口
+        LibraryRegistry* libraries = nullptr;     ///< 预编译库接口的来源
+        std::vector<std::shared_ptr<const LibraryInterface>> used_libraries;///< 保证 typedef_names 引用的映射有效
+        bool seen_declaration = false;            ///< 是否已经出现过 #use 以外的声明
+        /// 语句的最大嵌套层数，与 clang 的 -fbracket-depth 默认值相同，保证递归下降不会耗尽栈
+        static constexpr size_t kMaxStatementDepth = 256;
+        size_t statement_depth = 0;               ///< 当前语句的嵌套层数
+        bool in_ensures = false;                  ///< 正在解析 //@ensures，只有这里能用 \\result
     };
+
+    using C0Parser = BasicC0Parser<LangC0>;
+
+    extern template class BasicC0Parser<LangL1>;
+    extern template class BasicC0Parser<LangL2>;
+    extern template class BasicC0Parser<LangL3>;
+    extern template class BasicC0Parser<LangL4>;
+    extern template class BasicC0Parser<LangC0>;
 }
\ No newline at end of file
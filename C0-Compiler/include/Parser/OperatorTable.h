@@ -0,0 +1,115 @@
+//
+// Created by 陶子杨 on 25-11-20.
+//
+
+#pragma once
+
+#include "Lexer/Lexer.h"
+#include "Lexer/LanguageLevel.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace CC {
+
+    // TokenType::UNKNOWN 必须始终是枚举的最后一项
+    inline constexpr size_t kTokenTypeCount = static_cast<size_t>(TokenType::UNKNOWN) + 1;
+
+    enum class Associativity : uint8_t {
+        LEFT,
+        RIGHT,
+    };
+
+    /**
+     * @brief 单个运算符的语法属性，优先级越大结合越紧，0 表示不能出现在该位置
+     */
+    struct OperatorInfo {
+        uint8_t infix_precedence = 0;
+        uint8_t prefix_precedence = 0;
+        Associativity associativity = Associativity::LEFT;
+        bool is_assignment = false;
+    };
+
+    // 条件运算符 ?: 的优先级，介于赋值和 || 之间
+    inline constexpr uint8_t kConditionalPrecedence = 2;
+
+    namespace detail {
+        template <typename Lang>
+        constexpr void setInfix(std::array<OperatorInfo, kTokenTypeCount>& table, TokenType type,
+                                uint8_t precedence, Associativity associativity = Associativity::LEFT,
+                                bool is_assignment = false) {
+            if (!isTokenEnabled<Lang>(type)) {
+                return;
+            }
+            auto& info = table[static_cast<size_t>(type)];
+            info.infix_precedence = precedence;
+            info.associativity = associativity;
+            info.is_assignment = is_assignment;
+        }
+
+        template <typename Lang>
+        constexpr std::array<OperatorInfo, kTokenTypeCount> makeOperatorTable() {
+            std::array<OperatorInfo, kTokenTypeCount> table{};
+
+            // 赋值（包括复合赋值）优先级最低，右结合
+            for (TokenType type : {TokenType::OP_ASSIGN,
+                                   TokenType::OP_PLUS_ASSIGN, TokenType::OP_MINUS_ASSIGN,
+                                   TokenType::OP_MULTIPLY_ASSIGN, TokenType::OP_DIVIDE_ASSIGN,
+                                   TokenType::OP_MODULO_ASSIGN,
+                                   TokenType::OP_AND_ASSIGN, TokenType::OP_OR_ASSIGN,
+                                   TokenType::OP_XOR_ASSIGN, TokenType::OP_SHL_ASSIGN,
+                                   TokenType::OP_SHR_ASSIGN}) {
+                setInfix<Lang>(table, type, 1, Associativity::RIGHT, true);
+            }
+            // '?' 在解析器里单独处理，这里只占住优先级
+            setInfix<Lang>(table, TokenType::QUESTION, kConditionalPrecedence, Associativity::RIGHT);
+            setInfix<Lang>(table, TokenType::OP_LOGICAL_OR, 3);   // ||
+            setInfix<Lang>(table, TokenType::OP_LOGICAL_AND, 4);  // &&
+            setInfix<Lang>(table, TokenType::OP_OR, 5);           // |
+            setInfix<Lang>(table, TokenType::OP_XOR, 6);          // ^
+            setInfix<Lang>(table, TokenType::OP_AND, 7);          // &
+            setInfix<Lang>(table, TokenType::OP_EQ, 8);           // == !=
+            setInfix<Lang>(table, TokenType::OP_NE, 8);
+            setInfix<Lang>(table, TokenType::OP_LT, 9);           // < > <= >=
+            setInfix<Lang>(table, TokenType::OP_GT, 9);
+            setInfix<Lang>(table, TokenType::OP_LE, 9);
+            setInfix<Lang>(table, TokenType::OP_GE, 9);
+            setInfix<Lang>(table, TokenType::OP_SHL, 10);         // << >>
+            setInfix<Lang>(table, TokenType::OP_SHR, 10);
+            setInfix<Lang>(table, TokenType::OP_PLUS, 11);        // + -
+            setInfix<Lang>(table, TokenType::OP_MINUS, 11);
+            setInfix<Lang>(table, TokenType::OP_MULTIPLY, 12);    // * / %
+            setInfix<Lang>(table, TokenType::OP_DIVIDE, 12);
+            setInfix<Lang>(table, TokenType::OP_MODULO, 12);
+
+            // 一元前缀运算符比所有二元运算符结合得更紧
+            for (TokenType type : {TokenType::OP_PLUS, TokenType::OP_MINUS,
+                                   TokenType::OP_NOT, TokenType::OP_BIT_NOT}) {
+                if (isTokenEnabled<Lang>(type)) {
+                    table[static_cast<size_t>(type)].prefix_precedence = 13;
+                }
+            }
+            // 前缀 '*' 是解引用
+            if constexpr (Lang::pointers) {
+                table[static_cast<size_t>(TokenType::OP_MULTIPLY)].prefix_precedence = 13;
+            }
+            return table;
+        }
+    }
+
+    template <typename Lang>
+    inline constexpr std::array<OperatorInfo, kTokenTypeCount> kOperatorTable = detail::makeOperatorTable<Lang>();
+
+    template <typename Lang>
+    constexpr const OperatorInfo& getOperatorInfo(TokenType type) {
+        return kOperatorTable<Lang>[static_cast<size_t>(type)];
+    }
+
+    static_assert(getOperatorInfo<LangC0>(TokenType::OP_MULTIPLY).infix_precedence >
+                  getOperatorInfo<LangC0>(TokenType::OP_PLUS).infix_precedence);
+    static_assert(getOperatorInfo<LangC0>(TokenType::OP_DIVIDE_ASSIGN).associativity == Associativity::RIGHT);
+    static_assert(getOperatorInfo<LangC0>(TokenType::IDENTIFIER).infix_precedence == 0);
+    static_assert(getOperatorInfo<LangL1>(TokenType::OP_LOGICAL_AND).infix_precedence == 0);
+    static_assert(getOperatorInfo<LangL3>(TokenType::OP_MULTIPLY).prefix_precedence == 0);
+}
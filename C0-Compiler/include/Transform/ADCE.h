@@ -0,0 +1,42 @@
+//
+// Created by 陶子杨 on 25-12-14.
+//
+
+#pragma once
+
+#include "IR/PassManager.h"
+
+namespace CC::IR {
+
+    /**
+     * @brief 基于控制依赖的激进死代码删除
+     *
+     * 先假定所有指令都是死的，只从有副作用的指令（返回、中止、写内存、调用、可能中止程序的运算）
+     * 出发，沿操作数和控制依赖把需要的指令标记为活的：活指令所在块控制依赖的分支是活的，
+     * 活 PHI 的各来源块的跳转也是活的。剩下的指令全部删除，死的条件跳转改成直接跳到
+     * 直接后支配点，绕过去的块随后作为不可达块删除。
+     *
+     * C0 程序不终止是可观察的行为，所以环上的块的跳转一律视为活的，空循环也不会被删掉。
+     * 只被写、从不被读也不逃逸的 alloc 上的 STORE 不算副作用，
+     * 地址一定非空的 LOAD 不会中止程序，没有用到时一并删除
+     */
+    class ADCEPass final : public FunctionPass {
+    public:
+        [[nodiscard]] const char* getName() const override {
+            return "adce";
+        }
+
+        [[nodiscard]] AnalysisSet getRequired() const override {
+            return {AnalysisKind::CFG, AnalysisKind::POST_DOMINATOR_TREE, AnalysisKind::CONTROL_DEPENDENCE};
+        }
+
+        size_t run(Function& function, AnalysisManager& analyses) override;
+
+        [[nodiscard]] AnalysisSet getPreserved() const override {
+            return cfg_changed ? AnalysisSet() : AnalysisSet::cfgShape();
+        }
+
+    private:
+        bool cfg_changed = false;
+    };
+}
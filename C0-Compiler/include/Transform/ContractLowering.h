@@ -0,0 +1,98 @@
+//
+// Created by 陶子杨 on 25-12-8.
+//
+
+#pragma once
+
+#include "AST/DeclarationNode.h"
+#include "AST/StatementNode.h"
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace CC {
+
+    struct ContractStats {
+        size_t checked = 0;         ///< 保留在函数体中的检查（AssertStmt）
+        size_t elided = 0;          ///< 可证明成立或已经检查过而删除的检查
+        size_t hoisted = 0;         ///< 提到循环之前只检查一次的循环不变式
+        size_t each_iteration = 0;  ///< 仍需每次迭代检查的循环不变式
+
+        ContractStats& operator+=(const ContractStats& other) {
+            checked += other.checked;
+            elided += other.elided;
+            hoisted += other.hoisted;
+            each_iteration += other.each_iteration;
+            return *this;
+        }
+    };
+
+    /**
+     * @brief 动态检查模式（-d）：把函数上的规约展开成 AssertStmt，并删掉冗余的检查
+     *
+     * requires 展开到函数体开头，ensures 展开到每个 return 之前（void 函数还包括函数末尾）。
+     * 沿着语句顺序维护"已经检查过且此后没有被修改"的条件，常量成立的或者已经成立的检查
+     * （按 && 拆开逐项判断）会被删掉。循环中没有修改到的循环不变式只在进入循环前检查一次，
+     * 其余的标记为 EACH_ITERATION 留在循环上，由后端在循环头生成检查
+     */
+    class ContractLowering {
+    public:
+        /**
+         * @param resource 新建的AST节点的内存来源，应与函数本身的AST一致
+         */
+        explicit ContractLowering(std::pmr::memory_resource* resource);
+
+        /**
+         * @brief 改写一个函数定义，没有函数体时什么也不做
+         */
+        void run(FunctionDecl& function);
+
+        [[nodiscard]] const ContractStats& getStats() const;
+
+    private:
+        struct FactSet;
+
+        /**
+         * @brief 按 && 拆开条件，删掉已知成立的部分
+         * @return 仍需检查的条件，整个条件都成立时返回 nullptr
+         */
+        std::shared_ptr<Expression> simplifyCheck(const std::shared_ptr<Expression>& condition,
+                                                  const FactSet& facts);
+
+        void lowerBlock(CompoundStmt& block, FactSet& facts);
+
+        /**
+         * @brief 改写 if/循环的分支，展开出多条语句时包成一个代码块
+         */
+        void lowerNested(std::shared_ptr<Statement>& slot, FactSet& facts);
+
+        /**
+         * @brief 改写一条语句，结果（可能是零条或多条语句）追加到 out
+         */
+        void lowerStatement(const std::shared_ptr<Statement>& statement, FactSet& facts,
+                            std::vector<std::shared_ptr<Statement>>& out);
+
+        /**
+         * @brief 处理循环不变式并改写循环体
+         *
+         * 循环中没有修改到的不变式生成 AssertStmt 追加到 hoisted，由调用者放在第一次判断条件之前，
+         * 其余的标记为每次迭代检查。提前检查不会越过留在循环里、可能中止程序的分量
+         * @param increment for 循环的步进表达式，while 循环为空
+         */
+        void lowerLoop(std::vector<Contract>& invariants, const std::shared_ptr<Expression>& condition,
+                       const std::shared_ptr<Expression>& increment, std::shared_ptr<Statement>& body,
+                       FactSet& facts, std::vector<std::shared_ptr<Statement>>& hoisted);
+
+        /**
+         * @brief 在 return（或 void 函数末尾）之前展开 ensures
+         */
+        void lowerReturn(const std::shared_ptr<Statement>& statement, FactSet& facts,
+                         std::vector<std::shared_ptr<Statement>>& out);
+
+        std::pmr::memory_resource* resource;
+        ContractStats stats;
+        FunctionDecl* function = nullptr;  ///< 正在改写的函数
+    };
+}
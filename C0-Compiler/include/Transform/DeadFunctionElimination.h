@@ -0,0 +1,23 @@
+//
+// Created by 陶子杨 on 25-12-14.
+//
+
+#pragma once
+
+#include "IR/PassManager.h"
+
+namespace CC::IR {
+
+    /**
+     * @brief 删除从 main 出发沿调用关系到不了的函数，包括没有被调用的库函数声明。
+     * 模块里没有 main（例如只编译库）时什么也不做
+     */
+    class DeadFunctionEliminationPass final : public ModulePass {
+    public:
+        [[nodiscard]] const char* getName() const override {
+            return "dead-functions";
+        }
+
+        size_t run(Module& module, AnalysisManager& analyses) override;
+    };
+}
@@ -0,0 +1,37 @@
+//
+// Created by 陶子杨 on 25-12-20.
+//
+
+#pragma once
+
+#include "IR/PassManager.h"
+
+namespace CC::IR {
+
+    /**
+     * @brief 死存储删除
+     *
+     * 后向数据流求每一点之后一定不会再被读到的内存：在所有路径上先被同一个地址覆盖的位置，
+     * 以及再也不会被读的对象（返回时没有逃逸的分配，中止程序之后的所有内存）。
+     * LOAD 和可能读内存的调用让它们可能读到的内容重新变成活的；越过地址的定义往回走时，
+     * 这个地址指的是上一次计算的位置，关于它的结论作废。
+     * 写进这种内存的 STORE 可以删掉，前提是它自己不会中止程序：地址一定非空，
+     * 或者同一个基址上已经有支配它的访问成功执行过
+     */
+    class DeadStoreEliminationPass final : public FunctionPass {
+    public:
+        [[nodiscard]] const char* getName() const override {
+            return "dse";
+        }
+
+        [[nodiscard]] AnalysisSet getRequired() const override {
+            return {AnalysisKind::CFG, AnalysisKind::DOMINATOR_TREE, AnalysisKind::ALIAS_ANALYSIS};
+        }
+
+        size_t run(Function& function, AnalysisManager& analyses) override;
+
+        [[nodiscard]] AnalysisSet getPreserved() const override {
+            return AnalysisSet::cfgShape();
+        }
+    };
+}
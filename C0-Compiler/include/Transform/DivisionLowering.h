@@ -0,0 +1,39 @@
+//
+// Created by 陶子杨 on 25-12-21.
+//
+
+#pragma once
+
+#include "IR/PassManager.h"
+
+namespace CC::IR {
+
+    /**
+     * @brief 整数除法和取模的降级，保持中止程序的语义
+     *
+     * 除数是常量时它不会中止程序（0 和 -1 除外），换成乘法和移位：2 的幂用带符号偏置的算术右移，
+     * 其他除数用 MULH 乘以魔数再右移（Hacker's Delight 10-1），取模再用 x - q * d 算出余数。
+     * 被除数已知非负时省掉向零取整的修正。-1 和 INT_MIN 作除数时保持原样。
+     *
+     * 除数是变量时，用支配它的条件分支、归纳变量和简单的值域推出除数不是 0，
+     * 且除数不是 -1 或被除数不是 INT_MIN，证明之后把指令标记为不会中止程序，
+     * 后端生成代码时可以省掉检查
+     */
+    class DivisionLoweringPass final : public FunctionPass {
+    public:
+        [[nodiscard]] const char* getName() const override {
+            return "lower-division";
+        }
+
+        [[nodiscard]] AnalysisSet getRequired() const override {
+            return {AnalysisKind::CFG, AnalysisKind::DOMINATOR_TREE, AnalysisKind::LOOPS,
+                    AnalysisKind::INDUCTION_VARIABLES};
+        }
+
+        size_t run(Function& function, AnalysisManager& analyses) override;
+
+        [[nodiscard]] AnalysisSet getPreserved() const override {
+            return AnalysisSet::cfgShape();
+        }
+    };
+}
@@ -0,0 +1,25 @@
+//
+// Created by 陶子杨 on 25-12-15.
+//
+
+#pragma once
+
+#include "IR/PassManager.h"
+
+namespace CC::IR {
+
+    /**
+     * @brief 推断哪些函数是纯函数（见 Function::isPure）
+     *
+     * 先假定所有有函数体、自身不读写也不分配内存的函数都是纯的，再反复去掉调用了非纯函数的，
+     * 直到不动点，互相递归的纯函数因此也能认出来。库函数只有声明，一律不算纯函数
+     */
+    class FunctionAttrsPass final : public ModulePass {
+    public:
+        [[nodiscard]] const char* getName() const override {
+            return "function-attrs";
+        }
+
+        size_t run(Module& module, AnalysisManager& analyses) override;
+    };
+}
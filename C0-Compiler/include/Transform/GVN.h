@@ -0,0 +1,38 @@
+//
+// Created by 陶子杨 on 25-12-15.
+//
+
+#pragma once
+
+#include "IR/PassManager.h"
+
+namespace CC::IR {
+
+    /**
+     * @brief 基于支配树的全局值编号
+     *
+     * 按支配树先序遍历，用带作用域的哈希表记录每个表达式最早的计算；后面被支配的相同计算
+     * 直接换成它。能中止程序的除法、移位和下标计算也可以合并：支配它的那一次已经执行成功，
+     * 同样的操作数不会再中止。全部来源相同的 PHI 换成那个来源。
+     *
+     * 内存按"代"处理：每条写内存的指令（STORE、非纯函数的调用）开启新的一代，
+     * 有多个前驱或者唯一前驱不是直接支配点的块也开启新的一代，LOAD 只和同一代的 LOAD 合并。
+     * 纯函数的调用按 (被调函数, 实参) 合并
+     */
+    class GVNPass final : public FunctionPass {
+    public:
+        [[nodiscard]] const char* getName() const override {
+            return "gvn";
+        }
+
+        [[nodiscard]] AnalysisSet getRequired() const override {
+            return {AnalysisKind::DOMINATOR_TREE};
+        }
+
+        size_t run(Function& function, AnalysisManager& analyses) override;
+
+        [[nodiscard]] AnalysisSet getPreserved() const override {
+            return AnalysisSet::cfgShape();
+        }
+    };
+}
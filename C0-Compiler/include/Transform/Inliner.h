@@ -0,0 +1,33 @@
+//
+// Created by 陶子杨 on 25-12-17.
+//
+
+#pragma once
+
+#include "IR/PassManager.h"
+
+namespace CC::IR {
+
+    /**
+     * @brief 把一次调用替换成被调函数体的副本，返回是否成功（被调函数只有声明时不能内联）。
+     * 调用所在的块在调用处一分为二，副本中的 RET 改为跳到后半块，返回值在后半块开头用 PHI 汇合
+     */
+    bool inlineCall(Instruction* call);
+
+    /**
+     * @brief 自底向上的内联
+     *
+     * 按调用图的强连通分量逆拓扑序处理，被调函数先于调用者完成内联，调用者看到的是已经展开过的大小。
+     * 代价是被调函数的指令数减去省掉的调用开销和常量实参的奖励，阈值随调用点的循环深度提高，
+     * 只有一个调用点的函数内联后原函数会被删掉，阈值再提高一截。
+     * 处在调用环上的函数（包括直接递归）不内联。每个函数内联后的大小不超过原来的两倍再加一个常量
+     */
+    class InlinerPass final : public ModulePass {
+    public:
+        [[nodiscard]] const char* getName() const override {
+            return "inline";
+        }
+
+        size_t run(Module& module, AnalysisManager& analyses) override;
+    };
+}
@@ -0,0 +1,37 @@
+//
+// Created by 陶子杨 on 25-12-15.
+//
+
+#pragma once
+
+#include "IR/PassManager.h"
+
+namespace CC::IR {
+
+    /**
+     * @brief 循环不变代码外提
+     *
+     * 从内层到外层处理每个有前置块的循环，按支配顺序把操作数都在循环外定义的指令移到前置块末尾：
+     * - 不会中止程序的纯运算无条件外提，即使循环一次也不执行，多算一次也看不出来；
+     * - 可能中止程序的除法、移位、下标计算以及纯函数调用只在它位于头结点、并且前面没有其他
+     *   可观察的操作时外提，进入循环就一定会执行到它，提前中止的时机和原来相同；
+     * - LOAD 要求循环中的 STORE 按别名分析都不会写到它读的位置，可能读写内存的调用访问不到这个位置，
+     *   并且地址一定非空或者满足上一条
+     */
+    class LICMPass final : public FunctionPass {
+    public:
+        [[nodiscard]] const char* getName() const override {
+            return "licm";
+        }
+
+        [[nodiscard]] AnalysisSet getRequired() const override {
+            return {AnalysisKind::LOOPS, AnalysisKind::ALIAS_ANALYSIS};
+        }
+
+        size_t run(Function& function, AnalysisManager& analyses) override;
+
+        [[nodiscard]] AnalysisSet getPreserved() const override {
+            return AnalysisSet::cfgShape();
+        }
+    };
+}
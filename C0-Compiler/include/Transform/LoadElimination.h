@@ -0,0 +1,36 @@
+//
+// Created by 陶子杨 on 25-12-20.
+//
+
+#pragma once
+
+#include "IR/PassManager.h"
+
+namespace CC::IR {
+
+    /**
+     * @brief 存储到加载的转发和冗余加载删除
+     *
+     * 前向数据流求每一点上已知的内存内容：位置编号 -> 值。STORE 之后位置里是写进去的值，
+     * LOAD 之后是读出来的值，新分配的对象整个是 0；STORE 去掉可能与它重叠的位置，
+     * 可能读写内存的调用去掉它能访问的位置。汇合点取各前驱上值相同的部分，
+     * 只保留地址和值都严格支配该块的事实，循环中重新计算的地址不会把上一次迭代的内容带进来。
+     * 读已知位置的 LOAD 直接换成那个值：前面的访问已经成功，它也不会中止程序
+     */
+    class LoadEliminationPass final : public FunctionPass {
+    public:
+        [[nodiscard]] const char* getName() const override {
+            return "load-elim";
+        }
+
+        [[nodiscard]] AnalysisSet getRequired() const override {
+            return {AnalysisKind::CFG, AnalysisKind::DOMINATOR_TREE, AnalysisKind::ALIAS_ANALYSIS};
+        }
+
+        size_t run(Function& function, AnalysisManager& analyses) override;
+
+        [[nodiscard]] AnalysisSet getPreserved() const override {
+            return AnalysisSet::cfgShape();
+        }
+    };
+}
@@ -0,0 +1,34 @@
+//
+// Created by 陶子杨 on 25-12-22.
+//
+
+#pragma once
+
+#include "IR/PassManager.h"
+
+namespace CC::IR {
+
+    /**
+     * @brief 交换两层循环的次序，让数组的数组按行访问
+     *
+     * int[][] 的每一行是单独的数组，内层循环改变行下标时每次迭代都跳到另一行。
+     * 对 LoopNest 描述的完美嵌套，交换之后按列访问的数组访问更少，并且依赖分析证明交换不会颠倒依赖时，
+     * 把两层的归纳变量在循环体中的使用互换，再互换两层的初值、步长和退出条件，CFG 不变
+     */
+    class LoopInterchangePass final : public FunctionPass {
+    public:
+        [[nodiscard]] const char* getName() const override {
+            return "loop-interchange";
+        }
+
+        [[nodiscard]] AnalysisSet getRequired() const override {
+            return {AnalysisKind::LOOPS, AnalysisKind::INDUCTION_VARIABLES, AnalysisKind::DEPENDENCES};
+        }
+
+        size_t run(Function& function, AnalysisManager& analyses) override;
+
+        [[nodiscard]] AnalysisSet getPreserved() const override {
+            return AnalysisSet::cfgShape();
+        }
+    };
+}
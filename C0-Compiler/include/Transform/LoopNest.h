@@ -0,0 +1,67 @@
+//
+// Created by 陶子杨 on 25-12-22.
+//
+
+#pragma once
+
+#include "IR/DependenceAnalysis.h"
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+namespace CC::IR {
+
+    /**
+     * @brief 完美嵌套的两层循环，两层都由头结点中的 "phi predicate bound" 控制，迭代空间是矩形
+     *
+     * 外层循环中不属于内层的块只有归纳变量和归约的 PHI、外层的比较和步进，没有别的指令；
+     * 内层循环体只通过数组访问读写内存，不调用函数，除了数组越界不会以别的方式中止程序。
+     * 于是只要数组访问之间的依赖允许，可以任意改变迭代的执行顺序
+     */
+    struct LoopNest {
+        struct Level {
+            const Loop* loop;
+            const InductionVariable* variable;
+            Instruction* compare;   ///< 头结点中为真时留在循环里的比较，第一个操作数是 phi
+            Value* bound;           ///< 外层循环的不变量
+            int32_t step;
+        };
+
+        /**
+         * @brief 跨越两层循环的归约 s = s OP x：外层头结点的 outer 在内层头结点变成 inner，
+         * 每次迭代更新成 update = inner OP x，OP 满足交换律和结合律（SUB 只能减去 x），
+         * 中间值在嵌套中没有别的用处，所以迭代的顺序不影响最后的结果
+         */
+        struct Reduction {
+            Instruction* outer;
+            Instruction* inner;
+            Instruction* update;
+        };
+
+        Level outer;
+        Level inner;
+        std::vector<Reduction> reductions;
+        std::vector<ArrayAccess> accesses;
+
+        [[nodiscard]] std::vector<const Loop*> getLoops() const {
+            return {outer.loop, inner.loop};
+        }
+    };
+
+    /**
+     * @brief outer 和它唯一的内层循环组成上面描述的嵌套时返回它，两层循环都要满足 isSimpleLoop
+     */
+    std::optional<LoopNest> analyzeLoopNest(const Loop* outer, const InductionVariables& induction,
+                                            const DependenceAnalysis& dependences);
+
+    /**
+     * @brief 交换两层循环的次序不会颠倒任何一对依赖：不存在方向为 (<, >) 或 (>, <) 的依赖
+     */
+    bool isInterchangeLegal(const LoopNest& nest, const DependenceAnalysis& dependences);
+
+    /**
+     * @brief 以 innermost 作为最内层循环的归纳变量时，按列访问（行下标随它变化、最后一维不变）的数组访问个数
+     */
+    size_t countColumnAccesses(const LoopNest& nest, const Instruction* innermost);
+}
@@ -0,0 +1,35 @@
+//
+// Created by 陶子杨 on 25-12-19.
+//
+
+#pragma once
+
+#include "IR/PassManager.h"
+
+namespace CC::IR {
+
+    /**
+     * @brief 把最内层循环的第一次迭代剥到循环前面
+     *
+     * 只在第一次迭代特殊时才剥：头结点的某个 PHI 从回边进来的是循环不变量，
+     * 例如 first = true ... first = false。剥出的那一份里它是初值，剩下的循环里它是不变量，
+     * 之后的常量传播和 LICM 能把依赖它的判断化简掉。循环大小超过 threshold 时不剥
+     */
+    class LoopPeelPass final : public FunctionPass {
+    public:
+        [[nodiscard]] const char* getName() const override {
+            return "loop-peel";
+        }
+
+        [[nodiscard]] AnalysisSet getRequired() const override {
+            return {AnalysisKind::DOMINATOR_TREE, AnalysisKind::LOOPS};
+        }
+
+        size_t run(Function& function, AnalysisManager& analyses) override;
+
+        bool setParameter(std::string_view key, int64_t value) override;
+
+    private:
+        int64_t threshold = 40;
+    };
+}
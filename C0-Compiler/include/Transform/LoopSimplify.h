@@ -0,0 +1,41 @@
+//
+// Created by 陶子杨 on 25-12-15.
+//
+
+#pragma once
+
+#include "IR/PassManager.h"
+
+namespace CC::IR {
+
+    /**
+     * @brief 把循环整理成规范形式：有前置块（循环外唯一的前驱，只跳到头结点），
+     * 出口块的前驱都在循环中。循环优化往前置块里放提出来的代码，往出口块里放循环结束后才需要的代码
+     */
+    class LoopSimplifyPass final : public FunctionPass {
+    public:
+        [[nodiscard]] const char* getName() const override {
+            return "loop-simplify";
+        }
+
+        [[nodiscard]] AnalysisSet getRequired() const override {
+            return {AnalysisKind::LOOPS};
+        }
+
+        /**
+         * @brief 新建的块逐条边更新到支配树和后支配树中，不用作废重算
+         */
+        [[nodiscard]] AnalysisSet getPreserved() const override {
+            return {AnalysisKind::DOMINATOR_TREE, AnalysisKind::POST_DOMINATOR_TREE};
+        }
+
+        size_t run(Function& function, AnalysisManager& analyses) override;
+    };
+
+    /**
+     * @brief 给 loop 建立前置块和专用出口，新建的块同时登记到 loops 中，返回新建的块数。
+     * 传入的支配树和后支配树随之增量更新
+     */
+    size_t simplifyLoop(Loop* loop, LoopInfo& loops, DominatorTree* dominators = nullptr,
+                        DominatorTree* post_dominators = nullptr);
+}
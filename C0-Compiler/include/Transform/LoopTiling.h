@@ -0,0 +1,39 @@
+//
+// Created by 陶子杨 on 25-12-22.
+//
+
+#pragma once
+
+#include "IR/PassManager.h"
+
+namespace CC::IR {
+
+    /**
+     * @brief 按块访问两层嵌套中按列走的数组的数组
+     *
+     * 有的访问按行走、有的按列走时（例如转置 b[i][j] = a[j][i]），交换循环不能让所有访问都按行走。
+     * 这时把内层循环按 size 切成条带，再把条带循环移到最外层：
+     * for (jj = j0; jj < m; jj = 上一条带结束时的 j) for (i ...) for (j = jj; j < m && j - jj < size; j++)，
+     * 于是外层循环的相邻迭代访问的是同样的 size 行，缓存里的行可以复用。
+     * 条带循环和外层交换，所以要求依赖分析证明两层可以交换；内层循环步长为 1、用 < 退出，
+     * 常量的迭代次数不超过 size 时不处理
+     */
+    class LoopTilingPass final : public FunctionPass {
+    public:
+        [[nodiscard]] const char* getName() const override {
+            return "loop-tile";
+        }
+
+        [[nodiscard]] AnalysisSet getRequired() const override {
+            return {AnalysisKind::DOMINATOR_TREE, AnalysisKind::LOOPS, AnalysisKind::INDUCTION_VARIABLES,
+                    AnalysisKind::DEPENDENCES};
+        }
+
+        size_t run(Function& function, AnalysisManager& analyses) override;
+
+        bool setParameter(std::string_view key, int64_t value) override;
+
+    private:
+        int64_t size = 32;
+    };
+}
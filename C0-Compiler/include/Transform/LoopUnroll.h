@@ -0,0 +1,48 @@
+//
+// Created by 陶子杨 on 25-12-19.
+//
+
+#pragma once
+
+#include "IR/PassManager.h"
+
+namespace CC::IR {
+
+    /**
+     * @brief 展开最内层循环
+     *
+     * 要求循环只有一个出口边，出口在头结点或回边源上。
+     * 循环体复制成若干份首尾相接，每份对应一次迭代，头结点的 PHI 在副本中直接取上一份的值。
+     * 回边次数是常量时第 k 次执行出口块是否退出只取决于 k：
+     * - 完全展开：总大小不超过 full-threshold 时复制 回边次数 + 1 份，最后一份的出口分支改成跳出，
+     *   其余改成留在循环里，回边随之消失；
+     * - 部分展开：复制 factor 份（总大小不超过 threshold 时），最后一份跳回第一份。
+     *   迭代次数除以 factor 的余数决定最后一次退出落在哪一份，只有那一份保留出口分支，
+     *   余下的几次迭代就在这一轮中途退出。
+     * 回边次数不是常量、但头结点用常量步长的归纳变量和循环不变的界比较时（如 i < n），
+     * 复制 factor 份组成主循环，每轮只检查剩下的迭代是否还够 factor 次，
+     * 原来的循环留作余数循环，执行最后不足 factor 次的迭代
+     */
+    class LoopUnrollPass final : public FunctionPass {
+    public:
+        [[nodiscard]] const char* getName() const override {
+            return "loop-unroll";
+        }
+
+        [[nodiscard]] AnalysisSet getRequired() const override {
+            return {AnalysisKind::DOMINATOR_TREE, AnalysisKind::LOOPS, AnalysisKind::INDUCTION_VARIABLES};
+        }
+
+        size_t run(Function& function, AnalysisManager& analyses) override;
+
+        /**
+         * @brief full-threshold、threshold 和 factor，factor 为 1 时只做完全展开
+         */
+        bool setParameter(std::string_view key, int64_t value) override;
+
+    private:
+        int64_t full_threshold = 160;   ///< 完全展开后循环的总大小上限
+        int64_t threshold = 80;         ///< 部分展开后循环体的大小上限
+        int64_t factor = 4;
+    };
+}
@@ -0,0 +1,35 @@
+//
+// Created by 陶子杨 on 25-12-19.
+//
+
+#pragma once
+
+#include "IR/PassManager.h"
+
+namespace CC::IR {
+
+    /**
+     * @brief 循环外提不变的条件分支
+     *
+     * 循环中第一个条件是循环不变量的 COND_BR：把整个循环复制一份，前置块按条件选择进入哪一份，
+     * 原来的一份里分支固定走真的一边，副本里固定走假的一边。每个循环嵌套最多处理一次，
+     * 循环大小超过 threshold 时不处理
+     */
+    class LoopUnswitchPass final : public FunctionPass {
+    public:
+        [[nodiscard]] const char* getName() const override {
+            return "loop-unswitch";
+        }
+
+        [[nodiscard]] AnalysisSet getRequired() const override {
+            return {AnalysisKind::DOMINATOR_TREE, AnalysisKind::LOOPS};
+        }
+
+        size_t run(Function& function, AnalysisManager& analyses) override;
+
+        bool setParameter(std::string_view key, int64_t value) override;
+
+    private:
+        int64_t threshold = 60;
+    };
+}
@@ -0,0 +1,38 @@
+//
+// Created by 陶子杨 on 25-12-19.
+//
+
+#pragma once
+
+#include "IR/Cloning.h"
+#include "IR/LoopInfo.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace CC::IR {
+
+    /**
+     * @brief 循环中不含 PHI 的指令数，复制循环的代价
+     */
+    size_t getLoopSize(const Loop* loop);
+
+    /**
+     * @brief 复制类变换要求的形状：有前置块并且它以 BR 结尾，唯一的回边源只有一条边跳到头结点，出口是专用的
+     */
+    bool isSimpleLoop(const Loop* loop);
+
+    /**
+     * @brief 把循环整理成 LCSSA 形式：循环中定义、循环外使用的值先经过出口块开头的 PHI，
+     * 复制循环时只需要给这些 PHI 补上来自副本的值。要求出口是专用的。
+     * 使用点不被单个出口块支配时（例如 break 和正常退出在循环后汇合），在汇合点也建立 PHI。
+     * 只添加 PHI，不改变 CFG，所以可以用同一棵支配树处理多个循环
+     */
+    void formLCSSA(const Loop* loop, const DominatorTree& dominators);
+
+    /**
+     * @brief 复制 LCSSA 形式的循环的全部块，返回新块。出口块中的 PHI 补上来自副本的值；
+     * 副本头结点的 PHI 保留来自前置块的项，但前置块并不跳到副本，由调用者改写
+     */
+    std::vector<BasicBlock*> cloneLoop(const Loop* loop, CloneMap& map);
+}
@@ -0,0 +1,37 @@
+//
+// Created by 陶子杨 on 25-12-13.
+//
+
+#pragma once
+
+#include "IR/PassManager.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace CC::IR {
+
+    /**
+     * @brief 优化级别（-O0/-O1/-O2）对应的默认流水线，格式同 parsePipeline
+     */
+    std::string_view getDefaultPipeline(int level);
+
+    /**
+     * @brief 按名称新建一个 pass，未知的名称返回 nullptr
+     */
+    std::unique_ptr<Pass> createPass(std::string_view name);
+
+    /**
+     * @brief 所有可用的 pass 名称，按注册顺序
+     */
+    std::vector<std::string_view> getPassNames();
+
+    /**
+     * @brief 解析逗号分隔的 pass 名称并依次加入 manager，名称两边的空白忽略。
+     * 有参数的 pass 写成 name<key=value;key=value>
+     * @return 遇到未知的名称时返回 false，error 中给出原因，manager 不被修改
+     */
+    bool parsePipeline(std::string_view spec, PassManager& manager, std::string& error);
+}
@@ -0,0 +1,37 @@
+//
+// Created by 陶子杨 on 25-12-13.
+//
+
+#pragma once
+
+#include "IR/PassManager.h"
+
+namespace CC::IR {
+
+    /**
+     * @brief 稀疏条件常量传播（Wegman-Zadeck）
+     *
+     * 在 SSA 图和 CFG 上同时传播：值的格是 未知 < 常量 < 不确定，只沿着可能执行的边合并 PHI，
+     * 条件是常量的分支只把一条出边标记为可执行。结束后把常量值替换进所有使用，
+     * 把条件已知的 COND_BR 改成 BR，再删掉不可达的块。
+     * 常量按 C0 的 32 位补码语义计算，会中止程序的除法和移位保持不确定，原样留到运行时
+     */
+    class SCCPPass final : public FunctionPass {
+    public:
+        [[nodiscard]] const char* getName() const override {
+            return "sccp";
+        }
+
+        size_t run(Function& function, AnalysisManager& analyses) override;
+
+        /**
+         * @brief 没有改动分支时 CFG 不变
+         */
+        [[nodiscard]] AnalysisSet getPreserved() const override {
+            return cfg_changed ? AnalysisSet() : AnalysisSet::cfgShape();
+        }
+
+    private:
+        bool cfg_changed = false;
+    };
+}
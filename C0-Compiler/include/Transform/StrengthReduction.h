@@ -0,0 +1,35 @@
+//
+// Created by 陶子杨 on 25-12-16.
+//
+
+#pragma once
+
+#include "IR/PassManager.h"
+
+namespace CC::IR {
+
+    /**
+     * @brief 归纳变量化简和强度削弱
+     *
+     * 同一循环中初值和步长都相同的基本归纳变量合并成一个。
+     * 循环中的 iv * m（m 是循环不变量）换成一个新的归纳变量：前置块里算出 start * m 和 step * m，
+     * 每次迭代在 iv 递增的位置加上 step * m。C0 的整数运算是 32 位回绕，乘法对加法的分配律
+     * 在回绕下仍然成立，所以不需要考虑溢出。原来的归纳变量只剩比较在用时交给 ADCE 之后的 pass 处理
+     */
+    class StrengthReductionPass final : public FunctionPass {
+    public:
+        [[nodiscard]] const char* getName() const override {
+            return "strength-reduce";
+        }
+
+        [[nodiscard]] AnalysisSet getRequired() const override {
+            return {AnalysisKind::LOOPS, AnalysisKind::INDUCTION_VARIABLES};
+        }
+
+        size_t run(Function& function, AnalysisManager& analyses) override;
+
+        [[nodiscard]] AnalysisSet getPreserved() const override {
+            return AnalysisSet::cfgShape();
+        }
+    };
+}
@@ -0,0 +1,39 @@
+//
+// Created by 陶子杨 on 25-12-18.
+//
+
+#pragma once
+
+#include "IR/PassManager.h"
+
+namespace CC::IR {
+
+    /**
+     * @brief 尾递归消除和尾调用标记
+     *
+     * 紧跟着 RET 的自递归调用改成跳回函数开头：入口块的内容移到一个新的循环头中，
+     * 每个参数在循环头里变成一个 PHI，递归调用处的实参作为回边上的值。
+     * 形如 return x + f(...) 或 return x * f(...) 的调用引入一个累加器，
+     * 递归处先把 x 合进累加器，其余返回点返回时再合上；C0 的加法和乘法都是 32 位回绕的，
+     * 交换律和结合律成立，结果与原来相同。
+     * 其余紧跟着返回它结果的调用标记为尾调用，留给后端改成跳转
+     */
+    class TailRecursionPass final : public FunctionPass {
+    public:
+        [[nodiscard]] const char* getName() const override {
+            return "tail-recursion";
+        }
+
+        size_t run(Function& function, AnalysisManager& analyses) override;
+
+        /**
+         * @brief 只标记尾调用时 CFG 不变
+         */
+        [[nodiscard]] AnalysisSet getPreserved() const override {
+            return cfg_changed ? AnalysisSet() : AnalysisSet::cfgShape();
+        }
+
+    private:
+        bool cfg_changed = false;
+    };
+}
@@ -5,5 +5,102 @@
 #include "AST/ExprisionNode.h"
 
 namespace CC {
+    namespace {
+        bool hasChildren(const Expression& node) {
+            switch (node.type) {
+            case ExpressionType::ASSIGNMENT_EXPR:
+            case ExpressionType::BINARY_EXPR:
+            case ExpressionType::UNARY_EXPR:
+            case ExpressionType::CALL_EXPR:
+            case ExpressionType::ARRAY_SUBSCRIPT_EXPR:
+            case ExpressionType::MEMBER_EXPR:
+            case ExpressionType::CONDITIONAL_EXPR:
+            case ExpressionType::ALLOC_EXPR:
+            case ExpressionType::LENGTH_EXPR:
+                return true;
+            default:
+                return false;
+            }
+        }
 
+        // 把节点的子表达式移交给 pending，节点本身随后只做浅析构
+        void takeChildren(Expression& node, std::vector<std::shared_ptr<Expression>>& pending) {
+            switch (node.type) {
+            case ExpressionType::ASSIGNMENT_EXPR: {
+                auto& assign = static_cast<AssignmentExpr&>(node);
+                pending.push_back(std::move(assign.left));
+                pending.push_back(std::move(assign.right));
+                break;
+            }
+            case ExpressionType::BINARY_EXPR: {
+                auto& binary = static_cast<BinaryExpr&>(node);
+                pending.push_back(std::move(binary.left));
+                pending.push_back(std::move(binary.right));
+                break;
+            }
+            case ExpressionType::UNARY_EXPR:
+                pending.push_back(std::move(static_cast<UnaryExpr&>(node).operand));
+                break;
+            case ExpressionType::CALL_EXPR: {
+                auto& call = static_cast<CallExpr&>(node);
+                pending.push_back(std::move(call.callee));
+                for (auto& arg : call.arguments) {
+                    pending.push_back(std::move(arg));
+                }
+                call.arguments.clear();
+                break;
+            }
+            case ExpressionType::ARRAY_SUBSCRIPT_EXPR: {
+                auto& subscript = static_cast<ArraySubscriptExpr&>(node);
+                pending.push_back(std::move(subscript.base));
+                pending.push_back(std::move(subscript.index));
+                break;
+            }
+            case ExpressionType::MEMBER_EXPR:
+                pending.push_back(std::move(static_cast<MemberExpr&>(node).base));
+                break;
+            case ExpressionType::CONDITIONAL_EXPR: {
+                auto& conditional = static_cast<ConditionalExpr&>(node);
+                pending.push_back(std::move(conditional.condition));
+                pending.push_back(std::move(conditional.thenExpr));
+                pending.push_back(std::move(conditional.elseExpr));
+                break;
+            }
+            case ExpressionType::ALLOC_EXPR:
+                pending.push_back(std::move(static_cast<AllocExpr&>(node).count));
+                break;
+            case ExpressionType::LENGTH_EXPR:
+                pending.push_back(std::move(static_cast<LengthExpr&>(node).array));
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    void Expression::collectChild(std::vector<std::shared_ptr<Expression>>& pending,
+                                  std::shared_ptr<Expression>& child) {
+        // 叶子节点和仍被别处引用的节点不会引起深层递归，照常释放即可
+        if (child && child.use_count() == 1 && hasChildren(*child)) {
+            pending.push_back(std::move(child));
+        }
+    }
+
+    void Expression::collectChild(std::vector<std::shared_ptr<Expression>>& pending,
+                                  std::vector<std::shared_ptr<Expression>>& children) {
+        for (auto& child : children) {
+            collectChild(pending, child);
+        }
+    }
+
+    void Expression::releaseTree(std::vector<std::shared_ptr<Expression>>& pending) {
+        while (!pending.empty()) {
+            std::shared_ptr<Expression> node = std::move(pending.back());
+            pending.pop_back();
+            if (node && node.use_count() == 1) {
+                takeChildren(*node, pending);
+            }
+            // node 在这里析构，它的子节点已经移交出去了
+        }
+    }
 }
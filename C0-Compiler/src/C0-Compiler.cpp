@@ -2,15 +2,69 @@
 // Created by 陶子杨 on 25-10-23.
 //
 #include "C0-Compiler.h"
-#include "Lexer/Lexer.h"
+#include "Compiler/IncrementalBuilder.h"
+#include "Infra/FileWatcher.h"
+#include "IR/IRPrinter.h"
 
+#include <chrono>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
 #include <string>
-#include <vector>
-#include <memory>
+#include <string_view>
 
-#include "Lexer/C0Lexer.h"
-#include "Parser/C0Parser.h"
+namespace {
+    std::optional<CC::LanguageLevel> parseLanguageLevel(std::string_view name) {
+        if (name == "l1") return CC::LanguageLevel::L1;
+        if (name == "l2") return CC::LanguageLevel::L2;
+        if (name == "l3") return CC::LanguageLevel::L3;
+        if (name == "l4") return CC::LanguageLevel::L4;
+        if (name == "c0") return CC::LanguageLevel::C0;
+        return std::nullopt;
+    }
+
+    void printDiagnostics(const CC::CompileResult& result) {
+        for (const auto& diagnostic : result.diagnostics) {
+            std::cerr << result.name;
+            if (diagnostic.location.line != 0) {
+                std::cerr << ":" << diagnostic.location.line << ":" << diagnostic.location.column;
+            }
+            std::cerr << ": 错误: " << diagnostic.message << std::endl;
+        }
+    }
+
+    // 监视模式：文件变化后只重新编译受影响的文件，直到进程被中断
+    int runWatch(const CC::CompilerInstance& compiler, const std::string& file_path) {
+        CC::IncrementalBuilder builder(compiler);
+        builder.addRoot(file_path);
+        INFRA::FileWatcher watcher;
+        while (true) {
+            auto start = std::chrono::steady_clock::now();
+            CC::BuildStats stats = builder.build();
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start);
+
+            for (const auto& path : stats.compiled_files) {
+                printDiagnostics(*builder.getResult(path));
+            }
+            size_t failed = 0;
+            for (const auto& path : builder.getFiles()) {
+                failed += builder.getResult(path)->success() ? 0 : 1;
+                watcher.watch(path);
+            }
+            std::cout << "重新编译 " << stats.compiled_files.size() << " 个文件，复用 " << stats.reused
+                      << " 个，用时 " << static_cast<double>(elapsed.count()) / 1000.0 << " ms";
+            if (failed != 0) {
+                std::cout << "，" << failed << " 个文件有错误";
+            }
+            std::cout << std::endl;
+
+            for (const auto& path : watcher.waitForChanges(std::chrono::milliseconds(10))) {
+                builder.invalidate(path);
+            }
+        }
+    }
+}
 
 int main(int argc, char* argv[]) {
     // 检查是否有输入参数
@@ -19,19 +73,90 @@ int main(int argc, char* argv[]) {
         std::cout << "可用参数:" << std::endl;
         std::cout << "  compile <输入文件>    编译指定的C0源文件" << std::endl;
         std::cout << "  help                 显示帮助信息" << std::endl;
+        std::cout << "  --lang=<l1|l2|l3|l4|c0>  按指定的语言层级解析，默认为 c0" << std::endl;
+        std::cout << "  -L<目录>                 添加 #use <库名> 查找 .c0i 的目录" << std::endl;
+        std::cout << "  --emit-interface=<输出>  把库头文件预编译成 .c0i 接口文件" << std::endl;
+        std::cout << "  --watch                  监视源文件及其 #use 的文件，修改后增量重新编译" << std::endl;
+        std::cout << "  -d                       动态检查 //@ 规约，删除可证明冗余的检查并把循环不变式提到循环之外" << std::endl;
+        std::cout << "  --emit-ir                把函数降低成 SSA 形式的 IR 并输出" << std::endl;
+        std::cout << "  -O0/-O1/-O2              IR 的优化级别，默认为 -O0" << std::endl;
+        std::cout << "  --passes=<p1,p2,...>     用指定的 pass 流水线代替优化级别的默认流水线" << std::endl;
+        std::cout << "  --pass-limit=<N>         只执行前 N 次 pass，用于二分定位出问题的 pass" << std::endl;
+        std::cout << "  --time-passes            输出各 pass 和分析的执行次数、修改数和用时" << std::endl;
         return 1;
     }
 
-    std::string file_path = argv[1];
-    CC::C0Lexer lexer(file_path);
-    // while (true) {
-    //     auto token = lexer.nextToken();
-    //     if (token.type == CC::TokenType::END_OF_FILE) {
-    //         break;
-    //     }
-    //     std::cout<<token.lexeme<<std::endl;
-    // }
-    CC::C0Parser parser(file_path);
-    parser.parse();
+    CC::CompilerOptions options;
+    std::string file_path;
+    std::string interface_path;
+    bool watch = false;
+    bool time_passes = false;
+    bool emit_ir = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg.rfind("--lang=", 0) == 0) {
+            auto level = parseLanguageLevel(arg.substr(7));
+            if (!level) {
+                std::cerr << "未知的语言层级: " << arg.substr(7) << std::endl;
+                return 1;
+            }
+            options.language_level = *level;
+        } else if (arg.rfind("-L", 0) == 0) {
+            options.library_paths.emplace_back(arg.substr(2));
+        } else if (arg.rfind("--emit-interface=", 0) == 0) {
+            interface_path = arg.substr(17);
+        } else if (arg == "--watch") {
+            watch = true;
+        } else if (arg == "-d") {
+            options.dynamic_checks = true;
+        } else if (arg == "--emit-ir") {
+            emit_ir = true;
+        } else if (arg == "-O0" || arg == "-O1" || arg == "-O2") {
+            options.optimization_level = arg[2] - '0';
+        } else if (arg.rfind("--passes=", 0) == 0) {
+            options.pass_pipeline = arg.substr(9);
+        } else if (arg.rfind("--pass-limit=", 0) == 0) {
+            try {
+                options.pass_limit = std::stoll(std::string(arg.substr(13)));
+            } catch (const std::exception&) {
+                std::cerr << "无效的 pass 执行次数: " << arg.substr(13) << std::endl;
+                return 1;
+            }
+        } else if (arg == "--time-passes") {
+            time_passes = true;
+        } else {
+            file_path = arg;
+        }
+    }
+
+    // 类型检查和明确赋值检查在降低到 IR 时进行，每次编译都要降低；
+    // #use "文件" 引入的声明在降低之前就已加入，监视模式下也一样
+    options.lower_to_ir = true;
+    CC::CompilerInstance compiler(options);
+    if (watch) {
+        return runWatch(compiler, file_path);
+    }
+
+    CC::CompileResult result = compiler.compileFile(file_path);
+    printDiagnostics(result);
+    if (time_passes) {
+        CC::IR::printStatistics(result.pass_stats, std::cerr);
+    }
+    if (!result.success()) {
+        return 1;
+    }
+
+    if (emit_ir && result.module) {
+        CC::IR::print(*result.module, std::cout);
+    }
+
+    if (!interface_path.empty()) {
+        try {
+            CC::LibraryInterface::write(*result.translation_unit, interface_path);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
     return 0;
 }
@@ -3,83 +3,146 @@
 //
 
 #include "CodeManager/CodeManager.h"
+#include <algorithm>
+#include <bit>
 #include <stdexcept>
 #include <iostream>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace CC {
-    CodeManager::CodeManager(const std::string& file_path) 
-        : location{1, 1}, current_pos(0) {
-        file_stream.open(file_path);
-        if (!file_stream.is_open()) {
-            throw std::runtime_error("无法打开文件: " + file_path);
+    namespace {
+        // 统计 [data, data + size) 中换行符的个数
+        size_t countNewlines(const char* data, size_t size) {
+            size_t count = 0;
+            size_t i = 0;
+#if defined(__SSE2__)
+            const __m128i newline = _mm_set1_epi8('\n');
+            for (; i + 16 <= size; i += 16) {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+                count += std::popcount(mask);
+            }
+#endif
+            for (; i < size; ++i) {
+                count += data[i] == '\n';
+            }
+            return count;
+        }
+
+        // 把每个换行符之后的偏移（即下一行的行首）追加到 line_starts
+        void collectLineStarts(const char* data, size_t size, std::vector<uint32_t>& line_starts) {
+            size_t i = 0;
+#if defined(__SSE2__)
+            const __m128i newline = _mm_set1_epi8('\n');
+            for (; i + 16 <= size; i += 16) {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+                while (mask != 0) {
+                    line_starts.push_back(static_cast<uint32_t>(i + std::countr_zero(mask) + 1));
+                    mask &= mask - 1;
+                }
+            }
+#endif
+            for (; i < size; ++i) {
+                if (data[i] == '\n') {
+                    line_starts.push_back(static_cast<uint32_t>(i + 1));
+                }
+            }
         }
-        
-        // 读取整个文件到缓冲区
-        file_stream.seekg(0, std::ios::end);
-        auto file_size = file_stream.tellg();
-        file_stream.seekg(0, std::ios::beg);
+    }
 
-        buffer.resize(file_size);
-        file_stream.read(buffer.data(), file_size);
+    CodeManager::CodeManager(const std::string& file_path)
+        : file(file_path), name(file_path), text(file.getText()), current_pos(0) {
+    }
+
+    CodeManager::CodeManager(std::string name, std::string_view source)
+        : name(std::move(name)), text(source), current_pos(0) {
+    }
+
+    const std::string& CodeManager::getName() const {
+        return name;
     }
 
     Location CodeManager::getLocation() const {
-        return location;
+        return getLocation(current_pos);
+    }
+
+    Location CodeManager::getLocation(size_t offset) const {
+        if (line_starts.empty()) {
+            buildLineStarts();
+        }
+        offset = std::min(offset, text.size());
+        // 找到最后一个不大于 offset 的行首
+        auto it = std::upper_bound(line_starts.begin(), line_starts.end(), offset);
+        size_t line = static_cast<size_t>(it - line_starts.begin());
+        return {line, offset - line_starts[line - 1] + 1};
     }
 
-    char CodeManager::lookChar() const {
-        if (current_pos >= buffer.size()) {
+    void CodeManager::buildLineStarts() const {
+        line_starts.reserve(countNewlines(text.data(), text.size()) + 1);
+        line_starts.push_back(0);
+        collectLineStarts(text.data(), text.size(), line_starts);
+    }
+
+    char CodeManager::lookChar(size_t k) const {
+        if (current_pos + k >= text.size()) {
             return '\0';
         }
-        return buffer[current_pos];
+        return text[current_pos + k];
     }
 
     char CodeManager::getChar() {
-        if (current_pos >= buffer.size()) {
+        if (current_pos >= text.size()) {
             eof_reached = true;
             return '\0';
         }
-        
-        char ch = buffer[current_pos++];
-        
-        if (ch == '\n') {
-            location.line++;
-            last_column = location.column;
-            location.column = 1;
-        } else {
-            location.column++;
-        }
-        
-        return ch;
+        return text[current_pos++];
     }
 
     void CodeManager::ungetChar() {
         if (current_pos > 0) {
             current_pos--;
-            char ch = buffer[current_pos];
-            
-            if (ch == '\n') {
-                location.line--;
-                // 简化处理，实际应该计算上一行的列数
-                location.column = last_column;
-            } else {
-                location.column--;
-            }
         }
     }
 
+    void CodeManager::skip(size_t n) {
+        current_pos = std::min(current_pos + n, text.size());
+    }
+
+    size_t CodeManager::getOffset() const {
+        return current_pos;
+    }
+
+    size_t CodeManager::remaining() const {
+        return current_pos < text.size() ? text.size() - current_pos : 0;
+    }
+
+    const char* CodeManager::current() const {
+        return text.data() + current_pos;
+    }
+
+    std::string_view CodeManager::getText(size_t offset, size_t length) const {
+        if (offset >= text.size()) {
+            return {};
+        }
+        return {text.data() + offset, std::min(length, text.size() - offset)};
+    }
+
     bool CodeManager::eofReached() const {
         return eof_reached;
     }
 
     void CodeManager::updateBuffer(std::vector<char>& new_buffer) {
         buffer = std::move(new_buffer);
+        text = {buffer.data(), buffer.size()};
+        line_starts.clear();
     }
 
     void CodeManager::restar() {
-        location = {1, 1};
         current_pos = 0;
         eof_reached = false;
-        last_column = 0;
     }
 }
@@ -0,0 +1,438 @@
+//
+// Created by 陶子杨 on 25-11-24.
+//
+
+#include "Compiler/CompilerInstance.h"
+#include "IR/IRLowering.h"
+#include "Transform/PassRegistry.h"
+#include "Parser/C0Parser.h"
+#include "Infra/casting.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace CC {
+    namespace {
+        // 把运行时的语言层级分派到对应的编译期实例上
+        template <typename Function>
+        CompileResult withLanguage(LanguageLevel level, Function&& function) {
+            switch (level) {
+            case LanguageLevel::L1:
+                return function(LangL1{});
+            case LanguageLevel::L2:
+                return function(LangL2{});
+            case LanguageLevel::L3:
+                return function(LangL3{});
+            case LanguageLevel::L4:
+                return function(LangL4{});
+            case LanguageLevel::C0:
+            default:
+                return function(LangC0{});
+            }
+        }
+
+        // 文件无法打开、库接口损坏等错误统一转成诊断信息，它们不对应源码中的位置
+        CompileResult failure(std::string name, const std::runtime_error& e) {
+            CompileResult result;
+            result.name = std::move(name);
+            result.diagnostics.push_back({kNoLocation, e.what()});
+            return result;
+        }
+
+        // 按优化级别或 --passes 建立流水线，流水线写错时记录诊断并返回 false
+        bool buildPipeline(IR::PassManager& manager, const CompilerOptions& options,
+                           std::vector<Diagnostic>& diagnostics) {
+            std::string_view pipeline = options.pass_pipeline.empty()
+                                            ? IR::getDefaultPipeline(options.optimization_level)
+                                            : std::string_view(options.pass_pipeline);
+            std::string error;
+            if (!IR::parsePipeline(pipeline, manager, error)) {
+                diagnostics.push_back({kNoLocation, error});
+                return false;
+            }
+            manager.setExecutionLimit(options.pass_limit);
+#ifndef NDEBUG
+            manager.setVerifyEach(true);
+#endif
+            return true;
+        }
+
+        void collectPipelineResults(const IR::PassManager& manager, const CodeManager& source,
+                                    CompileResult& result) {
+            result.pass_stats = manager.getStatistics();
+            for (const auto& problem : manager.getDiagnostics()) {
+                result.diagnostics.push_back({source.getLocation(problem.offset), problem.message});
+            }
+        }
+
+        void optimize(IR::Module& module, const CodeManager& source, const CompilerOptions& options,
+                      CompileResult& result) {
+            IR::PassManager manager;
+            if (!buildPipeline(manager, options, result.diagnostics) || manager.empty()) {
+                return;
+            }
+            manager.run(module);
+            collectPipelineResults(manager, source, result);
+        }
+
+        // #use 只能出现在文件开头，读到第一个其他 token 就停下
+        std::vector<std::string> scanUses(C0Lexer& lexer, const std::string& path) {
+            std::vector<std::string> dependencies;
+            std::filesystem::path directory = std::filesystem::path(path).parent_path();
+            while (true) {
+                Token token = lexer.nextToken();
+                if (token.type == TokenType::USE_FILE) {
+                    auto dependency = normalizeSourcePath((directory / std::string(lexer.getLexeme(token))).string());
+                    if (std::find(dependencies.begin(), dependencies.end(), dependency) == dependencies.end()) {
+                        dependencies.push_back(std::move(dependency));
+                    }
+                } else if (token.type != TokenType::USE_LIBRARY) {
+                    break;
+                }
+            }
+            return dependencies;
+        }
+
+        // 一个文件通过 #use "文件" 看到的内容，包括间接引入的
+        struct FileImports {
+            std::vector<std::string> typedef_names;
+            std::vector<std::shared_ptr<Declaration>> declarations;
+            std::vector<Diagnostic> diagnostics;  ///< 被引入文件中的错误和循环引用
+        };
+
+        struct ImportedFile {
+            std::vector<std::string> dependencies;
+            FileImports exports;  ///< 对引入它的文件可见的内容：它看到的加上它自己声明的
+            bool done = false;    ///< 依赖都已处理完，自己也解析过了
+        };
+
+        // 合并已经处理完的依赖导出的内容；还没处理完的依赖形成了环，跳过
+        FileImports collectImports(const std::unordered_map<std::string, ImportedFile>& files,
+                                   const std::vector<std::string>& dependencies) {
+            FileImports imports;
+            std::unordered_set<std::string_view> names;
+            std::unordered_set<const Declaration*> declarations;
+            for (const auto& dependency : dependencies) {
+                const ImportedFile& file = files.at(dependency);
+                if (!file.done) {
+                    continue;
+                }
+                for (const auto& name : file.exports.typedef_names) {
+                    if (names.insert(name).second) {
+                        imports.typedef_names.push_back(name);
+                    }
+                }
+                for (const auto& decl : file.exports.declarations) {
+                    if (declarations.insert(decl.get()).second) {
+                        imports.declarations.push_back(decl);
+                    }
+                }
+            }
+            return imports;
+        }
+
+        std::vector<std::string> scanUsesOrNothing(const std::string& path) {
+            try {
+                return scanUseFiles(path);
+            } catch (const std::runtime_error&) {
+                // 打不开的文件在解析时报告
+                return {};
+            }
+        }
+
+        /**
+         * @brief 从 file_path 出发解析它直接和间接 #use 的文件，依赖在前，每个文件只解析一次
+         *
+         * 和 IncrementalBuilder 一样用显式栈做后序遍历，遇到正在访问的文件说明有循环引用，报告后忽略这条边
+         */
+        template <typename Parser>
+        FileImports importFiles(const std::string& file_path, const CompilerOptions& options,
+                                LibraryRegistry* libraries) {
+            FileImports result;
+            std::unordered_map<std::string, ImportedFile> files;
+            std::string root = normalizeSourcePath(file_path);
+            files[root].dependencies = scanUsesOrNothing(root);
+            std::vector<std::pair<std::string, size_t>> stack{{root, 0}};
+            while (!stack.empty()) {
+                auto& [path, next] = stack.back();
+                ImportedFile& file = files[path];
+                if (next < file.dependencies.size()) {
+                    const std::string& dependency = file.dependencies[next++];
+                    auto found = files.find(dependency);
+                    if (found == files.end()) {
+                        files[dependency].dependencies = scanUsesOrNothing(dependency);
+                        stack.emplace_back(dependency, 0);
+                    } else if (!found->second.done) {
+                        result.diagnostics.push_back({kNoLocation, "循环引用 #use \"" + dependency + "\""});
+                    }
+                    continue;
+                }
+
+                file.exports = collectImports(files, file.dependencies);
+                file.done = true;
+                if (path != root) {
+                    try {
+                        std::shared_ptr<TranslationUnit> unit;
+                        {
+                            Parser parser(path, options.memory_resource);
+                            parser.setLibraryRegistry(libraries);
+                            parser.addTypedefNames(file.exports.typedef_names);
+                            parser.parse();
+                            // 诊断的位置属于被引入的文件，换成消息里的文件名和行列号
+                            for (const auto& diagnostic : parser.getDiagnostics()) {
+                                result.diagnostics.push_back(
+                                    {kNoLocation, path + ":" + std::to_string(diagnostic.location.line) + ":" +
+                                                      std::to_string(diagnostic.location.column) + ": " +
+                                                      diagnostic.message});
+                            }
+                            unit = parser.getTranslationUnit();
+                        }
+                        for (const auto& decl : unit->declarations) {
+                            if (auto typedef_decl = INFRA::dyn_cast<TypedefDecl>(decl)) {
+                                file.exports.typedef_names.push_back(typedef_decl->name);
+                            }
+                            file.exports.declarations.push_back(decl);
+                        }
+                    } catch (const std::runtime_error& e) {
+                        result.diagnostics.push_back({kNoLocation, e.what()});
+                    }
+                }
+                stack.pop_back();
+            }
+
+            FileImports imports = collectImports(files, files[root].dependencies);
+            imports.diagnostics = std::move(result.diagnostics);
+            return imports;
+        }
+
+        template <typename Parser>
+        CompileResult runParser(Parser& parser, std::string name, const CompilerOptions& options,
+                                const std::vector<std::shared_ptr<Declaration>>& imported) {
+            parser.parse();
+            CompileResult result;
+            result.name = std::move(name);
+            result.translation_unit = parser.getTranslationUnit();
+            result.diagnostics = parser.getDiagnostics();
+            if (options.dynamic_checks && result.success()) {
+                ContractLowering lowering(options.memory_resource);
+                for (const auto& decl : result.translation_unit->declarations) {
+                    if (auto function = INFRA::dyn_cast<FunctionDecl>(decl)) {
+                        lowering.run(*function);
+                    }
+                }
+                result.contract_stats = lowering.getStats();
+            }
+            if (options.lower_to_ir && result.success()) {
+                result.module = IR::lowerTranslationUnit(*result.translation_unit, imported,
+                                                         parser.getCodeManager(), result.diagnostics);
+                if (result.success()) {
+                    optimize(*result.module, parser.getCodeManager(), options, result);
+                }
+            }
+            return result;
+        }
+
+        // 流式编译中把一个函数降低到只含它自己的模块并优化，成功时交给 consumer
+        void lowerFunction(const FunctionDecl& function, const GlobalDeclarations& globals, const CodeManager& source,
+                           IR::PassManager& manager, FunctionConsumer& consumer,
+                           std::vector<Diagnostic>& diagnostics) {
+            IR::Module module;
+            IR::IRLowering lowering(module, globals, source);
+            bool lowered = lowering.lower(function) != nullptr && lowering.getDiagnostics().empty();
+            diagnostics.insert(diagnostics.end(), lowering.getDiagnostics().begin(), lowering.getDiagnostics().end());
+            if (!lowered) {
+                return;
+            }
+            size_t problems = manager.getDiagnostics().size();
+            manager.run(module);
+            // 缓存的分析以函数地址为键，模块销毁之后地址可能被下一个函数重用
+            manager.getAnalyses().clear();
+            if (manager.getDiagnostics().size() == problems) {
+                consumer.consumeModule(module);
+            }
+        }
+
+        template <typename Parser>
+        CompileResult runStreamingParser(Parser& parser, std::string name, const CompilerOptions& options,
+                                         FunctionConsumer& consumer,
+                                         const std::vector<std::shared_ptr<Declaration>>& imported) {
+            std::pmr::memory_resource* resident = options.memory_resource;
+            GlobalDeclarations globals(resident);
+            for (const auto& decl : imported) {
+                globals.addDeclaration(decl);
+            }
+            ContractStats contract_stats;
+            // 每个函数单独降低成一个模块并跑一遍流水线，流水线的统计和执行次数上限跨函数累计
+            std::vector<Diagnostic> lowering_diagnostics;
+            IR::PassManager manager;
+            bool lower_to_ir = options.lower_to_ir && buildPipeline(manager, options, lowering_diagnostics);
+            // 每个函数的AST都分配在这里，处理完整体归还给上游
+            std::pmr::monotonic_buffer_resource function_arena(resident);
+
+            while (!parser.atEnd()) {
+                if (parser.nextIsTypeDeclaration()) {
+                    // 结构体、类型别名和 #use 直接分配在常驻内存上
+                    parser.setMemoryResource(resident);
+                    auto decl = parser.parseNextDeclaration();
+                    if (auto structDecl = INFRA::dyn_cast<StructDecl>(decl)) {
+                        globals.addStruct(std::move(structDecl));
+                    } else if (auto typedefDecl = INFRA::dyn_cast<TypedefDecl>(decl)) {
+                        globals.addTypedef(std::move(typedefDecl));
+                    } else if (auto useDecl = INFRA::dyn_cast<UseDecl>(decl)) {
+                        globals.addLibrary(useDecl->library);
+                    }
+                    continue;
+                }
+
+                // 类型可能带 '*'、'[]'，预读窗口分不清函数和变量，统一先放进函数内存池
+                parser.setMemoryResource(&function_arena);
+                size_t errors = parser.getDiagnostics().size();
+                {
+                    auto decl = parser.parseNextDeclaration();
+                    if (auto variableDecl = INFRA::dyn_cast<VariableDecl>(decl)) {
+                        // C0 没有全局变量，这里只在常驻内存上留下名字和类型
+                        globals.addVariable(makeNode<VariableDecl>(resident, variableDecl->name,
+                                                                   variableDecl->type, nullptr));
+                    }
+                    auto function = INFRA::dyn_cast<FunctionDecl>(decl);
+                    if (function) {
+                        globals.addFunctionSignature(*function);
+                        if (function->body && parser.getDiagnostics().size() == errors) {
+                            if (options.dynamic_checks) {
+                                ContractLowering lowering(&function_arena);
+                                lowering.run(*function);
+                                contract_stats += lowering.getStats();
+                            }
+                            consumer.consume(function, globals);
+                            if (lower_to_ir) {
+                                lowerFunction(*function, globals, parser.getCodeManager(), manager, consumer,
+                                              lowering_diagnostics);
+                            }
+                        }
+                    }
+                }
+                // 函数的AST已经全部析构，可以整体释放
+                function_arena.release();
+                parser.releaseStringLiterals();
+            }
+
+            CompileResult result;
+            result.name = std::move(name);
+            result.diagnostics = parser.getDiagnostics();
+            result.diagnostics.insert(result.diagnostics.end(), lowering_diagnostics.begin(),
+                                      lowering_diagnostics.end());
+            result.contract_stats = contract_stats;
+            if (lower_to_ir) {
+                collectPipelineResults(manager, parser.getCodeManager(), result);
+            }
+            return result;
+        }
+    }
+
+    CompilerInstance::CompilerInstance(CompilerOptions options)
+        : options(std::move(options)) {
+        std::vector<std::string> library_paths = this->options.library_paths;
+#ifdef C0_LIBRARY_DIR
+        if (library_paths.empty()) {
+            library_paths.emplace_back(C0_LIBRARY_DIR);
+        }
+#endif
+        libraries = std::make_shared<LibraryRegistry>(std::move(library_paths));
+    }
+
+    CompileResult CompilerInstance::compile(const SourceBuffer& source) const {
+        try {
+            return withLanguage(options.language_level, [&](auto lang) {
+                BasicC0Parser<decltype(lang)> parser(source.name, source.text, options.memory_resource);
+                parser.setLibraryRegistry(libraries.get());
+                parser.addTypedefNames(source.imported_typedefs);
+                return runParser(parser, source.name, options, source.imported_declarations);
+            });
+        } catch (const std::runtime_error& e) {
+            return failure(source.name, e);
+        }
+    }
+
+    CompileResult CompilerInstance::compileFile(const std::string& file_path) const {
+        try {
+            return withLanguage(options.language_level, [&](auto lang) {
+                using Parser = BasicC0Parser<decltype(lang)>;
+                FileImports imports;
+                if constexpr (decltype(lang)::libraries) {
+                    imports = importFiles<Parser>(file_path, options, libraries.get());
+                }
+                Parser parser(file_path, options.memory_resource);
+                parser.setLibraryRegistry(libraries.get());
+                parser.addTypedefNames(imports.typedef_names);
+                CompileResult result = runParser(parser, file_path, options, imports.declarations);
+                result.diagnostics.insert(result.diagnostics.begin(), imports.diagnostics.begin(),
+                                          imports.diagnostics.end());
+                return result;
+            });
+        } catch (const std::runtime_error& e) {
+            return failure(file_path, e);
+        }
+    }
+
+    CompileResult CompilerInstance::compileStreaming(const SourceBuffer& source, FunctionConsumer& consumer) const {
+        try {
+            return withLanguage(options.language_level, [&](auto lang) {
+                BasicC0Parser<decltype(lang)> parser(source.name, source.text, options.memory_resource);
+                parser.setLibraryRegistry(libraries.get());
+                parser.addTypedefNames(source.imported_typedefs);
+                return runStreamingParser(parser, source.name, options, consumer, source.imported_declarations);
+            });
+        } catch (const std::runtime_error& e) {
+            return failure(source.name, e);
+        }
+    }
+
+    CompileResult CompilerInstance::compileFileStreaming(const std::string& file_path,
+                                                         FunctionConsumer& consumer) const {
+        try {
+            return withLanguage(options.language_level, [&](auto lang) {
+                using Parser = BasicC0Parser<decltype(lang)>;
+                FileImports imports;
+                if constexpr (decltype(lang)::libraries) {
+                    imports = importFiles<Parser>(file_path, options, libraries.get());
+                }
+                Parser parser(file_path, options.memory_resource);
+                parser.setLibraryRegistry(libraries.get());
+                parser.addTypedefNames(imports.typedef_names);
+                CompileResult result = runStreamingParser(parser, file_path, options, consumer, imports.declarations);
+                result.diagnostics.insert(result.diagnostics.begin(), imports.diagnostics.begin(),
+                                          imports.diagnostics.end());
+                return result;
+            });
+        } catch (const std::runtime_error& e) {
+            return failure(file_path, e);
+        }
+    }
+
+    std::vector<std::string> scanUseFiles(const std::string& path, std::string_view text) {
+        C0Lexer lexer(path, text);
+        return scanUses(lexer, path);
+    }
+
+    std::vector<std::string> scanUseFiles(const std::string& path) {
+        C0Lexer lexer(path);
+        return scanUses(lexer, path);
+    }
+
+    std::string normalizeSourcePath(const std::string& file_path) {
+        std::error_code error;
+        auto path = std::filesystem::weakly_canonical(std::filesystem::absolute(file_path, error), error);
+        return error ? file_path : path.string();
+    }
+
+    const CompilerOptions& CompilerInstance::getOptions() const {
+        return options;
+    }
+
+    LibraryRegistry& CompilerInstance::getLibraries() const {
+        return *libraries;
+    }
+}
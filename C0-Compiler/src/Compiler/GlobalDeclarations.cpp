@@ -0,0 +1,116 @@
+//
+// Created by 陶子杨 on 25-11-26.
+//
+
+#include "Compiler/GlobalDeclarations.h"
+#include "Infra/casting.h"
+
+namespace CC {
+    GlobalDeclarations::GlobalDeclarations(std::pmr::memory_resource* resource)
+        : memory_resource(resource) {
+    }
+
+    void GlobalDeclarations::addDeclaration(const std::shared_ptr<Declaration>& decl) {
+        if (auto struct_decl = INFRA::dyn_cast<StructDecl>(decl)) {
+            addStruct(std::move(struct_decl));
+        } else if (auto typedef_decl = INFRA::dyn_cast<TypedefDecl>(decl)) {
+            addTypedef(std::move(typedef_decl));
+        } else if (auto use_decl = INFRA::dyn_cast<UseDecl>(decl)) {
+            addLibrary(use_decl->library);
+        } else if (auto function_decl = INFRA::dyn_cast<FunctionDecl>(decl)) {
+            addFunctionSignature(*function_decl);
+        }
+    }
+
+    void GlobalDeclarations::addStruct(std::shared_ptr<StructDecl> decl) {
+        // 前置声明不覆盖已有的定义
+        auto it = struct_index.find(decl->name);
+        if (it != struct_index.end() && !decl->isDefinition) {
+            return;
+        }
+        struct_index[decl->name] = structs.size();
+        structs.push_back(std::move(decl));
+    }
+
+    void GlobalDeclarations::addFunctionSignature(const FunctionDecl& decl) {
+        // 原型和定义可能重复出现，保留第一次的签名
+        if (function_index.count(decl.name) != 0) {
+            return;
+        }
+        std::vector<std::shared_ptr<VariableDecl>> parameters;
+        parameters.reserve(decl.parameters.size());
+        for (const auto& parameter : decl.parameters) {
+            parameters.push_back(makeNode<VariableDecl>(memory_resource, parameter->name, parameter->type, nullptr));
+        }
+        function_index[decl.name] = functions.size();
+        functions.push_back(makeNode<FunctionDecl>(memory_resource, decl.name, decl.returnType,
+                                                   std::move(parameters), nullptr));
+    }
+
+    void GlobalDeclarations::addVariable(std::shared_ptr<VariableDecl> decl) {
+        variables.push_back(std::move(decl));
+    }
+
+    void GlobalDeclarations::addTypedef(std::shared_ptr<TypedefDecl> decl) {
+        typedef_index[decl->name] = typedefs.size();
+        typedefs.push_back(std::move(decl));
+    }
+
+    void GlobalDeclarations::addLibrary(std::shared_ptr<const LibraryInterface> library) {
+        if (!library) {
+            return;
+        }
+        for (const auto& used : libraries) {
+            if (used == library) {
+                return;
+            }
+        }
+        libraries.push_back(std::move(library));
+    }
+
+    const StructDecl* GlobalDeclarations::findStruct(std::string_view name) const {
+        auto it = struct_index.find(std::string(name));
+        return it == struct_index.end() ? nullptr : structs[it->second].get();
+    }
+
+    const FunctionDecl* GlobalDeclarations::findFunction(std::string_view name) const {
+        auto it = function_index.find(std::string(name));
+        return it == function_index.end() ? nullptr : functions[it->second].get();
+    }
+
+    const TypedefDecl* GlobalDeclarations::findTypedef(std::string_view name) const {
+        auto it = typedef_index.find(std::string(name));
+        return it == typedef_index.end() ? nullptr : typedefs[it->second].get();
+    }
+
+    std::optional<LibraryFunction> GlobalDeclarations::findLibraryFunction(std::string_view name) const {
+        for (const auto& library : libraries) {
+            if (auto function = library->findFunction(name)) {
+                return function;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<LibraryStruct> GlobalDeclarations::findLibraryStruct(std::string_view name) const {
+        for (const auto& library : libraries) {
+            if (auto found = library->findStruct(name)) {
+                return found;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<std::string_view> GlobalDeclarations::findLibraryTypedef(std::string_view name) const {
+        // 类型别名在 .c0i 中按声明顺序保存，只能逐个比较
+        for (const auto& library : libraries) {
+            for (size_t i = 0; i < library->getTypedefCount(); ++i) {
+                LibraryVariable alias = library->getTypedef(i);
+                if (alias.name == name) {
+                    return alias.type;
+                }
+            }
+        }
+        return std::nullopt;
+    }
+}
@@ -0,0 +1,290 @@
+//
+// Created by 陶子杨 on 25-12-5.
+//
+
+#include "Compiler/IncrementalBuilder.h"
+#include "Infra/casting.h"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <sstream>
+#include <unordered_set>
+
+namespace CC {
+    namespace {
+        bool readFile(const std::string& path, std::string& text) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file.is_open()) {
+                return false;
+            }
+            std::ostringstream content;
+            content << file.rdbuf();
+            text = std::move(content).str();
+            return true;
+        }
+
+        // 声明对引入它的文件可见的部分写成文字，用来判断接口是否变化；函数只看签名
+        std::string describeInterface(const Declaration& decl) {
+            if (auto typedef_decl = INFRA::dyn_cast<TypedefDecl>(&decl)) {
+                return "typedef " + typedef_decl->type + " " + typedef_decl->name;
+            }
+            if (auto struct_decl = INFRA::dyn_cast<StructDecl>(&decl)) {
+                std::string text = "struct " + struct_decl->name;
+                if (struct_decl->isDefinition) {
+                    text += " {";
+                    for (const auto& member : struct_decl->members) {
+                        text += " " + member->type + " " + member->name + ";";
+                    }
+                    text += " }";
+                }
+                return text;
+            }
+            if (auto function_decl = INFRA::dyn_cast<FunctionDecl>(&decl)) {
+                std::string text = function_decl->returnType + " " + function_decl->name + "(";
+                for (const auto& parameter : function_decl->parameters) {
+                    text += parameter->type + ",";
+                }
+                return text + ")";
+            }
+            if (auto use_decl = INFRA::dyn_cast<UseDecl>(&decl)) {
+                return "#use " + use_decl->name;
+            }
+            return "";
+        }
+
+        CompileResult openFailure(const std::string& path) {
+            CompileResult result;
+            result.name = path;
+            result.diagnostics.push_back({kNoLocation, "无法打开文件: " + path});
+            return result;
+        }
+    }
+
+    IncrementalBuilder::IncrementalBuilder(const CompilerInstance& compiler)
+        : compiler(compiler) {
+    }
+
+    std::string IncrementalBuilder::normalizePath(const std::string& file_path) {
+        return normalizeSourcePath(file_path);
+    }
+
+    void IncrementalBuilder::addRoot(const std::string& file_path) {
+        std::string path = normalizePath(file_path);
+        if (std::find(roots.begin(), roots.end(), path) == roots.end()) {
+            roots.push_back(path);
+        }
+        nodes.try_emplace(path);
+    }
+
+    void IncrementalBuilder::invalidate(const std::string& file_path) {
+        auto it = nodes.find(normalizePath(file_path));
+        if (it != nodes.end()) {
+            it->second.dirty = true;
+        }
+    }
+
+    BuildStats IncrementalBuilder::build() {
+        BuildStats stats;
+
+        // 1. 重新读取被标记的文件，新发现的依赖也加入依赖图
+        std::unordered_map<std::string, std::string> texts;
+        std::vector<std::string> pending;
+        for (const auto& [path, node] : nodes) {
+            if (node.dirty) {
+                pending.push_back(path);
+            }
+        }
+        while (!pending.empty()) {
+            std::string path = std::move(pending.back());
+            pending.pop_back();
+            FileNode& node = nodes[path];
+            if (!node.dirty) {
+                continue;
+            }
+            std::string text;
+            if (refresh(path, node, text) && node.needs_compile) {
+                texts[path] = std::move(text);
+            }
+            for (const auto& dependency : node.dependencies) {
+                if (nodes.try_emplace(dependency).second) {
+                    pending.push_back(dependency);
+                }
+            }
+        }
+
+        // 2. 依赖在前依次处理，只有自身内容或引入的接口变化时才重新编译
+        for (const auto& path : sortFiles()) {
+            FileNode& node = nodes[path];
+            bool imports_changed = std::any_of(node.dependencies.begin(), node.dependencies.end(),
+                                               [&](const std::string& dependency) {
+                                                   return nodes[dependency].exports_changed;
+                                               });
+            if (!node.needs_compile && !imports_changed) {
+                ++stats.reused;
+                continue;
+            }
+            auto text = texts.find(path);
+            if (text != texts.end()) {
+                compileNode(path, node, text->second);
+            } else {
+                std::string content;
+                if (readFile(path, content)) {
+                    compileNode(path, node, content);
+                } else {
+                    node.result = openFailure(path);
+                }
+            }
+            stats.compiled_files.push_back(path);
+        }
+
+        for (auto& [path, node] : nodes) {
+            node.exports_changed = false;
+        }
+        return stats;
+    }
+
+    bool IncrementalBuilder::refresh(const std::string& path, FileNode& node, std::string& text) {
+        node.dirty = false;
+        if (!readFile(path, text)) {
+            node.result = openFailure(path);
+            node.dependencies.clear();
+            node.exports_changed = !node.exported_interface.empty();
+            node.exported_typedefs.clear();
+            node.exported_declarations.clear();
+            node.exported_interface.clear();
+            node.loaded = false;
+            // 在第 2 步再报告一次打不开，让这个错误出现在本次构建的结果里
+            node.needs_compile = true;
+            return false;
+        }
+        uint64_t hash = std::hash<std::string_view>{}(text);
+        if (node.loaded && hash == node.content_hash && node.cyclic_uses.empty()) {
+            // 只是被触碰了，内容没变
+            return true;
+        }
+        node.content_hash = hash;
+        node.needs_compile = true;
+        node.dependencies = scanUseFiles(path, text);
+        return true;
+    }
+
+    std::vector<std::string> IncrementalBuilder::sortFiles() {
+        enum class Mark { VISITING, DONE };
+        std::unordered_map<std::string, Mark> marks;
+        std::vector<std::string> order;
+        std::vector<std::pair<std::string, std::string>> cycles;
+
+        // 显式栈的后序遍历，栈中记录下一个要访问的依赖下标
+        for (const auto& root : roots) {
+            if (marks.count(root) != 0) {
+                continue;
+            }
+            std::vector<std::pair<std::string, size_t>> stack{{root, 0}};
+            marks[root] = Mark::VISITING;
+            while (!stack.empty()) {
+                auto& [path, next] = stack.back();
+                const auto& dependencies = nodes[path].dependencies;
+                if (next == dependencies.size()) {
+                    marks[path] = Mark::DONE;
+                    order.push_back(path);
+                    stack.pop_back();
+                    continue;
+                }
+                const std::string& dependency = dependencies[next++];
+                auto mark = marks.find(dependency);
+                if (mark == marks.end()) {
+                    marks[dependency] = Mark::VISITING;
+                    stack.emplace_back(dependency, 0);
+                } else if (mark->second == Mark::VISITING) {
+                    cycles.emplace_back(path, dependency);
+                }
+            }
+        }
+
+        // 入口文件不再引入的文件移出依赖图
+        for (auto it = nodes.begin(); it != nodes.end();) {
+            it = marks.count(it->first) == 0 ? nodes.erase(it) : std::next(it);
+        }
+
+        // 去掉形成环的那条边，下次构建重新扫描时会恢复；
+        // 循环引用的文件每次都重新编译，这样报错不会因为复用缓存而消失
+        for (auto& [path, node] : nodes) {
+            node.cyclic_uses.clear();
+        }
+        for (const auto& [from, to] : cycles) {
+            FileNode& node = nodes[from];
+            node.needs_compile = true;
+            node.dirty = true;
+            node.dependencies.erase(std::remove(node.dependencies.begin(), node.dependencies.end(), to),
+                                    node.dependencies.end());
+            node.cyclic_uses.push_back(to);
+        }
+        return order;
+    }
+
+    void IncrementalBuilder::compileNode(const std::string& path, FileNode& node, const std::string& text) {
+        SourceBuffer source{path, text, {}, {}};
+        std::unordered_set<std::string> seen;
+        std::unordered_set<const Declaration*> seen_declarations;
+        for (const auto& dependency : node.dependencies) {
+            const FileNode& imported = nodes[dependency];
+            for (const auto& name : imported.exported_typedefs) {
+                if (seen.insert(name).second) {
+                    source.imported_typedefs.push_back(name);
+                }
+            }
+            for (const auto& decl : imported.exported_declarations) {
+                if (seen_declarations.insert(decl.get()).second) {
+                    source.imported_declarations.push_back(decl);
+                }
+            }
+        }
+
+        node.result = compiler.compile(source);
+        node.loaded = true;
+        node.needs_compile = false;
+        for (const auto& dependency : node.cyclic_uses) {
+            node.result.diagnostics.push_back({kNoLocation, "循环引用 #use \"" + dependency + "\""});
+        }
+
+        // #use "文件" 相当于把文件内容引入进来，间接引入的声明也继续对外可见
+        std::vector<std::string> exports = std::move(source.imported_typedefs);
+        std::vector<std::shared_ptr<Declaration>> declarations = std::move(source.imported_declarations);
+        if (node.result.translation_unit) {
+            for (const auto& decl : node.result.translation_unit->declarations) {
+                if (auto typedefDecl = INFRA::dyn_cast<TypedefDecl>(decl)) {
+                    if (seen.insert(typedefDecl->name).second) {
+                        exports.push_back(typedefDecl->name);
+                    }
+                }
+                declarations.push_back(decl);
+            }
+        }
+        std::vector<std::string> interface;
+        for (const auto& decl : declarations) {
+            if (std::string text = describeInterface(*decl); !text.empty()) {
+                interface.push_back(std::move(text));
+            }
+        }
+        node.exports_changed = interface != node.exported_interface;
+        node.exported_typedefs = std::move(exports);
+        node.exported_declarations = std::move(declarations);
+        node.exported_interface = std::move(interface);
+    }
+
+    std::vector<std::string> IncrementalBuilder::getFiles() const {
+        std::vector<std::string> files;
+        files.reserve(nodes.size());
+        for (const auto& [path, node] : nodes) {
+            files.push_back(path);
+        }
+        return files;
+    }
+
+    const CompileResult* IncrementalBuilder::getResult(const std::string& file_path) const {
+        auto it = nodes.find(normalizePath(file_path));
+        return it == nodes.end() ? nullptr : &it->second.result;
+    }
+}
@@ -0,0 +1,253 @@
+//
+// Created by 陶子杨 on 25-12-20.
+//
+
+#include "IR/AliasAnalysis.h"
+#include "Infra/casting.h"
+
+#include <algorithm>
+#include <map>
+
+namespace CC::IR {
+    namespace {
+        bool isAllocation(const Value* value) {
+            auto instruction = INFRA::dyn_cast<Instruction>(value);
+            return instruction != nullptr &&
+                   (instruction->getOpcode() == Opcode::ALLOC || instruction->getOpcode() == Opcode::ALLOC_ARRAY);
+        }
+
+        bool isAddressComputation(const Value* value) {
+            auto instruction = INFRA::dyn_cast<Instruction>(value);
+            return instruction != nullptr && (instruction->getOpcode() == Opcode::FIELD_ADDR ||
+                                              instruction->getOpcode() == Opcode::ELEMENT_ADDR);
+        }
+
+        /**
+         * @brief 分配得到的指针（或由它算出的地址）是否可能被别处拿到
+         */
+        bool isCaptured(const Instruction* object) {
+            std::vector<const Value*> worklist{object};
+            while (!worklist.empty()) {
+                const Value* pointer = worklist.back();
+                worklist.pop_back();
+                for (Use* use = pointer->getFirstUse(); use; use = use->getNext()) {
+                    const Instruction* user = use->getUser();
+                    switch (user->getOpcode()) {
+                    case Opcode::LOAD:
+                    case Opcode::ARRAY_LENGTH:
+                    case Opcode::EQ:
+                    case Opcode::NE:
+                        break;
+                    case Opcode::STORE:
+                        // 作为地址没关系，作为值写进内存就逃逸了
+                        if (&user->getOperandUse(1) != use) {
+                            return true;
+                        }
+                        break;
+                    case Opcode::FIELD_ADDR:
+                    case Opcode::ELEMENT_ADDR:
+                        if (&user->getOperandUse(0) == use) {
+                            worklist.push_back(user);
+                        }
+                        break;
+                    default:
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief 把下标拆成 index + 常量，只看加减常量
+         */
+        AccessStep makeElementStep(const Value* index) {
+            int64_t offset = 0;
+            while (auto instruction = INFRA::dyn_cast<Instruction>(index)) {
+                Opcode opcode = instruction->getOpcode();
+                if (opcode != Opcode::ADD && opcode != Opcode::SUB) {
+                    break;
+                }
+                if (auto constant = INFRA::dyn_cast<Constant>(instruction->getOperand(1))) {
+                    offset += opcode == Opcode::ADD ? constant->getValue() : -int64_t{constant->getValue()};
+                    index = instruction->getOperand(0);
+                } else if (auto constant = INFRA::dyn_cast<Constant>(instruction->getOperand(0));
+                           constant != nullptr && opcode == Opcode::ADD) {
+                    offset += constant->getValue();
+                    index = instruction->getOperand(1);
+                } else {
+                    break;
+                }
+            }
+            if (auto constant = INFRA::dyn_cast<Constant>(index)) {
+                return {true, nullptr, offset + constant->getValue()};
+            }
+            return {true, index, offset};
+        }
+
+        /**
+         * @brief 下标按 32 位回绕，比较时只看低 32 位
+         */
+        bool sameOffset(int64_t a, int64_t b) {
+            return static_cast<uint32_t>(a) == static_cast<uint32_t>(b);
+        }
+    }
+
+    AliasAnalysis::AliasAnalysis(const Function& function) {
+        std::vector<const Instruction*> phis;
+        for (BasicBlock* block : function.getBlocks()) {
+            for (Instruction* instruction = block->front(); instruction; instruction = instruction->getNext()) {
+                if (isAllocation(instruction) && !isCaptured(instruction)) {
+                    local_objects.insert(instruction);
+                } else if (instruction->isPhi() && instruction->getType() == Type::PTR) {
+                    phis.push_back(instruction);
+                }
+            }
+        }
+
+        // 汇入了对象内部地址的 PHI 不再指向对象开头，沿着 PHI 之间的边传播到不动点
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (const Instruction* phi : phis) {
+                if (interior_phis.contains(phi)) {
+                    continue;
+                }
+                for (uint32_t i = 0; i < phi->getOperandCount(); ++i) {
+                    const Value* incoming = phi->getOperand(i);
+                    if (isAddressComputation(incoming) || interior_phis.contains(incoming)) {
+                        interior_phis.insert(phi);
+                        changed = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        // 同一个地址以同一种类型访问的指令共用一个编号
+        std::map<std::pair<const Value*, Type>, uint32_t> by_address;
+        for (BasicBlock* block : function.getBlocks()) {
+            for (Instruction* instruction = block->front(); instruction; instruction = instruction->getNext()) {
+                if (isAllocation(instruction)) {
+                    location_ids.emplace(instruction, static_cast<uint32_t>(locations.size()));
+                    locations.push_back({instruction, Type::VOID, instruction, {}});
+                    continue;
+                }
+                if (instruction->getOpcode() != Opcode::LOAD && instruction->getOpcode() != Opcode::STORE) {
+                    continue;
+                }
+                MemoryLocation location = getLocation(instruction);
+                auto [it, inserted] = by_address.try_emplace({location.address, location.type},
+                                                             static_cast<uint32_t>(locations.size()));
+                if (inserted) {
+                    locations.push_back(std::move(location));
+                }
+                location_ids.emplace(instruction, it->second);
+            }
+        }
+    }
+
+    MemoryLocation AliasAnalysis::getLocation(const Value* address, Type type) const {
+        MemoryLocation location{address, type, address, {}};
+        // 从外往里走，收集到的路径是反的
+        while (auto instruction = INFRA::dyn_cast<Instruction>(location.object)) {
+            if (instruction->getOpcode() == Opcode::FIELD_ADDR) {
+                if (!location.path.empty() && !location.path.back().is_element) {
+                    location.path.back().offset += instruction->getImmediate();
+                } else {
+                    location.path.push_back({false, nullptr, instruction->getImmediate()});
+                }
+            } else if (instruction->getOpcode() == Opcode::ELEMENT_ADDR) {
+                location.path.push_back(makeElementStep(instruction->getOperand(1)));
+            } else {
+                break;
+            }
+            location.object = instruction->getOperand(0);
+        }
+        std::reverse(location.path.begin(), location.path.end());
+        // 偏移为 0 的字段没有 FIELD_ADDR，补上让路径的形状一致
+        if (location.path.empty() || location.path.back().is_element) {
+            location.path.push_back({false, nullptr, 0});
+        }
+        return location;
+    }
+
+    MemoryLocation AliasAnalysis::getLocation(const Instruction* access) const {
+        if (access->getOpcode() == Opcode::LOAD) {
+            return getLocation(access->getOperand(0), access->getType());
+        }
+        return getLocation(access->getOperand(1), access->getOperand(0)->getType());
+    }
+
+    uint32_t AliasAnalysis::getObjectId(const MemoryLocation& location) const {
+        if (!isAllocation(location.object)) {
+            return kNone;
+        }
+        return getLocationId(&INFRA::cast<Instruction>(*location.object));
+    }
+
+    bool AliasAnalysis::isObjectStart(const Value* object) const {
+        return !isAddressComputation(object) && !interior_phis.contains(object);
+    }
+
+    bool AliasAnalysis::mayAccessObject(const MemoryLocation& location, const Value* object) const {
+        if (location.object == object) {
+            return true;
+        }
+        return !(isAllocation(location.object) && isAllocation(object)) && !isLocalObject(location.object) &&
+               !isLocalObject(object);
+    }
+
+    AliasResult AliasAnalysis::alias(const MemoryLocation& a, const MemoryLocation& b) const {
+        if (a.type == Type::VOID || b.type == Type::VOID) {
+            const MemoryLocation& whole = a.type == Type::VOID ? a : b;
+            const MemoryLocation& other = a.type == Type::VOID ? b : a;
+            return mayAccessObject(other, whole.object) ? AliasResult::MAY_ALIAS : AliasResult::NO_ALIAS;
+        }
+        if (a.type != b.type) {
+            return AliasResult::NO_ALIAS;
+        }
+        if (a.address == b.address) {
+            return AliasResult::MUST_ALIAS;
+        }
+        bool same_object = a.object == b.object;
+        if (!same_object && !mayAccessObject(a, b.object)) {
+            return AliasResult::NO_ALIAS;
+        }
+        if (!isObjectStart(a.object) || !isObjectStart(b.object)) {
+            return AliasResult::MAY_ALIAS;
+        }
+        // 路径的形状由对象的类型决定，形状不同说明不是同一种对象
+        if (a.path.size() != b.path.size()) {
+            return AliasResult::NO_ALIAS;
+        }
+
+        // 基址可能是同一个对象，逐步比较路径，任何一步不同就不会重叠
+        bool identical = same_object;
+        for (size_t i = 0; i < a.path.size(); ++i) {
+            const AccessStep& x = a.path[i];
+            const AccessStep& y = b.path[i];
+            if (x.is_element != y.is_element) {
+                return AliasResult::NO_ALIAS;
+            }
+            if (x.index != y.index) {
+                identical = false;
+            } else if (!sameOffset(x.offset, y.offset)) {
+                return AliasResult::NO_ALIAS;
+            }
+        }
+        return identical ? AliasResult::MUST_ALIAS : AliasResult::MAY_ALIAS;
+    }
+
+    bool AliasAnalysis::mayAlias(uint32_t a, uint32_t b) const {
+        if (a == b) {
+            return true;
+        }
+        uint64_t key = uint64_t{std::min(a, b)} << 32 | std::max(a, b);
+        auto [it, inserted] = alias_cache.try_emplace(key, false);
+        if (inserted) {
+            it->second = alias(locations[a], locations[b]) != AliasResult::NO_ALIAS;
+        }
+        return it->second;
+    }
+}
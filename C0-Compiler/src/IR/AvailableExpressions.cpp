@@ -0,0 +1,105 @@
+//
+// Created by 陶子杨 on 25-12-12.
+//
+
+#include "IR/AvailableExpressions.h"
+#include "IR/Dataflow.h"
+#include "IR/ExpressionKey.h"
+
+#include <unordered_map>
+
+namespace CC::IR {
+    AvailableExpressions::AvailableExpressions(const Function& function)
+        : expression_of(function.getInstructionCount(), kNone) {
+        // 先按键归并并计数，只出现一次的表达式不可能冗余，不占集合的位置。
+        // 机器生成的大函数里绝大多数表达式都只出现一次，全集因此小得多
+        std::unordered_map<ExpressionKey, uint32_t, ExpressionKeyHash> expressions;
+        std::vector<Instruction*> firsts;
+        std::vector<uint32_t> occurrences;
+        for (BasicBlock* block : function.getBlocks()) {
+            for (Instruction* instruction = block->front(); instruction; instruction = instruction->getNext()) {
+                if (!isExpression(instruction)) {
+                    continue;
+                }
+                auto [it, inserted] = expressions.try_emplace(makeExpressionKey(instruction),
+                                                              static_cast<uint32_t>(firsts.size()));
+                if (inserted) {
+                    firsts.push_back(instruction);
+                    occurrences.push_back(0);
+                }
+                ++occurrences[it->second];
+                expression_of[instruction->getNumber()] = it->second;
+            }
+        }
+        std::vector<uint32_t> compact(firsts.size(), kNone);
+        for (size_t key = 0; key < firsts.size(); ++key) {
+            if (occurrences[key] > 1) {
+                compact[key] = static_cast<uint32_t>(representatives.size());
+                representatives.push_back(firsts[key]);
+            }
+        }
+        for (uint32_t& expression : expression_of) {
+            if (expression != kNone) {
+                expression = compact[expression];
+            }
+        }
+
+        uint32_t universe = getExpressionCount();
+        loads = INFRA::BitVector(universe);
+        for (uint32_t e = 0; e < universe; ++e) {
+            if (representatives[e]->getOpcode() == Opcode::LOAD) {
+                loads.set(e);
+            }
+        }
+
+        CFG cfg(function);
+        uint32_t count = cfg.size();
+        GenKillProblem<INFRA::BitVector, DataflowDirection::FORWARD, MeetOperator::INTERSECTION> problem;
+        problem.boundary = INFRA::BitVector(universe);
+        problem.initial = INFRA::BitVector(universe, true);
+        problem.gen.reserve(count);
+        problem.kill.reserve(count);
+        for (uint32_t b = 0; b < count; ++b) {
+            INFRA::BitVector gen(universe);
+            INFRA::BitVector kill(universe);
+            for (Instruction* instruction = cfg.getBlock(b)->front(); instruction;
+                 instruction = instruction->getNext()) {
+                if (instruction->mayWriteMemory()) {
+                    gen.subtract(loads);
+                    kill.unionWith(loads);
+                }
+                if (uint32_t expression = getExpression(instruction); expression != kNone) {
+                    gen.set(expression);
+                }
+            }
+            problem.gen.push_back(std::move(gen));
+            problem.kill.push_back(std::move(kill));
+        }
+
+        DataflowSolver solver(cfg, problem);
+        solver.solve();
+        available_in.reserve(count);
+        available_out.reserve(count);
+        for (uint32_t b = 0; b < count; ++b) {
+            available_in.push_back(solver.getIn(b));
+            available_out.push_back(solver.getOut(b));
+        }
+    }
+
+    bool AvailableExpressions::isAvailableBefore(const Instruction* instruction) const {
+        uint32_t expression = getExpression(instruction);
+        if (expression == kNone) {
+            return false;
+        }
+        bool is_load = loads.test(expression);
+        for (Instruction* previous = instruction->getPrev(); previous; previous = previous->getPrev()) {
+            if (getExpression(previous) == expression) {
+                return true;
+            }
+            if (is_load && previous->mayWriteMemory()) {
+                return false;
+            }
+        }
+        return getAvailableIn(instruction->getParent()).test(expression);
+    }
+}
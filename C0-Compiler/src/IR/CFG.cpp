@@ -0,0 +1,196 @@
+//
+// Created by 陶子杨 on 25-12-11.
+//
+
+#include "IR/CFG.h"
+#include "IR/Dominators.h"
+#include "IR/IRBuilder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace CC::IR {
+    CFG::CFG(const Function& function) : blocks(function.getBlocks()) {
+        auto count = static_cast<uint32_t>(blocks.size());
+        successor_offsets.assign(count + 1, 0);
+        predecessor_offsets.assign(count + 1, 0);
+        for (uint32_t i = 0; i < count; ++i) {
+            assert(blocks[i]->getNumber() == i && "基本块编号不稠密");
+            successor_offsets[i + 1] = successor_offsets[i] + blocks[i]->getSuccessorCount();
+            predecessor_offsets[i + 1] =
+                predecessor_offsets[i] + static_cast<uint32_t>(blocks[i]->getPredecessors().size());
+        }
+        successors.reserve(successor_offsets[count]);
+        predecessors.reserve(predecessor_offsets[count]);
+        for (BasicBlock* block : blocks) {
+            for (uint32_t i = 0; i < block->getSuccessorCount(); ++i) {
+                successors.push_back(block->getSuccessor(i)->getNumber());
+            }
+            for (BasicBlock* predecessor : block->getPredecessors()) {
+                predecessors.push_back(predecessor->getNumber());
+            }
+        }
+
+        // 显式栈上的深度优先遍历：每一项记录块和下一个要访问的后继
+        rpo_number.assign(count, kUnreachable);
+        if (count == 0) {
+            return;
+        }
+        std::vector<uint32_t> post_order;
+        post_order.reserve(count);
+        std::vector<char> visited(count, 0);
+        std::vector<std::pair<uint32_t, uint32_t>> stack;
+        stack.emplace_back(0, successor_offsets[0]);
+        visited[0] = 1;
+        while (!stack.empty()) {
+            auto& [block, next] = stack.back();
+            if (next == successor_offsets[block + 1]) {
+                post_order.push_back(block);
+                stack.pop_back();
+                continue;
+            }
+            uint32_t successor = successors[next++];
+            if (!visited[successor]) {
+                visited[successor] = 1;
+                stack.emplace_back(successor, successor_offsets[successor]);
+            }
+        }
+        reverse_post_order.assign(post_order.rbegin(), post_order.rend());
+        for (uint32_t i = 0; i < reverse_post_order.size(); ++i) {
+            rpo_number[reverse_post_order[i]] = i;
+        }
+    }
+
+    bool isCriticalEdge(const BasicBlock* from, const BasicBlock* to) {
+        return from->getSuccessorCount() > 1 && to->getPredecessors().size() > 1;
+    }
+
+    BasicBlock* splitEdge(BasicBlock* from, BasicBlock* to) {
+        Function* function = from->getParent();
+        Instruction* terminator = from->getTerminator();
+        uint32_t index = 0;
+        while (terminator->getSuccessor(index) != to) {
+            ++index;
+        }
+
+        BasicBlock* middle = function->createBlock();
+        // 两条边都跳到 to 时只改其中一条，PHI 中也只改一个来源
+        for (Instruction* phi = to->front(); phi != nullptr && phi->isPhi(); phi = phi->getNext()) {
+            for (uint32_t i = 0; i < phi->getOperandCount(); ++i) {
+                if (phi->getIncomingBlock(i) == from) {
+                    phi->setIncomingBlock(i, middle);
+                    break;
+                }
+            }
+        }
+        terminator->setSuccessor(index, middle);
+        IRBuilder builder(*function);
+        builder.setInsertPoint(middle);
+        builder.createBr(to);
+        return middle;
+    }
+
+    BasicBlock* splitBlock(BasicBlock* block, Instruction* before) {
+        BasicBlock* tail = block->getParent()->createBlock();
+        if (Instruction* terminator = block->getTerminator()) {
+            for (uint32_t s = 0; s < terminator->getSuccessorCount(); ++s) {
+                BasicBlock* successor = terminator->getSuccessor(s);
+                for (Instruction* phi = successor->front(); phi != nullptr && phi->isPhi(); phi = phi->getNext()) {
+                    for (uint32_t i = 0; i < phi->getOperandCount(); ++i) {
+                        if (phi->getIncomingBlock(i) == block) {
+                            phi->setIncomingBlock(i, tail);
+                        }
+                    }
+                }
+            }
+        }
+        while (before != nullptr) {
+            Instruction* next = before->getNext();
+            block->remove(before);
+            tail->append(before);
+            before = next;
+        }
+        return tail;
+    }
+
+    void foldBranch(Instruction* branch, uint32_t taken) {
+        BasicBlock* block = branch->getParent();
+        BasicBlock* target = branch->getSuccessor(taken);
+        BasicBlock* dead = branch->getSuccessor(1 - taken);
+        // 两个目标相同时也要去掉一份 PHI 操作数，与前驱列表中少掉的一项对应
+        dead->removePredecessor(block);
+        branch->eraseFromParent();
+        IRBuilder builder(*block->getParent());
+        builder.setInsertPoint(block);
+        builder.createBr(target);
+    }
+
+    BasicBlock* splitPredecessors(BasicBlock* block, std::span<BasicBlock* const> predecessors) {
+        Function* function = block->getParent();
+        BasicBlock* middle = function->createBlock();
+        auto isMoved = [&](const BasicBlock* predecessor) {
+            return std::find(predecessors.begin(), predecessors.end(), predecessor) != predecessors.end();
+        };
+
+        IRBuilder builder(*function);
+        std::vector<std::pair<BasicBlock*, Value*>> moved;
+        for (Instruction* phi = block->front(); phi != nullptr && phi->isPhi(); phi = phi->getNext()) {
+            moved.clear();
+            bool same = true;
+            for (uint32_t i = 0; i < phi->getOperandCount();) {
+                if (!isMoved(phi->getIncomingBlock(i))) {
+                    ++i;
+                    continue;
+                }
+                same = same && (moved.empty() || moved.front().second == phi->getOperand(i));
+                moved.emplace_back(phi->getIncomingBlock(i), phi->getOperand(i));
+                phi->removeOperand(i);
+            }
+            if (moved.empty()) {
+                continue;
+            }
+            if (same) {
+                phi->addOperand(moved.front().second, middle);
+                continue;
+            }
+            Instruction* merged = builder.createPhi(phi->getType(), middle);
+            for (const auto& [from, value] : moved) {
+                merged->addOperand(value, from);
+            }
+            phi->addOperand(merged, middle);
+        }
+
+        for (BasicBlock* predecessor : predecessors) {
+            Instruction* terminator = predecessor->getTerminator();
+            for (uint32_t i = 0; i < terminator->getSuccessorCount(); ++i) {
+                if (terminator->getSuccessor(i) == block) {
+                    terminator->setSuccessor(i, middle);
+                }
+            }
+        }
+        builder.setInsertPoint(middle);
+        builder.createBr(block);
+        return middle;
+    }
+
+    size_t splitCriticalEdges(Function& function, DominatorTree* dominators, DominatorTree* post_dominators) {
+        std::vector<std::pair<BasicBlock*, BasicBlock*>> critical;
+        for (BasicBlock* block : function.getBlocks()) {
+            for (uint32_t i = 0; i < block->getSuccessorCount(); ++i) {
+                if (isCriticalEdge(block, block->getSuccessor(i))) {
+                    critical.emplace_back(block, block->getSuccessor(i));
+                }
+            }
+        }
+        for (const auto& [from, to] : critical) {
+            BasicBlock* middle = splitEdge(from, to);
+            for (DominatorTree* tree : {dominators, post_dominators}) {
+                if (tree != nullptr) {
+                    tree->splitEdge(from, middle, to);
+                }
+            }
+        }
+        return critical.size();
+    }
+}
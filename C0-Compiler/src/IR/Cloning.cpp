@@ -0,0 +1,59 @@
+//
+// Created by 陶子杨 on 25-12-19.
+//
+
+#include "IR/Cloning.h"
+#include "Infra/casting.h"
+
+namespace CC::IR {
+    Value* CloneMap::lookup(Function& function, Value* value) const {
+        if (auto it = values.find(value); it != values.end()) {
+            return it->second;
+        }
+        if (!foreign) {
+            return value;
+        }
+        if (auto constant = INFRA::dyn_cast<Constant>(value)) {
+            return function.getConstant(constant->getType(), constant->getValue());
+        }
+        if (INFRA::isa<Undef>(value)) {
+            return function.getUndef(value->getType());
+        }
+        if (auto string = INFRA::dyn_cast<StringConstant>(value)) {
+            return function.getString(string->getText());
+        }
+        return value;
+    }
+
+    std::vector<BasicBlock*> cloneBlocks(Function& function, const std::vector<BasicBlock*>& blocks, CloneMap& map) {
+        std::vector<BasicBlock*> copies;
+        copies.reserve(blocks.size());
+        for (BasicBlock* block : blocks) {
+            copies.push_back(function.createBlock());
+            map.blocks[block] = copies.back();
+        }
+
+        // 先建出所有指令，PHI 可能用到后面的值，操作数第二遍再填
+        std::vector<std::pair<Instruction*, Instruction*>> clones;
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            for (Instruction* instruction = blocks[b]->front(); instruction; instruction = instruction->getNext()) {
+                Instruction* clone = function.createInstruction(instruction->getOpcode(), instruction->getType());
+                clone->setImmediate(instruction->getImmediate());
+                clone->setCallee(instruction->getCallee());
+                for (uint32_t s = 0; s < instruction->getSuccessorCount(); ++s) {
+                    clone->setSuccessor(s, map.lookup(instruction->getSuccessor(s)));
+                }
+                copies[b]->append(clone);
+                map.values[instruction] = clone;
+                clones.emplace_back(instruction, clone);
+            }
+        }
+        for (const auto& [instruction, clone] : clones) {
+            for (uint32_t i = 0; i < instruction->getOperandCount(); ++i) {
+                BasicBlock* from = instruction->isPhi() ? map.lookup(instruction->getIncomingBlock(i)) : nullptr;
+                clone->addOperand(map.lookup(function, instruction->getOperand(i)), from);
+            }
+        }
+        return copies;
+    }
+}
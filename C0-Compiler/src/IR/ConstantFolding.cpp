@@ -0,0 +1,51 @@
+//
+// Created by 陶子杨 on 25-12-13.
+//
+
+#include "IR/ConstantFolding.h"
+
+#include <climits>
+
+namespace CC::IR {
+    bool binaryTraps(Opcode opcode, int32_t left, int32_t right) {
+        switch (opcode) {
+        case Opcode::DIV:
+        case Opcode::MOD:
+            return right == 0 || (left == INT32_MIN && right == -1);
+        case Opcode::SHL:
+        case Opcode::SHR:
+            return right < 0 || right >= 32;
+        default:
+            return false;
+        }
+    }
+
+    std::optional<int32_t> foldBinary(Opcode opcode, int32_t left, int32_t right) {
+        if (binaryTraps(opcode, left, right)) {
+            return std::nullopt;
+        }
+        // 加减乘和左移在无符号数上做，回绕是良定义的
+        auto a = static_cast<uint32_t>(left);
+        auto b = static_cast<uint32_t>(right);
+        switch (opcode) {
+        case Opcode::ADD: return static_cast<int32_t>(a + b);
+        case Opcode::SUB: return static_cast<int32_t>(a - b);
+        case Opcode::MUL: return static_cast<int32_t>(a * b);
+        case Opcode::MULH: return static_cast<int32_t>(static_cast<int64_t>(left) * right >> 32);
+        case Opcode::DIV: return left / right;
+        case Opcode::MOD: return left % right;
+        case Opcode::SHL: return static_cast<int32_t>(a << right);
+        case Opcode::SHR: return left >> right;
+        case Opcode::AND: return left & right;
+        case Opcode::OR: return left | right;
+        case Opcode::XOR: return left ^ right;
+        case Opcode::EQ: return left == right;
+        case Opcode::NE: return left != right;
+        case Opcode::LT: return left < right;
+        case Opcode::LE: return left <= right;
+        case Opcode::GT: return left > right;
+        case Opcode::GE: return left >= right;
+        default: return std::nullopt;
+        }
+    }
+}
@@ -0,0 +1,20 @@
+//
+// Created by 陶子杨 on 25-12-14.
+//
+
+#include "IR/ControlDependence.h"
+
+namespace CC::IR {
+    ControlDependence::ControlDependence(const PostDominatorTree& tree)
+        : controlling(tree.getFunction().getBlocks().size()) {
+        DominanceFrontier frontier(tree);
+        for (BasicBlock* block : tree.getFunction().getBlocks()) {
+            // 虚拟出口没有对应的基本块，不算作控制点
+            for (BasicBlock* controller : frontier.getFrontier(block)) {
+                if (controller != nullptr) {
+                    controlling[block->getNumber()].push_back(controller);
+                }
+            }
+        }
+    }
+}
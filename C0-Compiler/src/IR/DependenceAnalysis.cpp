@@ -0,0 +1,241 @@
+//
+// Created by 陶子杨 on 25-12-22.
+//
+
+#include "IR/DependenceAnalysis.h"
+#include "Infra/casting.h"
+
+#include <algorithm>
+
+namespace CC::IR {
+    namespace {
+        constexpr int64_t kMaxConstant = int64_t{1} << 30;
+        constexpr uint32_t kMaxDepth = 8;
+
+        bool isArrayAllocation(const Value* value) {
+            auto instruction = INFRA::dyn_cast<Instruction>(value);
+            return instruction != nullptr && instruction->getOpcode() == Opcode::ALLOC_ARRAY;
+        }
+
+        bool isFreshArray(const Value* value) {
+            return isArrayAllocation(value) && value->getFirstUse() != nullptr &&
+                   value->getFirstUse()->getNext() == nullptr;
+        }
+
+        /**
+         * @brief 从指针数组读出来的行只用来访问元素或取长度
+         */
+        bool isRowOnlyIndexed(const Instruction* row) {
+            for (Use* use = row->getFirstUse(); use; use = use->getNext()) {
+                const Instruction* user = use->getUser();
+                bool indexed = user->getOpcode() == Opcode::ELEMENT_ADDR && &user->getOperandUse(0) == use;
+                if (!indexed && user->getOpcode() != Opcode::ARRAY_LENGTH) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool hasDistinctRowsImpl(const Instruction* array) {
+            if (array->getOpcode() != Opcode::ALLOC_ARRAY ||
+                array->getImmediate() != static_cast<int64_t>(sizeOf(Type::PTR))) {
+                return false;
+            }
+            for (Use* use = array->getFirstUse(); use; use = use->getNext()) {
+                const Instruction* user = use->getUser();
+                if (user->getOpcode() == Opcode::ARRAY_LENGTH) {
+                    continue;
+                }
+                if (user->getOpcode() != Opcode::ELEMENT_ADDR || &user->getOperandUse(0) != use) {
+                    return false;
+                }
+                for (Use* element = user->getFirstUse(); element; element = element->getNext()) {
+                    const Instruction* access = element->getUser();
+                    if (access->getOpcode() == Opcode::LOAD) {
+                        if (!isRowOnlyIndexed(access)) {
+                            return false;
+                        }
+                    } else if (access->getOpcode() != Opcode::STORE || &access->getOperandUse(1) != element ||
+                               !isFreshArray(access->getOperand(0))) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief ADD 或 SUB 的两边合并成一个下标，合并不了时返回 nullopt
+         */
+        std::optional<Subscript> combine(Subscript left, Subscript right, bool subtract) {
+            if (subtract) {
+                if (right.symbol != nullptr) {
+                    return std::nullopt;
+                }
+                right.coefficient = -right.coefficient;
+                right.constant = -right.constant;
+            }
+            if ((left.variable != nullptr && right.variable != nullptr) ||
+                (left.symbol != nullptr && right.symbol != nullptr)) {
+                return std::nullopt;
+            }
+            int64_t constant = int64_t{left.constant} + right.constant;
+            if (constant < -kMaxConstant || constant > kMaxConstant) {
+                return std::nullopt;
+            }
+            Subscript result = left.variable != nullptr ? left : right;
+            result.symbol = left.symbol != nullptr ? left.symbol : right.symbol;
+            result.constant = static_cast<int32_t>(constant);
+            return result;
+        }
+    }
+
+    DependenceAnalysis::DependenceAnalysis(const Function& function, const InductionVariables& induction)
+        : induction(induction) {
+        for (BasicBlock* block : function.getBlocks()) {
+            for (Instruction* instruction = block->front(); instruction; instruction = instruction->getNext()) {
+                if (hasDistinctRowsImpl(instruction)) {
+                    distinct_rows.insert(instruction);
+                }
+            }
+        }
+    }
+
+    Subscript DependenceAnalysis::getSubscript(const Value* value, uint32_t depth) const {
+        if (auto constant = INFRA::dyn_cast<Constant>(value)) {
+            if (constant->getValue() >= -kMaxConstant && constant->getValue() <= kMaxConstant) {
+                return {nullptr, 0, nullptr, constant->getValue()};
+            }
+            return {nullptr, 0, value, 0};
+        }
+        auto instruction = INFRA::dyn_cast<Instruction>(value);
+        if (instruction == nullptr) {
+            return {nullptr, 0, value, 0};
+        }
+        // 取值非负的归纳变量，同一个变量两次取值的差不会超过 INT_MAX
+        if (instruction->isPhi()) {
+            auto range = induction.getRangeInLoop(instruction);
+            if (range && range->lower >= 0) {
+                return {instruction, 1, nullptr, 0};
+            }
+            return {nullptr, 0, value, 0};
+        }
+        Opcode opcode = instruction->getOpcode();
+        if ((opcode == Opcode::ADD || opcode == Opcode::SUB) && depth < kMaxDepth) {
+            auto result = combine(getSubscript(instruction->getOperand(0), depth + 1),
+                                  getSubscript(instruction->getOperand(1), depth + 1), opcode == Opcode::SUB);
+            if (result) {
+                return *result;
+            }
+        }
+        return {nullptr, 0, value, 0};
+    }
+
+    std::optional<ArrayAccess> DependenceAnalysis::getAccess(Instruction* instruction) const {
+        const Value* address;
+        Type type;
+        if (instruction->getOpcode() == Opcode::LOAD) {
+            address = instruction->getOperand(0);
+            type = instruction->getType();
+        } else if (instruction->getOpcode() == Opcode::STORE) {
+            address = instruction->getOperand(1);
+            type = instruction->getOperand(0)->getType();
+        } else {
+            return std::nullopt;
+        }
+        auto element = INFRA::dyn_cast<Instruction>(address);
+        if (element == nullptr || element->getOpcode() != Opcode::ELEMENT_ADDR) {
+            return std::nullopt;
+        }
+
+        ArrayAccess access{instruction, element->getOperand(0), {getSubscript(element->getOperand(1), 0)}, type,
+                           instruction->getOpcode() == Opcode::STORE};
+        // array[s0][s1]：行是从 array[s0] 读出来的
+        auto row = INFRA::dyn_cast<Instruction>(access.array);
+        if (row != nullptr && row->getOpcode() == Opcode::LOAD) {
+            auto outer = INFRA::dyn_cast<Instruction>(row->getOperand(0));
+            if (outer != nullptr && outer->getOpcode() == Opcode::ELEMENT_ADDR) {
+                access.array = outer->getOperand(0);
+                access.subscripts.insert(access.subscripts.begin(), getSubscript(outer->getOperand(1), 0));
+            }
+        }
+        return access;
+    }
+
+    bool DependenceAnalysis::compare(const Subscript& a, const Subscript& b, const std::vector<const Loop*>& nest,
+                                     std::vector<uint8_t>& directions) const {
+        auto getLevel = [&](const Instruction* variable) -> int32_t {
+            if (variable == nullptr) {
+                return -1;
+            }
+            auto it = std::find(nest.begin(), nest.end(), induction.getInductionVariable(variable)->loop);
+            return it == nest.end() ? -1 : static_cast<int32_t>(it - nest.begin());
+        };
+        int32_t level_a = getLevel(a.variable);
+        int32_t level_b = getLevel(b.variable);
+
+        // 嵌套之外的部分在整个嵌套中不变，必须完全相同才能消去
+        auto isInvariant = [&](const Value* value) { return value == nullptr || isLoopInvariant(nest.front(), value); };
+        if (a.symbol != b.symbol || !isInvariant(a.symbol)) {
+            return true;
+        }
+        if (level_a < 0 && level_b < 0) {
+            if (a.variable != b.variable || a.coefficient != b.coefficient || !isInvariant(a.variable)) {
+                return true;
+            }
+        } else if (level_a < 0 || level_b < 0) {
+            return true;
+        }
+
+        if (level_a < 0) {
+            return a.constant == b.constant;
+        }
+        if (a.variable != b.variable || a.coefficient != b.coefficient) {
+            return true;
+        }
+        auto step = induction.getInductionVariable(a.variable)->getConstantStep();
+        if (!step) {
+            return true;
+        }
+        // ca + k * v(α) = cb + k * v(β)，k = ±1，于是 v(β) - v(α) = (ca - cb) * k
+        int64_t distance = (int64_t{a.constant} - b.constant) * a.coefficient;
+        if (distance % *step != 0) {
+            return false;
+        }
+        int64_t iterations = distance / *step;
+        uint8_t direction = iterations > 0 ? Dependence::kLess : iterations == 0 ? Dependence::kEqual
+                                                                                 : Dependence::kGreater;
+        directions[level_a] &= direction;
+        return true;
+    }
+
+    std::optional<Dependence> DependenceAnalysis::depends(const ArrayAccess& a, const ArrayAccess& b,
+                                                          const std::vector<const Loop*>& nest) const {
+        if (a.type != b.type) {
+            return std::nullopt;
+        }
+        bool rows_a = a.subscripts.size() == 2 && hasDistinctRows(a.array);
+        bool rows_b = b.subscripts.size() == 2 && hasDistinctRows(b.array);
+        Dependence dependence{std::vector<uint8_t>(nest.size(), Dependence::kAll)};
+        if (rows_a || rows_b) {
+            if (!rows_a || !rows_b || a.array != b.array) {
+                return std::nullopt;
+            }
+            if (!compare(a.subscripts[0], b.subscripts[0], nest, dependence.directions)) {
+                return std::nullopt;
+            }
+        } else if (a.subscripts.size() == 1 && b.subscripts.size() == 1 && a.array != b.array &&
+                   isArrayAllocation(a.array) && isArrayAllocation(b.array)) {
+            // 两次不同的分配
+            return std::nullopt;
+        }
+        if (!compare(a.subscripts.back(), b.subscripts.back(), nest, dependence.directions)) {
+            return std::nullopt;
+        }
+        if (std::find(dependence.directions.begin(), dependence.directions.end(), 0) !=
+            dependence.directions.end()) {
+            return std::nullopt;
+        }
+        return dependence;
+    }
+}
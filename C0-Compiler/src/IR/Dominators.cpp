@@ -0,0 +1,672 @@
+//
+// Created by 陶子杨 on 25-12-11.
+//
+
+#include "IR/Dominators.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace CC::IR {
+    DominatorTree::DominatorTree(const Function& function, bool post) : function(function), post(post) {
+        recalculate();
+    }
+
+    BasicBlock* DominatorTree::block(uint32_t node) const {
+        if (post) {
+            return node == 0 ? nullptr : function.getBlocks()[node - 1];
+        }
+        return function.getBlocks()[node];
+    }
+
+    template <typename Visitor>
+    void DominatorTree::forEachSuccessor(uint32_t node, Visitor&& visitor) const {
+        if (!post) {
+            const BasicBlock* current = function.getBlocks()[node];
+            for (uint32_t i = 0; i < current->getSuccessorCount(); ++i) {
+                visitor(current->getSuccessor(i)->getNumber());
+            }
+            return;
+        }
+        if (node == 0) {
+            for (uint32_t exit : roots) {
+                visitor(exit);
+            }
+            return;
+        }
+        for (const BasicBlock* predecessor : function.getBlocks()[node - 1]->getPredecessors()) {
+            visitor(predecessor->getNumber() + 1);
+        }
+    }
+
+    template <typename Visitor>
+    void DominatorTree::forEachPredecessor(uint32_t node, Visitor&& visitor) const {
+        if (!post) {
+            for (const BasicBlock* predecessor : function.getBlocks()[node]->getPredecessors()) {
+                visitor(predecessor->getNumber());
+            }
+            return;
+        }
+        if (node == 0) {
+            return;
+        }
+        const BasicBlock* current = function.getBlocks()[node - 1];
+        for (uint32_t i = 0; i < current->getSuccessorCount(); ++i) {
+            visitor(current->getSuccessor(i)->getNumber() + 1);
+        }
+        if (is_root[node]) {
+            visitor(0);
+        }
+    }
+
+    void DominatorTree::resize() {
+        size_t size = function.getBlocks().size() + (post ? 1 : 0);
+        if (size <= levels.size()) {
+            return;
+        }
+        // 新建的基本块先当作不可达，由后续的增量更新挂进树中
+        idoms.resize(size, kNone);
+        levels.resize(size, 0);
+        first_child.resize(size, kNone);
+        next_sibling.resize(size, kNone);
+        prev_sibling.resize(size, kNone);
+        marks.resize(size, 0);
+        dfs_number.resize(size, 0);
+        if (post) {
+            is_root.resize(size, 0);
+            was_exit.resize(size, 0);
+            reaches_exit.resize(size, 0);
+        }
+    }
+
+    void DominatorTree::recalculate() {
+        size_t size = function.getBlocks().size() + (post ? 1 : 0);
+        idoms.assign(size, kNone);
+        levels.assign(size, 0);
+        first_child.assign(size, kNone);
+        next_sibling.assign(size, kNone);
+        prev_sibling.assign(size, kNone);
+        marks.assign(size, 0);
+        mark_stamp = 0;
+        dfs_number.assign(size, 0);
+        dfs_valid = false;
+        slow_queries = 0;
+        root = 0;
+        if (function.getBlocks().empty()) {
+            return;
+        }
+        if (post) {
+            computeRoots();
+        }
+
+        uint32_t stamp = ++mark_stamp;
+        std::fill(marks.begin(), marks.end(), stamp);
+        computeFrom(root, stamp);
+        updateLevels(root);
+    }
+
+    void DominatorTree::computeRoots() {
+        size_t size = levels.size();
+        roots.clear();
+        is_root.assign(size, 0);
+        was_exit.assign(size, 0);
+        reaches_exit.assign(size, 0);
+
+        std::vector<uint32_t> worklist;
+        const auto& blocks = function.getBlocks();
+        for (const BasicBlock* exit : blocks) {
+            if (exit->getSuccessorCount() == 0) {
+                uint32_t exit_node = node(exit);
+                was_exit[exit_node] = 1;
+                is_root[exit_node] = 1;
+                reaches_exit[exit_node] = 1;
+                roots.push_back(exit_node);
+                worklist.push_back(exit_node);
+            }
+        }
+        auto flood = [&](std::vector<char>& reached) {
+            while (!worklist.empty()) {
+                uint32_t current = worklist.back();
+                worklist.pop_back();
+                for (const BasicBlock* predecessor : blocks[current - 1]->getPredecessors()) {
+                    uint32_t predecessor_node = node(predecessor);
+                    if (!reached[predecessor_node]) {
+                        reached[predecessor_node] = 1;
+                        worklist.push_back(predecessor_node);
+                    }
+                }
+            }
+        };
+        flood(reaches_exit);
+
+        // 到不了出口的区域：从编号最大的块开始，每次选一个还没覆盖的块连到虚拟出口
+        std::vector<char> covered = reaches_exit;
+        for (auto current = static_cast<uint32_t>(size - 1); current >= 1; --current) {
+            if (!covered[current]) {
+                covered[current] = 1;
+                is_root[current] = 1;
+                roots.push_back(current);
+                worklist.push_back(current);
+                flood(covered);
+            }
+        }
+    }
+
+    uint32_t DominatorTree::computeFrom(uint32_t start, uint32_t stamp) {
+        // 按 DFS 序号索引的数组，0 号不用，start 的序号为 1
+        std::vector<uint32_t> order = {kNone};
+        std::vector<uint32_t> parent = {0};
+
+        // 显式栈上的 DFS：弹出时才编号，栈中的项记录压入它的节点的序号
+        std::vector<std::pair<uint32_t, uint32_t>> stack = {{start, 0}};
+        while (!stack.empty()) {
+            auto [current, from] = stack.back();
+            stack.pop_back();
+            if (dfs_number[current] != 0) {
+                continue;
+            }
+            auto number = static_cast<uint32_t>(order.size());
+            dfs_number[current] = number;
+            order.push_back(current);
+            parent.push_back(from);
+            forEachSuccessor(current, [&](uint32_t successor) {
+                if (marks[successor] == stamp && dfs_number[successor] == 0) {
+                    stack.emplace_back(successor, number);
+                }
+            });
+        }
+
+        auto count = static_cast<uint32_t>(order.size());
+        std::vector<uint32_t> semi(count);
+        std::vector<uint32_t> label(count);
+        std::vector<uint32_t> ancestor = parent;
+        std::vector<uint32_t> idom = parent;
+        for (uint32_t i = 0; i < count; ++i) {
+            semi[i] = i;
+            label[i] = i;
+        }
+
+        // 带路径压缩的 eval：只压缩序号不小于 last_linked 的祖先，即已经处理过的节点
+        std::vector<uint32_t> path;
+        auto eval = [&](uint32_t v, uint32_t last_linked) {
+            if (ancestor[v] < last_linked) {
+                return label[v];
+            }
+            do {
+                path.push_back(v);
+                v = ancestor[v];
+            } while (ancestor[v] >= last_linked);
+            uint32_t p = v;
+            do {
+                v = path.back();
+                path.pop_back();
+                ancestor[v] = ancestor[p];
+                if (semi[label[p]] < semi[label[v]]) {
+                    label[v] = label[p];
+                }
+                p = v;
+            } while (!path.empty());
+            return label[v];
+        };
+
+        // 第一步：按 DFS 序号从大到小求半支配点
+        for (uint32_t i = count - 1; i >= 2; --i) {
+            semi[i] = parent[i];
+            forEachPredecessor(order[i], [&](uint32_t predecessor) {
+                uint32_t number = dfs_number[predecessor];
+                if (number == 0) {
+                    return;
+                }
+                uint32_t u = eval(number, i + 1);
+                semi[i] = std::min(semi[i], semi[u]);
+            });
+        }
+
+        // 第二步：直接支配点是半支配点和生成树父节点的最近公共祖先
+        for (uint32_t i = 2; i < count; ++i) {
+            uint32_t candidate = idom[i];
+            while (candidate > semi[i]) {
+                candidate = idom[candidate];
+            }
+            idom[i] = candidate;
+        }
+
+        for (uint32_t i = 2; i < count; ++i) {
+            idoms[order[i]] = order[idom[i]];
+        }
+        for (uint32_t i = 2; i < count; ++i) {
+            link(order[i], order[idom[i]]);
+        }
+        for (uint32_t i = 1; i < count; ++i) {
+            dfs_number[order[i]] = 0;
+        }
+        return count - 1;
+    }
+
+    void DominatorTree::link(uint32_t child, uint32_t parent) {
+        idoms[child] = parent;
+        prev_sibling[child] = kNone;
+        next_sibling[child] = first_child[parent];
+        if (first_child[parent] != kNone) {
+            prev_sibling[first_child[parent]] = child;
+        }
+        first_child[parent] = child;
+    }
+
+    void DominatorTree::unlink(uint32_t child) {
+        uint32_t parent = idoms[child];
+        if (prev_sibling[child] != kNone) {
+            next_sibling[prev_sibling[child]] = next_sibling[child];
+        } else if (parent != kNone) {
+            first_child[parent] = next_sibling[child];
+        }
+        if (next_sibling[child] != kNone) {
+            prev_sibling[next_sibling[child]] = prev_sibling[child];
+        }
+        prev_sibling[child] = kNone;
+        next_sibling[child] = kNone;
+        idoms[child] = kNone;
+    }
+
+    void DominatorTree::updateLevels(uint32_t top) {
+        std::vector<uint32_t> stack = {top};
+        while (!stack.empty()) {
+            uint32_t current = stack.back();
+            stack.pop_back();
+            for (uint32_t child = first_child[current]; child != kNone; child = next_sibling[child]) {
+                levels[child] = levels[current] + 1;
+                stack.push_back(child);
+            }
+        }
+    }
+
+    std::vector<uint32_t> DominatorTree::rebuildSubtree(uint32_t top) {
+        // 收集 top 的子树并整体拆下，只在这些节点上重新计算
+        uint32_t stamp = ++mark_stamp;
+        std::vector<uint32_t> subtree;
+        std::vector<uint32_t> stack = {top};
+        marks[top] = stamp;
+        while (!stack.empty()) {
+            uint32_t current = stack.back();
+            stack.pop_back();
+            for (uint32_t child = first_child[current]; child != kNone; child = next_sibling[child]) {
+                marks[child] = stamp;
+                subtree.push_back(child);
+                stack.push_back(child);
+            }
+        }
+        for (uint32_t member : subtree) {
+            idoms[member] = kNone;
+            first_child[member] = kNone;
+            next_sibling[member] = kNone;
+            prev_sibling[member] = kNone;
+        }
+        first_child[top] = kNone;
+
+        uint32_t reached = computeFrom(top, stamp);
+        updateLevels(top);
+        dfs_valid = false;
+        std::vector<uint32_t> lost;
+        if (reached < subtree.size() + 1) {
+            for (uint32_t member : subtree) {
+                if (idoms[member] == kNone) {
+                    lost.push_back(member);
+                }
+            }
+        }
+        return lost;
+    }
+
+    uint32_t DominatorTree::nearestCommonDominator(uint32_t a, uint32_t b) const {
+        if (!contains(a) || !contains(b)) {
+            return kNone;
+        }
+        while (a != b) {
+            if (levels[a] < levels[b]) {
+                std::swap(a, b);
+            }
+            a = idoms[a];
+        }
+        return a;
+    }
+
+    void DominatorTree::computeDFSNumbers() const {
+        dfs_in.assign(levels.size(), 0);
+        dfs_out.assign(levels.size(), 0);
+        uint32_t counter = 0;
+        // 栈中的每一项是节点和下一个要访问的孩子
+        std::vector<std::pair<uint32_t, uint32_t>> stack = {{root, first_child[root]}};
+        dfs_in[root] = counter++;
+        while (!stack.empty()) {
+            auto& [current, child] = stack.back();
+            if (child == kNone) {
+                dfs_out[current] = counter++;
+                stack.pop_back();
+                continue;
+            }
+            uint32_t next = child;
+            child = next_sibling[next];
+            dfs_in[next] = counter++;
+            stack.emplace_back(next, first_child[next]);
+        }
+        dfs_valid = true;
+        slow_queries = 0;
+    }
+
+    BasicBlock* DominatorTree::getRoot() const {
+        if (function.getBlocks().empty()) {
+            return nullptr;
+        }
+        return block(root);
+    }
+
+    BasicBlock* DominatorTree::getIdom(const BasicBlock* block) const {
+        uint32_t current = node(block);
+        if (!contains(current) || current == root) {
+            return nullptr;
+        }
+        return this->block(idoms[current]);
+    }
+
+    std::vector<BasicBlock*> DominatorTree::getChildren(const BasicBlock* block) const {
+        std::vector<BasicBlock*> children;
+        uint32_t current = node(block);
+        if (!contains(current)) {
+            return children;
+        }
+        for (uint32_t child = first_child[current]; child != kNone; child = next_sibling[child]) {
+            children.push_back(this->block(child));
+        }
+        return children;
+    }
+
+    std::vector<BasicBlock*> DominatorTree::getPreorder() const {
+        std::vector<BasicBlock*> preorder;
+        if (function.getBlocks().empty()) {
+            return preorder;
+        }
+        std::vector<uint32_t> stack = {root};
+        while (!stack.empty()) {
+            uint32_t current = stack.back();
+            stack.pop_back();
+            if (BasicBlock* current_block = block(current)) {
+                preorder.push_back(current_block);
+            }
+            for (uint32_t child = first_child[current]; child != kNone; child = next_sibling[child]) {
+                stack.push_back(child);
+            }
+        }
+        return preorder;
+    }
+
+    bool DominatorTree::dominates(const BasicBlock* a, const BasicBlock* b) const {
+        if (a == b) {
+            return true;
+        }
+        uint32_t x = node(a);
+        uint32_t y = node(b);
+        if (!contains(x) || !contains(y)) {
+            return false;
+        }
+        if (!dfs_valid) {
+            // 增量更新之后的少量查询直接沿树向上走，查询多了再重算进出序号
+            if (++slow_queries <= 32) {
+                while (levels[y] > levels[x]) {
+                    y = idoms[y];
+                }
+                return x == y;
+            }
+            computeDFSNumbers();
+        }
+        return dfs_in[x] <= dfs_in[y] && dfs_out[y] <= dfs_out[x];
+    }
+
+    bool DominatorTree::dominates(const Instruction* def, const Instruction* user) const {
+        const BasicBlock* def_block = def->getParent();
+        const BasicBlock* user_block = user->getParent();
+        if (def_block != user_block) {
+            return dominates(def_block, user_block);
+        }
+        if (def == user) {
+            return false;
+        }
+        for (const Instruction* current = def->getNext(); current != nullptr; current = current->getNext()) {
+            if (current == user) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    BasicBlock* DominatorTree::findNearestCommonDominator(const BasicBlock* a, const BasicBlock* b) const {
+        uint32_t common = nearestCommonDominator(node(a), node(b));
+        return common == kNone ? nullptr : block(common);
+    }
+
+    void DominatorTree::insertReachable(uint32_t from, uint32_t to) {
+        uint32_t common = nearestCommonDominator(from, to);
+        // to 支配 from（回边），或新路径经过 to 原来的直接支配点，支配关系都不变
+        if (common == to || common == idoms[to]) {
+            return;
+        }
+        rebuildSubtree(common);
+    }
+
+    void DominatorTree::insertUnreachable(uint32_t from, uint32_t to) {
+        // 新变得可达的区域只能经过这条边进入，先在区域内部计算，再把 to 挂到 from 下面
+        uint32_t stamp = ++mark_stamp;
+        std::vector<std::pair<uint32_t, uint32_t>> entries;
+        std::vector<uint32_t> stack = {to};
+        marks[to] = stamp;
+        while (!stack.empty()) {
+            uint32_t current = stack.back();
+            stack.pop_back();
+            forEachSuccessor(current, [&](uint32_t successor) {
+                if (contains(successor)) {
+                    entries.emplace_back(current, successor);
+                } else if (marks[successor] != stamp) {
+                    marks[successor] = stamp;
+                    stack.push_back(successor);
+                }
+            });
+        }
+        link(to, from);
+        computeFrom(to, stamp);
+        levels[to] = levels[from] + 1;
+        updateLevels(to);
+        // 区域中跳回原有节点的边按可达的插入处理
+        for (const auto& [source, target] : entries) {
+            insertReachable(source, target);
+        }
+    }
+
+    void DominatorTree::insertEdge(BasicBlock* from, BasicBlock* to) {
+        resize();
+        dfs_valid = false;
+        uint32_t source = node(from);
+        uint32_t target = node(to);
+        if (!post) {
+            if (!contains(source)) {
+                return;
+            }
+            if (!contains(target)) {
+                insertUnreachable(source, target);
+            } else {
+                insertReachable(source, target);
+            }
+            return;
+        }
+        // 反向图中的边是 to -> from；from 原来是出口或到不了出口时，出口集合和额外的根都会变化
+        if (!contains(source) || !contains(target) || was_exit[source] || !reaches_exit[source]) {
+            recalculate();
+            return;
+        }
+        insertReachable(target, source);
+    }
+
+    void DominatorTree::deleteEdge(BasicBlock* from, BasicBlock* to) {
+        resize();
+        dfs_valid = false;
+        uint32_t source = node(from);
+        uint32_t target = node(to);
+        if (!post) {
+            if (!contains(source) || !contains(target)) {
+                return;
+            }
+            uint32_t common = nearestCommonDominator(source, target);
+            if (common == target) {
+                return;
+            }
+            std::vector<uint32_t> lost = rebuildSubtree(common);
+            // 不可达区域跳到子树之外的边也随之失效，它们的目标可能失去一条支配路径
+            uint32_t top = common;
+            for (uint32_t member : lost) {
+                forEachSuccessor(member, [&](uint32_t successor) {
+                    if (contains(successor)) {
+                        uint32_t candidate = nearestCommonDominator(common, successor);
+                        if (levels[candidate] < levels[top]) {
+                            top = candidate;
+                        }
+                    }
+                });
+            }
+            if (top != common) {
+                rebuildSubtree(top);
+            }
+            return;
+        }
+        if (!contains(source) || !contains(target) || from->getSuccessorCount() == 0) {
+            recalculate();
+            return;
+        }
+        uint32_t common = nearestCommonDominator(target, source);
+        if (common == source) {
+            return;
+        }
+        // 子树中有块从此到不了出口时，需要重新选择额外的根
+        if (common == root || !reaches_exit[common] || !rebuildSubtree(common).empty()) {
+            recalculate();
+        }
+    }
+
+    void DominatorTree::splitNode(uint32_t from, uint32_t middle, uint32_t to) {
+        link(middle, from);
+        levels[middle] = levels[from] + 1;
+        // to 的其他前驱都被 to 支配时（只剩回边），middle 成为 to 新的直接支配点
+        bool only_through_middle = true;
+        forEachPredecessor(to, [&](uint32_t predecessor) {
+            if (predecessor != middle && contains(predecessor) && predecessor != to) {
+                uint32_t current = predecessor;
+                while (levels[current] > levels[to]) {
+                    current = idoms[current];
+                }
+                only_through_middle = only_through_middle && current == to;
+            }
+        });
+        if (only_through_middle && idoms[to] == from) {
+            unlink(to);
+            link(to, middle);
+            updateLevels(middle);
+        }
+    }
+
+    void DominatorTree::splitEdge(BasicBlock* from, BasicBlock* middle, BasicBlock* to) {
+        resize();
+        dfs_valid = false;
+        uint32_t source = node(from);
+        uint32_t center = node(middle);
+        uint32_t target = node(to);
+        if (!post) {
+            if (contains(source)) {
+                splitNode(source, center, target);
+            }
+            return;
+        }
+        if (!contains(source) || !contains(target) || !reaches_exit[target]) {
+            recalculate();
+            return;
+        }
+        reaches_exit[center] = 1;
+        splitNode(target, center, source);
+    }
+
+    void DominatorTree::splitPredecessors(BasicBlock* block, BasicBlock* middle,
+                                          std::span<BasicBlock* const> predecessors) {
+        // 先让 middle 变得可达并连上 block，再删掉原来直接跳到 block 的边，中间状态里 block 一直可达
+        for (BasicBlock* predecessor : predecessors) {
+            insertEdge(predecessor, middle);
+        }
+        insertEdge(middle, block);
+        for (BasicBlock* predecessor : predecessors) {
+            deleteEdge(predecessor, block);
+        }
+    }
+
+    bool DominatorTree::verify() const {
+        DominatorTree fresh(function, post);
+        if (fresh.levels.size() != levels.size()) {
+            return false;
+        }
+        for (uint32_t i = 0; i < levels.size(); ++i) {
+            if (fresh.contains(i) != contains(i) || (contains(i) && fresh.idoms[i] != idoms[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    DominanceFrontier::DominanceFrontier(const DominatorTree& tree) : frontiers(tree.getFunction().getBlocks().size()) {
+        auto size = static_cast<uint32_t>(tree.levels.size());
+        for (uint32_t join = 0; join < size; ++join) {
+            if (!tree.contains(join)) {
+                continue;
+            }
+            // 入口也可以是回边的目标，这时一直走到树根为止（树根的 idoms 为 kNone）
+            BasicBlock* join_block = tree.block(join);
+            uint32_t idom = tree.idoms[join];
+            tree.forEachPredecessor(join, [&](uint32_t predecessor) {
+                if (!tree.contains(predecessor)) {
+                    return;
+                }
+                for (uint32_t runner = predecessor; runner != idom; runner = tree.idoms[runner]) {
+                    BasicBlock* runner_block = tree.block(runner);
+                    if (runner_block == nullptr) {
+                        break;
+                    }
+                    auto& frontier = frontiers[runner_block->getNumber()];
+                    if (!frontier.empty() && frontier.back() == join_block) {
+                        break;
+                    }
+                    frontier.push_back(join_block);
+                }
+            });
+        }
+    }
+
+    std::vector<BasicBlock*> DominanceFrontier::getIteratedFrontier(std::span<BasicBlock* const> blocks) const {
+        std::vector<char> in_result(frontiers.size(), 0);
+        std::vector<char> visited(frontiers.size(), 0);
+        std::vector<BasicBlock*> worklist(blocks.begin(), blocks.end());
+        for (BasicBlock* block : blocks) {
+            visited[block->getNumber()] = 1;
+        }
+        std::vector<BasicBlock*> result;
+        while (!worklist.empty()) {
+            BasicBlock* current = worklist.back();
+            worklist.pop_back();
+            for (BasicBlock* frontier_block : frontiers[current->getNumber()]) {
+                uint32_t number = frontier_block->getNumber();
+                if (in_result[number]) {
+                    continue;
+                }
+                in_result[number] = 1;
+                result.push_back(frontier_block);
+                if (!visited[number]) {
+                    visited[number] = 1;
+                    worklist.push_back(frontier_block);
+                }
+            }
+        }
+        return result;
+    }
+}
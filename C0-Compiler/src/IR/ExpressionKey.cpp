@@ -0,0 +1,39 @@
+//
+// Created by 陶子杨 on 25-12-15.
+//
+
+#include "IR/ExpressionKey.h"
+
+#include <utility>
+
+namespace CC::IR {
+    bool isExpression(const Instruction* instruction) {
+        if (instruction->isBinary() || instruction->isComparison()) {
+            return true;
+        }
+        switch (instruction->getOpcode()) {
+        case Opcode::FIELD_ADDR:
+        case Opcode::ELEMENT_ADDR:
+        case Opcode::ARRAY_LENGTH:
+        case Opcode::LOAD:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    ExpressionKey makeExpressionKey(const Instruction* instruction) {
+        ExpressionKey key{instruction->getOpcode(), instruction->getType(), instruction->getImmediate(),
+                          {nullptr, nullptr}};
+        for (uint32_t i = 0; i < instruction->getOperandCount(); ++i) {
+            key.operands[i] = instruction->getOperand(i);
+        }
+        if (key.opcode == Opcode::GT || key.opcode == Opcode::GE) {
+            key.opcode = key.opcode == Opcode::GT ? Opcode::LT : Opcode::LE;
+            std::swap(key.operands[0], key.operands[1]);
+        } else if (instruction->isCommutative() && std::less<Value*>()(key.operands[1], key.operands[0])) {
+            std::swap(key.operands[0], key.operands[1]);
+        }
+        return key;
+    }
+}
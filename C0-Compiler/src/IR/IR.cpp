@@ -0,0 +1,558 @@
+//
+// Created by 陶子杨 on 25-12-10.
+//
+
+#include "IR/IR.h"
+#include "Infra/casting.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace CC::IR {
+
+    size_t sizeOf(Type type) {
+        switch (type) {
+        case Type::VOID:
+            return 0;
+        case Type::BOOL:
+        case Type::CHAR:
+            return 1;
+        case Type::INT:
+            return 4;
+        case Type::PTR:
+        default:
+            return 8;
+        }
+    }
+
+    const char* getTypeName(Type type) {
+        switch (type) {
+        case Type::VOID:
+            return "void";
+        case Type::BOOL:
+            return "bool";
+        case Type::CHAR:
+            return "char";
+        case Type::INT:
+            return "int";
+        case Type::PTR:
+        default:
+            return "ptr";
+        }
+    }
+
+    const char* getOpcodeName(Opcode opcode) {
+        static constexpr const char* kNames[] = {
+            "add", "sub", "mul", "mulh", "div", "mod", "shl", "shr", "and", "or", "xor",
+            "eq", "ne", "lt", "le", "gt", "ge",
+            "phi",
+            "alloc", "alloc_array", "load", "store", "field_addr", "element_addr", "array_length", "call",
+            "br", "cond_br", "ret", "abort",
+        };
+        return kNames[static_cast<size_t>(opcode)];
+    }
+
+    // ---- Use ----
+
+    void Use::link() {
+        if (value == nullptr) {
+            return;
+        }
+        next = value->use_head;
+        if (next != nullptr) {
+            next->prev = &next;
+        }
+        prev = &value->use_head;
+        value->use_head = this;
+    }
+
+    void Use::unlink() {
+        if (value == nullptr) {
+            return;
+        }
+        *prev = next;
+        if (next != nullptr) {
+            next->prev = prev;
+        }
+        next = nullptr;
+        prev = nullptr;
+    }
+
+    void Use::set(Value* new_value) {
+        unlink();
+        value = new_value;
+        link();
+    }
+
+    // ---- Value ----
+
+    size_t Value::getUseCount() const {
+        size_t count = 0;
+        for (Use* use = use_head; use != nullptr; use = use->next) {
+            ++count;
+        }
+        return count;
+    }
+
+    void Value::replaceAllUsesWith(Value* replacement) {
+        if (replacement == this) {
+            return;
+        }
+        while (use_head != nullptr) {
+            use_head->set(replacement);
+        }
+    }
+
+    // ---- Instruction ----
+
+    uint32_t Instruction::getSuccessorCount() const {
+        switch (opcode) {
+        case Opcode::BR:
+            return 1;
+        case Opcode::COND_BR:
+            return 2;
+        default:
+            return 0;
+        }
+    }
+
+    void Instruction::setSuccessor(uint32_t index, BasicBlock* block) {
+        // 只维护前驱列表，目标块中 PHI 的来源由调用者负责
+        if (parent != nullptr) {
+            if (successors[index] != nullptr) {
+                successors[index]->erasePredecessorEntry(parent);
+            }
+            if (block != nullptr) {
+                block->addPredecessor(parent);
+            }
+        }
+        successors[index] = block;
+    }
+
+    Value* Instruction::getIncomingValueFor(const BasicBlock* block) const {
+        for (uint32_t i = 0; i < operand_count; ++i) {
+            if (incoming[i] == block) {
+                return operands[i].get();
+            }
+        }
+        return nullptr;
+    }
+
+    void Instruction::growOperands(uint32_t capacity) {
+        auto* resource = function->getMemoryResource();
+        auto* new_operands = static_cast<Use*>(resource->allocate(sizeof(Use) * capacity, alignof(Use)));
+        for (uint32_t i = 0; i < capacity; ++i) {
+            new (new_operands + i) Use();
+            new_operands[i].user = this;
+        }
+        // 把旧数组中的节点原地替换成新节点，链表中的前后指针跟着改过来
+        for (uint32_t i = 0; i < operand_count; ++i) {
+            Use& from = operands[i];
+            Use& to = new_operands[i];
+            to.value = from.value;
+            if (from.value == nullptr) {
+                continue;
+            }
+            to.next = from.next;
+            to.prev = from.prev;
+            *to.prev = &to;
+            if (to.next != nullptr) {
+                to.next->prev = &to.next;
+            }
+        }
+        operands = new_operands;
+
+        if (opcode == Opcode::PHI) {
+            auto* new_incoming = static_cast<BasicBlock**>(
+                resource->allocate(sizeof(BasicBlock*) * capacity, alignof(BasicBlock*)));
+            if (operand_count != 0) {
+                std::memcpy(new_incoming, incoming, sizeof(BasicBlock*) * operand_count);
+            }
+            incoming = new_incoming;
+        }
+        operand_capacity = capacity;
+    }
+
+    void Instruction::addOperand(Value* value, BasicBlock* from) {
+        if (operand_count == operand_capacity) {
+            growOperands(std::max<uint32_t>(4, operand_capacity * 2));
+        }
+        operands[operand_count].set(value);
+        if (opcode == Opcode::PHI) {
+            incoming[operand_count] = from;
+        }
+        ++operand_count;
+    }
+
+    void Instruction::removeOperand(uint32_t index) {
+        for (uint32_t i = index; i + 1 < operand_count; ++i) {
+            operands[i].set(operands[i + 1].get());
+            if (opcode == Opcode::PHI) {
+                incoming[i] = incoming[i + 1];
+            }
+        }
+        --operand_count;
+        operands[operand_count].set(nullptr);
+    }
+
+    void Instruction::dropOperands() {
+        for (uint32_t i = 0; i < operand_count; ++i) {
+            operands[i].set(nullptr);
+        }
+    }
+
+    bool Instruction::isCommutative() const {
+        switch (opcode) {
+        case Opcode::ADD:
+        case Opcode::MUL:
+        case Opcode::MULH:
+        case Opcode::AND:
+        case Opcode::OR:
+        case Opcode::XOR:
+        case Opcode::EQ:
+        case Opcode::NE:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool Instruction::mayTrap() const {
+        switch (opcode) {
+        case Opcode::DIV:
+        case Opcode::MOD:
+            return immediate == 0 && !isSafeToSpeculate();
+        case Opcode::SHL:
+        case Opcode::SHR:
+            return !isSafeToSpeculate();
+        case Opcode::ALLOC_ARRAY:
+        case Opcode::LOAD:
+        case Opcode::STORE:
+        case Opcode::ELEMENT_ADDR:
+        case Opcode::CALL:
+        case Opcode::ABORT:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool Instruction::isSafeToSpeculate() const {
+        switch (opcode) {
+        case Opcode::DIV:
+        case Opcode::MOD: {
+            auto constant = INFRA::dyn_cast<Constant>(getOperand(1));
+            return constant != nullptr && constant->getValue() != 0 && constant->getValue() != -1;
+        }
+        case Opcode::SHL:
+        case Opcode::SHR: {
+            auto constant = INFRA::dyn_cast<Constant>(getOperand(1));
+            return constant != nullptr && constant->getValue() >= 0 && constant->getValue() < 32;
+        }
+        default:
+            return !mayTrap();
+        }
+    }
+
+    bool Instruction::mayReadMemory() const {
+        return opcode == Opcode::LOAD || opcode == Opcode::CALL;
+    }
+
+    bool Instruction::mayWriteMemory() const {
+        return opcode == Opcode::STORE || opcode == Opcode::CALL;
+    }
+
+    bool Instruction::isRemovableIfUnused() const {
+        return !isTerminator() && !mayWriteMemory() && !mayTrap();
+    }
+
+    void Instruction::eraseFromParent() {
+        assert(!hasUses() && "删除的指令仍然被使用");
+        if (parent != nullptr) {
+            parent->remove(this);
+        }
+        dropOperands();
+    }
+
+    // ---- BasicBlock ----
+
+    Instruction* BasicBlock::getTerminator() const {
+        return last != nullptr && last->isTerminator() ? last : nullptr;
+    }
+
+    Instruction* BasicBlock::getFirstNonPhi() const {
+        Instruction* instruction = first;
+        while (instruction != nullptr && instruction->isPhi()) {
+            instruction = instruction->next;
+        }
+        return instruction;
+    }
+
+    uint32_t BasicBlock::getSuccessorCount() const {
+        Instruction* terminator = getTerminator();
+        return terminator == nullptr ? 0 : terminator->getSuccessorCount();
+    }
+
+    BasicBlock* BasicBlock::getSuccessor(uint32_t index) const {
+        return last->getSuccessor(index);
+    }
+
+    void BasicBlock::insert(Instruction* instruction, Instruction* before) {
+        assert(instruction->parent == nullptr && "指令已经在某个基本块中");
+        instruction->parent = this;
+        instruction->next = before;
+        instruction->prev = before != nullptr ? before->prev : last;
+        if (instruction->prev != nullptr) {
+            instruction->prev->next = instruction;
+        } else {
+            first = instruction;
+        }
+        if (before != nullptr) {
+            before->prev = instruction;
+        } else {
+            last = instruction;
+        }
+        for (uint32_t i = 0; i < instruction->getSuccessorCount(); ++i) {
+            if (instruction->successors[i] != nullptr) {
+                instruction->successors[i]->addPredecessor(this);
+            }
+        }
+    }
+
+    void BasicBlock::remove(Instruction* instruction) {
+        assert(instruction->parent == this);
+        for (uint32_t i = 0; i < instruction->getSuccessorCount(); ++i) {
+            if (instruction->successors[i] != nullptr) {
+                instruction->successors[i]->erasePredecessorEntry(this);
+            }
+        }
+        if (instruction->prev != nullptr) {
+            instruction->prev->next = instruction->next;
+        } else {
+            first = instruction->next;
+        }
+        if (instruction->next != nullptr) {
+            instruction->next->prev = instruction->prev;
+        } else {
+            last = instruction->prev;
+        }
+        instruction->prev = nullptr;
+        instruction->next = nullptr;
+        instruction->parent = nullptr;
+    }
+
+    void BasicBlock::erasePredecessorEntry(BasicBlock* predecessor) {
+        auto it = std::find(predecessors.begin(), predecessors.end(), predecessor);
+        assert(it != predecessors.end());
+        predecessors.erase(it);
+    }
+
+    void BasicBlock::removePredecessor(BasicBlock* predecessor) {
+        for (Instruction* phi = first; phi != nullptr && phi->isPhi(); phi = phi->next) {
+            for (uint32_t i = 0; i < phi->operand_count; ++i) {
+                if (phi->incoming[i] == predecessor) {
+                    phi->removeOperand(i);
+                    break;
+                }
+            }
+        }
+    }
+
+    void BasicBlock::replacePredecessor(BasicBlock* from, BasicBlock* to) {
+        for (auto& predecessor : predecessors) {
+            if (predecessor == from) {
+                predecessor = to;
+            }
+        }
+        for (Instruction* phi = first; phi != nullptr && phi->isPhi(); phi = phi->next) {
+            for (uint32_t i = 0; i < phi->operand_count; ++i) {
+                if (phi->incoming[i] == from) {
+                    phi->incoming[i] = to;
+                }
+            }
+        }
+    }
+
+    size_t BasicBlock::countPredecessor(const BasicBlock* predecessor) const {
+        return static_cast<size_t>(std::count(predecessors.begin(), predecessors.end(), predecessor));
+    }
+
+    // ---- Function ----
+
+    Function::Function(std::string name, Type return_type, const std::vector<Type>& parameter_types,
+                       const std::vector<std::string>& parameter_names)
+        : name(std::move(name)), return_type(return_type) {
+        arguments.reserve(parameter_types.size());
+        for (size_t i = 0; i < parameter_types.size(); ++i) {
+            std::string_view parameter_name;
+            if (i < parameter_names.size()) {
+                auto* text = static_cast<char*>(arena.allocate(parameter_names[i].size() + 1, 1));
+                std::memcpy(text, parameter_names[i].c_str(), parameter_names[i].size() + 1);
+                parameter_name = {text, parameter_names[i].size()};
+            }
+            arguments.push_back(create<Argument>(parameter_types[i], static_cast<uint32_t>(i), parameter_name));
+        }
+    }
+
+    BasicBlock* Function::createBlock() {
+        auto* block = create<BasicBlock>(this, &arena);
+        block->number = static_cast<uint32_t>(blocks.size());
+        blocks.push_back(block);
+        return block;
+    }
+
+    void Function::eraseBlock(BasicBlock* block) {
+        // 不可达的块之间可能互相使用对方的值，先把这些使用换成 undef
+        for (Instruction* instruction = block->first; instruction != nullptr; instruction = instruction->next) {
+            if (instruction->hasUses()) {
+                instruction->replaceAllUsesWith(getUndef(instruction->getType()));
+            }
+        }
+        while (Instruction* instruction = block->last) {
+            if (instruction->isTerminator()) {
+                for (uint32_t i = 0; i < instruction->getSuccessorCount(); ++i) {
+                    instruction->successors[i]->removePredecessor(block);
+                }
+            }
+            instruction->eraseFromParent();
+        }
+        blocks.erase(std::find(blocks.begin(), blocks.end(), block));
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            blocks[i]->number = static_cast<uint32_t>(i);
+        }
+    }
+
+    size_t Function::removeUnreachableBlocks() {
+        if (blocks.empty()) {
+            return 0;
+        }
+        std::vector<char> reachable(blocks.size(), 0);
+        std::vector<BasicBlock*> stack = {blocks.front()};
+        reachable[blocks.front()->number] = 1;
+        while (!stack.empty()) {
+            BasicBlock* block = stack.back();
+            stack.pop_back();
+            for (uint32_t i = 0; i < block->getSuccessorCount(); ++i) {
+                BasicBlock* successor = block->getSuccessor(i);
+                if (!reachable[successor->number]) {
+                    reachable[successor->number] = 1;
+                    stack.push_back(successor);
+                }
+            }
+        }
+
+        std::vector<BasicBlock*> dead;
+        for (BasicBlock* block : blocks) {
+            if (!reachable[block->number]) {
+                dead.push_back(block);
+            }
+        }
+        if (dead.empty()) {
+            return 0;
+        }
+        // 先断开所有使用和边，再逐条删除指令，不可达的块之间可以任意互相引用
+        for (BasicBlock* block : dead) {
+            for (Instruction* instruction = block->first; instruction != nullptr; instruction = instruction->next) {
+                if (instruction->hasUses()) {
+                    instruction->replaceAllUsesWith(getUndef(instruction->getType()));
+                }
+            }
+            if (Instruction* terminator = block->getTerminator()) {
+                for (uint32_t i = 0; i < terminator->getSuccessorCount(); ++i) {
+                    terminator->successors[i]->removePredecessor(block);
+                }
+            }
+        }
+        for (BasicBlock* block : dead) {
+            while (Instruction* instruction = block->last) {
+                instruction->eraseFromParent();
+            }
+        }
+        size_t kept = 0;
+        for (BasicBlock* block : blocks) {
+            if (reachable[block->number]) {
+                blocks[kept++] = block;
+            }
+        }
+        blocks.resize(kept);
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            blocks[i]->number = static_cast<uint32_t>(i);
+        }
+        return dead.size();
+    }
+
+    void Function::renumber() {
+        uint32_t count = 0;
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            blocks[i]->number = static_cast<uint32_t>(i);
+            for (Instruction* instruction = blocks[i]->first; instruction != nullptr;
+                 instruction = instruction->next) {
+                instruction->number = count++;
+            }
+        }
+        instruction_count = count;
+    }
+
+    Constant* Function::getConstant(Type type, int32_t value) {
+        uint64_t key = (static_cast<uint64_t>(type) << 32) | static_cast<uint32_t>(value);
+        auto [it, inserted] = constants.try_emplace(key, nullptr);
+        if (inserted) {
+            it->second = create<Constant>(type, value);
+        }
+        return it->second;
+    }
+
+    Undef* Function::getUndef(Type type) {
+        Undef*& undef = undefs[static_cast<size_t>(type)];
+        if (undef == nullptr) {
+            undef = create<Undef>(type);
+        }
+        return undef;
+    }
+
+    StringConstant* Function::getString(std::string_view text) {
+        auto* copy = static_cast<char*>(arena.allocate(text.size() + 1, 1));
+        std::memcpy(copy, text.data(), text.size());
+        copy[text.size()] = '\0';
+        return create<StringConstant>(std::string_view(copy, text.size()));
+    }
+
+    Instruction* Function::createInstruction(Opcode opcode, Type type, std::initializer_list<Value*> operands) {
+        auto* instruction = create<Instruction>(opcode, type);
+        instruction->function = this;
+        if (operands.size() != 0) {
+            instruction->growOperands(static_cast<uint32_t>(operands.size()));
+            for (Value* operand : operands) {
+                instruction->addOperand(operand);
+            }
+        }
+        instruction->number = instruction_count++;
+        return instruction;
+    }
+
+    // ---- Module ----
+
+    Function* Module::getFunction(std::string_view name) const {
+        auto it = function_index.find(std::string(name));
+        return it == function_index.end() ? nullptr : it->second;
+    }
+
+    Function* Module::getOrCreateFunction(const std::string& name, Type return_type,
+                                          const std::vector<Type>& parameter_types,
+                                          const std::vector<std::string>& parameter_names) {
+        if (Function* existing = getFunction(name)) {
+            return existing;
+        }
+        functions.push_back(std::make_unique<Function>(name, return_type, parameter_types, parameter_names));
+        function_index[name] = functions.back().get();
+        return functions.back().get();
+    }
+
+    void Module::eraseFunction(Function* function) {
+        function_index.erase(function->getName());
+        std::erase_if(functions, [function](const std::unique_ptr<Function>& entry) {
+            return entry.get() == function;
+        });
+    }
+}
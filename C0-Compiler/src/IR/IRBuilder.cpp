@@ -0,0 +1,102 @@
+//
+// Created by 陶子杨 on 25-12-10.
+//
+
+#include "IR/IRBuilder.h"
+
+namespace CC::IR {
+
+    Instruction* IRBuilder::insert(Instruction* instruction) {
+        block->insert(instruction, before);
+        return instruction;
+    }
+
+    Instruction* IRBuilder::createBinary(Opcode opcode, Value* left, Value* right) {
+        return insert(function.createInstruction(opcode, left->getType(), {left, right}));
+    }
+
+    Instruction* IRBuilder::createCompare(Opcode opcode, Value* left, Value* right) {
+        return insert(function.createInstruction(opcode, Type::BOOL, {left, right}));
+    }
+
+    Instruction* IRBuilder::createNot(Value* operand) {
+        return insert(function.createInstruction(Opcode::XOR, Type::BOOL, {operand, function.getBool(true)}));
+    }
+
+    Instruction* IRBuilder::createPhi(Type type, BasicBlock* at) {
+        Instruction* phi = function.createInstruction(Opcode::PHI, type);
+        at->insert(phi, at->getFirstNonPhi());
+        return phi;
+    }
+
+    Instruction* IRBuilder::createAlloc(uint32_t size) {
+        Instruction* instruction = function.createInstruction(Opcode::ALLOC, Type::PTR);
+        instruction->setImmediate(size);
+        return insert(instruction);
+    }
+
+    Instruction* IRBuilder::createAllocArray(Value* count, uint32_t element_size) {
+        Instruction* instruction = function.createInstruction(Opcode::ALLOC_ARRAY, Type::PTR, {count});
+        instruction->setImmediate(element_size);
+        return insert(instruction);
+    }
+
+    Instruction* IRBuilder::createLoad(Type type, Value* address) {
+        return insert(function.createInstruction(Opcode::LOAD, type, {address}));
+    }
+
+    Instruction* IRBuilder::createStore(Value* value, Value* address) {
+        return insert(function.createInstruction(Opcode::STORE, Type::VOID, {value, address}));
+    }
+
+    Instruction* IRBuilder::createFieldAddr(Value* base, uint32_t offset) {
+        Instruction* instruction = function.createInstruction(Opcode::FIELD_ADDR, Type::PTR, {base});
+        instruction->setImmediate(offset);
+        return insert(instruction);
+    }
+
+    Instruction* IRBuilder::createElementAddr(Value* array, Value* index, uint32_t element_size) {
+        Instruction* instruction = function.createInstruction(Opcode::ELEMENT_ADDR, Type::PTR, {array, index});
+        instruction->setImmediate(element_size);
+        return insert(instruction);
+    }
+
+    Instruction* IRBuilder::createArrayLength(Value* array) {
+        return insert(function.createInstruction(Opcode::ARRAY_LENGTH, Type::INT, {array}));
+    }
+
+    Instruction* IRBuilder::createCall(Function* callee, const std::vector<Value*>& arguments) {
+        Instruction* instruction = function.createInstruction(Opcode::CALL, callee->getReturnType());
+        instruction->setCallee(callee);
+        for (Value* argument : arguments) {
+            instruction->addOperand(argument);
+        }
+        return insert(instruction);
+    }
+
+    Instruction* IRBuilder::createBr(BasicBlock* target) {
+        Instruction* instruction = function.createInstruction(Opcode::BR, Type::VOID);
+        instruction->setSuccessor(0, target);
+        return insert(instruction);
+    }
+
+    Instruction* IRBuilder::createCondBr(Value* condition, BasicBlock* if_true, BasicBlock* if_false) {
+        Instruction* instruction = function.createInstruction(Opcode::COND_BR, Type::VOID, {condition});
+        instruction->setSuccessor(0, if_true);
+        instruction->setSuccessor(1, if_false);
+        return insert(instruction);
+    }
+
+    Instruction* IRBuilder::createRet(Value* value) {
+        if (value == nullptr) {
+            return insert(function.createInstruction(Opcode::RET, Type::VOID));
+        }
+        return insert(function.createInstruction(Opcode::RET, Type::VOID, {value}));
+    }
+
+    Instruction* IRBuilder::createAbort(int64_t reason) {
+        Instruction* instruction = function.createInstruction(Opcode::ABORT, Type::VOID);
+        instruction->setImmediate(reason);
+        return insert(instruction);
+    }
+}
@@ -0,0 +1,1356 @@
+//
+// Created by 陶子杨 on 25-12-10.
+//
+
+#include "IR/IRLowering.h"
+#include "IR/CFG.h"
+#include "IR/Dataflow.h"
+#include "IR/IRBuilder.h"
+#include "IR/Verifier.h"
+#include "Infra/casting.h"
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace CC::IR {
+    namespace {
+        // 类型错误等无法继续降低当前语句的情况，诊断信息已经记录。
+        // 语句级别捕获之后从下一条语句继续检查，函数降低结束时再整体抛出，在 lower() 中捕获
+        struct LoweringError {};
+
+        struct Typed {
+            Value* value;
+            const C0Type* type;
+        };
+
+        // 赋值的左边：可提升的局部变量，或者堆上的一个地址
+        struct LValue {
+            bool is_variable;
+            uint32_t variable;
+            Value* address;
+            const C0Type* type;
+        };
+
+        // 显式栈上正在降低的一个表达式，stage 是已经降低完的子表达式个数
+        struct ExpressionFrame {
+            const Expression* expression;
+            bool as_lvalue;
+            size_t stage = 0;
+            BasicBlock* merge = nullptr;    ///< 短路求值和条件表达式的汇合块
+            BasicBlock* other = nullptr;    ///< 条件表达式还没有降低的 else 块
+            BasicBlock* from = nullptr;     ///< 第一个分支结束时所在的块
+            Function* callee = nullptr;
+        };
+
+        struct LoopTargets {
+            BasicBlock* break_target;
+            BasicBlock* continue_target;
+        };
+
+        // 源码中对局部变量的一次读或写，按执行顺序记在所在基本块上，供明确赋值检查使用
+        struct VariableAccess {
+            uint32_t variable;
+            bool is_write;
+            uint32_t offset;    ///< 读写所在的表达式在源码中的位置
+        };
+
+        Opcode binaryOpcode(TokenType op) {
+            switch (op) {
+            case TokenType::OP_PLUS: case TokenType::OP_PLUS_ASSIGN: return Opcode::ADD;
+            case TokenType::OP_MINUS: case TokenType::OP_MINUS_ASSIGN: return Opcode::SUB;
+            case TokenType::OP_MULTIPLY: case TokenType::OP_MULTIPLY_ASSIGN: return Opcode::MUL;
+            case TokenType::OP_DIVIDE: case TokenType::OP_DIVIDE_ASSIGN: return Opcode::DIV;
+            case TokenType::OP_MODULO: case TokenType::OP_MODULO_ASSIGN: return Opcode::MOD;
+            case TokenType::OP_SHL: case TokenType::OP_SHL_ASSIGN: return Opcode::SHL;
+            case TokenType::OP_SHR: case TokenType::OP_SHR_ASSIGN: return Opcode::SHR;
+            case TokenType::OP_AND: case TokenType::OP_AND_ASSIGN: return Opcode::AND;
+            case TokenType::OP_OR: case TokenType::OP_OR_ASSIGN: return Opcode::OR;
+            case TokenType::OP_XOR: case TokenType::OP_XOR_ASSIGN: return Opcode::XOR;
+            case TokenType::OP_EQ: return Opcode::EQ;
+            case TokenType::OP_NE: return Opcode::NE;
+            case TokenType::OP_LT: return Opcode::LT;
+            case TokenType::OP_LE: return Opcode::LE;
+            case TokenType::OP_GT: return Opcode::GT;
+            case TokenType::OP_GE: return Opcode::GE;
+            default: return Opcode::ABORT;
+            }
+        }
+
+        /**
+         * @brief 一个函数的降低过程，包括 SSA 构造的全部状态
+         */
+        class FunctionLowering {
+        public:
+            FunctionLowering(IRLowering& owner, Function& function, const FunctionDecl& decl)
+                : owner(owner), types(owner.getTypes()), function(function), decl(decl), builder(function) {}
+
+            void run();
+
+        private:
+            // ---- 报错 ----
+
+            void report(const std::string& message) {
+                owner.addDiagnostic(location, "函数 " + decl.name + ": " + message);
+                ++error_count;
+            }
+
+            [[noreturn]] void fail(const std::string& message) {
+                report(message);
+                throw LoweringError{};
+            }
+
+            /**
+             * @brief 丢掉出错时降低到一半的表达式，插入点所在的块已经终结时换到一个不可达的新块
+             */
+            void abandonExpression() {
+                expression_frames.clear();
+                value_stack.clear();
+                lvalue_stack.clear();
+                pending_phis.clear();
+                if (builder.isTerminated()) {
+                    startUnreachableBlock();
+                }
+            }
+
+            const C0Type* resolveType(const std::string& spelling) {
+                const C0Type* type = types.resolve(spelling);
+                if (type == nullptr) {
+                    fail("未知的类型 '" + spelling + "'");
+                }
+                return type;
+            }
+
+            /**
+             * @brief 检查 value 能否赋给 target 类型
+             */
+            void checkAssignable(const C0Type* target, const Typed& value, const char* what) {
+                if (target == value.type) {
+                    return;
+                }
+                if (target->isPointerLike() && value.type == types.getNull() && target->kind != C0Type::Kind::STRING) {
+                    return;
+                }
+                if (target->kind == C0Type::Kind::OPAQUE || value.type->kind == C0Type::Kind::OPAQUE) {
+                    return;
+                }
+                fail(std::string(what) + "的类型不匹配：需要 " + target->spelling + "，实际是 " + value.type->spelling);
+            }
+
+            void checkType(const Typed& value, const C0Type* expected, const char* what) {
+                if (value.type != expected) {
+                    fail(std::string(what) + "需要 " + expected->spelling + "，实际是 " + value.type->spelling);
+                }
+            }
+
+            // ---- SSA 构造 ----
+
+            BasicBlock* createBlock() {
+                BasicBlock* block = function.createBlock();
+                sealed.push_back(0);
+                accesses.emplace_back();
+                return block;
+            }
+
+            void writeVariable(uint32_t variable, BasicBlock* block, Value* value) {
+                accesses[block->getNumber()].push_back({variable, true, location});
+                definitions[variable][block] = value;
+            }
+
+            Value* readVariable(uint32_t variable, BasicBlock* block) {
+                accesses[block->getNumber()].push_back({variable, false, location});
+                Value* value = lookupVariable(variable, block);
+                fillPendingPhis();
+                return value;
+            }
+
+            /**
+             * @brief 沿着唯一前驱向上找变量的定义，需要合并时建 PHI 并把它放进待补操作数的工作表
+             */
+            Value* lookupVariable(uint32_t variable, BasicBlock* block) {
+                auto& defs = definitions[variable];
+                std::vector<BasicBlock*> chain;
+                BasicBlock* current = block;
+                Value* value = nullptr;
+                while (true) {
+                    auto it = defs.find(current);
+                    if (it != defs.end()) {
+                        value = it->second;
+                        break;
+                    }
+                    Type type = variables[variable].type->getIRType();
+                    if (!sealed[current->getNumber()]) {
+                        Instruction* phi = builder.createPhi(type, current);
+                        incomplete_phis[current].emplace_back(variable, phi);
+                        value = phi;
+                        break;
+                    }
+                    const auto& predecessors = current->getPredecessors();
+                    if (predecessors.empty()) {
+                        // 到达入口或不可达的块仍没有定义：变量未初始化
+                        value = function.getUndef(type);
+                        break;
+                    }
+                    if (predecessors.size() == 1) {
+                        chain.push_back(current);
+                        current = predecessors.front();
+                        continue;
+                    }
+                    Instruction* phi = builder.createPhi(type, current);
+                    pending_phis.emplace_back(variable, phi);
+                    value = phi;
+                    break;
+                }
+                defs[current] = value;
+                for (BasicBlock* visited : chain) {
+                    defs[visited] = value;
+                }
+                return value;
+            }
+
+            void fillPendingPhis() {
+                while (!pending_phis.empty()) {
+                    auto [variable, phi] = pending_phis.back();
+                    pending_phis.pop_back();
+                    BasicBlock* block = phi->getParent();
+                    for (BasicBlock* predecessor : block->getPredecessors()) {
+                        phi->addOperand(lookupVariable(variable, predecessor), predecessor);
+                    }
+                }
+            }
+
+            /**
+             * @brief 基本块的前驱已经全部确定，补全其中不完整的 PHI
+             */
+            void sealBlock(BasicBlock* block) {
+                sealed[block->getNumber()] = 1;
+                auto it = incomplete_phis.find(block);
+                if (it == incomplete_phis.end()) {
+                    return;
+                }
+                for (const auto& entry : it->second) {
+                    pending_phis.push_back(entry);
+                }
+                incomplete_phis.erase(it);
+                fillPendingPhis();
+            }
+
+            /**
+             * @brief 删掉所有操作数只有自身和另一个值的 PHI，被替换的 PHI 的使用者重新检查
+             */
+            void removeTrivialPhis() {
+                // 按基本块的顺序从前往后处理：链式的平凡 PHI 每次只搬动自己的使用，
+                // 反过来处理时使用链表会越滚越长，变成平方
+                std::vector<Instruction*> worklist;
+                for (BasicBlock* block : function.getBlocks()) {
+                    for (Instruction* phi = block->front(); phi != nullptr && phi->isPhi(); phi = phi->getNext()) {
+                        worklist.push_back(phi);
+                    }
+                }
+                std::reverse(worklist.begin(), worklist.end());
+                while (!worklist.empty()) {
+                    Instruction* phi = worklist.back();
+                    worklist.pop_back();
+                    if (phi->getParent() == nullptr) {
+                        continue;
+                    }
+                    Value* same = nullptr;
+                    bool trivial = true;
+                    for (uint32_t i = 0; i < phi->getOperandCount(); ++i) {
+                        Value* operand = phi->getOperand(i);
+                        if (operand == same || operand == phi) {
+                            continue;
+                        }
+                        if (same != nullptr) {
+                            trivial = false;
+                            break;
+                        }
+                        same = operand;
+                    }
+                    if (!trivial) {
+                        continue;
+                    }
+                    if (same == nullptr) {
+                        same = function.getUndef(phi->getType());
+                    }
+                    for (Use* use = phi->getFirstUse(); use != nullptr; use = use->getNext()) {
+                        Instruction* user = use->getUser();
+                        if (user != phi && user->isPhi()) {
+                            worklist.push_back(user);
+                        }
+                    }
+                    phi->replaceAllUsesWith(same);
+                    phi->eraseFromParent();
+                }
+            }
+
+            // ---- 作用域 ----
+
+            uint32_t declareVariable(const std::string& name, const C0Type* type) {
+                if (!type->isSmall()) {
+                    fail("变量 '" + name + "' 不能是 " + type->spelling + " 类型");
+                }
+                auto& binding = bindings[name];
+                if (!binding.empty()) {
+                    fail("变量 '" + name + "' 重复声明");
+                }
+                auto id = static_cast<uint32_t>(variables.size());
+                variables.push_back({name, type});
+                definitions.emplace_back();
+                binding.push_back(id);
+                scopes.back().push_back(name);
+                return id;
+            }
+
+            void pushScope() {
+                scopes.emplace_back();
+            }
+
+            void popScope() {
+                for (const auto& name : scopes.back()) {
+                    bindings[name].pop_back();
+                }
+                scopes.pop_back();
+            }
+
+            uint32_t findVariable(const std::string& name) {
+                auto it = bindings.find(name);
+                if (it == bindings.end() || it->second.empty()) {
+                    fail("未声明的变量 '" + name + "'");
+                }
+                return it->second.back();
+            }
+
+            // ---- 控制流辅助 ----
+
+            /**
+             * @brief return/break/continue 之后的语句放进一个没有前驱的新块，最后统一删掉
+             */
+            void startUnreachableBlock() {
+                BasicBlock* block = createBlock();
+                sealBlock(block);
+                builder.setInsertPoint(block);
+            }
+
+            void branchTo(BasicBlock* target) {
+                if (!builder.isTerminated()) {
+                    builder.createBr(target);
+                }
+            }
+
+            /**
+             * @brief 条件为假时中止程序
+             */
+            void lowerCheck(const std::shared_ptr<Expression>& condition, ContractKind kind) {
+                Typed check = lowerCondition(*condition, "检查条件");
+                BasicBlock* pass = createBlock();
+                BasicBlock* failure = createBlock();
+                builder.createCondBr(check.value, pass, failure);
+                sealBlock(pass);
+                sealBlock(failure);
+                builder.setInsertPoint(failure);
+                builder.createAbort(static_cast<int64_t>(kind));
+                builder.setInsertPoint(pass);
+            }
+
+            void lowerEachIterationInvariants(const std::vector<Contract>& invariants) {
+                for (const auto& invariant : invariants) {
+                    if (invariant.check == ContractCheck::EACH_ITERATION) {
+                        lowerCheck(invariant.condition, ContractKind::LOOP_INVARIANT);
+                    }
+                }
+            }
+
+            // ---- 语句 ----
+
+            /**
+             * @brief C0 要求变量在每条路径上都先赋值再使用
+             *
+             * 正向的必然问题：块出口处已赋值的变量 = 入口处的 | 块内写过的。
+             * 求出各块入口的集合之后按执行顺序重放块内的读写，读到不在集合中的变量就报错
+             */
+            void checkDefiniteAssignment();
+
+            /**
+             * @brief 降低一条语句，出错时恢复作用域和循环栈，之后的语句放进不可达的新块继续检查
+             */
+            void lowerStatement(const Statement& statement);
+            void lowerStatementBody(const Statement& statement);
+            void lowerCompound(const CompoundStmt& block);
+            void lowerDeclaration(const DeclStmt& statement);
+            void lowerIf(const IfStmt& statement);
+            void lowerWhile(const WhileStmt& statement);
+            void lowerFor(const ForStmt& statement);
+            void lowerDoWhile(const DoWhileStmt& statement);
+            void lowerReturn(const ReturnStmt& statement);
+
+            // ---- 表达式 ----
+
+            Typed lowerExpression(const Expression& expression);
+            /**
+             * @brief 降低条件并检查它是 bool，出错时用 undef 代替，分支和循环体照常检查
+             */
+            Typed lowerCondition(const Expression& expression, const char* what = "条件");
+            Typed readLValue(const LValue& lvalue);
+            void writeLValue(const LValue& lvalue, Value* value);
+
+            /**
+             * @brief 用显式栈降低整棵表达式树，结果留在 value_stack 或 lvalue_stack 的栈顶，
+             * 和语法分析一样，表达式的深度只受堆内存限制
+             */
+            void lowerTree(const Expression& root, bool as_lvalue);
+
+            // 每一步推进 frame：返回下一个要降低的子表达式，或者把 frame 的结果压栈后返回空
+            std::optional<ExpressionFrame> stepValue(ExpressionFrame& frame);
+            std::optional<ExpressionFrame> stepLValue(ExpressionFrame& frame);
+            std::optional<ExpressionFrame> stepRead(ExpressionFrame& frame);
+            std::optional<ExpressionFrame> stepMember(ExpressionFrame& frame, const MemberExpr& member);
+            std::optional<ExpressionFrame> stepAssignment(ExpressionFrame& frame, const AssignmentExpr& assignment);
+            std::optional<ExpressionFrame> stepBinary(ExpressionFrame& frame, const BinaryExpr& binary);
+            std::optional<ExpressionFrame> stepShortCircuit(ExpressionFrame& frame, const BinaryExpr& binary);
+            std::optional<ExpressionFrame> stepUnary(ExpressionFrame& frame, const UnaryExpr& unary);
+            std::optional<ExpressionFrame> stepConditional(ExpressionFrame& frame, const ConditionalExpr& conditional);
+            std::optional<ExpressionFrame> stepCall(ExpressionFrame& frame, const CallExpr& call);
+            std::optional<ExpressionFrame> stepAlloc(ExpressionFrame& frame, const AllocExpr& alloc);
+
+            static ExpressionFrame asValue(const Expression& expression) {
+                return {&expression, false};
+            }
+
+            static ExpressionFrame asLValue(const Expression& expression) {
+                return {&expression, true};
+            }
+
+            std::optional<ExpressionFrame> finishValue(const Typed& value) {
+                value_stack.push_back(value);
+                return std::nullopt;
+            }
+
+            std::optional<ExpressionFrame> finishLValue(const LValue& lvalue) {
+                lvalue_stack.push_back(lvalue);
+                return std::nullopt;
+            }
+
+            Typed popValue() {
+                Typed value = value_stack.back();
+                value_stack.pop_back();
+                return value;
+            }
+
+            LValue popLValue() {
+                LValue lvalue = lvalue_stack.back();
+                lvalue_stack.pop_back();
+                return lvalue;
+            }
+
+            Value* arithmetic(Opcode opcode, const Typed& left, const Typed& right) {
+                if (opcode == Opcode::AND || opcode == Opcode::OR || opcode == Opcode::XOR) {
+                    if (left.type != types.getInt() && left.type != types.getBool()) {
+                        fail(std::string("运算 ") + getOpcodeName(opcode) + " 需要 int 或 bool，实际是 " +
+                             left.type->spelling);
+                    }
+                    checkType(right, left.type, "位运算的右操作数");
+                } else {
+                    checkType(left, types.getInt(), "算术运算的左操作数");
+                    checkType(right, types.getInt(), "算术运算的右操作数");
+                }
+                return builder.createBinary(opcode, left.value, right.value);
+            }
+
+            IRLowering& owner;
+            TypeTable& types;
+            Function& function;
+            const FunctionDecl& decl;
+            IRBuilder builder;
+            const C0Type* return_type = nullptr;
+            uint32_t location = 0;      ///< 正在降低的节点在源码中的字节偏移，报错时换算成行列号
+            size_t error_count = 0;
+
+            struct Variable {
+                std::string name;
+                const C0Type* type;
+            };
+            std::vector<Variable> variables;
+            std::vector<std::unordered_map<BasicBlock*, Value*>> definitions;   ///< 每个变量在各块末尾的值
+            std::unordered_map<std::string, std::vector<uint32_t>> bindings;
+            std::vector<std::vector<std::string>> scopes;
+
+            std::vector<char> sealed;   ///< 按基本块编号
+            std::unordered_map<BasicBlock*, std::vector<std::pair<uint32_t, Instruction*>>> incomplete_phis;
+            std::vector<std::pair<uint32_t, Instruction*>> pending_phis;
+            std::vector<LoopTargets> loops;
+            std::vector<std::vector<VariableAccess>> accesses;   ///< 按基本块编号
+            std::vector<ExpressionFrame> expression_frames;
+            std::vector<Typed> value_stack;
+            std::vector<LValue> lvalue_stack;
+        };
+
+        void FunctionLowering::run() {
+            location = decl.offset;
+            return_type = resolveType(decl.returnType);
+            if (return_type->kind == C0Type::Kind::STRUCT) {
+                fail("返回类型不能是 " + return_type->spelling);
+            }
+
+            BasicBlock* entry = createBlock();
+            sealBlock(entry);
+            builder.setInsertPoint(entry);
+
+            pushScope();
+            for (size_t i = 0; i < decl.parameters.size(); ++i) {
+                const auto& parameter = decl.parameters[i];
+                location = parameter->offset;
+                uint32_t variable = declareVariable(parameter->name, resolveType(parameter->type));
+                writeVariable(variable, entry, function.getArguments()[i]);
+            }
+            lowerCompound(*decl.body);
+            popScope();
+            if (error_count != 0) {
+                // 出错的语句只降低了一半，明确赋值检查的结果不可信，出错的函数不做这项检查也不生成 IR
+                throw LoweringError{};
+            }
+
+            if (!builder.isTerminated()) {
+                BasicBlock* end = builder.getInsertBlock();
+                if (return_type->kind == C0Type::Kind::VOID) {
+                    builder.createRet(nullptr);
+                } else if (end == entry || !end->getPredecessors().empty()) {
+                    location = decl.offset;
+                    fail("控制流可能到达函数末尾而没有 return");
+                } else {
+                    builder.createAbort(-1);
+                }
+            }
+
+            checkDefiniteAssignment();
+            function.removeUnreachableBlocks();
+            removeTrivialPhis();
+            function.renumber();
+        }
+
+        void FunctionLowering::checkDefiniteAssignment() {
+            CFG cfg(function);
+            uint32_t count = cfg.size();
+            size_t universe = variables.size();
+            GenKillProblem<INFRA::BitVector, DataflowDirection::FORWARD, MeetOperator::INTERSECTION> problem;
+            problem.boundary = INFRA::BitVector(universe);
+            problem.initial = INFRA::BitVector(universe, true);
+            problem.gen.assign(count, INFRA::BitVector(universe));
+            problem.kill.assign(count, INFRA::BitVector(universe));
+            for (uint32_t b = 0; b < count; ++b) {
+                for (const VariableAccess& access : accesses[b]) {
+                    if (access.is_write) {
+                        problem.gen[b].set(access.variable);
+                    }
+                }
+            }
+
+            DataflowSolver solver(cfg, problem);
+            solver.solve();
+            for (uint32_t b : cfg.getReversePostOrder()) {
+                INFRA::BitVector assigned = solver.getIn(b);
+                for (const VariableAccess& access : accesses[b]) {
+                    if (access.is_write) {
+                        assigned.set(access.variable);
+                    } else if (!assigned.test(access.variable)) {
+                        // 报过一次之后当作已赋值，同一条路径上之后的读取不再重复报
+                        location = access.offset;
+                        report("变量 '" + variables[access.variable].name + "' 在使用前可能没有初始化");
+                        assigned.set(access.variable);
+                    }
+                }
+            }
+            if (error_count != 0) {
+                throw LoweringError{};
+            }
+        }
+
+        void FunctionLowering::lowerStatement(const Statement& statement) {
+            if (builder.isTerminated()) {
+                startUnreachableBlock();
+            }
+            size_t scope_depth = scopes.size();
+            size_t loop_depth = loops.size();
+            try {
+                lowerStatementBody(statement);
+            } catch (const LoweringError&) {
+                while (scopes.size() > scope_depth) {
+                    popScope();
+                }
+                loops.resize(loop_depth);
+                abandonExpression();
+                startUnreachableBlock();
+            }
+        }
+
+        void FunctionLowering::lowerStatementBody(const Statement& statement) {
+            location = statement.offset;
+            switch (statement.type) {
+            case StatementType::COMPOUND_STMT:
+                pushScope();
+                lowerCompound(static_cast<const CompoundStmt&>(statement));
+                popScope();
+                break;
+            case StatementType::EXPR_STMT: {
+                const auto& expression = static_cast<const ExpressionStmt&>(statement).expression;
+                if (expression) {
+                    lowerExpression(*expression);
+                }
+                break;
+            }
+            case StatementType::DECL_STMT:
+                lowerDeclaration(static_cast<const DeclStmt&>(statement));
+                break;
+            case StatementType::IF_STMT:
+                lowerIf(static_cast<const IfStmt&>(statement));
+                break;
+            case StatementType::WHILE_STMT:
+                lowerWhile(static_cast<const WhileStmt&>(statement));
+                break;
+            case StatementType::FOR_STMT:
+                lowerFor(static_cast<const ForStmt&>(statement));
+                break;
+            case StatementType::DO_WHILE_STMT:
+                lowerDoWhile(static_cast<const DoWhileStmt&>(statement));
+                break;
+            case StatementType::RETURN_STMT:
+                lowerReturn(static_cast<const ReturnStmt&>(statement));
+                break;
+            case StatementType::BREAK_STMT:
+                if (loops.empty()) {
+                    fail("break 不在循环中");
+                }
+                builder.createBr(loops.back().break_target);
+                break;
+            case StatementType::CONTINUE_STMT:
+                if (loops.empty()) {
+                    fail("continue 不在循环中");
+                }
+                builder.createBr(loops.back().continue_target);
+                break;
+            case StatementType::ASSERT_STMT: {
+                // 没有开启动态检查时 //@assert 和其他规约一样不生成检查
+                const auto& assertion = static_cast<const AssertStmt&>(statement);
+                if (assertion.check != ContractCheck::UNCHECKED && assertion.check != ContractCheck::ELIDED) {
+                    lowerCheck(assertion.condition, assertion.kind);
+                }
+                break;
+            }
+            case StatementType::NULL_STMT:
+                break;
+            }
+        }
+
+        void FunctionLowering::lowerCompound(const CompoundStmt& block) {
+            for (const auto& statement : block.statements) {
+                if (statement) {
+                    lowerStatement(*statement);
+                }
+            }
+        }
+
+        void FunctionLowering::lowerDeclaration(const DeclStmt& statement) {
+            auto variable_decl = INFRA::dyn_cast<VariableDecl>(statement.declaration);
+            if (!variable_decl) {
+                fail("函数体中只能声明变量");
+            }
+            const C0Type* type = resolveType(variable_decl->type);
+            // 初始化表达式在变量进入作用域之前求值，其中不能引用变量自己。
+            // 初始化出错时变量照样声明，之后的使用不会再报未声明
+            std::optional<Typed> initial;
+            if (variable_decl->initializer) {
+                try {
+                    initial = lowerExpression(*variable_decl->initializer);
+                } catch (const LoweringError&) {
+                    abandonExpression();
+                }
+            }
+            location = variable_decl->offset;
+            uint32_t variable = declareVariable(variable_decl->name, type);
+            if (initial) {
+                location = variable_decl->initializer->offset;
+                checkAssignable(type, *initial, "初始化");
+                writeVariable(variable, builder.getInsertBlock(), initial->value);
+            }
+        }
+
+        void FunctionLowering::lowerIf(const IfStmt& statement) {
+            Typed condition = lowerCondition(*statement.condition);
+            BasicBlock* then_block = createBlock();
+            BasicBlock* merge = createBlock();
+            BasicBlock* else_block = statement.elseStmt ? createBlock() : merge;
+            builder.createCondBr(condition.value, then_block, else_block);
+            sealBlock(then_block);
+
+            builder.setInsertPoint(then_block);
+            pushScope();
+            lowerStatement(*statement.thenStmt);
+            popScope();
+            branchTo(merge);
+
+            if (statement.elseStmt) {
+                sealBlock(else_block);
+                builder.setInsertPoint(else_block);
+                pushScope();
+                lowerStatement(*statement.elseStmt);
+                popScope();
+                branchTo(merge);
+            }
+            sealBlock(merge);
+            builder.setInsertPoint(merge);
+        }
+
+        void FunctionLowering::lowerWhile(const WhileStmt& statement) {
+            BasicBlock* header = createBlock();
+            BasicBlock* body = createBlock();
+            BasicBlock* exit = createBlock();
+            builder.createBr(header);
+
+            // 循环头在回边确定之前不能封闭
+            builder.setInsertPoint(header);
+            lowerEachIterationInvariants(statement.invariants);
+            Typed condition = lowerCondition(*statement.condition);
+            builder.createCondBr(condition.value, body, exit);
+            sealBlock(body);
+
+            builder.setInsertPoint(body);
+            loops.push_back({exit, header});
+            pushScope();
+            lowerStatement(*statement.body);
+            popScope();
+            loops.pop_back();
+            branchTo(header);
+
+            sealBlock(header);
+            sealBlock(exit);
+            builder.setInsertPoint(exit);
+        }
+
+        void FunctionLowering::lowerFor(const ForStmt& statement) {
+            pushScope();
+            if (statement.init) {
+                lowerStatement(*statement.init);
+            }
+            BasicBlock* header = createBlock();
+            BasicBlock* body = createBlock();
+            BasicBlock* latch = createBlock();
+            BasicBlock* exit = createBlock();
+            branchTo(header);
+
+            builder.setInsertPoint(header);
+            lowerEachIterationInvariants(statement.invariants);
+            if (statement.condition) {
+                Typed condition = lowerCondition(*statement.condition);
+                builder.createCondBr(condition.value, body, exit);
+            } else {
+                builder.createBr(body);
+            }
+            sealBlock(body);
+
+            builder.setInsertPoint(body);
+            loops.push_back({exit, latch});
+            pushScope();
+            lowerStatement(*statement.body);
+            popScope();
+            loops.pop_back();
+            branchTo(latch);
+
+            sealBlock(latch);
+            builder.setInsertPoint(latch);
+            if (statement.increment) {
+                lowerExpression(*statement.increment);
+            }
+            builder.createBr(header);
+            sealBlock(header);
+            sealBlock(exit);
+            builder.setInsertPoint(exit);
+            popScope();
+        }
+
+        void FunctionLowering::lowerDoWhile(const DoWhileStmt& statement) {
+            BasicBlock* body = createBlock();
+            BasicBlock* test = createBlock();
+            BasicBlock* exit = createBlock();
+            builder.createBr(body);
+
+            builder.setInsertPoint(body);
+            loops.push_back({exit, test});
+            pushScope();
+            lowerStatement(*statement.body);
+            popScope();
+            loops.pop_back();
+            branchTo(test);
+
+            sealBlock(test);
+            builder.setInsertPoint(test);
+            Typed condition = lowerCondition(*statement.condition);
+            builder.createCondBr(condition.value, body, exit);
+            sealBlock(body);
+            sealBlock(exit);
+            builder.setInsertPoint(exit);
+        }
+
+        void FunctionLowering::lowerReturn(const ReturnStmt& statement) {
+            if (!statement.expression) {
+                if (return_type->kind != C0Type::Kind::VOID) {
+                    fail("非 void 函数的 return 缺少返回值");
+                }
+                builder.createRet(nullptr);
+                return;
+            }
+            if (return_type->kind == C0Type::Kind::VOID) {
+                fail("void 函数不能返回值");
+            }
+            Typed value = lowerExpression(*statement.expression);
+            checkAssignable(return_type, value, "返回值");
+            builder.createRet(value.value);
+        }
+
+        Typed FunctionLowering::lowerCondition(const Expression& expression, const char* what) {
+            try {
+                Typed condition = lowerExpression(expression);
+                checkType(condition, types.getBool(), what);
+                return condition;
+            } catch (const LoweringError&) {
+                abandonExpression();
+                return {function.getUndef(Type::BOOL), types.getBool()};
+            }
+        }
+
+        Typed FunctionLowering::lowerExpression(const Expression& expression) {
+            lowerTree(expression, false);
+            return popValue();
+        }
+
+        void FunctionLowering::lowerTree(const Expression& root, bool as_lvalue) {
+            expression_frames.push_back({&root, as_lvalue});
+            while (!expression_frames.empty()) {
+                ExpressionFrame& frame = expression_frames.back();
+                location = frame.expression->offset;
+                std::optional<ExpressionFrame> child = frame.as_lvalue ? stepLValue(frame) : stepValue(frame);
+                // 压入子表达式之后 frame 不再有效
+                if (child) {
+                    expression_frames.push_back(*child);
+                } else {
+                    expression_frames.pop_back();
+                }
+            }
+        }
+
+        std::optional<ExpressionFrame> FunctionLowering::stepValue(ExpressionFrame& frame) {
+            const Expression& expression = *frame.expression;
+            switch (expression.type) {
+            case ExpressionType::INTEGER_LITERAL_EXPR:
+                return finishValue({function.getInt(static_cast<const IntegerLiteralExpr&>(expression).value),
+                                    types.getInt()});
+            case ExpressionType::BOOL_LITERAL_EXPR:
+                return finishValue({function.getBool(static_cast<const BoolLiteralExpr&>(expression).value),
+                                    types.getBool()});
+            case ExpressionType::CHAR_LITERAL_EXPR: {
+                auto value = static_cast<unsigned char>(static_cast<const CharLiteralExpr&>(expression).value);
+                return finishValue({function.getConstant(Type::CHAR, value), types.getChar()});
+            }
+            case ExpressionType::STRING_LITERAL_EXPR:
+                return finishValue({function.getString(static_cast<const StringLiteralExpr&>(expression).value),
+                                    types.getString()});
+            case ExpressionType::NULL_LITERAL_EXPR:
+                return finishValue({function.getConstant(Type::PTR, 0), types.getNull()});
+            case ExpressionType::FLOAT_LITERAL_EXPR:
+                fail("C0 不支持浮点数");
+            case ExpressionType::RESULT_EXPR:
+                fail("\\result 只能出现在 //@ensures 中");
+            case ExpressionType::IDENTIFIER_EXPR:
+            case ExpressionType::ARRAY_SUBSCRIPT_EXPR:
+            case ExpressionType::MEMBER_EXPR:
+                return stepRead(frame);
+            case ExpressionType::UNARY_EXPR:
+                return stepUnary(frame, static_cast<const UnaryExpr&>(expression));
+            case ExpressionType::BINARY_EXPR:
+                return stepBinary(frame, static_cast<const BinaryExpr&>(expression));
+            case ExpressionType::ASSIGNMENT_EXPR:
+                return stepAssignment(frame, static_cast<const AssignmentExpr&>(expression));
+            case ExpressionType::CONDITIONAL_EXPR:
+                return stepConditional(frame, static_cast<const ConditionalExpr&>(expression));
+            case ExpressionType::CALL_EXPR:
+                return stepCall(frame, static_cast<const CallExpr&>(expression));
+            case ExpressionType::ALLOC_EXPR:
+                return stepAlloc(frame, static_cast<const AllocExpr&>(expression));
+            case ExpressionType::LENGTH_EXPR: {
+                if (frame.stage++ == 0) {
+                    return asValue(*static_cast<const LengthExpr&>(expression).array);
+                }
+                Typed array = popValue();
+                if (array.type->kind != C0Type::Kind::ARRAY) {
+                    fail("\\length 需要数组，实际是 " + array.type->spelling);
+                }
+                return finishValue({builder.createArrayLength(array.value), types.getInt()});
+            }
+            }
+            fail("无法降低的表达式");
+        }
+
+        std::optional<ExpressionFrame> FunctionLowering::stepRead(ExpressionFrame& frame) {
+            if (frame.stage++ == 0) {
+                return asLValue(*frame.expression);
+            }
+            return finishValue(readLValue(popLValue()));
+        }
+
+        std::optional<ExpressionFrame> FunctionLowering::stepLValue(ExpressionFrame& frame) {
+            const Expression& expression = *frame.expression;
+            switch (expression.type) {
+            case ExpressionType::IDENTIFIER_EXPR: {
+                uint32_t variable = findVariable(static_cast<const IdentifierExpr&>(expression).name);
+                return finishLValue({true, variable, nullptr, variables[variable].type});
+            }
+            case ExpressionType::UNARY_EXPR: {
+                const auto& unary = static_cast<const UnaryExpr&>(expression);
+                if (unary.op != TokenType::OP_MULTIPLY) {
+                    break;
+                }
+                if (frame.stage++ == 0) {
+                    return asValue(*unary.operand);
+                }
+                Typed pointer = popValue();
+                if (pointer.type->kind != C0Type::Kind::POINTER) {
+                    fail("只能解引用指针，实际是 " + pointer.type->spelling);
+                }
+                if (pointer.type->element == nullptr) {
+                    fail("不能解引用 NULL");
+                }
+                return finishLValue({false, 0, pointer.value, pointer.type->element});
+            }
+            case ExpressionType::ARRAY_SUBSCRIPT_EXPR: {
+                const auto& subscript = static_cast<const ArraySubscriptExpr&>(expression);
+                switch (frame.stage++) {
+                case 0:
+                    return asValue(*subscript.base);
+                case 1:
+                    if (value_stack.back().type->kind != C0Type::Kind::ARRAY) {
+                        fail("下标运算需要数组，实际是 " + value_stack.back().type->spelling);
+                    }
+                    return asValue(*subscript.index);
+                default:
+                    break;
+                }
+                Typed index = popValue();
+                Typed array = popValue();
+                checkType(index, types.getInt(), "数组下标");
+                const C0Type* element = array.type->element;
+                Value* address = builder.createElementAddr(array.value, index.value, types.sizeOf(element));
+                return finishLValue({false, 0, address, element});
+            }
+            case ExpressionType::MEMBER_EXPR:
+                return stepMember(frame, static_cast<const MemberExpr&>(expression));
+            default:
+                break;
+            }
+            fail("表达式不能作为左值");
+        }
+
+        std::optional<ExpressionFrame> FunctionLowering::stepMember(ExpressionFrame& frame, const MemberExpr& member) {
+            if (frame.stage++ == 0) {
+                return member.arrow ? asValue(*member.base) : asLValue(*member.base);
+            }
+            Value* base;
+            const C0Type* struct_type;
+            if (member.arrow) {
+                Typed pointer = popValue();
+                if (pointer.type->kind != C0Type::Kind::POINTER || pointer.type->element == nullptr) {
+                    fail("'->' 需要结构体指针，实际是 " + pointer.type->spelling);
+                }
+                base = pointer.value;
+                struct_type = pointer.type->element;
+            } else {
+                LValue object = popLValue();
+                if (object.is_variable) {
+                    fail("'.' 的左边必须是堆上的结构体");
+                }
+                base = object.address;
+                struct_type = object.type;
+            }
+            if (struct_type->kind != C0Type::Kind::STRUCT) {
+                fail("成员访问需要结构体，实际是 " + struct_type->spelling);
+            }
+            const StructLayout* layout = types.getLayout(struct_type);
+            if (layout == nullptr) {
+                fail(struct_type->spelling + " 没有定义");
+            }
+            const FieldLayout* field = layout->findField(member.member);
+            if (field == nullptr) {
+                fail(struct_type->spelling + " 没有成员 '" + member.member + "'");
+            }
+            return finishLValue({false, 0, builder.createFieldAddr(base, field->offset), field->type});
+        }
+
+        Typed FunctionLowering::readLValue(const LValue& lvalue) {
+            if (lvalue.is_variable) {
+                return {readVariable(lvalue.variable, builder.getInsertBlock()), lvalue.type};
+            }
+            if (!lvalue.type->isSmall()) {
+                fail(lvalue.type->spelling + " 不能作为值使用");
+            }
+            return {builder.createLoad(lvalue.type->getIRType(), lvalue.address), lvalue.type};
+        }
+
+        void FunctionLowering::writeLValue(const LValue& lvalue, Value* value) {
+            if (lvalue.is_variable) {
+                writeVariable(lvalue.variable, builder.getInsertBlock(), value);
+            } else {
+                builder.createStore(value, lvalue.address);
+            }
+        }
+
+        std::optional<ExpressionFrame> FunctionLowering::stepAssignment(ExpressionFrame& frame,
+                                                                        const AssignmentExpr& assignment) {
+            switch (frame.stage++) {
+            case 0:
+                // 先求左边的地址，再求右边的值
+                return asLValue(*assignment.left);
+            case 1: {
+                const LValue& target = lvalue_stack.back();
+                if (!target.type->isSmall()) {
+                    fail(target.type->spelling + " 不能整体赋值");
+                }
+                if (assignment.op != TokenType::OP_ASSIGN) {
+                    if (binaryOpcode(assignment.op) == Opcode::ABORT) {
+                        fail("未知的赋值运算符");
+                    }
+                    value_stack.push_back(readLValue(target));
+                }
+                return asValue(*assignment.right);
+            }
+            default:
+                break;
+            }
+            Typed value = popValue();
+            LValue target = popLValue();
+            if (assignment.op == TokenType::OP_ASSIGN) {
+                checkAssignable(target.type, value, "赋值");
+            } else {
+                Typed current = popValue();
+                value = {arithmetic(binaryOpcode(assignment.op), current, value), target.type};
+            }
+            writeLValue(target, value.value);
+            return finishValue(value);
+        }
+
+        std::optional<ExpressionFrame> FunctionLowering::stepBinary(ExpressionFrame& frame, const BinaryExpr& binary) {
+            if (binary.op == TokenType::OP_LOGICAL_AND || binary.op == TokenType::OP_LOGICAL_OR) {
+                return stepShortCircuit(frame, binary);
+            }
+            Opcode opcode = binaryOpcode(binary.op);
+            if (opcode == Opcode::ABORT) {
+                fail("未知的二元运算符");
+            }
+            switch (frame.stage++) {
+            case 0:
+                return asValue(*binary.left);
+            case 1:
+                return asValue(*binary.right);
+            default:
+                break;
+            }
+            Typed right = popValue();
+            Typed left = popValue();
+            if (opcode >= Opcode::EQ && opcode <= Opcode::GE) {
+                if (opcode == Opcode::EQ || opcode == Opcode::NE) {
+                    bool pointers = left.type->isPointerLike() && right.type->isPointerLike() &&
+                                    (left.type == types.getNull() || right.type == types.getNull());
+                    if (!pointers && left.type != right.type) {
+                        fail("不能比较 " + left.type->spelling + " 和 " + right.type->spelling);
+                    }
+                    if (left.type->kind == C0Type::Kind::STRING) {
+                        fail("字符串要用 string_equal 比较");
+                    }
+                } else {
+                    if (left.type != right.type ||
+                        (left.type != types.getInt() && left.type != types.getChar())) {
+                        fail("大小比较需要两个 int 或两个 char");
+                    }
+                }
+                return finishValue({builder.createCompare(opcode, left.value, right.value), types.getBool()});
+            }
+            return finishValue({arithmetic(opcode, left, right), left.type});
+        }
+
+        std::optional<ExpressionFrame> FunctionLowering::stepShortCircuit(ExpressionFrame& frame,
+                                                                          const BinaryExpr& binary) {
+            bool is_and = binary.op == TokenType::OP_LOGICAL_AND;
+            switch (frame.stage++) {
+            case 0:
+                return asValue(*binary.left);
+            case 1: {
+                Typed left = popValue();
+                checkType(left, types.getBool(), "条件");
+                frame.from = builder.getInsertBlock();
+                BasicBlock* right_block = createBlock();
+                frame.merge = createBlock();
+                if (is_and) {
+                    builder.createCondBr(left.value, right_block, frame.merge);
+                } else {
+                    builder.createCondBr(left.value, frame.merge, right_block);
+                }
+                sealBlock(right_block);
+                builder.setInsertPoint(right_block);
+                return asValue(*binary.right);
+            }
+            default:
+                break;
+            }
+            Typed right = popValue();
+            checkType(right, types.getBool(), "条件");
+            BasicBlock* from_right = builder.getInsertBlock();
+            builder.createBr(frame.merge);
+            sealBlock(frame.merge);
+
+            builder.setInsertPoint(frame.merge);
+            Instruction* phi = builder.createPhi(Type::BOOL, frame.merge);
+            phi->addOperand(function.getBool(!is_and), frame.from);
+            phi->addOperand(right.value, from_right);
+            return finishValue({phi, types.getBool()});
+        }
+
+        std::optional<ExpressionFrame> FunctionLowering::stepUnary(ExpressionFrame& frame, const UnaryExpr& unary) {
+            if (unary.op == TokenType::OP_MULTIPLY) {
+                return stepRead(frame);
+            }
+            if (frame.stage++ == 0) {
+                return asValue(*unary.operand);
+            }
+            Typed operand = popValue();
+            switch (unary.op) {
+            case TokenType::OP_MINUS:
+                checkType(operand, types.getInt(), "取负");
+                return finishValue({builder.createBinary(Opcode::SUB, function.getInt(0), operand.value),
+                                    types.getInt()});
+            case TokenType::OP_PLUS:
+                checkType(operand, types.getInt(), "正号");
+                return finishValue(operand);
+            case TokenType::OP_NOT:
+                checkType(operand, types.getBool(), "逻辑非");
+                return finishValue({builder.createNot(operand.value), types.getBool()});
+            case TokenType::OP_BIT_NOT:
+                checkType(operand, types.getInt(), "按位取反");
+                return finishValue({builder.createBinary(Opcode::XOR, operand.value, function.getInt(-1)),
+                                    types.getInt()});
+            default:
+                fail("未知的一元运算符");
+            }
+        }
+
+        std::optional<ExpressionFrame> FunctionLowering::stepConditional(ExpressionFrame& frame,
+                                                                         const ConditionalExpr& conditional) {
+            switch (frame.stage++) {
+            case 0:
+                return asValue(*conditional.condition);
+            case 1: {
+                Typed condition = popValue();
+                checkType(condition, types.getBool(), "条件");
+                BasicBlock* then_block = createBlock();
+                frame.other = createBlock();
+                frame.merge = createBlock();
+                builder.createCondBr(condition.value, then_block, frame.other);
+                sealBlock(then_block);
+                sealBlock(frame.other);
+                builder.setInsertPoint(then_block);
+                return asValue(*conditional.thenExpr);
+            }
+            case 2:
+                frame.from = builder.getInsertBlock();
+                builder.createBr(frame.merge);
+                builder.setInsertPoint(frame.other);
+                return asValue(*conditional.elseExpr);
+            default:
+                break;
+            }
+            Typed else_value = popValue();
+            Typed then_value = popValue();
+            BasicBlock* from_else = builder.getInsertBlock();
+            builder.createBr(frame.merge);
+            sealBlock(frame.merge);
+
+            // 一边是 NULL 时结果取另一边的指针类型
+            const C0Type* type = then_value.type == types.getNull() ? else_value.type : then_value.type;
+            checkAssignable(type, then_value, "条件表达式的分支");
+            checkAssignable(type, else_value, "条件表达式的分支");
+            if (!type->isSmall()) {
+                fail("条件表达式的结果不能是 " + type->spelling);
+            }
+            builder.setInsertPoint(frame.merge);
+            Instruction* phi = builder.createPhi(type->getIRType(), frame.merge);
+            phi->addOperand(then_value.value, frame.from);
+            phi->addOperand(else_value.value, from_else);
+            return finishValue({phi, type});
+        }
+
+        std::optional<ExpressionFrame> FunctionLowering::stepCall(ExpressionFrame& frame, const CallExpr& call) {
+            if (frame.stage == 0) {
+                auto callee_name = INFRA::dyn_cast<IdentifierExpr>(call.callee);
+                if (!callee_name) {
+                    fail("只能调用具名函数");
+                }
+                frame.callee = owner.declare(callee_name->name);
+                if (frame.callee == nullptr) {
+                    fail("未声明的函数 '" + callee_name->name + "'");
+                }
+                if (frame.callee->getArguments().size() != call.arguments.size()) {
+                    fail("调用 " + callee_name->name + " 的参数个数不对");
+                }
+            } else {
+                // 刚降低完的是第 stage 个参数
+                const Typed& argument = value_stack.back();
+                if (argument.value->getType() != frame.callee->getArguments()[frame.stage - 1]->getType() &&
+                    argument.type != types.getNull()) {
+                    fail("调用 " + static_cast<const IdentifierExpr&>(*call.callee).name + " 的第 " +
+                         std::to_string(frame.stage) + " 个参数类型不对");
+                }
+            }
+            if (frame.stage < call.arguments.size()) {
+                return asValue(*call.arguments[frame.stage++]);
+            }
+            std::vector<Value*> arguments(call.arguments.size());
+            for (size_t i = arguments.size(); i-- > 0;) {
+                arguments[i] = popValue().value;
+            }
+            const std::string& name = static_cast<const IdentifierExpr&>(*call.callee).name;
+            return finishValue({builder.createCall(frame.callee, arguments), owner.getReturnType(name)});
+        }
+
+        std::optional<ExpressionFrame> FunctionLowering::stepAlloc(ExpressionFrame& frame, const AllocExpr& alloc) {
+            const C0Type* element = resolveType(alloc.elementType);
+            if (element->kind == C0Type::Kind::VOID) {
+                fail("不能分配 void");
+            }
+            uint32_t size = types.sizeOf(element);
+            if (size == 0) {
+                fail(element->spelling + " 没有定义");
+            }
+            if (!alloc.count) {
+                return finishValue({builder.createAlloc(size), types.getPointer(element)});
+            }
+            if (frame.stage++ == 0) {
+                return asValue(*alloc.count);
+            }
+            Typed count = popValue();
+            checkType(count, types.getInt(), "数组长度");
+            return finishValue({builder.createAllocArray(count.value, size), types.getArray(element)});
+        }
+    }
+
+    IRLowering::IRLowering(Module& module, const GlobalDeclarations& globals, const CodeManager& source)
+        : module(module), globals(globals), source(source), types(globals) {
+    }
+
+    const C0Type* IRLowering::getReturnType(std::string_view name) {
+        if (const FunctionDecl* signature = globals.findFunction(name)) {
+            return types.resolve(signature->returnType);
+        }
+        if (auto library_function = globals.findLibraryFunction(name)) {
+            return types.resolve(library_function->getReturnType());
+        }
+        return nullptr;
+    }
+
+    Function* IRLowering::declare(std::string_view name) {
+        if (Function* existing = module.getFunction(name)) {
+            return existing;
+        }
+        std::vector<std::string> parameter_types;
+        std::vector<std::string> parameter_names;
+        if (const FunctionDecl* signature = globals.findFunction(name)) {
+            for (const auto& parameter : signature->parameters) {
+                parameter_types.push_back(parameter->type);
+                parameter_names.push_back(parameter->name);
+            }
+        } else if (auto library_function = globals.findLibraryFunction(name)) {
+            for (size_t i = 0; i < library_function->getParameterCount(); ++i) {
+                LibraryVariable parameter = library_function->getParameter(i);
+                parameter_types.emplace_back(parameter.type);
+                parameter_names.emplace_back(parameter.name);
+            }
+        } else {
+            return nullptr;
+        }
+
+        const C0Type* return_type = getReturnType(name);
+        if (return_type == nullptr || return_type->kind == C0Type::Kind::STRUCT) {
+            return nullptr;
+        }
+        std::vector<Type> parameter_ir_types;
+        for (const auto& spelling : parameter_types) {
+            const C0Type* type = types.resolve(spelling);
+            if (type == nullptr || !type->isSmall()) {
+                return nullptr;
+            }
+            parameter_ir_types.push_back(type->getIRType());
+        }
+        return module.getOrCreateFunction(std::string(name), return_type->getIRType(), parameter_ir_types,
+                                          parameter_names);
+    }
+
+    Function* IRLowering::lower(const FunctionDecl& decl) {
+        if (!decl.body) {
+            return nullptr;
+        }
+        Function* function = declare(decl.name);
+        if (function == nullptr) {
+            addDiagnostic(decl.offset, "函数 " + decl.name + ": 签名中有未知的类型");
+            return nullptr;
+        }
+        if (!function->isDeclaration()) {
+            addDiagnostic(decl.offset, "函数 " + decl.name + " 重复定义");
+            return nullptr;
+        }
+        function->setSourceOffset(decl.offset);
+        try {
+            FunctionLowering(*this, *function, decl).run();
+        } catch (const LoweringError&) {
+            // 留下没有基本块的声明，调用它的函数仍然可以降低
+            while (!function->getBlocks().empty()) {
+                BasicBlock* block = function->getBlocks().back();
+                while (Instruction* instruction = block->back()) {
+                    instruction->replaceAllUsesWith(function->getUndef(instruction->getType()));
+                    if (instruction->isTerminator()) {
+                        for (uint32_t i = 0; i < instruction->getSuccessorCount(); ++i) {
+                            instruction->getSuccessor(i)->removePredecessor(block);
+                        }
+                    }
+                    instruction->eraseFromParent();
+                }
+                function->eraseBlock(block);
+            }
+            return nullptr;
+        }
+#ifndef NDEBUG
+        for (auto& problem : verify(*function)) {
+            addDiagnostic(decl.offset, "IR 校验失败: " + problem);
+        }
+#endif
+        return function;
+    }
+
+    std::shared_ptr<Module> lowerTranslationUnit(const TranslationUnit& unit,
+                                                 const std::vector<std::shared_ptr<Declaration>>& imported,
+                                                 const CodeManager& source, std::vector<Diagnostic>& diagnostics) {
+        GlobalDeclarations globals;
+        for (const auto& decl : imported) {
+            globals.addDeclaration(decl);
+        }
+        for (const auto& decl : unit.declarations) {
+            globals.addDeclaration(decl);
+        }
+
+        auto module = std::make_shared<Module>();
+        IRLowering lowering(*module, globals, source);
+        for (const auto& decl : unit.declarations) {
+            if (auto function_decl = INFRA::dyn_cast<FunctionDecl>(decl); function_decl && function_decl->body) {
+                lowering.lower(*function_decl);
+            }
+        }
+        diagnostics.insert(diagnostics.end(), lowering.getDiagnostics().begin(), lowering.getDiagnostics().end());
+        return module;
+    }
+}
@@ -0,0 +1,177 @@
+//
+// Created by 陶子杨 on 25-12-10.
+//
+
+#include "IR/IRPrinter.h"
+#include "Infra/casting.h"
+
+namespace CC::IR {
+    namespace {
+        void printString(std::string_view text, std::ostream& out) {
+            out << '"';
+            for (char c : text) {
+                switch (c) {
+                case '\n': out << "\\n"; break;
+                case '\t': out << "\\t"; break;
+                case '"': out << "\\\""; break;
+                case '\\': out << "\\\\"; break;
+                default: out << c; break;
+                }
+            }
+            out << '"';
+        }
+
+        void printInstruction(const Instruction& instruction, std::ostream& out) {
+            out << "  ";
+            if (instruction.getType() != Type::VOID) {
+                out << '%' << instruction.getNumber() << " = ";
+            }
+            if (instruction.isTailCall()) {
+                out << "tail ";
+            }
+            if (instruction.isTrapFreeDivision()) {
+                out << "notrap ";
+            }
+            out << getOpcodeName(instruction.getOpcode());
+            if (instruction.getType() != Type::VOID) {
+                out << ' ' << getTypeName(instruction.getType());
+            }
+
+            switch (instruction.getOpcode()) {
+            case Opcode::PHI:
+                for (uint32_t i = 0; i < instruction.getOperandCount(); ++i) {
+                    out << (i == 0 ? " [" : ", [");
+                    printOperand(instruction.getOperand(i), out);
+                    out << ", bb" << instruction.getIncomingBlock(i)->getNumber() << ']';
+                }
+                return;
+            case Opcode::CALL:
+                out << " @" << instruction.getCallee()->getName() << '(';
+                for (uint32_t i = 0; i < instruction.getOperandCount(); ++i) {
+                    out << (i == 0 ? "" : ", ");
+                    printOperand(instruction.getOperand(i), out);
+                }
+                out << ')';
+                return;
+            case Opcode::ABORT:
+                out << ' ' << instruction.getImmediate();
+                return;
+            default:
+                break;
+            }
+
+            const char* separator = " ";
+            for (uint32_t i = 0; i < instruction.getOperandCount(); ++i) {
+                out << separator;
+                printOperand(instruction.getOperand(i), out);
+                separator = ", ";
+            }
+            switch (instruction.getOpcode()) {
+            case Opcode::ALLOC:
+            case Opcode::ALLOC_ARRAY:
+            case Opcode::FIELD_ADDR:
+            case Opcode::ELEMENT_ADDR:
+                out << separator << instruction.getImmediate();
+                break;
+            default:
+                break;
+            }
+            for (uint32_t i = 0; i < instruction.getSuccessorCount(); ++i) {
+                out << separator << "bb" << instruction.getSuccessor(i)->getNumber();
+                separator = ", ";
+            }
+        }
+
+        void printSignature(const Function& function, std::ostream& out) {
+            out << getTypeName(function.getReturnType()) << " @" << function.getName() << '(';
+            const char* separator = "";
+            for (const Argument* argument : function.getArguments()) {
+                out << separator << getTypeName(argument->getType()) << ' ';
+                printOperand(argument, out);
+                separator = ", ";
+            }
+            out << ')';
+        }
+    }
+
+    void printOperand(const Value* value, std::ostream& out) {
+        if (value == nullptr) {
+            out << "<null>";
+            return;
+        }
+        switch (value->getKind()) {
+        case ValueKind::CONSTANT: {
+            auto* constant = INFRA::dyn_cast<Constant>(value);
+            switch (constant->getType()) {
+            case Type::BOOL:
+                out << (constant->getValue() != 0 ? "true" : "false");
+                break;
+            case Type::PTR:
+                out << "null";
+                break;
+            default:
+                out << constant->getValue();
+                break;
+            }
+            break;
+        }
+        case ValueKind::UNDEF:
+            out << "undef";
+            break;
+        case ValueKind::STRING:
+            printString(INFRA::dyn_cast<StringConstant>(value)->getText(), out);
+            break;
+        case ValueKind::ARGUMENT: {
+            auto* argument = INFRA::dyn_cast<Argument>(value);
+            if (argument->getName().empty()) {
+                out << "%arg" << argument->getIndex();
+            } else {
+                out << '%' << argument->getName();
+            }
+            break;
+        }
+        case ValueKind::INSTRUCTION:
+            out << '%' << INFRA::dyn_cast<Instruction>(value)->getNumber();
+            break;
+        }
+    }
+
+    void print(const Function& function, std::ostream& out) {
+        if (function.isDeclaration()) {
+            out << "declare ";
+            printSignature(function, out);
+            out << '\n';
+            return;
+        }
+        out << "define ";
+        printSignature(function, out);
+        out << (function.isPure() ? " pure {\n" : " {\n");
+        for (const BasicBlock* block : function.getBlocks()) {
+            out << "bb" << block->getNumber() << ':';
+            if (!block->getPredecessors().empty()) {
+                out << "    ; preds:";
+                for (const BasicBlock* predecessor : block->getPredecessors()) {
+                    out << " bb" << predecessor->getNumber();
+                }
+            }
+            out << '\n';
+            for (const Instruction* instruction = block->front(); instruction != nullptr;
+                 instruction = instruction->getNext()) {
+                printInstruction(*instruction, out);
+                out << '\n';
+            }
+        }
+        out << "}\n";
+    }
+
+    void print(const Module& module, std::ostream& out) {
+        bool first = true;
+        for (const auto& function : module.getFunctions()) {
+            if (!first && !function->isDeclaration()) {
+                out << '\n';
+            }
+            print(*function, out);
+            first = false;
+        }
+    }
+}
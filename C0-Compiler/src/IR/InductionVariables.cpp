@@ -0,0 +1,269 @@
+//
+// Created by 陶子杨 on 25-12-16.
+//
+
+#include "IR/InductionVariables.h"
+#include "IR/ConstantFolding.h"
+#include "Infra/casting.h"
+
+#include <utility>
+
+namespace CC::IR {
+    namespace {
+        std::optional<int32_t> getConstant(const Value* value) {
+            if (auto constant = INFRA::dyn_cast<Constant>(value)) {
+                return constant->getValue();
+            }
+            return std::nullopt;
+        }
+
+        Opcode negate(Opcode predicate) {
+            switch (predicate) {
+            case Opcode::LT: return Opcode::GE;
+            case Opcode::LE: return Opcode::GT;
+            case Opcode::GT: return Opcode::LE;
+            case Opcode::GE: return Opcode::LT;
+            case Opcode::EQ: return Opcode::NE;
+            default: return Opcode::EQ;
+            }
+        }
+
+        Opcode swapOperands(Opcode predicate) {
+            switch (predicate) {
+            case Opcode::LT: return Opcode::GT;
+            case Opcode::LE: return Opcode::GE;
+            case Opcode::GT: return Opcode::LT;
+            case Opcode::GE: return Opcode::LE;
+            default: return predicate;
+            }
+        }
+
+        /**
+         * @brief first, first + step, ... 依次满足 "value predicate bound" 的个数，
+         * 第一个不满足的值必须在不回绕的情况下得到
+         */
+        std::optional<uint32_t> countIterations(Opcode predicate, int64_t first, int64_t step, int64_t bound) {
+            if (!*foldBinary(predicate, static_cast<int32_t>(first), static_cast<int32_t>(bound))) {
+                return 0;
+            }
+            int64_t count;
+            switch (predicate) {
+            case Opcode::LT:
+            case Opcode::LE:
+                if (step <= 0) {
+                    return std::nullopt;
+                }
+                count = (bound - first + (predicate == Opcode::LE ? 1 : 0) + step - 1) / step;
+                break;
+            case Opcode::GT:
+            case Opcode::GE:
+                if (step >= 0) {
+                    return std::nullopt;
+                }
+                count = (first - bound + (predicate == Opcode::GE ? 1 : 0) - step - 1) / -step;
+                break;
+            case Opcode::NE:
+                if (step == 0 || (bound - first) % step != 0 || (bound - first) / step < 0) {
+                    return std::nullopt;
+                }
+                count = (bound - first) / step;
+                break;
+            case Opcode::EQ:
+                if (step == 0) {
+                    return std::nullopt;
+                }
+                count = 1;
+                break;
+            default:
+                return std::nullopt;
+            }
+            int64_t exit_value = first + count * step;
+            if (exit_value < INT32_MIN || exit_value > INT32_MAX || count > UINT32_MAX) {
+                return std::nullopt;
+            }
+            return static_cast<uint32_t>(count);
+        }
+    }
+
+    std::optional<int32_t> InductionVariable::getConstantStep() const {
+        auto value = getConstant(step);
+        if (!value) {
+            return std::nullopt;
+        }
+        return negated ? static_cast<int32_t>(0u - static_cast<uint32_t>(*value)) : *value;
+    }
+
+    bool isLoopInvariant(const Loop* loop, const Value* value) {
+        auto instruction = INFRA::dyn_cast<Instruction>(value);
+        return instruction == nullptr || !loop->contains(instruction->getParent());
+    }
+
+    InductionVariables::InductionVariables(const LoopInfo& loops) {
+        for (Loop* loop : loops.getLoopsInnermostFirst()) {
+            auto& found = variables[loop];
+            BasicBlock* preheader = loop->getPreheader();
+            auto latches = loop->getLatches();
+            if (preheader == nullptr || latches.size() != 1) {
+                continue;
+            }
+            for (Instruction* phi = loop->getHeader()->front(); phi && phi->isPhi(); phi = phi->getNext()) {
+                if (phi->getType() != Type::INT || phi->getOperandCount() != 2) {
+                    continue;
+                }
+                uint32_t from_latch = phi->getIncomingBlock(0) == latches.front() ? 0 : 1;
+                auto increment = INFRA::dyn_cast<Instruction>(phi->getOperand(from_latch));
+                if (increment == nullptr || phi->getIncomingBlock(1 - from_latch) != preheader) {
+                    continue;
+                }
+                Value* step = nullptr;
+                bool negated = false;
+                if (increment->getOpcode() == Opcode::ADD) {
+                    if (increment->getOperand(0) == phi) {
+                        step = increment->getOperand(1);
+                    } else if (increment->getOperand(1) == phi) {
+                        step = increment->getOperand(0);
+                    }
+                } else if (increment->getOpcode() == Opcode::SUB && increment->getOperand(0) == phi) {
+                    step = increment->getOperand(1);
+                    negated = true;
+                }
+                if (step != nullptr && isLoopInvariant(loop, step)) {
+                    found.push_back({phi, phi->getOperand(1 - from_latch), step, increment, negated, loop});
+                }
+            }
+        }
+        // 各循环的向量不再变化之后再建索引
+        for (const auto& [loop, found] : variables) {
+            for (const InductionVariable& variable : found) {
+                by_phi.emplace(variable.phi, &variable);
+            }
+        }
+        for (Loop* loop : loops.getLoopsInnermostFirst()) {
+            backedge_taken.emplace(loop, computeBackedgeTakenCount(loop));
+        }
+    }
+
+    const std::vector<InductionVariable>& InductionVariables::getInductionVariables(const Loop* loop) const {
+        static const std::vector<InductionVariable> kEmpty;
+        auto it = variables.find(loop);
+        return it == variables.end() ? kEmpty : it->second;
+    }
+
+    const InductionVariable* InductionVariables::getInductionVariable(const Instruction* phi) const {
+        auto it = by_phi.find(phi);
+        return it == by_phi.end() ? nullptr : it->second;
+    }
+
+    std::optional<uint32_t> InductionVariables::getBackedgeTakenCount(const Loop* loop) const {
+        auto it = backedge_taken.find(loop);
+        return it == backedge_taken.end() ? std::nullopt : it->second;
+    }
+
+    std::optional<InductionRange> InductionVariables::getRangeInLoop(const Instruction* phi) const {
+        const InductionVariable* variable = getInductionVariable(phi);
+        if (variable == nullptr) {
+            return std::nullopt;
+        }
+        auto step = variable->getConstantStep();
+        const Instruction* branch = phi->getParent()->getTerminator();
+        if (!step || *step == 0 || branch->getOpcode() != Opcode::COND_BR) {
+            return std::nullopt;
+        }
+        auto condition = INFRA::dyn_cast<Instruction>(branch->getOperand(0));
+        bool stays = variable->loop->contains(branch->getSuccessor(0));
+        if (condition == nullptr || !condition->isComparison() ||
+            stays == variable->loop->contains(branch->getSuccessor(1))) {
+            return std::nullopt;
+        }
+
+        // 整理成 "phi predicate bound" 为真时留在循环里
+        Opcode predicate = stays ? condition->getOpcode() : negate(condition->getOpcode());
+        const Value* bound = condition->getOperand(1);
+        if (condition->getOperand(1) == phi) {
+            predicate = swapOperands(predicate);
+            bound = condition->getOperand(0);
+        } else if (condition->getOperand(0) != phi) {
+            return std::nullopt;
+        }
+        auto limit = getConstant(bound);
+        auto start = getConstant(variable->start);
+
+        // 通过检查之后 phi 能取到的最远的值，再走一步也不能回绕
+        if (*step > 0) {
+            int64_t farthest;
+            if (predicate == Opcode::LT) {
+                farthest = limit ? int64_t{*limit} - 1 : INT32_MAX - 1;
+            } else if (predicate == Opcode::LE && limit) {
+                farthest = *limit;
+            } else {
+                return std::nullopt;
+            }
+            if (farthest + *step > INT32_MAX) {
+                return std::nullopt;
+            }
+            return InductionRange{start ? *start : INT32_MIN, farthest};
+        }
+        int64_t farthest;
+        if (predicate == Opcode::GT) {
+            farthest = limit ? int64_t{*limit} + 1 : INT32_MIN + 1;
+        } else if (predicate == Opcode::GE && limit) {
+            farthest = *limit;
+        } else {
+            return std::nullopt;
+        }
+        if (farthest + *step < INT32_MIN) {
+            return std::nullopt;
+        }
+        return InductionRange{farthest, start ? *start : INT32_MAX};
+    }
+
+    std::optional<uint32_t> InductionVariables::computeBackedgeTakenCount(const Loop* loop) const {
+        auto exiting = loop->getExitingBlocks();
+        auto latches = loop->getLatches();
+        if (exiting.size() != 1 || latches.size() != 1 ||
+            (exiting.front() != loop->getHeader() && exiting.front() != latches.front())) {
+            return std::nullopt;
+        }
+        Instruction* branch = exiting.front()->getTerminator();
+        if (branch->getOpcode() != Opcode::COND_BR) {
+            return std::nullopt;
+        }
+        auto condition = INFRA::dyn_cast<Instruction>(branch->getOperand(0));
+        if (condition == nullptr || !condition->isComparison()) {
+            return std::nullopt;
+        }
+
+        // 整理成 "归纳变量 predicate 常量" 为真时留在循环里
+        Opcode predicate = condition->getOpcode();
+        if (!loop->contains(branch->getSuccessor(0))) {
+            predicate = negate(predicate);
+        }
+        Value* tested = condition->getOperand(0);
+        auto bound = getConstant(condition->getOperand(1));
+        if (!bound) {
+            tested = condition->getOperand(1);
+            bound = getConstant(condition->getOperand(0));
+            predicate = swapOperands(predicate);
+        }
+        if (!bound) {
+            return std::nullopt;
+        }
+
+        for (const InductionVariable& variable : getInductionVariables(loop)) {
+            if (tested != variable.phi && tested != variable.increment) {
+                continue;
+            }
+            auto start = getConstant(variable.start);
+            auto step = variable.getConstantStep();
+            if (!start || !step) {
+                return std::nullopt;
+            }
+            // 比较的是下一个值时序列从 start + step 开始
+            int64_t first = tested == variable.phi
+                                ? *start
+                                : static_cast<int32_t>(static_cast<uint32_t>(*start) + static_cast<uint32_t>(*step));
+            return countIterations(predicate, first, *step, *bound);
+        }
+        return std::nullopt;
+    }
+}
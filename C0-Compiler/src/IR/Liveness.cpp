@@ -0,0 +1,146 @@
+//
+// Created by 陶子杨 on 25-12-12.
+//
+
+#include "IR/Liveness.h"
+#include "IR/Dataflow.h"
+#include "Infra/SparseSet.h"
+#include "Infra/casting.h"
+
+#include <algorithm>
+
+namespace CC::IR {
+    namespace {
+        // 稠密位集合总共不超过这么多位（8MB）时用稠密表示
+        constexpr uint64_t kDenseBitLimit = uint64_t(1) << 26;
+
+        template <typename Set>
+        Set makeSet(size_t universe, INFRA::SparseSet& elements) {
+            std::vector<uint32_t> sorted(elements.begin(), elements.end());
+            std::sort(sorted.begin(), sorted.end());
+            Set set(universe);
+            for (uint32_t element : sorted) {
+                set.set(element);
+            }
+            elements.clear();
+            return set;
+        }
+    }
+
+    Liveness::Liveness(const Function& function) : instruction_count(function.getInstructionCount()) {
+        values.assign(instruction_count + function.getArguments().size(), nullptr);
+        for (Argument* argument : function.getArguments()) {
+            values[instruction_count + argument->getIndex()] = argument;
+        }
+        for (BasicBlock* block : function.getBlocks()) {
+            for (Instruction* instruction = block->front(); instruction; instruction = instruction->getNext()) {
+                if (isTracked(instruction)) {
+                    values[instruction->getNumber()] = instruction;
+                }
+            }
+        }
+
+        CFG cfg(function);
+        if (uint64_t(cfg.size()) * values.size() <= kDenseBitLimit) {
+            sets = compute<INFRA::BitVector>(cfg);
+        } else {
+            sets = compute<INFRA::SparseBitVector>(cfg);
+        }
+    }
+
+    bool Liveness::isTracked(const Value* value) {
+        if (INFRA::isa<Argument>(value)) {
+            return true;
+        }
+        return INFRA::isa<Instruction>(value) && value->getType() != Type::VOID;
+    }
+
+    uint32_t Liveness::getValueIndex(const Value* value) const {
+        if (auto argument = INFRA::dyn_cast<Argument>(value)) {
+            return instruction_count + argument->getIndex();
+        }
+        return INFRA::cast<Instruction>(*value).getNumber();
+    }
+
+    bool Liveness::isLiveIn(const Value* value, const BasicBlock* block) const {
+        uint32_t index = getValueIndex(value);
+        return std::visit([&](const auto& sets) { return sets.live_in[block->getNumber()].test(index); }, sets);
+    }
+
+    bool Liveness::isLiveOut(const Value* value, const BasicBlock* block) const {
+        uint32_t index = getValueIndex(value);
+        return std::visit([&](const auto& sets) { return sets.live_out[block->getNumber()].test(index); }, sets);
+    }
+
+    template <typename Set>
+    Liveness::LiveSets<Set> Liveness::compute(const CFG& cfg) const {
+        uint32_t count = cfg.size();
+        size_t universe = values.size();
+
+        // 活跃入口 = 向上暴露的使用 | (出口 - 定义)，出口 = 各后继入口的并 | 本块末尾的 PHI 使用。
+        // 把 PHI 使用中不是本块定义的那部分并进 gen，就成了标准的 gen/kill 问题
+        GenKillProblem<Set, DataflowDirection::BACKWARD, MeetOperator::UNION> problem;
+        problem.boundary = Set(universe);
+        problem.initial = Set(universe);
+        problem.gen.reserve(count);
+        problem.kill.reserve(count);
+        std::vector<Set> phi_uses;
+        phi_uses.reserve(count);
+
+        // 大函数中逐块清空稠密的临时集合会变成平方复杂度，这里用常数时间清空的稀疏集合
+        auto universe32 = static_cast<uint32_t>(universe);
+        INFRA::SparseSet uses(universe32);
+        INFRA::SparseSet defs(universe32);
+        for (uint32_t b = 0; b < count; ++b) {
+            for (Instruction* instruction = cfg.getBlock(b)->back(); instruction;
+                 instruction = instruction->getPrev()) {
+                if (isTracked(instruction)) {
+                    defs.insert(instruction->getNumber());
+                    uses.erase(instruction->getNumber());
+                }
+                if (instruction->isPhi()) {
+                    continue;
+                }
+                for (uint32_t i = 0; i < instruction->getOperandCount(); ++i) {
+                    Value* operand = instruction->getOperand(i);
+                    if (isTracked(operand)) {
+                        uses.insert(getValueIndex(operand));
+                    }
+                }
+            }
+            problem.gen.push_back(makeSet<Set>(universe, uses));
+            problem.kill.push_back(makeSet<Set>(universe, defs));
+            phi_uses.emplace_back(universe);
+        }
+
+        // PHI 的操作数记到来源前驱的末尾
+        for (uint32_t b = 0; b < count; ++b) {
+            for (Instruction* phi = cfg.getBlock(b)->front(); phi && phi->isPhi(); phi = phi->getNext()) {
+                for (uint32_t i = 0; i < phi->getOperandCount(); ++i) {
+                    Value* operand = phi->getOperand(i);
+                    if (isTracked(operand)) {
+                        phi_uses[phi->getIncomingBlock(i)->getNumber()].set(getValueIndex(operand));
+                    }
+                }
+            }
+        }
+        for (uint32_t b = 0; b < count; ++b) {
+            Set exposed = phi_uses[b];
+            exposed.subtract(problem.kill[b]);
+            problem.gen[b].unionWith(exposed);
+        }
+
+        DataflowSolver solver(cfg, problem);
+        solver.solve();
+
+        LiveSets<Set> result;
+        result.live_in.reserve(count);
+        result.live_out.reserve(count);
+        for (uint32_t b = 0; b < count; ++b) {
+            result.live_in.push_back(solver.getIn(b));
+            result.live_out.push_back(solver.getOut(b));
+            result.live_out.back().unionWith(phi_uses[b]);
+        }
+        return result;
+    }
+}
@@ -0,0 +1,180 @@
+//
+// Created by 陶子杨 on 25-12-15.
+//
+
+#include "IR/LoopInfo.h"
+
+#include <algorithm>
+
+namespace CC::IR {
+    bool Loop::contains(const BasicBlock* block) const {
+        return contains(info.getLoopFor(block));
+    }
+
+    BasicBlock* Loop::getPreheader() const {
+        BasicBlock* outside = nullptr;
+        for (BasicBlock* predecessor : header->getPredecessors()) {
+            if (contains(predecessor)) {
+                continue;
+            }
+            if (outside != nullptr && outside != predecessor) {
+                return nullptr;
+            }
+            outside = predecessor;
+        }
+        if (outside == nullptr || outside->getSuccessorCount() != 1) {
+            return nullptr;
+        }
+        return outside;
+    }
+
+    std::vector<BasicBlock*> Loop::getLatches() const {
+        std::vector<BasicBlock*> latches;
+        for (BasicBlock* predecessor : header->getPredecessors()) {
+            if (contains(predecessor) && std::find(latches.begin(), latches.end(), predecessor) == latches.end()) {
+                latches.push_back(predecessor);
+            }
+        }
+        return latches;
+    }
+
+    std::vector<BasicBlock*> Loop::getExitingBlocks() const {
+        std::vector<BasicBlock*> exiting;
+        for (BasicBlock* block : blocks) {
+            for (uint32_t i = 0; i < block->getSuccessorCount(); ++i) {
+                if (!contains(block->getSuccessor(i))) {
+                    exiting.push_back(block);
+                    break;
+                }
+            }
+        }
+        return exiting;
+    }
+
+    std::vector<BasicBlock*> Loop::getExitBlocks() const {
+        std::vector<BasicBlock*> exits;
+        for (BasicBlock* block : blocks) {
+            for (uint32_t i = 0; i < block->getSuccessorCount(); ++i) {
+                BasicBlock* successor = block->getSuccessor(i);
+                if (!contains(successor) && std::find(exits.begin(), exits.end(), successor) == exits.end()) {
+                    exits.push_back(successor);
+                }
+            }
+        }
+        return exits;
+    }
+
+    bool Loop::hasDedicatedExits() const {
+        for (BasicBlock* exit : getExitBlocks()) {
+            for (BasicBlock* predecessor : exit->getPredecessors()) {
+                if (!contains(predecessor)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    LoopInfo::LoopInfo(const DominatorTree& dominators)
+        : loop_of(dominators.getFunction().getBlocks().size(), nullptr) {
+        std::vector<BasicBlock*> preorder = dominators.getPreorder();
+        std::vector<BasicBlock*> worklist;
+        for (auto it = preorder.rbegin(); it != preorder.rend(); ++it) {
+            BasicBlock* header = *it;
+            for (BasicBlock* predecessor : header->getPredecessors()) {
+                if (dominators.dominates(header, predecessor)) {
+                    worklist.push_back(predecessor);
+                }
+            }
+            if (worklist.empty()) {
+                continue;
+            }
+
+            loops.push_back(std::unique_ptr<Loop>(new Loop(*this, header)));
+            Loop* loop = loops.back().get();
+            loop_of[header->getNumber()] = loop;
+            while (!worklist.empty()) {
+                BasicBlock* block = worklist.back();
+                worklist.pop_back();
+                Loop* inner = loop_of[block->getNumber()];
+                if (inner == nullptr) {
+                    loop_of[block->getNumber()] = loop;
+                    for (BasicBlock* predecessor : block->getPredecessors()) {
+                        if (dominators.isReachable(predecessor)) {
+                            worklist.push_back(predecessor);
+                        }
+                    }
+                    continue;
+                }
+                while (inner->parent != nullptr) {
+                    inner = inner->parent;
+                }
+                if (inner == loop) {
+                    continue;
+                }
+                // 整个内层循环并进来，从它的头结点继续往回走
+                inner->parent = loop;
+                loop->sub_loops.push_back(inner);
+                for (BasicBlock* predecessor : inner->header->getPredecessors()) {
+                    if (!dominators.dominates(inner->header, predecessor)) {
+                        worklist.push_back(predecessor);
+                    }
+                }
+            }
+        }
+
+        // 先序保证外层循环和块都按程序顺序出现
+        for (BasicBlock* block : preorder) {
+            for (Loop* loop = loop_of[block->getNumber()]; loop != nullptr; loop = loop->parent) {
+                loop->blocks.push_back(block);
+            }
+            Loop* loop = loop_of[block->getNumber()];
+            if (loop != nullptr && loop->header == block) {
+                if (loop->parent == nullptr) {
+                    top_level.push_back(loop);
+                } else {
+                    loop->depth = loop->parent->depth + 1;
+                }
+            }
+        }
+        // 内层循环是逆着 CFG 找到的，按头结点在先序中的位置排回程序顺序
+        std::vector<uint32_t> position(loop_of.size(), 0);
+        for (uint32_t i = 0; i < preorder.size(); ++i) {
+            position[preorder[i]->getNumber()] = i;
+        }
+        for (const auto& loop : loops) {
+            std::sort(loop->sub_loops.begin(), loop->sub_loops.end(), [&](const Loop* a, const Loop* b) {
+                return position[a->header->getNumber()] < position[b->header->getNumber()];
+            });
+        }
+    }
+
+    std::vector<Loop*> LoopInfo::getLoopsInnermostFirst() const {
+        std::vector<Loop*> result;
+        std::vector<std::pair<Loop*, size_t>> stack;
+        for (Loop* top : top_level) {
+            stack.emplace_back(top, 0);
+            while (!stack.empty()) {
+                auto& [loop, next] = stack.back();
+                if (next < loop->sub_loops.size()) {
+                    Loop* child = loop->sub_loops[next++];
+                    stack.emplace_back(child, 0);
+                    continue;
+                }
+                result.push_back(loop);
+                stack.pop_back();
+            }
+        }
+        return result;
+    }
+
+    void LoopInfo::addBlock(BasicBlock* block, Loop* loop) {
+        if (block->getNumber() >= loop_of.size()) {
+            loop_of.resize(block->getNumber() + 1, nullptr);
+        }
+        loop_of[block->getNumber()] = loop;
+        for (; loop != nullptr; loop = loop->parent) {
+            loop->blocks.push_back(block);
+        }
+    }
+}
@@ -0,0 +1,233 @@
+//
+// Created by 陶子杨 on 25-12-13.
+//
+
+#include "IR/PassManager.h"
+#include "IR/Verifier.h"
+
+#include <iomanip>
+
+namespace CC::IR {
+    namespace {
+        double elapsedSince(std::chrono::steady_clock::time_point start) {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+
+    const char* getAnalysisName(AnalysisKind kind) {
+        switch (kind) {
+        case AnalysisKind::CFG: return "cfg";
+        case AnalysisKind::DOMINATOR_TREE: return "domtree";
+        case AnalysisKind::POST_DOMINATOR_TREE: return "postdomtree";
+        case AnalysisKind::DOMINANCE_FRONTIER: return "domfrontier";
+        case AnalysisKind::LIVENESS: return "liveness";
+        case AnalysisKind::REACHING_DEFINITIONS: return "reaching-defs";
+        case AnalysisKind::AVAILABLE_EXPRESSIONS: return "avail-exprs";
+        case AnalysisKind::CONTROL_DEPENDENCE: return "control-deps";
+        case AnalysisKind::LOOPS: return "loops";
+        case AnalysisKind::INDUCTION_VARIABLES: return "indvars";
+        case AnalysisKind::ALIAS_ANALYSIS: return "alias";
+        case AnalysisKind::DEPENDENCES: return "deps";
+        }
+        return "?";
+    }
+
+    // ---- AnalysisManager ----
+
+    void AnalysisManager::compute(Function& function, AnalysisKind kind) {
+        switch (kind) {
+        case AnalysisKind::CFG: get<CFG>(function); break;
+        case AnalysisKind::DOMINATOR_TREE: get<DominatorTree>(function); break;
+        case AnalysisKind::POST_DOMINATOR_TREE: get<PostDominatorTree>(function); break;
+        case AnalysisKind::DOMINANCE_FRONTIER: get<DominanceFrontier>(function); break;
+        case AnalysisKind::LIVENESS: get<Liveness>(function); break;
+        case AnalysisKind::REACHING_DEFINITIONS: get<ReachingDefinitions>(function); break;
+        case AnalysisKind::AVAILABLE_EXPRESSIONS: get<AvailableExpressions>(function); break;
+        case AnalysisKind::CONTROL_DEPENDENCE: get<ControlDependence>(function); break;
+        case AnalysisKind::LOOPS: get<LoopInfo>(function); break;
+        case AnalysisKind::INDUCTION_VARIABLES: get<InductionVariables>(function); break;
+        case AnalysisKind::ALIAS_ANALYSIS: get<AliasAnalysis>(function); break;
+        case AnalysisKind::DEPENDENCES: get<DependenceAnalysis>(function); break;
+        }
+    }
+
+    void AnalysisManager::invalidate(const Function& function, AnalysisSet preserved) {
+        auto it = cache.find(&function);
+        if (it == cache.end()) {
+            return;
+        }
+        for (size_t i = 0; i < kAnalysisKindCount; ++i) {
+            if (!preserved.contains(static_cast<AnalysisKind>(i))) {
+                it->second[i].reset();
+            }
+        }
+        // 归纳变量指向循环森林里的 Loop，不能比它活得长；依赖分析又引用着归纳变量
+        if (!preserved.contains(AnalysisKind::LOOPS)) {
+            it->second[static_cast<size_t>(AnalysisKind::INDUCTION_VARIABLES)].reset();
+        }
+        if (!it->second[static_cast<size_t>(AnalysisKind::INDUCTION_VARIABLES)]) {
+            it->second[static_cast<size_t>(AnalysisKind::DEPENDENCES)].reset();
+        }
+    }
+
+    void AnalysisManager::clear() {
+        cache.clear();
+    }
+
+    // ---- PassManager ----
+
+    void PassManager::addPass(std::unique_ptr<Pass> pass) {
+        stats.push_back({pass->getName()});
+        passes.push_back(std::move(pass));
+    }
+
+    bool PassManager::consumeExecution() {
+        if (execution_limit >= 0 && executions >= execution_limit) {
+            truncated = true;
+            return false;
+        }
+        ++executions;
+        return true;
+    }
+
+    size_t PassManager::run(Module& module) {
+        auto start = std::chrono::steady_clock::now();
+        size_t total = 0;
+        size_t index = 0;
+        while (index < passes.size()) {
+            if (!passes[index]->isModulePass()) {
+                size_t end = index;
+                while (end < passes.size() && !passes[end]->isModulePass()) {
+                    ++end;
+                }
+                total += runFunctionPasses(module, index, end);
+                index = end;
+                continue;
+            }
+
+            if (!consumeExecution()) {
+                break;
+            }
+            auto& pass = static_cast<ModulePass&>(*passes[index]);
+            auto pass_start = std::chrono::steady_clock::now();
+            size_t changes = pass.run(module, analyses);
+            PassStats& entry = stats[index];
+            entry.milliseconds += elapsedSince(pass_start);
+            ++entry.runs;
+            if (changes != 0) {
+                ++entry.changed_runs;
+                entry.changes += changes;
+                total += changes;
+                // 模块级的 pass 可能改动或删除任意函数，缓存整体作废
+                analyses.clear();
+                for (const auto& function : module.getFunctions()) {
+                    if (!function->isDeclaration()) {
+                        afterChange(*function, pass, index);
+                    }
+                }
+            }
+            ++index;
+        }
+        total_milliseconds += elapsedSince(start);
+        return total;
+    }
+
+    size_t PassManager::runFunctionPasses(Module& module, size_t begin, size_t end) {
+        size_t total = 0;
+        for (const auto& function : module.getFunctions()) {
+            if (function->isDeclaration()) {
+                continue;
+            }
+            for (size_t index = begin; index < end; ++index) {
+                if (!consumeExecution()) {
+                    return total;
+                }
+                auto& pass = static_cast<FunctionPass&>(*passes[index]);
+                AnalysisSet required = pass.getRequired();
+                for (size_t kind = 0; kind < kAnalysisKindCount; ++kind) {
+                    if (required.contains(static_cast<AnalysisKind>(kind))) {
+                        analyses.compute(*function, static_cast<AnalysisKind>(kind));
+                    }
+                }
+
+                auto pass_start = std::chrono::steady_clock::now();
+                size_t changes = pass.run(*function, analyses);
+                PassStats& entry = stats[index];
+                entry.milliseconds += elapsedSince(pass_start);
+                ++entry.runs;
+                if (changes != 0) {
+                    ++entry.changed_runs;
+                    entry.changes += changes;
+                    total += changes;
+                    analyses.invalidate(*function, pass.getPreserved());
+                    afterChange(*function, pass, index);
+                }
+            }
+            // 函数之间不共享分析，处理完一个函数就释放它的缓存
+            analyses.invalidate(*function);
+        }
+        return total;
+    }
+
+    void PassManager::afterChange(Function& function, const Pass& pass, size_t index) {
+        // 新建的指令编号在末尾，删掉的留下空洞，依赖稠密编号的分析需要重新编号
+        function.renumber();
+        if (!verify_each) {
+            return;
+        }
+        std::vector<std::string> problems = verify(function);
+        // pass 保留下来的支配树可能是增量更新的，和从头计算的结果比较
+        const DominatorTree* trees[] = {analyses.getCached<DominatorTree>(function),
+                                        analyses.getCached<PostDominatorTree>(function)};
+        for (const DominatorTree* tree : trees) {
+            if (tree != nullptr && !tree->verify()) {
+                problems.emplace_back(tree->isPostDominator() ? "后支配树与从头计算的结果不一致"
+                                                              : "支配树与从头计算的结果不一致");
+            }
+        }
+        for (const auto& problem : problems) {
+            diagnostics.push_back({function.getSourceOffset(),
+                                   "函数 " + function.getName() + ": IR 校验失败（第 " + std::to_string(index + 1) +
+                                       " 个 pass " + pass.getName() + " 之后）: " + problem});
+        }
+    }
+
+    PipelineStats PassManager::getStatistics() const {
+        PipelineStats result;
+        result.passes = stats;
+        for (size_t kind = 0; kind < kAnalysisKindCount; ++kind) {
+            result.analyses[kind] = analyses.getStats(static_cast<AnalysisKind>(kind));
+        }
+        result.total_milliseconds = total_milliseconds;
+        result.truncated = truncated;
+        return result;
+    }
+
+    void printStatistics(const PipelineStats& stats, std::ostream& out) {
+        auto flags = out.flags();
+        auto precision = out.precision();
+        out << std::fixed << std::setprecision(3);
+        out << "pass                      次数      修改       用时(ms)\n";
+        for (const PassStats& pass : stats.passes) {
+            out << std::left << std::setw(22) << pass.name << std::right << std::setw(10) << pass.runs
+                << std::setw(10) << pass.changes << std::setw(15) << pass.milliseconds << "\n";
+        }
+        out << "分析                      计算      命中       用时(ms)\n";
+        for (size_t kind = 0; kind < kAnalysisKindCount; ++kind) {
+            const AnalysisStats& analysis = stats.analyses[kind];
+            if (analysis.computed == 0 && analysis.hits == 0) {
+                continue;
+            }
+            out << std::left << std::setw(22) << getAnalysisName(static_cast<AnalysisKind>(kind)) << std::right
+                << std::setw(10) << analysis.computed << std::setw(10) << analysis.hits << std::setw(15)
+                << analysis.milliseconds << "\n";
+        }
+        out << "总用时 " << stats.total_milliseconds << " ms";
+        if (stats.truncated) {
+            out << "（达到执行次数上限，之后的 pass 没有执行）";
+        }
+        out << "\n";
+        out.flags(flags);
+        out.precision(precision);
+    }
+}
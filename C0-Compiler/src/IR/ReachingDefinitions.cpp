@@ -0,0 +1,77 @@
+//
+// Created by 陶子杨 on 25-12-12.
+//
+
+#include "IR/ReachingDefinitions.h"
+#include "IR/Dataflow.h"
+
+namespace CC::IR {
+    ReachingDefinitions::ReachingDefinitions(const Function& function) {
+        // 按地址分组，同组的 STORE 互相注销
+        std::unordered_map<const Value*, std::vector<uint32_t>> by_address;
+        for (BasicBlock* block : function.getBlocks()) {
+            for (Instruction* instruction = block->front(); instruction; instruction = instruction->getNext()) {
+                if (instruction->getOpcode() == Opcode::STORE) {
+                    auto index = static_cast<uint32_t>(stores.size());
+                    store_index.emplace(instruction, index);
+                    stores.push_back(instruction);
+                    by_address[instruction->getOperand(1)].push_back(index);
+                }
+            }
+        }
+
+        CFG cfg(function);
+        uint32_t count = cfg.size();
+        GenKillProblem<INFRA::SparseBitVector, DataflowDirection::FORWARD, MeetOperator::UNION> problem;
+        problem.gen.resize(count);
+        problem.kill.resize(count);
+        for (uint32_t b = 0; b < count; ++b) {
+            // 同一地址只有块内最后一条 STORE 能到达出口，同组的其他 STORE 都被注销
+            std::unordered_map<const Value*, uint32_t> last;
+            std::vector<const Value*> addresses;
+            for (Instruction* instruction = cfg.getBlock(b)->front(); instruction;
+                 instruction = instruction->getNext()) {
+                if (instruction->getOpcode() == Opcode::STORE) {
+                    auto [it, inserted] = last.try_emplace(instruction->getOperand(1), store_index.at(instruction));
+                    if (inserted) {
+                        addresses.push_back(instruction->getOperand(1));
+                    } else {
+                        it->second = store_index.at(instruction);
+                    }
+                }
+            }
+            for (const Value* address : addresses) {
+                problem.gen[b].set(last[address]);
+                for (uint32_t index : by_address[address]) {
+                    problem.kill[b].set(index);
+                }
+            }
+        }
+
+        DataflowSolver solver(cfg, problem);
+        solver.solve();
+        reaching_in.reserve(count);
+        reaching_out.reserve(count);
+        for (uint32_t b = 0; b < count; ++b) {
+            reaching_in.push_back(solver.getIn(b));
+            reaching_out.push_back(solver.getOut(b));
+        }
+    }
+
+    std::vector<Instruction*> ReachingDefinitions::getReachingStores(const Instruction* point,
+                                                                     const Value* address) const {
+        // 块内在 point 之前有同地址的 STORE 时只有最后一条能到达
+        for (Instruction* instruction = point->getPrev(); instruction; instruction = instruction->getPrev()) {
+            if (instruction->getOpcode() == Opcode::STORE && instruction->getOperand(1) == address) {
+                return {instruction};
+            }
+        }
+        std::vector<Instruction*> result;
+        getReachingIn(point->getParent()).forEach([&](size_t index) {
+            if (stores[index]->getOperand(1) == address) {
+                result.push_back(stores[index]);
+            }
+        });
+        return result;
+    }
+}
@@ -0,0 +1,228 @@
+//
+// Created by 陶子杨 on 25-12-10.
+//
+
+#include "IR/TypeTable.h"
+
+#include <algorithm>
+
+namespace CC::IR {
+    namespace {
+        // 类型别名互相引用的最大层数，超过时认为别名形成了环
+        constexpr int kMaxAliasDepth = 64;
+
+        uint32_t alignTo(uint32_t offset, uint32_t align) {
+            return (offset + align - 1) / align * align;
+        }
+    }
+
+    Type C0Type::getIRType() const {
+        switch (kind) {
+        case Kind::VOID:
+        case Kind::STRUCT:
+            return Type::VOID;
+        case Kind::INT:
+            return Type::INT;
+        case Kind::BOOL:
+            return Type::BOOL;
+        case Kind::CHAR:
+            return Type::CHAR;
+        default:
+            return Type::PTR;
+        }
+    }
+
+    const FieldLayout* StructLayout::findField(std::string_view field) const {
+        for (const auto& candidate : fields) {
+            if (candidate.name == field) {
+                return &candidate;
+            }
+        }
+        return nullptr;
+    }
+
+    TypeTable::TypeTable(const GlobalDeclarations& globals) : globals(globals) {
+        void_type = make(C0Type::Kind::VOID, "void");
+        int_type = make(C0Type::Kind::INT, "int");
+        bool_type = make(C0Type::Kind::BOOL, "bool");
+        char_type = make(C0Type::Kind::CHAR, "char");
+        string_type = make(C0Type::Kind::STRING, "string");
+        null_type = make(C0Type::Kind::POINTER, "NULL");
+    }
+
+    C0Type* TypeTable::make(C0Type::Kind kind, std::string spelling) {
+        types.push_back(std::make_unique<C0Type>());
+        C0Type* type = types.back().get();
+        type->kind = kind;
+        type->spelling = std::move(spelling);
+        return type;
+    }
+
+    const C0Type* TypeTable::getPointer(const C0Type* element) {
+        auto [it, inserted] = pointers.try_emplace(element, nullptr);
+        if (inserted) {
+            C0Type* type = make(C0Type::Kind::POINTER, element->spelling + "*");
+            type->element = element;
+            it->second = type;
+        }
+        return it->second;
+    }
+
+    const C0Type* TypeTable::getArray(const C0Type* element) {
+        auto [it, inserted] = arrays.try_emplace(element, nullptr);
+        if (inserted) {
+            C0Type* type = make(C0Type::Kind::ARRAY, element->spelling + "[]");
+            type->element = element;
+            it->second = type;
+        }
+        return it->second;
+    }
+
+    const C0Type* TypeTable::resolve(std::string_view spelling) {
+        return resolve(spelling, 0);
+    }
+
+    const C0Type* TypeTable::resolve(std::string_view spelling, int depth) {
+        auto it = resolved.find(std::string(spelling));
+        if (it != resolved.end()) {
+            return it->second;
+        }
+
+        // 先去掉末尾的 '*' 和 "[]"，从内到外套上去
+        size_t base_end = spelling.size();
+        while (base_end > 0) {
+            if (spelling[base_end - 1] == '*') {
+                --base_end;
+            } else if (base_end >= 2 && spelling.substr(base_end - 2, 2) == "[]") {
+                base_end -= 2;
+            } else {
+                break;
+            }
+        }
+        const C0Type* type = resolveBase(spelling.substr(0, base_end), depth);
+        for (size_t i = base_end; type != nullptr && i < spelling.size(); ++i) {
+            if (spelling[i] == '*') {
+                type = getPointer(type);
+            } else {
+                type = getArray(type);
+                ++i;
+            }
+        }
+        if (type != nullptr) {
+            resolved.emplace(std::string(spelling), type);
+        }
+        return type;
+    }
+
+    const C0Type* TypeTable::resolveBase(std::string_view name, int depth) {
+        if (name == "int") return int_type;
+        if (name == "bool") return bool_type;
+        if (name == "char") return char_type;
+        if (name == "string") return string_type;
+        if (name == "void") return void_type;
+
+        if (name.rfind("struct ", 0) == 0) {
+            std::string struct_name(name.substr(7));
+            auto [it, inserted] = structs.try_emplace(struct_name, nullptr);
+            if (inserted) {
+                C0Type* type = make(C0Type::Kind::STRUCT, std::string(name));
+                layouts.push_back(std::make_unique<StructLayout>());
+                type->layout = layouts.back().get();
+                type->layout->name = struct_name;
+                it->second = type;
+            }
+            return it->second;
+        }
+
+        if (depth >= kMaxAliasDepth) {
+            return nullptr;
+        }
+        if (const TypedefDecl* alias = globals.findTypedef(name)) {
+            return resolve(alias->type, depth + 1);
+        }
+        if (auto alias = globals.findLibraryTypedef(name)) {
+            return resolve(*alias, depth + 1);
+        }
+        // 通过 #use "文件" 引入的别名在这里只有名字，按不透明的指针处理
+        if (!name.empty() && name.find(' ') == std::string_view::npos) {
+            auto [it, inserted] = resolved.try_emplace(std::string(name), nullptr);
+            if (inserted) {
+                it->second = make(C0Type::Kind::OPAQUE, std::string(name));
+            }
+            return it->second;
+        }
+        return nullptr;
+    }
+
+    const StructLayout* TypeTable::getLayout(const C0Type* type) {
+        if (type == nullptr || type->kind != C0Type::Kind::STRUCT) {
+            return nullptr;
+        }
+        StructLayout* layout = type->layout;
+        if (layout->defined) {
+            return layout;
+        }
+        if (layout->in_progress) {
+            return nullptr;
+        }
+
+        // 先收集成员的 (名字, 类型)，源码中的定义优先于库中的定义
+        std::vector<std::pair<std::string, std::string>> members;
+        if (const StructDecl* decl = globals.findStruct(layout->name); decl != nullptr && decl->isDefinition) {
+            for (const auto& member : decl->members) {
+                members.emplace_back(member->name, member->type);
+            }
+        } else if (auto library_struct = globals.findLibraryStruct(layout->name)) {
+            for (size_t i = 0; i < library_struct->getFieldCount(); ++i) {
+                LibraryVariable field = library_struct->getField(i);
+                members.emplace_back(std::string(field.name), std::string(field.type));
+            }
+        } else {
+            return nullptr;
+        }
+
+        layout->in_progress = true;
+        layout->fields.clear();
+        uint32_t offset = 0;
+        uint32_t align = 1;
+        bool ok = true;
+        for (const auto& [member_name, member_type] : members) {
+            const C0Type* field_type = resolve(member_type);
+            if (field_type == nullptr || field_type->kind == C0Type::Kind::VOID ||
+                (field_type->kind == C0Type::Kind::STRUCT && getLayout(field_type) == nullptr)) {
+                ok = false;
+                break;
+            }
+            uint32_t field_align = alignOf(field_type);
+            offset = alignTo(offset, field_align);
+            layout->fields.push_back({member_name, field_type, offset});
+            offset += sizeOf(field_type);
+            align = std::max(align, field_align);
+        }
+        layout->in_progress = false;
+        if (!ok) {
+            layout->fields.clear();
+            return nullptr;
+        }
+        layout->size = alignTo(std::max<uint32_t>(offset, 1), align);
+        layout->align = align;
+        layout->defined = true;
+        return layout;
+    }
+
+    uint32_t TypeTable::sizeOf(const C0Type* type) {
+        if (type->kind == C0Type::Kind::STRUCT) {
+            const StructLayout* layout = getLayout(type);
+            return layout == nullptr ? 0 : layout->size;
+        }
+        return static_cast<uint32_t>(IR::sizeOf(type->getIRType()));
+    }
+
+    uint32_t TypeTable::alignOf(const C0Type* type) {
+        if (type->kind == C0Type::Kind::STRUCT) {
+            const StructLayout* layout = getLayout(type);
+            return layout == nullptr ? 1 : layout->align;
+        }
+        return std::max<uint32_t>(1, static_cast<uint32_t>(IR::sizeOf(type->getIRType())));
+    }
+}
@@ -0,0 +1,27 @@
+//
+// Created by 陶子杨 on 25-12-15.
+//
+
+#include "IR/ValueTracking.h"
+#include "Infra/casting.h"
+
+namespace CC::IR {
+    bool isKnownNonNull(const Value* address) {
+        auto instruction = INFRA::dyn_cast<Instruction>(address);
+        while (instruction != nullptr && instruction->getOpcode() == Opcode::FIELD_ADDR) {
+            address = instruction->getOperand(0);
+            instruction = INFRA::dyn_cast<Instruction>(address);
+        }
+        if (instruction == nullptr) {
+            return INFRA::isa<StringConstant>(address);
+        }
+        switch (instruction->getOpcode()) {
+        case Opcode::ALLOC:
+        case Opcode::ALLOC_ARRAY:
+        case Opcode::ELEMENT_ADDR:
+            return true;
+        default:
+            return false;
+        }
+    }
+}
@@ -0,0 +1,220 @@
+//
+// Created by 陶子杨 on 25-12-10.
+//
+
+#include "IR/Verifier.h"
+#include "IR/Dominators.h"
+#include "Infra/casting.h"
+
+#include <algorithm>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace CC::IR {
+    namespace {
+        class Verifier {
+        public:
+            explicit Verifier(const Function& function) : function(function) {}
+
+            std::vector<std::string> run() {
+                for (const BasicBlock* block : function.getBlocks()) {
+                    blocks.insert(block);
+                    uint32_t position = 0;
+                    for (const Instruction* instruction = block->front(); instruction != nullptr;
+                         instruction = instruction->getNext()) {
+                        positions.emplace(instruction, position++);
+                    }
+                }
+                for (const BasicBlock* block : function.getBlocks()) {
+                    checkBlock(*block);
+                }
+                // 结构完整之后才能建支配树
+                if (errors.empty()) {
+                    checkDominance();
+                }
+                return std::move(errors);
+            }
+
+        private:
+            template <typename... Parts>
+            void fail(const BasicBlock& block, const Parts&... parts) {
+                std::ostringstream message;
+                message << function.getName() << ": bb" << block.getNumber() << ": ";
+                (message << ... << parts);
+                errors.push_back(message.str());
+            }
+
+            void checkBlock(const BasicBlock& block) {
+                if (block.getParent() != &function) {
+                    fail(block, "基本块不属于本函数");
+                }
+                if (block.getTerminator() == nullptr) {
+                    fail(block, "没有以终结指令结尾");
+                }
+
+                bool seen_non_phi = false;
+                for (const Instruction* instruction = block.front(); instruction != nullptr;
+                     instruction = instruction->getNext()) {
+                    if (instruction->getParent() != &block) {
+                        fail(block, "%", instruction->getNumber(), " 的所属基本块不对");
+                    }
+                    if (instruction->isTerminator() && instruction != block.back()) {
+                        fail(block, "终结指令 %", instruction->getNumber(), " 后面还有指令");
+                    }
+                    if (instruction->isPhi()) {
+                        if (seen_non_phi) {
+                            fail(block, "PHI %", instruction->getNumber(), " 不在基本块开头");
+                        }
+                        checkPhi(block, *instruction);
+                    } else {
+                        seen_non_phi = true;
+                    }
+                    checkOperands(block, *instruction);
+                    if (instruction->isTailCall()) {
+                        checkTailCall(block, *instruction);
+                    }
+                }
+
+                // 前驱列表中的每一项都要对应一条跳转边，反之亦然
+                std::unordered_map<const BasicBlock*, size_t> edges;
+                for (const BasicBlock* predecessor : block.getPredecessors()) {
+                    if (blocks.count(predecessor) == 0) {
+                        fail(block, "前驱不在函数中");
+                        continue;
+                    }
+                    ++edges[predecessor];
+                }
+                for (const auto& [predecessor, count] : edges) {
+                    size_t actual = 0;
+                    for (uint32_t i = 0; i < predecessor->getSuccessorCount(); ++i) {
+                        actual += predecessor->getSuccessor(i) == &block ? 1 : 0;
+                    }
+                    if (actual != count) {
+                        fail(block, "前驱列表中 bb", predecessor->getNumber(), " 出现 ", count,
+                             " 次，但它有 ", actual, " 条边跳到这里");
+                    }
+                }
+                for (uint32_t i = 0; i < block.getSuccessorCount(); ++i) {
+                    const BasicBlock* successor = block.getSuccessor(i);
+                    if (successor == nullptr || blocks.count(successor) == 0) {
+                        fail(block, "跳转目标不在函数中");
+                    } else if (successor->countPredecessor(&block) == 0) {
+                        fail(block, "跳转目标 bb", successor->getNumber(), " 的前驱列表中没有本块");
+                    }
+                }
+            }
+
+            void checkPhi(const BasicBlock& block, const Instruction& phi) {
+                if (phi.getOperandCount() != block.getPredecessors().size()) {
+                    fail(block, "PHI %", phi.getNumber(), " 有 ", phi.getOperandCount(), " 个值，但基本块有 ",
+                         block.getPredecessors().size(), " 个前驱");
+                    return;
+                }
+                std::unordered_map<const BasicBlock*, size_t> remaining;
+                for (const BasicBlock* predecessor : block.getPredecessors()) {
+                    ++remaining[predecessor];
+                }
+                for (uint32_t i = 0; i < phi.getOperandCount(); ++i) {
+                    auto it = remaining.find(phi.getIncomingBlock(i));
+                    if (it == remaining.end() || it->second == 0) {
+                        fail(block, "PHI %", phi.getNumber(), " 的来源块不是前驱");
+                        return;
+                    }
+                    --it->second;
+                }
+            }
+
+            void checkTailCall(const BasicBlock& block, const Instruction& call) {
+                const Instruction* next = call.getNext();
+                bool returned = next != nullptr && next->getOpcode() == Opcode::RET &&
+                                (next->getOperandCount() == 0 ? call.getType() == Type::VOID
+                                                              : next->getOperand(0) == &call);
+                if (!returned) {
+                    fail(block, "尾调用 %", call.getNumber(), " 后面不是返回它结果的 RET");
+                }
+            }
+
+            void checkOperands(const BasicBlock& block, const Instruction& instruction) {
+                for (uint32_t i = 0; i < instruction.getOperandCount(); ++i) {
+                    const Use& use = instruction.getOperandUse(i);
+                    const Value* value = use.get();
+                    if (value == nullptr) {
+                        fail(block, "%", instruction.getNumber(), " 的第 ", i, " 个操作数为空");
+                        continue;
+                    }
+                    if (use.getUser() != &instruction) {
+                        fail(block, "%", instruction.getNumber(), " 的操作数记录的使用者不对");
+                    }
+                    // 每个值的使用链表只遍历一次，常量和参数有成千上万次使用时也不会变成平方
+                    if (walked_values.insert(value).second) {
+                        for (const Use* other = value->getFirstUse(); other != nullptr; other = other->getNext()) {
+                            linked_uses.insert(other);
+                        }
+                    }
+                    if (linked_uses.count(&use) == 0) {
+                        fail(block, "%", instruction.getNumber(), " 的第 ", i, " 个操作数不在该值的使用链表中");
+                    }
+                    if (auto* defining = INFRA::dyn_cast<Instruction>(value);
+                        defining != nullptr && positions.count(defining) == 0) {
+                        fail(block, "%", instruction.getNumber(), " 使用了已经删除的指令 %", defining->getNumber());
+                    }
+                    if (auto* argument = INFRA::dyn_cast<Argument>(value)) {
+                        const auto& arguments = function.getArguments();
+                        if (std::find(arguments.begin(), arguments.end(), argument) == arguments.end()) {
+                            fail(block, "%", instruction.getNumber(), " 使用了其他函数的参数");
+                        }
+                    }
+                }
+            }
+
+            /**
+             * @brief SSA 的基本要求：每个值的定义支配它的所有使用，PHI 的使用位置是来源块的末尾
+             */
+            void checkDominance() {
+                DominatorTree tree(function);
+                for (const BasicBlock* block : function.getBlocks()) {
+                    if (!tree.isReachable(block)) {
+                        continue;
+                    }
+                    for (const Instruction* instruction = block->front(); instruction != nullptr;
+                         instruction = instruction->getNext()) {
+                        for (uint32_t i = 0; i < instruction->getOperandCount(); ++i) {
+                            auto* defining = INFRA::dyn_cast<Instruction>(instruction->getOperand(i));
+                            if (defining == nullptr) {
+                                continue;
+                            }
+                            const BasicBlock* use_block =
+                                instruction->isPhi() ? instruction->getIncomingBlock(i) : block;
+                            bool dominated;
+                            if (defining->getParent() != use_block) {
+                                dominated = tree.dominates(defining->getParent(), use_block);
+                            } else {
+                                dominated = instruction->isPhi() ||
+                                            positions.at(defining) < positions.at(instruction);
+                            }
+                            if (!dominated && tree.isReachable(use_block)) {
+                                fail(*block, "%", instruction->getNumber(), " 的第 ", i, " 个操作数 %",
+                                     defining->getNumber(), " 的定义不支配这次使用");
+                            }
+                        }
+                    }
+                }
+            }
+
+            const Function& function;
+            std::unordered_set<const BasicBlock*> blocks;
+            std::unordered_map<const Instruction*, uint32_t> positions;   ///< 指令在所属块中的位置
+            std::unordered_set<const Value*> walked_values;
+            std::unordered_set<const Use*> linked_uses;
+            std::vector<std::string> errors;
+        };
+    }
+
+    std::vector<std::string> verify(const Function& function) {
+        if (function.isDeclaration()) {
+            return {};
+        }
+        return Verifier(function).run();
+    }
+}
@@ -0,0 +1,117 @@
+//
+// Created by 陶子杨 on 25-12-5.
+//
+
+#include "Infra/FileWatcher.h"
+
+#include <array>
+#include <thread>
+
+#ifdef __linux__
+#define INFRA_HAS_INOTIFY 1
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace INFRA {
+    namespace {
+        std::filesystem::file_time_type modifiedTime(const std::string& path) {
+            std::error_code error;
+            auto time = std::filesystem::last_write_time(path, error);
+            return error ? std::filesystem::file_time_type::min() : time;
+        }
+    }
+
+    FileWatcher::FileWatcher() {
+#ifdef INFRA_HAS_INOTIFY
+        inotify_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+    }
+
+    FileWatcher::~FileWatcher() {
+#ifdef INFRA_HAS_INOTIFY
+        if (inotify_fd >= 0) {
+            ::close(inotify_fd);
+        }
+#endif
+    }
+
+    void FileWatcher::watch(const std::string& file_path) {
+        if (!files.insert(file_path).second) {
+            return;
+        }
+        modified_times[file_path] = modifiedTime(file_path);
+#ifdef INFRA_HAS_INOTIFY
+        std::string directory = std::filesystem::path(file_path).parent_path().string();
+        if (inotify_fd >= 0 && watched_directories.insert(directory).second) {
+            int wd = ::inotify_add_watch(inotify_fd, directory.c_str(),
+                                         IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_MODIFY);
+            if (wd >= 0) {
+                directories[wd] = directory;
+            }
+        }
+#endif
+    }
+
+    std::vector<std::string> FileWatcher::waitForChanges(std::chrono::milliseconds quiet_period) {
+        std::unordered_set<std::string> changed;
+        while (changed.empty()) {
+            collect(std::chrono::milliseconds(-1), changed);
+        }
+        // 保存一个文件往往会产生好几个事件，等事件停下来再一起处理
+        size_t count;
+        do {
+            count = changed.size();
+            collect(quiet_period, changed);
+        } while (changed.size() != count);
+        return {changed.begin(), changed.end()};
+    }
+
+    void FileWatcher::collect(std::chrono::milliseconds timeout, std::unordered_set<std::string>& changed) {
+#ifdef INFRA_HAS_INOTIFY
+        if (inotify_fd >= 0) {
+            pollfd descriptor{inotify_fd, POLLIN, 0};
+            if (::poll(&descriptor, 1, static_cast<int>(timeout.count())) <= 0) {
+                return;
+            }
+            alignas(inotify_event) std::array<char, 16 * 1024> buffer{};
+            while (true) {
+                ssize_t length = ::read(inotify_fd, buffer.data(), buffer.size());
+                if (length <= 0) {
+                    break;
+                }
+                for (ssize_t offset = 0; offset < length;) {
+                    auto event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+                    offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+                    auto directory = directories.find(event->wd);
+                    if (directory == directories.end() || event->len == 0) {
+                        continue;
+                    }
+                    std::string path = (std::filesystem::path(directory->second) / event->name).string();
+                    if (files.count(path) != 0) {
+                        changed.insert(std::move(path));
+                    }
+                }
+            }
+            return;
+        }
+#endif
+        // 没有 inotify：每 100ms 比较一次修改时间
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        size_t before = changed.size();
+        while (true) {
+            for (const auto& file : files) {
+                auto time = modifiedTime(file);
+                if (time != modified_times[file]) {
+                    modified_times[file] = time;
+                    changed.insert(file);
+                }
+            }
+            if (changed.size() != before || (timeout.count() >= 0 && std::chrono::steady_clock::now() >= deadline)) {
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+}
@@ -0,0 +1,91 @@
+//
+// Created by 陶子杨 on 25-11-26.
+//
+
+#include "Infra/MappedFile.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define INFRA_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace INFRA {
+    MappedFile::MappedFile(const std::string& file_path) {
+#ifdef INFRA_HAS_MMAP
+        int fd = ::open(file_path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("无法打开文件: " + file_path);
+        }
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("无法读取文件信息: " + file_path);
+        }
+        size = static_cast<size_t>(st.st_size);
+        if (size > 0) {
+            void* address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("无法映射文件: " + file_path);
+            }
+            // 源码和接口文件都是顺序扫描的
+            ::madvise(address, size, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(address);
+            mapped = true;
+        }
+        ::close(fd);
+#else
+        std::ifstream file_stream(file_path, std::ios::binary);
+        if (!file_stream.is_open()) {
+            throw std::runtime_error("无法打开文件: " + file_path);
+        }
+        file_stream.seekg(0, std::ios::end);
+        fallback.resize(static_cast<size_t>(file_stream.tellg()));
+        file_stream.seekg(0, std::ios::beg);
+        file_stream.read(fallback.data(), static_cast<std::streamsize>(fallback.size()));
+        data = fallback.data();
+        size = fallback.size();
+#endif
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            reset();
+            fallback = std::move(other.fallback);
+            data = other.mapped ? other.data : fallback.data();
+            size = other.size;
+            mapped = other.mapped;
+            other.data = nullptr;
+            other.size = 0;
+            other.mapped = false;
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile() {
+        reset();
+    }
+
+    void MappedFile::reset() {
+#ifdef INFRA_HAS_MMAP
+        if (mapped) {
+            ::munmap(const_cast<char*>(data), size);
+        }
+#endif
+        data = nullptr;
+        size = 0;
+        mapped = false;
+        fallback.clear();
+    }
+}
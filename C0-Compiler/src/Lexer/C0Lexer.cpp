@@ -4,197 +4,372 @@
 
 #include "Lexer/C0Lexer.h"
 
+#include <array>
+
 namespace CC {
+    namespace {
+        struct KeywordEntry {
+            std::string_view spelling;
+            TokenType type;
+        };
 
-      std::unordered_map<std::string, TokenType> C0Lexer::keywords = {
-        {"int", TokenType::KW_INT},
-        {"bool", TokenType::KW_BOOL},
-        {"void", TokenType::KW_VOID},
-        {"if", TokenType::KW_IF},
-        {"else", TokenType::KW_ELSE},
-        {"while", TokenType::KW_WHILE},
-        {"return", TokenType::KW_RETURN},
-        {"true", TokenType::KW_TRUE},
-        {"false", TokenType::KW_FALSE},
-        {"struct", TokenType::KW_STRUCT},
-        {"typedef", TokenType::KW_TYPEDEF},
-        {"for", TokenType::KW_FOR},
-        {"continue", TokenType::KW_CONTINUE},
-        {"break", TokenType::KW_BREAK},
-        {"NULL", TokenType::KW_NULL},
-        {"alloc", TokenType::KW_ALLOC},
-        {"alloc_array", TokenType::KW_ALLOC_ARRAY},
-        {"char", TokenType::KW_CHAR},
-        {"string", TokenType::KW_STRING}
-    };
-
-    C0Lexer::C0Lexer(const std::string& file_path) {
-        code_manager = std::make_unique<CodeManager>(file_path);
+        constexpr std::array<KeywordEntry, 20> kAllKeywords = {{
+            {"int", TokenType::KW_INT},
+            {"bool", TokenType::KW_BOOL},
+            {"void", TokenType::KW_VOID},
+            {"if", TokenType::KW_IF},
+            {"else", TokenType::KW_ELSE},
+            {"while", TokenType::KW_WHILE},
+            {"return", TokenType::KW_RETURN},
+            {"true", TokenType::KW_TRUE},
+            {"false", TokenType::KW_FALSE},
+            {"struct", TokenType::KW_STRUCT},
+            {"typedef", TokenType::KW_TYPEDEF},
+            {"for", TokenType::KW_FOR},
+            {"continue", TokenType::KW_CONTINUE},
+            {"break", TokenType::KW_BREAK},
+            {"NULL", TokenType::KW_NULL},
+            {"alloc", TokenType::KW_ALLOC},
+            {"alloc_array", TokenType::KW_ALLOC_ARRAY},
+            {"char", TokenType::KW_CHAR},
+            {"string", TokenType::KW_STRING},
+            {"do", TokenType::KW_DO},
+        }};
+
+        constexpr size_t kMaxKeywordLength = 11;  // alloc_array
 
-        //预处理，消除所有的注释
-        std::vector<char> result;
-        while (!code_manager->eofReached()) {
-            char c = code_manager->getChar();
-            if (c == '/') {
-                char next = code_manager->getChar();
-                if (next == '/') {
-                    //单行注释
-                    while (!code_manager->eofReached() && code_manager->getChar() != '\n');
+        /**
+         * @brief 按长度分桶的关键字表，只包含 Lang 中开启的关键字。
+         * 查找时先按长度定位到桶，桶内最多只有几个候选
+         */
+        template <typename Lang>
+        struct KeywordTable {
+            static constexpr size_t count() {
+                size_t n = 0;
+                for (const auto& entry : kAllKeywords) {
+                    n += isTokenEnabled<Lang>(entry.type) ? 1 : 0;
                 }
-                else if (next == '*') {
-                    //多行注释
-                    char last = code_manager->getChar();
-                    while (!code_manager->eofReached()) {
-                        c = code_manager->getChar();
-                        if (last == '*' && c == '/') {
-                            break;
+                return n;
+            }
+
+            std::array<KeywordEntry, count()> entries{};
+            std::array<uint8_t, kMaxKeywordLength + 2> bucket_start{};
+
+            constexpr KeywordTable() {
+                size_t index = 0;
+                for (size_t length = 0; length <= kMaxKeywordLength; ++length) {
+                    bucket_start[length] = static_cast<uint8_t>(index);
+                    for (const auto& entry : kAllKeywords) {
+                        if (entry.spelling.size() == length && isTokenEnabled<Lang>(entry.type)) {
+                            entries[index++] = entry;
                         }
-                        last = c;
                     }
                 }
-                else {
-                    result.push_back(c);
-                }
+                bucket_start[kMaxKeywordLength + 1] = static_cast<uint8_t>(index);
             }
-            else {
-                result.push_back(c);
+
+            [[nodiscard]] constexpr TokenType lookup(std::string_view word) const {
+                if (word.size() > kMaxKeywordLength) {
+                    return TokenType::IDENTIFIER;
+                }
+                for (size_t i = bucket_start[word.size()]; i < bucket_start[word.size() + 1]; ++i) {
+                    if (entries[i].spelling == word) {
+                        return entries[i].type;
+                    }
+                }
+                return TokenType::IDENTIFIER;
             }
-        }
-        code_manager->updateBuffer(result);
-        code_manager->restar();
+        };
+
+        template <typename Lang>
+        inline constexpr KeywordTable<Lang> kKeywords{};
+
+        // 只在规约注解内部才是关键字，注解外仍然可以用作标识符
+        constexpr std::array<KeywordEntry, 4> kContractKeywords = {{
+            {"requires", TokenType::KW_REQUIRES},
+            {"ensures", TokenType::KW_ENSURES},
+            {"loop_invariant", TokenType::KW_LOOP_INVARIANT},
+            {"assert", TokenType::KW_ASSERT},
+        }};
+
+        static_assert(kKeywords<LangC0>.lookup("alloc_array") == TokenType::KW_ALLOC_ARRAY);
+        static_assert(kKeywords<LangL1>.lookup("while") == TokenType::IDENTIFIER);
+        static_assert(kKeywords<LangL4>.lookup("string") == TokenType::IDENTIFIER);
+    }
+
+    template <typename Lang>
+    BasicC0Lexer<Lang>::BasicC0Lexer(const std::string& file_path) {
+        code_manager = std::make_unique<CodeManager>(file_path);
     }
 
-    Token C0Lexer::nextToken() {
-        skipWhitespace();
+    template <typename Lang>
+    BasicC0Lexer<Lang>::BasicC0Lexer(std::string name, std::string_view source) {
+        code_manager = std::make_unique<CodeManager>(std::move(name), source);
+    }
 
+    template <typename Lang>
+    Token BasicC0Lexer<Lang>::nextToken() {
+        if constexpr (Lang::contracts) {
+            this->skipWhitespace(annotation == AnnotationState::NONE, annotation == AnnotationState::LINE);
+            // 多行注解中续行开头的 '@' 只是排版用的，和空白一样跳过
+            while (annotation == AnnotationState::BLOCK && code_manager->lookChar() == '@' &&
+                   !(code_manager->lookChar(1) == '*' && code_manager->lookChar(2) == '/')) {
+                code_manager->getChar();
+                this->skipWhitespace();
+            }
+        } else {
+            this->skipWhitespace();
+        }
+
+        auto start = static_cast<uint32_t>(code_manager->getOffset());
+        if constexpr (Lang::contracts) {
+            // 单行注解在行尾或文件末尾结束，ANNOT_END 不占用任何字符
+            if (annotation == AnnotationState::LINE &&
+                (code_manager->eofReached() || code_manager->lookChar() == '\n')) {
+                annotation = AnnotationState::NONE;
+                return {TokenType::ANNOT_END, start, 0, 0};
+            }
+        }
         if (code_manager->eofReached()) {
-            return {TokenType::END_OF_FILE, "", code_manager->getLocation()};
+            return {TokenType::END_OF_FILE, start, 0, 0};
         }
 
         char c = code_manager->lookChar();
 
-        if (isDigit(c)) {
-            return {TokenType::INT_LITERAL, readNumber(), code_manager->getLocation()};
+        if constexpr (Lang::contracts) {
+            if (annotation == AnnotationState::NONE && c == '/' && code_manager->lookChar(2) == '@' &&
+                (code_manager->lookChar(1) == '/' || code_manager->lookChar(1) == '*')) {
+                annotation = code_manager->lookChar(1) == '/' ? AnnotationState::LINE : AnnotationState::BLOCK;
+                code_manager->skip(3);
+                return {TokenType::ANNOT_BEGIN, start, 3, 0};
+            }
+            if (annotation == AnnotationState::BLOCK && c == '@' &&
+                code_manager->lookChar(1) == '*' && code_manager->lookChar(2) == '/') {
+                annotation = AnnotationState::NONE;
+                code_manager->skip(3);
+                return {TokenType::ANNOT_END, start, 3, 0};
+            }
+            if (annotation != AnnotationState::NONE && c == '\\') {
+                return readAnnotationKeyword();
+            }
+        }
+
+        if (Base::isDigit(c)) {
+            return this->readNumber();
         }
 
-        if (isLetter(c) || c == '_') {
+        if (Base::isLetter(c) || c == '_') {
             return readKeywordOrIdentifier();
         }
 
-        if (isOperator(c)) {
+        if (Base::isOperator(c)) {
             return readOperator();
         }
 
-        if (isDelimiter(c)) {
+        if (Base::isDelimiter(c)) {
             return readDelimiter();
         }
 
-        if (c == '"') {
-            return readString();
-        }
+        if constexpr (Lang::strings) {
+            if (c == '"') {
+                return this->readString();
+            }
 
-        if (c == '\'') {
-            return {TokenType::CHAR_LITERAL, readChar(), code_manager->getLocation()};
+            if (c == '\'') {
+                return this->readChar();
+            }
         }
 
-        return {TokenType::UNKNOWN, std::string(1,code_manager->getChar()), code_manager->getLocation()};
-    }
+        if constexpr (Lang::libraries) {
+            if (c == '#') {
+                return readDirective();
+            }
+        }
 
-    bool C0Lexer::isKeyword(const std::string& word) {
-        return keywords.find(word) != keywords.end();
+        code_manager->getChar();
+        return {TokenType::UNKNOWN, start, 1, 0};
     }
 
-    Token C0Lexer::readKeywordOrIdentifier() {
-        std::string word;
-        while (isLetter(code_manager->lookChar()) ||
-            isDigit(code_manager->lookChar()) ||
+    template <typename Lang>
+    Token BasicC0Lexer<Lang>::readKeywordOrIdentifier() {
+        auto start = static_cast<uint32_t>(code_manager->getOffset());
+        while (Base::isLetter(code_manager->lookChar()) ||
+            Base::isDigit(code_manager->lookChar()) ||
             code_manager->lookChar() == '_') {
-            word += code_manager->getChar();
+            code_manager->getChar();
         }
 
-        if (isKeyword(word)) {
-            return {keywords[word], word, code_manager->getLocation()};
-        } else {
-            return {TokenType::IDENTIFIER, word, code_manager->getLocation()};
+        auto length = static_cast<uint32_t>(code_manager->getOffset()) - start;
+        std::string_view word = code_manager->getText(start, length);
+        if constexpr (Lang::contracts) {
+            if (annotation != AnnotationState::NONE) {
+                for (const auto& entry : kContractKeywords) {
+                    if (entry.spelling == word) {
+                        return {entry.type, start, length, 0};
+                    }
+                }
+            }
         }
+        return {kKeywords<Lang>.lookup(word), start, length, 0};
     }
 
-    Token C0Lexer::readOperator() {
-        std::string word;
-
+    template <typename Lang>
+    Token BasicC0Lexer<Lang>::readOperator() {
+        auto start = static_cast<uint32_t>(code_manager->getOffset());
         char c = code_manager->getChar();
-        word = c;
-        char next = code_manager->getChar();
-        word += next;
-        if (word == "+=") {
-            return {TokenType::OP_PLUS_ASSIGN, word, code_manager->getLocation()};
-        } else if (word == "-=") {
-            return {TokenType::OP_MINUS_ASSIGN, word, code_manager->getLocation()};
-        } else if (word == "*=") {
-            return {TokenType::OP_MULTIPLY_ASSIGN, word, code_manager->getLocation()};
-        } else if (word == "\\=") {
-            return {TokenType::OP_DIVIDE_ASSIGN, word, code_manager->getLocation()};
-        } else if (word == "%=") {
-            return {TokenType::OP_MODULO_ASSIGN, word, code_manager->getLocation()};
-        } else if (word == "==") {
-            return {TokenType::OP_EQ, word, code_manager->getLocation()};
-        } else if (word == "!=") {
-            return {TokenType::OP_NE, word, code_manager->getLocation()};
-        } else if (word == "<=") {
-            return {TokenType::OP_LE, word, code_manager->getLocation()};
-        } else if (word == ">=") {
-            return {TokenType::OP_GE, word, code_manager->getLocation()};
-        } else if (word == "&&") {
-            return {TokenType::OP_LOGICAL_AND, word, code_manager->getLocation()};
-        } else if (word == "||") {
-            return {TokenType::OP_LOGICAL_OR, word, code_manager->getLocation()};
-        }
-        code_manager->ungetChar();
+        char next = code_manager->lookChar();
+        char after = code_manager->lookChar(1);
+
+        // 最长匹配：依次尝试三字符、双字符运算符，当前层级没有的运算符会退回到更短的匹配
+        TokenType type = TokenType::UNKNOWN;
+        uint32_t length = 1;
+        auto accept = [&](TokenType candidate, uint32_t candidate_length) {
+            if (type == TokenType::UNKNOWN && isTokenEnabled<Lang>(candidate)) {
+                type = candidate;
+                length = candidate_length;
+            }
+        };
+
+        if (next == c && after == '=') {
+            if (c == '<') accept(TokenType::OP_SHL_ASSIGN, 3);
+            if (c == '>') accept(TokenType::OP_SHR_ASSIGN, 3);
+        }
+        if (next == '=') {
+            switch (c) {
+            case '+': accept(TokenType::OP_PLUS_ASSIGN, 2); break;
+            case '-': accept(TokenType::OP_MINUS_ASSIGN, 2); break;
+            case '*': accept(TokenType::OP_MULTIPLY_ASSIGN, 2); break;
+            case '/': accept(TokenType::OP_DIVIDE_ASSIGN, 2); break;
+            case '%': accept(TokenType::OP_MODULO_ASSIGN, 2); break;
+            case '&': accept(TokenType::OP_AND_ASSIGN, 2); break;
+            case '|': accept(TokenType::OP_OR_ASSIGN, 2); break;
+            case '^': accept(TokenType::OP_XOR_ASSIGN, 2); break;
+            case '=': accept(TokenType::OP_EQ, 2); break;
+            case '!': accept(TokenType::OP_NE, 2); break;
+            case '<': accept(TokenType::OP_LE, 2); break;
+            case '>': accept(TokenType::OP_GE, 2); break;
+            default: break;
+            }
+        } else if (next == c) {
+            switch (c) {
+            case '&': accept(TokenType::OP_LOGICAL_AND, 2); break;
+            case '|': accept(TokenType::OP_LOGICAL_OR, 2); break;
+            case '<': accept(TokenType::OP_SHL, 2); break;
+            case '>': accept(TokenType::OP_SHR, 2); break;
+            case '+': accept(TokenType::OP_INCREMENT, 2); break;
+            case '-': accept(TokenType::OP_DECREMENT, 2); break;
+            default: break;
+            }
+        } else if (c == '-' && next == '>') {
+            accept(TokenType::OP_ARROW, 2);
+        }
+
         switch (c) {
-        case '+':
-            return {TokenType::OP_PLUS, std::string(1, c), code_manager->getLocation()};
-        case '-':
-            return {TokenType::OP_MINUS, std::string(1, c), code_manager->getLocation()};
-        case '*':
-            return {TokenType::OP_MULTIPLY, std::string(1, c), code_manager->getLocation()};
-        case '/':
-            return {TokenType::OP_DIVIDE, std::string(1, c), code_manager->getLocation()};
-        case '%':
-            return {TokenType::OP_MODULO, std::string(1, c), code_manager->getLocation()};
-        case '=':
-            return {TokenType::OP_ASSIGN, std::string(1, c), code_manager->getLocation()};
-        case '>':
-            return {TokenType::OP_GT, std::string(1, c), code_manager->getLocation()};
-        case '<':
-            return {TokenType::OP_LT, std::string(1, c), code_manager->getLocation()};
-        case '!':
-            return {TokenType::OP_NOT, std::string(1, c), code_manager->getLocation()};
-        case '&':
-            return {TokenType::OP_AND, std::string(1, c), code_manager->getLocation()};
-        case '|':
-            return {TokenType::OP_OR, std::string(1, c), code_manager->getLocation()};
-        case '^':
-            return {TokenType::OP_XOR, std::string(1, c), code_manager->getLocation()};
+        case '+': accept(TokenType::OP_PLUS, 1); break;
+        case '-': accept(TokenType::OP_MINUS, 1); break;
+        case '*': accept(TokenType::OP_MULTIPLY, 1); break;
+        case '/': accept(TokenType::OP_DIVIDE, 1); break;
+        case '%': accept(TokenType::OP_MODULO, 1); break;
+        case '=': accept(TokenType::OP_ASSIGN, 1); break;
+        case '>': accept(TokenType::OP_GT, 1); break;
+        case '<': accept(TokenType::OP_LT, 1); break;
+        case '!': accept(TokenType::OP_NOT, 1); break;
+        case '&': accept(TokenType::OP_AND, 1); break;
+        case '|': accept(TokenType::OP_OR, 1); break;
+        case '^': accept(TokenType::OP_XOR, 1); break;
+        case '~': accept(TokenType::OP_BIT_NOT, 1); break;
+        default: break;
         }
+        code_manager->skip(length - 1);
+        return {type, start, length, 0};
     }
 
-    Token C0Lexer::readDelimiter() {
-        char c = code_manager->getChar();
-        switch (c) {
-        case ';':
-            return {TokenType::SEMICOLON, ";", code_manager->getLocation()};
-        case ',':
-            return {TokenType::COMMA, ",", code_manager->getLocation()};
-        case '(':
-            return {TokenType::LPAREN, "(", code_manager->getLocation()};
-        case ')':
-            return {TokenType::RPAREN, ")", code_manager->getLocation()};
-        case '{':
-            return {TokenType::LBRACE, "{", code_manager->getLocation()};
-        case '}':
-            return {TokenType::RBRACE, "}", code_manager->getLocation()};
-        case '.':
-            return {TokenType::DOT, ".", code_manager->getLocation()};
+    template <typename Lang>
+    Token BasicC0Lexer<Lang>::readDelimiter() {
+        auto start = static_cast<uint32_t>(code_manager->getOffset());
+        TokenType type = TokenType::UNKNOWN;
+        switch (code_manager->getChar()) {
+        case ';': type = TokenType::SEMICOLON; break;
+        case ',': type = TokenType::COMMA; break;
+        case '(': type = TokenType::LPAREN; break;
+        case ')': type = TokenType::RPAREN; break;
+        case '{': type = TokenType::LBRACE; break;
+        case '}': type = TokenType::RBRACE; break;
+        case '[': type = TokenType::LBRACKET; break;
+        case ']': type = TokenType::RBRACKET; break;
+        case '?': type = TokenType::QUESTION; break;
+        case ':': type = TokenType::COLON; break;
+        case '.': type = TokenType::DOT; break;
+        default: break;
         }
+        if (!isTokenEnabled<Lang>(type)) {
+            type = TokenType::UNKNOWN;
+        }
+        return {type, start, 1, 0};
     }
+
+    template <typename Lang>
+    Token BasicC0Lexer<Lang>::readDirective() {
+        auto start = static_cast<uint32_t>(code_manager->getOffset());
+        auto unknown = [&]() -> Token {
+            // 整行都当作无法识别的内容，避免在指令内部连锁报错
+            while (!code_manager->eofReached() && code_manager->lookChar() != '\n') {
+                code_manager->getChar();
+            }
+            return {TokenType::UNKNOWN, start, static_cast<uint32_t>(code_manager->getOffset()) - start, 0};
+        };
+
+        if (code_manager->remaining() < 4 || code_manager->getText(start, 4) != "#use") {
+            return unknown();
+        }
+        code_manager->skip(4);
+        if (code_manager->lookChar() != ' ' && code_manager->lookChar() != '\t') {
+            return unknown();
+        }
+        while (code_manager->lookChar() == ' ' || code_manager->lookChar() == '\t') {
+            code_manager->getChar();
+        }
+
+        char open = code_manager->lookChar();
+        if (open != '<' && open != '"') {
+            return unknown();
+        }
+        char close = open == '<' ? '>' : '"';
+        code_manager->getChar();
+        auto name_start = static_cast<uint32_t>(code_manager->getOffset());
+        while (!code_manager->eofReached() && code_manager->lookChar() != close &&
+               code_manager->lookChar() != '\n') {
+            code_manager->getChar();
+        }
+        auto name_length = static_cast<uint32_t>(code_manager->getOffset()) - name_start;
+        if (code_manager->lookChar() != close || name_length == 0) {
+            return unknown();
+        }
+        code_manager->getChar();
+        return {open == '<' ? TokenType::USE_LIBRARY : TokenType::USE_FILE, name_start, name_length, 0};
+    }
+
+    template <typename Lang>
+    Token BasicC0Lexer<Lang>::readAnnotationKeyword() {
+        auto start = static_cast<uint32_t>(code_manager->getOffset());
+        code_manager->getChar();
+        while (Base::isLetter(code_manager->lookChar()) || code_manager->lookChar() == '_') {
+            code_manager->getChar();
+        }
+        auto length = static_cast<uint32_t>(code_manager->getOffset()) - start;
+        std::string_view word = code_manager->getText(start, length);
+        TokenType type = TokenType::UNKNOWN;
+        if (word == "\\result") {
+            type = TokenType::KW_RESULT;
+        } else if (word == "\\length") {
+            type = TokenType::KW_LENGTH;
+        }
+        return {type, start, length, 0};
+    }
+
+    template class BasicC0Lexer<LangL1>;
+    template class BasicC0Lexer<LangL2>;
+    template class BasicC0Lexer<LangL3>;
+    template class BasicC0Lexer<LangL4>;
+    template class BasicC0Lexer<LangC0>;
 }
@@ -0,0 +1,290 @@
+//
+// Created by 陶子杨 on 25-12-2.
+//
+
+#include "Library/LibraryInterface.h"
+#include "AST/UnitNode.h"
+#include "Infra/casting.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace CC {
+    namespace {
+        using namespace LibraryFormat;
+
+        // 追加写入的字符串表，相同的字符串只存一份
+        class StringTableBuilder {
+        public:
+            StringRef add(const std::string& string) {
+                auto it = offsets.find(string);
+                if (it != offsets.end()) {
+                    return it->second;
+                }
+                StringRef ref{static_cast<uint32_t>(data.size()), static_cast<uint32_t>(string.size())};
+                data += string;
+                offsets.emplace(string, ref);
+                return ref;
+            }
+
+            [[nodiscard]] const std::string& getData() const {
+                return data;
+            }
+
+        private:
+            std::string data;
+            std::unordered_map<std::string, StringRef> offsets;
+        };
+
+        template <typename T>
+        void appendRecords(std::string& out, const std::vector<T>& records) {
+            out.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T));
+        }
+
+        template <typename Record>
+        const Record* findByName(const Record* records, uint32_t count, const char* strings, std::string_view name) {
+            const Record* end = records + count;
+            const Record* it = std::lower_bound(records, end, name, [&](const Record& record, std::string_view key) {
+                return std::string_view(strings + record.name.offset, record.name.length) < key;
+            });
+            if (it == end || std::string_view(strings + it->name.offset, it->name.length) != name) {
+                return nullptr;
+            }
+            return it;
+        }
+
+        template <typename Decl>
+        void sortByName(std::vector<std::shared_ptr<Decl>>& decls) {
+            std::stable_sort(decls.begin(), decls.end(), [](const auto& a, const auto& b) {
+                return a->name < b->name;
+            });
+            // 原型可能重复出现，只保留第一次
+            decls.erase(std::unique(decls.begin(), decls.end(), [](const auto& a, const auto& b) {
+                return a->name == b->name;
+            }), decls.end());
+        }
+    }
+
+    std::string_view LibraryFunction::getName() const {
+        return owner->getString(record->name);
+    }
+
+    std::string_view LibraryFunction::getReturnType() const {
+        return owner->getString(record->return_type);
+    }
+
+    size_t LibraryFunction::getParameterCount() const {
+        return record->parameter_count;
+    }
+
+    LibraryVariable LibraryFunction::getParameter(size_t index) const {
+        return owner->getVariable(owner->parameters[record->first_parameter + index]);
+    }
+
+    std::string_view LibraryStruct::getName() const {
+        return owner->getString(record->name);
+    }
+
+    size_t LibraryStruct::getFieldCount() const {
+        return record->field_count;
+    }
+
+    LibraryVariable LibraryStruct::getField(size_t index) const {
+        return owner->getVariable(owner->fields[record->first_field + index]);
+    }
+
+    LibraryInterface::LibraryInterface(std::string name, INFRA::MappedFile file)
+        : name(std::move(name)), file(std::move(file)) {
+    }
+
+    std::shared_ptr<const LibraryInterface> LibraryInterface::load(std::string name, const std::string& file_path) {
+        INFRA::MappedFile file(file_path);
+        const char* data = file.getData();
+        size_t size = file.getSize();
+        auto invalid = [&]() {
+            return std::runtime_error("库接口文件已损坏: " + file_path);
+        };
+
+        if (size < sizeof(Header)) {
+            throw invalid();
+        }
+        auto header = reinterpret_cast<const Header*>(data);
+        if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion) {
+            throw invalid();
+        }
+        uint64_t expected = sizeof(Header) +
+                            uint64_t(header->function_count) * sizeof(FunctionRecord) +
+                            uint64_t(header->parameter_count) * sizeof(NamedTypeRecord) +
+                            uint64_t(header->struct_count) * sizeof(StructRecord) +
+                            uint64_t(header->field_count) * sizeof(NamedTypeRecord) +
+                            uint64_t(header->typedef_count) * sizeof(NamedTypeRecord) +
+                            header->string_size;
+        if (expected != size) {
+            throw invalid();
+        }
+
+        // 构造函数是私有的，不能用 make_shared
+        std::shared_ptr<LibraryInterface> library(new LibraryInterface(std::move(name), std::move(file)));
+        const char* cursor = library->file.getData() + sizeof(Header);
+        library->header = reinterpret_cast<const Header*>(library->file.getData());
+        library->functions = reinterpret_cast<const FunctionRecord*>(cursor);
+        cursor += header->function_count * sizeof(FunctionRecord);
+        library->parameters = reinterpret_cast<const NamedTypeRecord*>(cursor);
+        cursor += header->parameter_count * sizeof(NamedTypeRecord);
+        library->structs = reinterpret_cast<const StructRecord*>(cursor);
+        cursor += header->struct_count * sizeof(StructRecord);
+        library->fields = reinterpret_cast<const NamedTypeRecord*>(cursor);
+        cursor += header->field_count * sizeof(NamedTypeRecord);
+        library->typedefs = reinterpret_cast<const NamedTypeRecord*>(cursor);
+        cursor += header->typedef_count * sizeof(NamedTypeRecord);
+        library->strings = cursor;
+
+        // 一次性检查所有下标和字符串范围，之后的查询不再做边界检查
+        header = library->header;
+        auto validString = [&](StringRef ref) {
+            return uint64_t(ref.offset) + ref.length <= header->string_size;
+        };
+        auto validRange = [](uint32_t first, uint32_t count, uint32_t total) {
+            return uint64_t(first) + count <= total;
+        };
+        for (uint32_t i = 0; i < header->function_count; ++i) {
+            const auto& function = library->functions[i];
+            if (!validString(function.name) || !validString(function.return_type) ||
+                !validRange(function.first_parameter, function.parameter_count, header->parameter_count)) {
+                throw invalid();
+            }
+        }
+        for (uint32_t i = 0; i < header->struct_count; ++i) {
+            const auto& structRecord = library->structs[i];
+            if (!validString(structRecord.name) ||
+                !validRange(structRecord.first_field, structRecord.field_count, header->field_count)) {
+                throw invalid();
+            }
+        }
+        auto validNamedTypes = [&](const NamedTypeRecord* records, uint32_t count) {
+            for (uint32_t i = 0; i < count; ++i) {
+                if (!validString(records[i].name) || !validString(records[i].type)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        if (!validNamedTypes(library->parameters, header->parameter_count) ||
+            !validNamedTypes(library->fields, header->field_count) ||
+            !validNamedTypes(library->typedefs, header->typedef_count)) {
+            throw invalid();
+        }
+        return library;
+    }
+
+    void LibraryInterface::write(const TranslationUnit& unit, const std::string& file_path) {
+        std::vector<std::shared_ptr<FunctionDecl>> functionDecls;
+        std::vector<std::shared_ptr<StructDecl>> structDecls;
+        std::vector<std::shared_ptr<TypedefDecl>> typedefDecls;
+        for (const auto& decl : unit.declarations) {
+            if (auto function = INFRA::dyn_cast<FunctionDecl>(decl)) {
+                functionDecls.push_back(std::move(function));
+            } else if (auto structDecl = INFRA::dyn_cast<StructDecl>(decl)) {
+                if (structDecl->isDefinition) {
+                    structDecls.push_back(std::move(structDecl));
+                }
+            } else if (auto typedefDecl = INFRA::dyn_cast<TypedefDecl>(decl)) {
+                typedefDecls.push_back(std::move(typedefDecl));
+            }
+        }
+        sortByName(functionDecls);
+        sortByName(structDecls);
+        // 类型别名按声明顺序保存，后面的别名可能引用前面的
+
+        StringTableBuilder stringTable;
+        std::vector<FunctionRecord> functionRecords;
+        std::vector<NamedTypeRecord> parameterRecords;
+        for (const auto& function : functionDecls) {
+            functionRecords.push_back({stringTable.add(function->name), stringTable.add(function->returnType),
+                                       static_cast<uint32_t>(parameterRecords.size()),
+                                       static_cast<uint32_t>(function->parameters.size())});
+            for (const auto& parameter : function->parameters) {
+                parameterRecords.push_back({stringTable.add(parameter->name), stringTable.add(parameter->type)});
+            }
+        }
+        std::vector<StructRecord> structRecords;
+        std::vector<NamedTypeRecord> fieldRecords;
+        for (const auto& structDecl : structDecls) {
+            structRecords.push_back({stringTable.add(structDecl->name),
+                                     static_cast<uint32_t>(fieldRecords.size()),
+                                     static_cast<uint32_t>(structDecl->members.size())});
+            for (const auto& member : structDecl->members) {
+                fieldRecords.push_back({stringTable.add(member->name), stringTable.add(member->type)});
+            }
+        }
+        std::vector<NamedTypeRecord> typedefRecords;
+        for (const auto& typedefDecl : typedefDecls) {
+            typedefRecords.push_back({stringTable.add(typedefDecl->name), stringTable.add(typedefDecl->type)});
+        }
+
+        Header header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.function_count = static_cast<uint32_t>(functionRecords.size());
+        header.parameter_count = static_cast<uint32_t>(parameterRecords.size());
+        header.struct_count = static_cast<uint32_t>(structRecords.size());
+        header.field_count = static_cast<uint32_t>(fieldRecords.size());
+        header.typedef_count = static_cast<uint32_t>(typedefRecords.size());
+        header.string_size = static_cast<uint32_t>(stringTable.getData().size());
+
+        std::string out(reinterpret_cast<const char*>(&header), sizeof(header));
+        appendRecords(out, functionRecords);
+        appendRecords(out, parameterRecords);
+        appendRecords(out, structRecords);
+        appendRecords(out, fieldRecords);
+        appendRecords(out, typedefRecords);
+        out += stringTable.getData();
+
+        std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+        if (!file || !file.write(out.data(), static_cast<std::streamsize>(out.size()))) {
+            throw std::runtime_error("无法写入库接口文件: " + file_path);
+        }
+    }
+
+    size_t LibraryInterface::getFunctionCount() const {
+        return header->function_count;
+    }
+
+    LibraryFunction LibraryInterface::getFunction(size_t index) const {
+        return {this, functions + index};
+    }
+
+    std::optional<LibraryFunction> LibraryInterface::findFunction(std::string_view function_name) const {
+        if (auto record = findByName(functions, header->function_count, strings, function_name)) {
+            return LibraryFunction(this, record);
+        }
+        return std::nullopt;
+    }
+
+    size_t LibraryInterface::getStructCount() const {
+        return header->struct_count;
+    }
+
+    LibraryStruct LibraryInterface::getStruct(size_t index) const {
+        return {this, structs + index};
+    }
+
+    std::optional<LibraryStruct> LibraryInterface::findStruct(std::string_view struct_name) const {
+        if (auto record = findByName(structs, header->struct_count, strings, struct_name)) {
+            return LibraryStruct(this, record);
+        }
+        return std::nullopt;
+    }
+
+    size_t LibraryInterface::getTypedefCount() const {
+        return header->typedef_count;
+    }
+
+    LibraryVariable LibraryInterface::getTypedef(size_t index) const {
+        return getVariable(typedefs[index]);
+    }
+}
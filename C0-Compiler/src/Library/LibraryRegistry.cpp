@@ -0,0 +1,34 @@
+//
+// Created by 陶子杨 on 25-12-2.
+//
+
+#include "Library/LibraryRegistry.h"
+
+#include <filesystem>
+
+namespace CC {
+    LibraryRegistry::LibraryRegistry(std::vector<std::string> search_paths)
+        : search_paths(std::move(search_paths)) {
+    }
+
+    std::shared_ptr<const LibraryInterface> LibraryRegistry::find(std::string_view name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = loaded.find(std::string(name));
+        if (it != loaded.end()) {
+            return it->second;
+        }
+
+        std::shared_ptr<const LibraryInterface> library;
+        for (const auto& directory : search_paths) {
+            std::filesystem::path path = std::filesystem::path(directory) / (std::string(name) + ".c0i");
+            std::error_code error;
+            if (std::filesystem::is_regular_file(path, error)) {
+                library = LibraryInterface::load(std::string(name), path.string());
+                break;
+            }
+        }
+        // 找不到的库也记下来，避免每次 #use 都重新扫描目录
+        loaded.emplace(std::string(name), library);
+        return library;
+    }
+}
@@ -3,238 +3,566 @@
 //
 
 #include "Parser/C0Parser.h"
+#include "Parser/OperatorTable.h"
 #include "AST/StatementNode.h"
 #include "Infra/casting.h"
 
 namespace CC {
-    std::shared_ptr<Expression> C0Parser::parseExpression(int minPrec) {
-        std::shared_ptr<Expression> left = parsePrefixExpression();
-        while (true) {
-            Token op = peek(0);
-            int prec = getInfixPrecedence(op.type);
-
-            // 不是中缀运算符 或者 优先级低于当前 minPrec，则停止
-            if (prec < minPrec || prec == 0) {
-                break;
+    namespace {
+        // 运算符栈中的条目：普通运算符，或者括号/函数调用形成的嵌套边界
+        enum class FrameKind {
+            PREFIX,   // 一元前缀运算符
+            INFIX,    // 二元运算符（包括赋值）
+            GROUP,    // '(' 括号表达式
+            CALL,     // '(' 函数调用，operand_base 之前紧挨着的是被调用者
+            SUBSCRIPT,// '[' 数组下标，operand_base 之前紧挨着的是数组
+            ALLOC,    // alloc_array(T, ...) 的元素个数，type_index 指向元素类型
+            TERNARY,  // '?' 到 ':' 之间的分支
+            CONDITIONAL,// 读到 ':' 之后的条件运算符，归约时取三个操作数
+            LENGTH,   // 规约中的 \length( ... )
+        };
+
+        struct OperatorFrame {
+            FrameKind kind;
+            TokenType op;
+            uint8_t precedence;
+            size_t operand_base;
+            uint32_t offset;    ///< 运算符或边界 token 的位置，归约出的节点用它报错
+        };
+
+        constexpr unsigned contractMask(ContractKind kind) {
+            return 1u << static_cast<unsigned>(kind);
+        }
+
+        bool isOperatorFrame(const OperatorFrame& frame) {
+            return frame.kind == FrameKind::PREFIX || frame.kind == FrameKind::INFIX ||
+                   frame.kind == FrameKind::CONDITIONAL;
+        }
+
+        // 最近一个尚未闭合的括号/调用/下标边界打开时操作数栈的深度，没有边界时为 0
+        size_t innermostOperandBase(const std::vector<OperatorFrame>& operators) {
+            for (auto frame = operators.rbegin(); frame != operators.rend(); ++frame) {
+                if (!isOperatorFrame(*frame)) {
+                    return frame->operand_base;
+                }
             }
-
-            // 处理结合性：右结合的右边用相同优先级，左结合的右边用 prec + 1
-            int nextMinPrec = isRightAssociative(op.type) ? prec : prec + 1;
-
-            advance(1); // 消耗运算符
-
-            // 右操作数递归调用 parseExpression
-            auto right = parseExpression(nextMinPrec);
-
-            // 根据是赋值还是普通二元，构建不同节点
-            if (op.type == TokenType::OP_ASSIGN) {
-                left = std::make_shared<AssignmentExpr>(left, right,op.type);
+            return 0;
+        }
+
+        // 把栈顶运算符和对应的操作数归约成一个AST节点
+        template <typename Lang>
+        bool reduceTop(std::vector<OperatorFrame>& operators,
+                       std::vector<std::shared_ptr<Expression>>& operands,
+                       std::pmr::memory_resource* resource) {
+            OperatorFrame frame = operators.back();
+            operators.pop_back();
+            if (frame.kind == FrameKind::PREFIX) {
+                if (operands.empty()) {
+                    return false;
+                }
+                operands.back() = makeNode<UnaryExpr>(resource, operands.back(), frame.op);
+                operands.back()->offset = frame.offset;
+                return true;
+            }
+            if (frame.kind == FrameKind::CONDITIONAL) {
+                if (operands.size() < 3) {
+                    return false;
+                }
+                auto elseExpr = std::move(operands.back());
+                operands.pop_back();
+                auto thenExpr = std::move(operands.back());
+                operands.pop_back();
+                operands.back() = makeNode<ConditionalExpr>(resource, std::move(operands.back()),
+                                                            std::move(thenExpr), std::move(elseExpr));
+                operands.back()->offset = frame.offset;
+                return true;
+            }
+            if (operands.size() < 2) {
+                return false;
+            }
+            auto right = std::move(operands.back());
+            operands.pop_back();
+            auto left = std::move(operands.back());
+            if (getOperatorInfo<Lang>(frame.op).is_assignment) {
+                operands.back() = makeNode<AssignmentExpr>(resource, std::move(left), std::move(right), frame.op);
             } else {
-                left = std::make_shared<BinaryExpr>(left, right, op.type);
+                operands.back() = makeNode<BinaryExpr>(resource, std::move(left), std::move(right), frame.op);
             }
+            operands.back()->offset = frame.offset;
+            return true;
         }
 
-        return left;
-    }
-
-    std::shared_ptr<Expression> C0Parser::parsePrefixExpression() {
-        Token token = peek(0);
-
-        // 如果是一元运算符 (+, -, !)
-        if (token.type == TokenType::OP_PLUS ||
-            token.type == TokenType::OP_MINUS ||
-            token.type == TokenType::OP_NOT) {
-
-            advance(1); // 消耗运算符
-
-            // 递归调用 parsePrefixExpression，支持 !!x 或 - -y
-            auto operand = parsePrefixExpression();
-            return std::make_shared<UnaryExpr>(operand, token.type);
+        // 归约到最近的括号/调用边界为止（不弹出边界本身）
+        template <typename Lang>
+        bool reduceToFrame(std::vector<OperatorFrame>& operators,
+                           std::vector<std::shared_ptr<Expression>>& operands,
+                           std::pmr::memory_resource* resource) {
+            while (!operators.empty() && isOperatorFrame(operators.back())) {
+                if (!reduceTop<Lang>(operators, operands, resource)) {
+                    return false;
+                }
             }
-
-        // 如果不是一元运算符，下沉到后缀表达式层级
-        return parsePostfixExpression();
+            return true;
+        }
     }
 
-    std::shared_ptr<Expression> C0Parser::parsePostfixExpression() {
-        // 先解析最基本的元素 (标识符、字面量、括号表达式)
-        auto expr = parsePrimary();
+    template <typename Lang>
+    std::shared_ptr<Expression> BasicC0Parser<Lang>::parseExpression() {
+        std::vector<std::shared_ptr<Expression>> operands;
+        std::vector<OperatorFrame> operators;
+        std::vector<std::string> alloc_types; // 尚未闭合的 alloc_array 的元素类型
+        size_t open_frames = 0;      // 尚未闭合的括号/调用/下标/?: 个数
+        bool expect_operand = true;  // 当前位置需要操作数还是运算符
 
-        // 循环检查后面是否紧跟着后缀运算符
         while (true) {
-            Token t = peek(0);
+            Token token = peek(0);
+
+            if (expect_operand) {
+                const OperatorInfo& info = getOperatorInfo<Lang>(token.type);
+                if (info.prefix_precedence != 0) {
+                    // 一元运算符，支持 !!x 或 - -y
+                    operators.push_back({FrameKind::PREFIX, token.type, info.prefix_precedence, 0, token.offset});
+                    advance(1);
+                    continue;
+                }
+                if (token.type == TokenType::LPAREN) {
+                    operators.push_back({FrameKind::GROUP, token.type, 0, operands.size(), token.offset});
+                    ++open_frames;
+                    advance(1);
+                    continue;
+                }
+                if constexpr (Lang::pointers || Lang::arrays) {
+                    // alloc(T) 直接成为操作数；alloc_array(T, n) 的元素个数按括号边界继续解析
+                    if (token.type == TokenType::KW_ALLOC || token.type == TokenType::KW_ALLOC_ARRAY) {
+                        advance(1);
+                        if (!expect(TokenType::LPAREN, "'('")) {
+                            return nullptr;
+                        }
+                        std::string type = parseType();
+                        if (token.type == TokenType::KW_ALLOC) {
+                            if (!expect(TokenType::RPAREN, "')'")) {
+                                return nullptr;
+                            }
+                            operands.push_back(makeAt<AllocExpr>(token, std::move(type), nullptr));
+                            expect_operand = false;
+                            continue;
+                        }
+                        if (!expect(TokenType::COMMA, "','")) {
+                            return nullptr;
+                        }
+                        alloc_types.push_back(std::move(type));
+                        operators.push_back({FrameKind::ALLOC, token.type, 0, operands.size(), token.offset});
+                        ++open_frames;
+                        continue;
+                    }
+                }
+                if constexpr (Lang::contracts) {
+                    // \length(A) 和括号一样按边界继续解析，闭合时再包一层
+                    if (token.type == TokenType::KW_LENGTH) {
+                        advance(1);
+                        if (!expect(TokenType::LPAREN, "'('")) {
+                            return nullptr;
+                        }
+                        operators.push_back({FrameKind::LENGTH, token.type, 0, operands.size(), token.offset});
+                        ++open_frames;
+                        continue;
+                    }
+                }
+                if constexpr (Lang::structs) {
+                    // f(.x)、(->x) 这类成员访问前面没有操作数
+                    if (token.type == TokenType::DOT || token.type == TokenType::OP_ARROW) {
+                        error(advance(1), "成员访问前缺少表达式");
+                        return nullptr;
+                    }
+                }
+                auto primary = parsePrimary();
+                if (!primary) {
+                    return nullptr;
+                }
+                operands.push_back(std::move(primary));
+                expect_operand = false;
+                continue;
+            }
 
-            // --- Case A: 函数调用 '(' ---
-            if (t.type == TokenType::LPAREN) {
-                advance(1); // 消耗 '('
+            // --- 函数调用 '(' ---
+            // 将当前的操作数作为被调用者，这样支持链式调用，如 getFunc()(arg)
+            if (token.type == TokenType::LPAREN) {
+                advance(1);
+                operators.push_back({FrameKind::CALL, token.type, 0, operands.size(), token.offset});
+                ++open_frames;
+                // 如果不是立即闭合 ')'，说明有参数
+                expect_operand = peek(0).type != TokenType::RPAREN;
+                continue;
+            }
 
-                std::vector<std::shared_ptr<Expression>> args;
+            // --- 数组下标 '[' ---
+            if constexpr (Lang::arrays) {
+                if (token.type == TokenType::LBRACKET) {
+                    advance(1);
+                    operators.push_back({FrameKind::SUBSCRIPT, token.type, 0, operands.size(), token.offset});
+                    ++open_frames;
+                    expect_operand = true;
+                    continue;
+                }
+                if (token.type == TokenType::RBRACKET && open_frames > 0) {
+                    if (!reduceToFrame<Lang>(operators, operands, memory_resource) ||
+                        operators.back().kind != FrameKind::SUBSCRIPT ||
+                        operands.size() != operators.back().operand_base + 1) {
+                        error(token, "此处不能出现 ']'");
+                        return nullptr;
+                    }
+                    uint32_t offset = operators.back().offset;
+                    operators.pop_back();
+                    --open_frames;
+                    advance(1);
+                    auto index = std::move(operands.back());
+                    operands.pop_back();
+                    operands.back() = make<ArraySubscriptExpr>(std::move(operands.back()), std::move(index));
+                    operands.back()->offset = offset;
+                    continue;
+                }
+            }
 
-                // 如果不是立即闭合 ')'，说明有参数
-                if (peek(0).type != TokenType::RPAREN) {
-                    args.push_back(parseExpression()); // 解析第一个参数
+            // --- 成员访问 '.' 和 '->'，和调用、下标一样直接作用在当前操作数上 ---
+            if constexpr (Lang::structs) {
+                if (token.type == TokenType::DOT || token.type == TokenType::OP_ARROW) {
+                    // 作用对象必须是最近的边界打开之后读到的操作数，不能是边界外面的被调用者或数组
+                    if (operands.size() <= innermostOperandBase(operators)) {
+                        error(advance(1), "成员访问前缺少表达式");
+                        return nullptr;
+                    }
+                    advance(1);
+                    Token member = advance(1);
+                    if (member.type != TokenType::IDENTIFIER) {
+                        error(member, "应为成员名");
+                        return nullptr;
+                    }
+                    operands.back() = makeAt<MemberExpr>(token, std::move(operands.back()), getSpelling(member),
+                                                         token.type == TokenType::OP_ARROW);
+                    continue;
+                }
+            }
 
-                    // 解析后续参数 (被 ',' 分隔)
-                    while (match(TokenType::COMMA)) {
-                        args.push_back(parseExpression());
+            // --- 条件运算符 '?' ':'，'?' 到 ':' 之间是一个独立的边界 ---
+            if constexpr (Lang::control_flow) {
+                if (token.type == TokenType::QUESTION) {
+                    while (!operators.empty() && isOperatorFrame(operators.back()) &&
+                           operators.back().precedence > kConditionalPrecedence) {
+                        if (!reduceTop<Lang>(operators, operands, memory_resource)) {
+                            return nullptr;
+                        }
                     }
+                    advance(1);
+                    operators.push_back({FrameKind::TERNARY, token.type, 0, operands.size(), token.offset});
+                    ++open_frames;
+                    expect_operand = true;
+                    continue;
                 }
+                if (token.type == TokenType::COLON && open_frames > 0) {
+                    if (!reduceToFrame<Lang>(operators, operands, memory_resource) ||
+                        operators.back().kind != FrameKind::TERNARY ||
+                        operands.size() != operators.back().operand_base + 1) {
+                        error(token, "此处不能出现 ':'");
+                        return nullptr;
+                    }
+                    // 右结合：之后的 ?: 不会把这里归约掉，条件表达式的位置仍然是 '?'
+                    operators.back() = {FrameKind::CONDITIONAL, token.type, kConditionalPrecedence, 0,
+                                        operators.back().offset};
+                    --open_frames;
+                    advance(1);
+                    expect_operand = true;
+                    continue;
+                }
+            }
 
-                if (!match(TokenType::RPAREN)) {
-                    // TODO: 报错 "Expect ')'
+            // --- 参数分隔符 ',' 只在调用内部有意义 ---
+            if (token.type == TokenType::COMMA && open_frames > 0) {
+                if (!reduceToFrame<Lang>(operators, operands, memory_resource) ||
+                    operators.back().kind != FrameKind::CALL) {
+                    error(token, "括号表达式中不能出现 ','");
                     return nullptr;
                 }
+                advance(1);
+                expect_operand = true;
+                continue;
+            }
 
-                // 将当前的 expr 包装进 CallExpr，并更新 expr
-                // 这样支持链式调用，如 getFunc()(arg)
-                expr = std::make_shared<CallExpr>(expr, std::move(args));
+            // --- 闭合括号或调用 ')' ---
+            // 没有未闭合的边界时，')' 属于外层语法（如 if 条件），表达式到此结束
+            if (token.type == TokenType::RPAREN && open_frames > 0) {
+                if (!reduceToFrame<Lang>(operators, operands, memory_resource)) {
+                    return nullptr;
+                }
+                OperatorFrame frame = operators.back();
+                if (frame.kind == FrameKind::SUBSCRIPT || frame.kind == FrameKind::TERNARY) {
+                    error(token, frame.kind == FrameKind::SUBSCRIPT ? "缺少 ']'" : "缺少 ':'");
+                    return nullptr;
+                }
+                operators.pop_back();
+                --open_frames;
+                advance(1);
+                if (frame.kind == FrameKind::CALL) {
+                    std::vector<std::shared_ptr<Expression>> args(
+                        std::make_move_iterator(operands.begin() + static_cast<std::ptrdiff_t>(frame.operand_base)),
+                        std::make_move_iterator(operands.end()));
+                    operands.resize(frame.operand_base);
+                    // 调用的位置是被调用者
+                    uint32_t offset = operands.back()->offset;
+                    operands.back() = make<CallExpr>(operands.back(), std::move(args));
+                    operands.back()->offset = offset;
+                } else if (operands.size() != frame.operand_base + 1) {
+                    error(token, "应为表达式");
+                    return nullptr;
+                } else if (frame.kind == FrameKind::ALLOC) {
+                    operands.back() = make<AllocExpr>(std::move(alloc_types.back()), std::move(operands.back()));
+                    alloc_types.pop_back();
+                    operands.back()->offset = frame.offset;
+                } else if (frame.kind == FrameKind::LENGTH) {
+                    operands.back() = make<LengthExpr>(std::move(operands.back()));
+                    operands.back()->offset = frame.offset;
+                }
+                continue;
             }
 
-            // --- 既不是调用也不是下标，后缀解析结束 ---
-            else {
+            // --- 二元运算符 ---
+            const OperatorInfo& info = getOperatorInfo<Lang>(token.type);
+            if (info.infix_precedence == 0) {
+                // 既不是运算符也不是调用，表达式解析结束
                 break;
             }
+            while (!operators.empty() && isOperatorFrame(operators.back())) {
+                uint8_t top = operators.back().precedence;
+                bool reduce = top > info.infix_precedence ||
+                              (top == info.infix_precedence && info.associativity == Associativity::LEFT);
+                if (!reduce) {
+                    break;
+                }
+                if (!reduceTop<Lang>(operators, operands, memory_resource)) {
+                    return nullptr;
+                }
+            }
+            operators.push_back({FrameKind::INFIX, token.type, info.infix_precedence, 0, token.offset});
+            advance(1);
+            expect_operand = true;
         }
 
-        return expr;
+        if (open_frames > 0) {
+            reduceToFrame<Lang>(operators, operands, memory_resource);
+            switch (operators.back().kind) {
+            case FrameKind::SUBSCRIPT:
+                error(peek(0), "缺少 ']'");
+                break;
+            case FrameKind::TERNARY:
+                error(peek(0), "缺少 ':'");
+                break;
+            default:
+                error(peek(0), "缺少 ')'");
+                break;
+            }
+            return nullptr;
+        }
+        if (!reduceToFrame<Lang>(operators, operands, memory_resource) || operands.size() != 1) {
+            return nullptr;
+        }
+        return operands.back();
     }
 
-    std::shared_ptr<Expression> C0Parser::parsePrimary() {
+    template <typename Lang>
+    std::shared_ptr<Expression> BasicC0Parser<Lang>::parsePrimary() {
         Token token = advance(1); // 获取并消耗当前 Token
 
         switch (token.type) {
         case TokenType::INT_LITERAL:
-            return std::make_shared<IntegerLiteralExpr>(std::stoi(token.lexeme));
+            return makeAt<IntegerLiteralExpr>(token, token.intValue());
         case TokenType::CHAR_LITERAL:
-            return std::make_shared<CharLiteralExpr>(token.lexeme[0]);
+            return makeAt<CharLiteralExpr>(token, token.charValue());
         case TokenType::STRING_LITERAL:
-            return std::make_shared<StringLiteralExpr>(token.lexeme);
+            return makeAt<StringLiteralExpr>(token, lexer->getStringLiteral(token));
         case TokenType::BOOL_LITERAL:
-            return std::make_shared<BoolLiteralExpr>(token.lexeme == "true");
+            return makeAt<BoolLiteralExpr>(token, token.payload != 0);
+        case TokenType::KW_TRUE:
+            return makeAt<BoolLiteralExpr>(token, true);
+        case TokenType::KW_FALSE:
+            return makeAt<BoolLiteralExpr>(token, false);
+        case TokenType::KW_NULL:
+            return makeAt<NullLiteralExpr>(token);
         case TokenType::IDENTIFIER:
-            return std::make_shared<IdentifierExpr>(token.lexeme);
-        case TokenType::LPAREN: {
-            // 处理括号中的表达式 (expr)
-            auto expr = parseExpression();
-            if (peek(0).type != TokenType::RPAREN) {
-                // TODO: 错误处理 "Expect ')'"
-                return nullptr;
+            return makeAt<IdentifierExpr>(token, getSpelling(token));
+        case TokenType::KW_RESULT:
+            if (!in_ensures) {
+                error(token, "\\result 只能出现在 //@ensures 中");
             }
-            else {
-                advance(1); // 消耗 ')'
-            }
-            return expr;
-        }
-
+            return makeAt<ResultExpr>(token);
         default:
-            // TODO: 错误处理
+            error(token, "应为表达式");
             return nullptr;
         }
     }
 
-    int C0Parser::getInfixPrecedence(TokenType type) {
-        switch (type) {
-        case TokenType::OP_ASSIGN:
-            return 1;  // =
-        case TokenType::OP_OR:
-            return 2;  // ||
-        case TokenType::OP_AND:
-            return 3;  // &&
-        case TokenType::OP_EQ:
-        case TokenType::OP_NE:
-            return 4;  // == !=
-        case TokenType::OP_LT:
-        case TokenType::OP_GT:
-        case TokenType::OP_LE:
-        case TokenType::OP_GE:
-            return 5;  // < > <= >=
-        case TokenType::OP_PLUS:
-        case TokenType::OP_MINUS:
-            return 6;  // + -
-        case TokenType::OP_MULTIPLY:
-        case TokenType::OP_DIVIDE:
-        case TokenType::OP_MODULO:
-            return 7;  // * / %
+    template <typename Lang>
+    std::string BasicC0Parser<Lang>::parseType() {
+        Token token = advance(1);
+        std::string type;
+        switch (token.type) {
+        case TokenType::KW_INT:
+        case TokenType::KW_BOOL:
+        case TokenType::KW_VOID:
+        case TokenType::KW_CHAR:
+        case TokenType::KW_STRING:
+            type = getSpelling(token);
+            break;
+        case TokenType::KW_STRUCT: {
+            Token name = advance(1);
+            if (name.type != TokenType::IDENTIFIER) {
+                error(name, "应为结构体名");
+            }
+            type = "struct " + getSpelling(name);
+            break;
+        }
         default:
-            return 0;  // 0 表示“不是中缀运算符”
+            if (!isTypeSpecifier(token)) {
+                error(token, "应为类型");
+            }
+            type = getSpelling(token);
+            break;
+        }
+
+        while (true) {
+            if constexpr (Lang::pointers) {
+                if (peek(0).type == TokenType::OP_MULTIPLY) {
+                    advance(1);
+                    type += '*';
+                    continue;
+                }
+            }
+            if constexpr (Lang::arrays) {
+                if (peek(0).type == TokenType::LBRACKET && peek(1).type == TokenType::RBRACKET) {
+                    advance(2);
+                    type += "[]";
+                    continue;
+                }
+            }
+            break;
         }
+        return type;
     }
 
-    bool C0Parser::isRightAssociative(TokenType type) {
-        // 比如赋值、指数这些是右结合的
-        switch (type) {
-        case TokenType::OP_ASSIGN:
-        case TokenType::OP_MULTIPLY_ASSIGN:
-        case TokenType::OP_DIVIDE_ASSIGN:
-        case TokenType::OP_MODULO_ASSIGN:
-        case TokenType::OP_PLUS_ASSIGN:
-        case TokenType::OP_MINUS_ASSIGN:
-        case TokenType::OP_LOGICAL_AND:
-        case TokenType::OP_LOGICAL_OR:
-        case TokenType::OP_XOR:
-            return true;
-        default:
-            return false;
+    template <typename Lang>
+    std::shared_ptr<Expression> BasicC0Parser<Lang>::parsePostfixIncrement(std::shared_ptr<Expression> expr) {
+        if constexpr (Lang::control_flow) {
+            Token op = peek(0);
+            if (op.type == TokenType::OP_INCREMENT || op.type == TokenType::OP_DECREMENT) {
+                advance(1);
+                if (!expr) {
+                    return nullptr;
+                }
+                return makeAt<AssignmentExpr>(op, std::move(expr), makeAt<IntegerLiteralExpr>(op, 1),
+                                              op.type == TokenType::OP_INCREMENT ? TokenType::OP_PLUS_ASSIGN
+                                                                                 : TokenType::OP_MINUS_ASSIGN);
+            }
         }
+        return expr;
     }
 
-    std::shared_ptr<Declaration> C0Parser::parseDeclaration() {
-        if (peek(0).type == TokenType::KW_STRUCT) {
-            return parseStructDeclaration();
+    template <typename Lang>
+    std::shared_ptr<Declaration> BasicC0Parser<Lang>::parseDeclaration() {
+        if constexpr (Lang::libraries) {
+            if (peek(0).type == TokenType::USE_LIBRARY || peek(0).type == TokenType::USE_FILE) {
+                return parseUseDirective();
+            }
+            seen_declaration = true;
         }
-        Token mark = peek(2);
-        if (mark.type == TokenType::LPAREN) {
-            return parseFunctionDeclaration();
+        if constexpr (Lang::functions) {
+            if (peek(0).type == TokenType::KW_TYPEDEF) {
+                return parseTypedefDeclaration();
+            }
+        }
+        if constexpr (Lang::structs) {
+            if (peek(0).type == TokenType::KW_STRUCT &&
+                (peek(2).type == TokenType::LBRACE || peek(2).type == TokenType::SEMICOLON)) {
+                return parseStructDeclaration();
+            }
+        }
+        if constexpr (Lang::contracts) {
+            if (peek(0).type == TokenType::ANNOT_BEGIN) {
+                parseAnnotations(0, "声明之间");
+                return nullptr;
+            }
         }
-        else if (mark.type == TokenType::END_OF_FILE) {
+        std::string type = parseType();
+        Token name = advance(1);
+        if (name.type == TokenType::END_OF_FILE) {
+            error(name, "声明不完整");
             return nullptr;
         }
-        return parseVariableDeclaration();
+        if (peek(0).type == TokenType::LPAREN) {
+            return parseFunctionDeclaration(std::move(type), name);
+        }
+        return parseVariableDeclaration(std::move(type), name);
     }
 
-    std::shared_ptr<Declaration> C0Parser::parseFunctionDeclaration() {
-        Token type = advance(1);
-        Token name = advance(1);
-        advance(1); // 跳过 '('
+    template <typename Lang>
+    std::shared_ptr<Declaration> BasicC0Parser<Lang>::parseFunctionDeclaration(std::string returnType,
+                                                                               const Token& name) {
+        expect(TokenType::LPAREN, "'('");
 
         std::vector<std::shared_ptr<VariableDecl>> params;
-        while (peek(0).type != TokenType::RPAREN) {
+        while (peek(0).type != TokenType::RPAREN && peek(0).type != TokenType::END_OF_FILE) {
+            if (!isTypeSpecifier(peek(0))) {
+                // 参数列表没有闭合，例如 "int f( {"，交给后面的 ')' 检查报错
+                error(peek(0), "应为参数类型");
+                break;
+            }
             auto param = parseParamDecl(); // 只吃 "type name" 和可能的逗号
             params.push_back(param);
         }
-        if (peek(0).type == TokenType::RPAREN) {
-            advance(1);
-        } else {
-            // TODO: 错误处理
-        }
-        std::shared_ptr<Statement> body = parseCompoundStmt();
-        return std::make_shared<FunctionDecl>(
-            name.lexeme,
-            type.lexeme,
+        expect(TokenType::RPAREN, "')'");
+        std::vector<Contract> contracts;
+        if constexpr (Lang::contracts) {
+            contracts = parseAnnotations(contractMask(ContractKind::REQUIRES) | contractMask(ContractKind::ENSURES),
+                                         "函数头之后");
+        }
+        // 只有原型没有函数体，例如库的接口声明
+        std::shared_ptr<Statement> body = nullptr;
+        if (!match(TokenType::SEMICOLON)) {
+            body = parseCompoundStmt();
+        }
+        auto function = makeAt<FunctionDecl>(
+            name,
+            getSpelling(name),
+            std::move(returnType),
             params,
             INFRA::dyn_cast<CompoundStmt>(body)
         );
+        function->contracts = std::move(contracts);
+        return function;
     }
 
-    std::shared_ptr<VariableDecl> C0Parser::parseParamDecl() {
-        Token type = advance(1);
+    template <typename Lang>
+    std::shared_ptr<VariableDecl> BasicC0Parser<Lang>::parseParamDecl() {
+        std::string type = parseType();
         Token name = advance(1);
+        if (name.type != TokenType::IDENTIFIER) {
+            error(name, "应为参数名");
+        }
         if (peek(0).type == TokenType::COMMA) {
             advance(1);
         }
-        else {
-            //TODO: 错误处理
+        else if (peek(0).type != TokenType::RPAREN) {
+            error(peek(0), "参数之间缺少 ','");
         }
-        return std::make_shared<VariableDecl>(name.lexeme, type.lexeme, nullptr);
+        return makeAt<VariableDecl>(name, getSpelling(name), std::move(type), nullptr);
     }
 
-    std::shared_ptr<Declaration> C0Parser::parseVariableDeclaration() {
-        Token type = advance(1);
-        Token name = advance(1);
+    template <typename Lang>
+    std::shared_ptr<Declaration> BasicC0Parser<Lang>::parseVariableDeclaration(std::string type, const Token& name) {
+        if (name.type != TokenType::IDENTIFIER) {
+            error(name, "应为变量名");
+        }
 
         std::shared_ptr<Expression> initializer = nullptr;
 
-        if (peek(0).type == TokenType::OP_EQ) {
+        if (peek(0).type == TokenType::OP_ASSIGN) {
             advance(1);
             initializer = parseExpression();
         }
@@ -248,30 +576,114 @@ namespace CC {
             advance(1); // 吃掉结束符号
             break;
         default:
-            // 以后可以在这里做错误处理
+            error(endTok, "变量声明后缺少 ';'");
             break;
         }
-        return std::make_shared<VariableDecl>(name.lexeme, type.lexeme, initializer);
+        return makeAt<VariableDecl>(name, getSpelling(name), std::move(type), initializer);
     }
 
-    std::shared_ptr<Declaration> C0Parser::parseStructDeclaration() {
+    template <typename Lang>
+    std::shared_ptr<Declaration> BasicC0Parser<Lang>::parseStructDeclaration() {
         advance(1); // 吃掉 'struct'
         Token name = advance(1);
-        advance(1); // 吃掉 '{'
+        if (name.type != TokenType::IDENTIFIER) {
+            error(name, "应为结构体名");
+        }
+        if (match(TokenType::SEMICOLON)) {
+            // 前置声明 struct name;
+            return makeAt<StructDecl>(name, getSpelling(name), std::vector<std::shared_ptr<VariableDecl>>{}, false);
+        }
+        expect(TokenType::LBRACE, "'{'");
         std::vector<std::shared_ptr<VariableDecl>> members;
-        while (peek(0).type != TokenType::RBRACE) {
-            auto member = parseVariableDeclaration();
+        while (peek(0).type != TokenType::RBRACE && peek(0).type != TokenType::END_OF_FILE) {
+            std::string type = parseType();
+            Token member_name = advance(1);
+            auto member = parseVariableDeclaration(std::move(type), member_name);
             if (auto memberDecl = INFRA::dyn_cast<VariableDecl>(member)) {
                 members.push_back(std::move(memberDecl));
             }
         }
-        advance(1); // 吃掉 '}'
-        advance(1); // 吃掉 ';'
-        return std::make_shared<StructDecl>(name.lexeme, members);
+        expect(TokenType::RBRACE, "'}'");
+        expect(TokenType::SEMICOLON, "';'");
+        return makeAt<StructDecl>(name, getSpelling(name), members);
     }
 
-    std::shared_ptr<Statement> C0Parser::parseStatement() {
+    template <typename Lang>
+    std::shared_ptr<Declaration> BasicC0Parser<Lang>::parseTypedefDeclaration() {
+        advance(1); // 吃掉 'typedef'
+        std::string type = parseType();
+        Token name = advance(1);
+        if (name.type != TokenType::IDENTIFIER) {
+            error(name, "应为类型名");
+        } else {
+            typedef_names.insert(lexer->getLexeme(name));
+        }
+        expect(TokenType::SEMICOLON, "';'");
+        return makeAt<TypedefDecl>(name, getSpelling(name), std::move(type));
+    }
+
+    template <typename Lang>
+    std::shared_ptr<Declaration> BasicC0Parser<Lang>::parseUseDirective() {
+        Token token = advance(1);
+        bool isLibrary = token.type == TokenType::USE_LIBRARY;
+        if (seen_declaration) {
+            error(token, "#use 必须出现在所有声明之前");
+        }
+        std::shared_ptr<const LibraryInterface> library;
+        if (isLibrary) {
+            if (libraries) {
+                library = libraries->find(lexer->getLexeme(token));
+            }
+            if (!library) {
+                error(token, "找不到库 <" + getSpelling(token) + ">");
+            } else {
+                for (size_t i = 0; i < library->getTypedefCount(); ++i) {
+                    typedef_names.insert(library->getTypedef(i).name);
+                }
+                used_libraries.push_back(library);
+            }
+        }
+        return makeAt<UseDecl>(token, getSpelling(token), isLibrary, std::move(library));
+    }
+
+    template <typename Lang>
+    std::shared_ptr<Statement> BasicC0Parser<Lang>::parseStatement() {
         Token token = peek(0);
+        // 语句的解析是递归的，嵌套过深时不再深入，整条语句跳过
+        if (statement_depth >= kMaxStatementDepth) {
+            error(token, "语句嵌套超过 " + std::to_string(kMaxStatementDepth) + " 层");
+            skipStatement();
+            return make<NullStmt>();
+        }
+        ++statement_depth;
+        auto statement = parseStatementBody(token);
+        --statement_depth;
+        statement->offset = token.offset;
+        return statement;
+    }
+
+    template <typename Lang>
+    void BasicC0Parser<Lang>::skipStatement() {
+        size_t depth = 0;
+        while (peek(0).type != TokenType::END_OF_FILE) {
+            TokenType type = peek(0).type;
+            if (type == TokenType::RBRACE && depth == 0) {
+                // 属于外层的代码块
+                return;
+            }
+            advance(1);
+            if (type == TokenType::LBRACE) {
+                ++depth;
+            } else if (type == TokenType::RBRACE && --depth == 0) {
+                return;
+            } else if (type == TokenType::SEMICOLON && depth == 0) {
+                return;
+            }
+        }
+    }
+
+    template <typename Lang>
+    std::shared_ptr<Statement> BasicC0Parser<Lang>::parseStatementBody(const Token& token) {
         switch (token.type) {
         case TokenType::LBRACE: {
             auto compoundStmt = parseCompoundStmt();
@@ -287,201 +699,238 @@ namespace CC {
             return parseDowhileStmt();
         case TokenType::KW_CONTINUE:
             advance(1);
-            if (peek(0).type != TokenType::SEMICOLON) {
-                //TODO: 错误处理
-            }
-            else {
-                advance(1);
-            }
-            return std::make_shared<ContinueStmt>();
+            expect(TokenType::SEMICOLON, "';'");
+            return make<ContinueStmt>();
         case TokenType::KW_BREAK:
             advance(1);
-            if (peek(0).type != TokenType::SEMICOLON) {
-                //TODO: 错误处理
-            }
-            else {
-                advance(1);
-            }
-            return std::make_shared<BreakStmt>();
+            expect(TokenType::SEMICOLON, "';'");
+            return make<BreakStmt>();
         case TokenType::KW_RETURN:
             return parseReturnStmt();
         case TokenType::SEMICOLON:
             // 空语句
             advance(1);
-            return std::make_shared<NullStmt>();
+            return make<NullStmt>();
+        case TokenType::ANNOT_BEGIN:
+            if constexpr (Lang::contracts) {
+                return parseAnnotationStmt();
+            }
+            break;
         default:
             break;
         }
 
         if (isTypeSpecifier(token)) {
-            return std::make_shared<DeclStmt>(parseDeclaration());
-        }
-        auto expr = parseExpression();
-        if (peek(0).type != TokenType::SEMICOLON) {
-            //TODO: 错误处理
+            return make<DeclStmt>(parseDeclaration());
         }
-        else {
-            advance(1);
-        }
-        return std::make_shared<ExpressionStmt>(expr);
+        auto expr = parsePostfixIncrement(parseExpression());
+        expect(TokenType::SEMICOLON, "';'");
+        return make<ExpressionStmt>(expr);
     }
 
-    std::shared_ptr<Statement> C0Parser::parseCompoundStmt() {
-        Token lbrace = peek(0);
-        if (lbrace.type != TokenType::LBRACE) {
-            //TODO: 错误处理
-        }
-        else {
-            advance(1);
-        }
+    template <typename Lang>
+    std::shared_ptr<Statement> BasicC0Parser<Lang>::parseCompoundStmt() {
+        Token brace = peek(0);
+        expect(TokenType::LBRACE, "'{'");
         std::vector<std::shared_ptr<Statement>> statements;
         while (peek(0).type != TokenType::RBRACE && peek(0).type != TokenType::END_OF_FILE) {
             auto stmt = parseStatement();
             statements.push_back(stmt);
         }
-        if (peek(0).type != TokenType::RBRACE) {
-            //TODO: 错误处理
-        }
-        advance(1);
+        expect(TokenType::RBRACE, "'}'");
 
-        return std::make_shared<CompoundStmt>(std::move(statements));
+        return makeAt<CompoundStmt>(brace, std::move(statements));
     }
 
-    std::shared_ptr<Statement> C0Parser::parseIfStmt() {
-        Token token = peek(0);
-        if (token.type != TokenType::KW_IF) {
-            //TODO: 错误处理
-        }
+    template <typename Lang>
+    std::shared_ptr<Statement> BasicC0Parser<Lang>::parseIfStmt() {
         advance(1); // 吃掉 'if'
-        if (peek(0).type != TokenType::LPAREN) {
-            //TODO: 错误处理
-        }
-        advance(1); // 吃掉 '('
+        expect(TokenType::LPAREN, "'('");
         auto expr = parseExpression();
-        if (peek(0).type != TokenType::RPAREN) {
-            //TODO: 错误处理
-        }
-        advance(1); // 吃掉 ')'
+        expect(TokenType::RPAREN, "')'");
         auto stmt = parseStatement();
         std::shared_ptr<Statement> elseStmt = nullptr;
         if (peek(0).type == TokenType::KW_ELSE) {
             advance(1); // 吃掉 'else'
             elseStmt = parseStatement();
         }
-        return std::make_shared<IfStmt>(expr, stmt, elseStmt);
+        return make<IfStmt>(expr, stmt, elseStmt);
     }
 
-    std::shared_ptr<Statement> C0Parser::parseWhileStmt() {
-        Token token = peek(0);
-        if (token.type != TokenType::KW_WHILE) {
-            //TODO: 错误处理
-        }
-        advance(1);
-        if (peek(0).type != TokenType::LPAREN) {
-            //TODO: 错误处理
-        }
-        advance(1);
+    template <typename Lang>
+    std::shared_ptr<Statement> BasicC0Parser<Lang>::parseWhileStmt() {
+        advance(1); // 吃掉 'while'
+        expect(TokenType::LPAREN, "'('");
         auto expr = parseExpression();
-        if (peek(0).type != TokenType::RPAREN) {
-            //TODO: 错误处理
+        expect(TokenType::RPAREN, "')'");
+        std::vector<Contract> invariants;
+        if constexpr (Lang::contracts) {
+            invariants = parseAnnotations(contractMask(ContractKind::LOOP_INVARIANT), "循环头之后");
         }
-        advance(1);
         auto stmt = parseStatement();
-        return std::make_shared<WhileStmt>(expr, stmt);
+        auto loop = make<WhileStmt>(expr, stmt);
+        loop->invariants = std::move(invariants);
+        return loop;
     }
 
-    std::shared_ptr<Statement> C0Parser::parseForStmt() {
-        Token token = peek(0);
-        if (token.type != TokenType::KW_FOR) {
-            //TODO: 错误处理
-        }
-        advance(1);
-        if (peek(0).type != TokenType::LPAREN) {
-            //TODO: 错误处理
-        }
-        advance(1); // 吃掉 '('
+    template <typename Lang>
+    std::shared_ptr<Statement> BasicC0Parser<Lang>::parseForStmt() {
+        advance(1); // 吃掉 'for'
+        expect(TokenType::LPAREN, "'('");
 
         // 1. init 部分：可以是声明、表达式或空
         std::shared_ptr<Statement> init = nullptr;
-        if (peek(0).type != TokenType::SEMICOLON) {
-            if (isTypeSpecifier(peek(0))) {
-                init = std::make_shared<DeclStmt>(parseDeclaration());
+        if (Token token = peek(0); token.type != TokenType::SEMICOLON) {
+            if (isTypeSpecifier(token)) {
+                // 变量声明会自己吃掉结尾的 ';'
+                init = makeAt<DeclStmt>(token, parseDeclaration());
             } else {
-                init = std::make_shared<ExpressionStmt>(parseExpression());
+                init = makeAt<ExpressionStmt>(token, parseExpression());
+                expect(TokenType::SEMICOLON, "';'");
             }
+        } else {
+            advance(1); // 吃掉 ';'
         }
-        if (peek(0).type != TokenType::SEMICOLON) {
-            // TODO: 错误处理
-        }
-        advance(1); // 吃掉 ';'
 
         // 2. cond 部分：表达式或空
         std::shared_ptr<Expression> cond = nullptr;
         if (peek(0).type != TokenType::SEMICOLON) {
             cond = parseExpression();
         }
-        if (peek(0).type != TokenType::SEMICOLON) {
-            // TODO: 错误处理
-        }
-        advance(1); // 吃掉 ';'
+        expect(TokenType::SEMICOLON, "';'");
 
         // 3. step 部分：表达式或空
         std::shared_ptr<Expression> step = nullptr;
         if (peek(0).type != TokenType::RPAREN) {  // 可以为空
-            step = parseExpression();
+            step = parsePostfixIncrement(parseExpression());
         }
-
-        if (peek(0).type != TokenType::RPAREN) {
-            // TODO: 错误处理
+        expect(TokenType::RPAREN, "')'");
+        std::vector<Contract> invariants;
+        if constexpr (Lang::contracts) {
+            invariants = parseAnnotations(contractMask(ContractKind::LOOP_INVARIANT), "循环头之后");
         }
-        advance(1); // 吃掉 ')'
-
 
         auto stmt = parseStatement();
-        return std::make_shared<ForStmt>(init, cond, step, stmt);
+        auto loop = make<ForStmt>(init, cond, step, stmt);
+        loop->invariants = std::move(invariants);
+        return loop;
     }
 
-    std::shared_ptr<Statement> C0Parser::parseDowhileStmt() {
-        Token token = peek(0);
-        if (token.type != TokenType::KW_DO) {
-            //TODO: 错误处理
-        }
+    template <typename Lang>
+    std::shared_ptr<Statement> BasicC0Parser<Lang>::parseDowhileStmt() {
         advance(1); // 吃掉 'do'
         auto stmt = parseStatement();
-        if (peek(0).type != TokenType::KW_WHILE) {
-            //TODO: 错误处理
+        expect(TokenType::KW_WHILE, "'while'");
+        expect(TokenType::LPAREN, "'('");
+        auto expr = parseExpression();
+        expect(TokenType::RPAREN, "')'");
+        expect(TokenType::SEMICOLON, "';'");
+        return make<DoWhileStmt>(stmt, expr);
+    }
+
+    template <typename Lang>
+    std::shared_ptr<Statement> BasicC0Parser<Lang>::parseReturnStmt() {
+        advance(1); // 吃掉 'return'
+        std::shared_ptr<Expression> expr = nullptr;
+        if (peek(0).type != TokenType::SEMICOLON) {
+            expr = parseExpression();
         }
-        advance(1); // 吃掉 'while'
-        if (peek(0).type != TokenType::LPAREN) {
-            //TODO: 错误处理
+        expect(TokenType::SEMICOLON, "';'");
+        return make<ReturnStmt>(expr);
+    }
+
+    template <typename Lang>
+    std::vector<Contract> BasicC0Parser<Lang>::parseAnnotations(unsigned allowed, const char* where) {
+        std::vector<Contract> contracts;
+        while (peek(0).type == TokenType::ANNOT_BEGIN) {
+            advance(1); // 吃掉 '//@' 或 '/*@'
+            while (peek(0).type != TokenType::ANNOT_END && peek(0).type != TokenType::END_OF_FILE) {
+                Token keyword = advance(1);
+                ContractKind kind;
+                switch (keyword.type) {
+                case TokenType::KW_REQUIRES: kind = ContractKind::REQUIRES; break;
+                case TokenType::KW_ENSURES: kind = ContractKind::ENSURES; break;
+                case TokenType::KW_LOOP_INVARIANT: kind = ContractKind::LOOP_INVARIANT; break;
+                case TokenType::KW_ASSERT: kind = ContractKind::ASSERT; break;
+                default:
+                    error(keyword, "应为 requires、ensures、loop_invariant 或 assert");
+                    skipAnnotation();
+                    continue;
+                }
+                if ((allowed & contractMask(kind)) == 0) {
+                    error(keyword, "//@" + getSpelling(keyword) + " 不能出现在" + where);
+                }
+
+                in_ensures = kind == ContractKind::ENSURES;
+                auto condition = parseExpression();
+                in_ensures = false;
+                if (!condition || !expect(TokenType::SEMICOLON, "';'")) {
+                    skipAnnotation();
+                    continue;
+                }
+                if ((allowed & contractMask(kind)) != 0) {
+                    contracts.push_back({kind, std::move(condition), lexer->getLocation(keyword)});
+                }
+            }
+            expect(TokenType::ANNOT_END, "'@*/'");
         }
-        advance(1); // 吃掉 '('
-        auto expr = parseExpression();
-        if (peek(0).type != TokenType::RPAREN) {
-            //TODO: 错误处理
+        return contracts;
+    }
+
+    template <typename Lang>
+    std::shared_ptr<Statement> BasicC0Parser<Lang>::parseAnnotationStmt() {
+        auto contracts = parseAnnotations(contractMask(ContractKind::ASSERT), "语句中");
+        std::vector<std::shared_ptr<Statement>> asserts;
+        for (auto& contract : contracts) {
+            uint32_t offset = contract.condition->offset;
+            asserts.push_back(make<AssertStmt>(std::move(contract.condition), contract.kind, contract.location));
+            asserts.back()->offset = offset;
         }
-        advance(1); // 吃掉 ')'
-        if (peek(0).type != TokenType::SEMICOLON) {
-            //TODO: 错误处理
+        if (asserts.size() == 1) {
+            return asserts.front();
         }
-        advance(1); // 吃掉 ';'
-        return std::make_shared<DoWhileStmt>(stmt, expr);
+        if (asserts.empty()) {
+            return make<NullStmt>();
+        }
+        return make<CompoundStmt>(std::move(asserts));
     }
 
-    std::shared_ptr<Statement> C0Parser::parseReturnStmt() {
-        Token token = peek(0);
-        if (token.type != TokenType::KW_RETURN) {
-            //TODO: 错误处理
+    template <typename Lang>
+    void BasicC0Parser<Lang>::skipAnnotation() {
+        while (peek(0).type != TokenType::ANNOT_END && peek(0).type != TokenType::END_OF_FILE) {
+            advance(1);
         }
-        advance(1);
-        std::shared_ptr<Expression> expr = nullptr;
-        if (peek(0).type != TokenType::SEMICOLON) {
-            expr = parseExpression();
+    }
+
+    template <typename Lang>
+    bool BasicC0Parser<Lang>::expect(TokenType type, const char* what) {
+        if (match(type)) {
+            return true;
         }
-        if (peek(0).type != TokenType::SEMICOLON) {
-            //TODO: 错误处理
+        error(peek(0), std::string("缺少 ") + what);
+        return false;
+    }
+
+    template <typename Lang>
+    void BasicC0Parser<Lang>::error(const Token& token, std::string message) {
+        // 同一位置只报第一个错误，避免错误恢复过程中的连锁报错
+        if (!diagnostics.empty() && last_error_offset == token.offset) {
+            return;
+        }
+        last_error_offset = token.offset;
+        if (token.type == TokenType::UNKNOWN) {
+            if (static_cast<LexError>(token.payload) == LexError::INTEGER_OUT_OF_RANGE) {
+                message = "整数字面量 " + getSpelling(token) + " 超出范围";
+            } else {
+                message = "无法识别的符号 '" + getSpelling(token) + "'";
+            }
         }
-        advance(1);
-        return std::make_shared<ReturnStmt>(expr);
+        diagnostics.push_back({lexer->getLocation(token), std::move(message)});
     }
-}
+
+    template class BasicC0Parser<LangL1>;
+    template class BasicC0Parser<LangL2>;
+    template class BasicC0Parser<LangL3>;
+    template class BasicC0Parser<LangL4>;
+    template class BasicC0Parser<LangC0>;
+}
\ No newline at end of file
@@ -0,0 +1,220 @@
+//
+// Created by 陶子杨 on 25-12-14.
+//
+
+#include "Transform/ADCE.h"
+#include "IR/IRBuilder.h"
+#include "IR/ValueTracking.h"
+#include "Infra/casting.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace CC::IR {
+    namespace {
+        /**
+         * @brief 用迭代的 Tarjan 算法找出处在环上的块：所在强连通分量不止一个块，或者有自环
+         */
+        std::vector<char> findCyclicBlocks(const CFG& cfg) {
+            constexpr uint32_t kUnvisited = UINT32_MAX;
+            uint32_t count = cfg.size();
+            std::vector<char> cyclic(count, 0);
+            std::vector<uint32_t> index(count, kUnvisited);
+            std::vector<uint32_t> low(count, 0);
+            std::vector<char> on_stack(count, 0);
+            std::vector<uint32_t> stack;
+            // (块, 下一个要看的后继)
+            std::vector<std::pair<uint32_t, uint32_t>> frames;
+            uint32_t next_index = 0;
+
+            for (uint32_t start : cfg.getReversePostOrder()) {
+                if (index[start] != kUnvisited) {
+                    continue;
+                }
+                frames.emplace_back(start, 0);
+                index[start] = low[start] = next_index++;
+                stack.push_back(start);
+                on_stack[start] = 1;
+                while (!frames.empty()) {
+                    auto& [block, position] = frames.back();
+                    auto successors = cfg.getSuccessors(block);
+                    if (position < successors.size()) {
+                        uint32_t successor = successors[position++];
+                        if (successor == block) {
+                            cyclic[block] = 1;
+                        }
+                        if (index[successor] == kUnvisited) {
+                            index[successor] = low[successor] = next_index++;
+                            stack.push_back(successor);
+                            on_stack[successor] = 1;
+                            frames.emplace_back(successor, 0);
+                        } else if (on_stack[successor]) {
+                            low[block] = std::min(low[block], index[successor]);
+                        }
+                        continue;
+                    }
+                    uint32_t finished = block;
+                    frames.pop_back();
+                    if (!frames.empty()) {
+                        uint32_t parent = frames.back().first;
+                        low[parent] = std::min(low[parent], low[finished]);
+                    }
+                    if (low[finished] != index[finished]) {
+                        continue;
+                    }
+                    bool single = stack.back() == finished;
+                    uint32_t member;
+                    do {
+                        member = stack.back();
+                        stack.pop_back();
+                        on_stack[member] = 0;
+                        if (!single) {
+                            cyclic[member] = 1;
+                        }
+                    } while (member != finished);
+                }
+            }
+            return cyclic;
+        }
+
+        /**
+         * @brief 地址只用作 STORE 的目标和 FIELD_ADDR 的基址，写进去的值永远不会被读到
+         */
+        bool isWriteOnly(const Instruction* address) {
+            for (Use* use = address->getFirstUse(); use; use = use->getNext()) {
+                const Instruction* user = use->getUser();
+                if (user->getOpcode() == Opcode::STORE && &user->getOperandUse(1) == use) {
+                    continue;
+                }
+                if (user->getOpcode() == Opcode::FIELD_ADDR && isWriteOnly(user)) {
+                    continue;
+                }
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * @brief 不管结果是否被用到都必须保留的指令
+         */
+        bool hasSideEffects(const Instruction* instruction) {
+            switch (instruction->getOpcode()) {
+            case Opcode::BR:
+            case Opcode::COND_BR:
+                return false;
+            case Opcode::LOAD:
+                return !isKnownNonNull(instruction->getOperand(0));
+            case Opcode::STORE: {
+                // 写到只写不读的 alloc 里，地址非空，不会中止也没有人能看到
+                auto address = INFRA::dyn_cast<Instruction>(instruction->getOperand(1));
+                while (address != nullptr && address->getOpcode() == Opcode::FIELD_ADDR) {
+                    address = INFRA::dyn_cast<Instruction>(address->getOperand(0));
+                }
+                return address == nullptr || address->getOpcode() != Opcode::ALLOC || !isWriteOnly(address);
+            }
+            default:
+                return !instruction->isRemovableIfUnused();
+            }
+        }
+    }
+
+    size_t ADCEPass::run(Function& function, AnalysisManager& analyses) {
+        cfg_changed = false;
+        // 不可达块里的指令可能用到可达块里的死指令，先删掉它们，分析也要跟着重算
+        size_t changes = function.removeUnreachableBlocks();
+        if (changes != 0) {
+            cfg_changed = true;
+            analyses.invalidate(function);
+        }
+        const CFG& cfg = analyses.get<CFG>(function);
+        const PostDominatorTree& post_dominators = analyses.get<PostDominatorTree>(function);
+        const ControlDependence& control = analyses.get<ControlDependence>(function);
+
+        std::vector<char> live(function.getInstructionCount(), 0);
+        std::vector<char> live_block(function.getBlocks().size(), 0);
+        std::vector<Instruction*> worklist;
+        auto mark = [&](Instruction* instruction) {
+            if (!live[instruction->getNumber()]) {
+                live[instruction->getNumber()] = 1;
+                worklist.push_back(instruction);
+            }
+        };
+
+        std::vector<char> cyclic = findCyclicBlocks(cfg);
+        for (BasicBlock* block : function.getBlocks()) {
+            // 环上的块可能一直执行下去；直接后支配点是虚拟出口的分支没有可以改跳的目标
+            Instruction* terminator = block->getTerminator();
+            if (cyclic[block->getNumber()] ||
+                (terminator->getOpcode() == Opcode::COND_BR && post_dominators.getIdom(block) == nullptr)) {
+                mark(terminator);
+            }
+            for (Instruction* instruction = block->front(); instruction; instruction = instruction->getNext()) {
+                if (hasSideEffects(instruction)) {
+                    mark(instruction);
+                }
+            }
+        }
+
+        while (!worklist.empty()) {
+            Instruction* instruction = worklist.back();
+            worklist.pop_back();
+            for (uint32_t i = 0; i < instruction->getOperandCount(); ++i) {
+                if (auto operand = INFRA::dyn_cast<Instruction>(instruction->getOperand(i))) {
+                    mark(operand);
+                }
+            }
+            if (instruction->isPhi()) {
+                // 选哪个值取决于从哪条边进来，各来源块的跳转因此都是活的
+                for (uint32_t i = 0; i < instruction->getOperandCount(); ++i) {
+                    mark(instruction->getIncomingBlock(i)->getTerminator());
+                }
+            }
+            BasicBlock* block = instruction->getParent();
+            if (!live_block[block->getNumber()]) {
+                live_block[block->getNumber()] = 1;
+                for (BasicBlock* controller : control.getControllingBlocks(block)) {
+                    mark(controller->getTerminator());
+                }
+            }
+        }
+
+        // 死指令只被死指令使用，先断开全部操作数再删，不用关心顺序
+        std::vector<Instruction*> dead;
+        std::vector<Instruction*> dead_branches;
+        for (BasicBlock* block : function.getBlocks()) {
+            for (Instruction* instruction = block->front(); instruction; instruction = instruction->getNext()) {
+                if (live[instruction->getNumber()] || instruction->getOpcode() == Opcode::BR) {
+                    continue;
+                }
+                instruction->dropOperands();
+                if (instruction->getOpcode() == Opcode::COND_BR) {
+                    dead_branches.push_back(instruction);
+                } else {
+                    dead.push_back(instruction);
+                }
+            }
+        }
+        for (Instruction* instruction : dead) {
+            instruction->eraseFromParent();
+        }
+        changes += dead.size();
+
+        // 死分支的两边最后都汇合到直接后支配点，中间的块里没有活指令，可以直接跳过去。
+        // 后支配点里的 PHI 如果是活的，各来源块的跳转就是活的，这个分支也就是活的，所以这里已经没有 PHI
+        for (Instruction* branch : dead_branches) {
+            BasicBlock* block = branch->getParent();
+            BasicBlock* target = post_dominators.getIdom(block);
+            branch->eraseFromParent();
+            IRBuilder builder(function);
+            builder.setInsertPoint(block);
+            builder.createBr(target);
+            ++changes;
+            cfg_changed = true;
+        }
+
+        if (cfg_changed) {
+            changes += function.removeUnreachableBlocks();
+        }
+        return changes;
+    }
+}
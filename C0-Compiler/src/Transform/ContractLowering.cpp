@@ -0,0 +1,1015 @@
+//
+// Created by 陶子杨 on 25-12-8.
+//
+
+#include "Transform/ContractLowering.h"
+#include "Infra/casting.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace CC {
+    namespace {
+        // 展开 ensures 时保存返回值的临时变量，用户代码中不可能出现这个名字
+        constexpr std::string_view kResultName = "\\result";
+
+        // 依次对节点的每个子表达式槽位调用 f，槽位可能为空
+        template <typename Function>
+        void forEachChild(Expression& node, Function&& f) {
+            switch (node.type) {
+            case ExpressionType::ASSIGNMENT_EXPR: {
+                auto& assign = static_cast<AssignmentExpr&>(node);
+                f(assign.left);
+                f(assign.right);
+                break;
+            }
+            case ExpressionType::BINARY_EXPR: {
+                auto& binary = static_cast<BinaryExpr&>(node);
+                f(binary.left);
+                f(binary.right);
+                break;
+            }
+            case ExpressionType::UNARY_EXPR:
+                f(static_cast<UnaryExpr&>(node).operand);
+                break;
+            case ExpressionType::CALL_EXPR: {
+                auto& call = static_cast<CallExpr&>(node);
+                f(call.callee);
+                for (auto& argument : call.arguments) {
+                    f(argument);
+                }
+                break;
+            }
+            case ExpressionType::ARRAY_SUBSCRIPT_EXPR: {
+                auto& subscript = static_cast<ArraySubscriptExpr&>(node);
+                f(subscript.base);
+                f(subscript.index);
+                break;
+            }
+            case ExpressionType::MEMBER_EXPR:
+                f(static_cast<MemberExpr&>(node).base);
+                break;
+            case ExpressionType::CONDITIONAL_EXPR: {
+                auto& conditional = static_cast<ConditionalExpr&>(node);
+                f(conditional.condition);
+                f(conditional.thenExpr);
+                f(conditional.elseExpr);
+                break;
+            }
+            case ExpressionType::ALLOC_EXPR:
+                f(static_cast<AllocExpr&>(node).count);
+                break;
+            case ExpressionType::LENGTH_EXPR:
+                f(static_cast<LengthExpr&>(node).array);
+                break;
+            default:
+                break;
+            }
+        }
+
+        // 检查条件读到的变量和内存
+        struct Uses {
+            std::vector<std::string_view> variables;
+            bool reads_memory = false;  // 解引用、下标、成员访问
+            bool impure = false;        // 含有调用、赋值或 alloc，不能当作已知条件复用
+            bool may_trap = false;      // 除法、取模或移位，操作数不合法时中止程序
+
+            // 求值时可能中止程序（算术错误、空指针、越界或者调用中的任何错误）
+            [[nodiscard]] bool canTrap() const {
+                return may_trap || reads_memory || impure;
+            }
+        };
+
+        bool isTrappingOperator(TokenType op) {
+            switch (op) {
+            case TokenType::OP_DIVIDE: case TokenType::OP_DIVIDE_ASSIGN:
+            case TokenType::OP_MODULO: case TokenType::OP_MODULO_ASSIGN:
+            case TokenType::OP_SHL: case TokenType::OP_SHL_ASSIGN:
+            case TokenType::OP_SHR: case TokenType::OP_SHR_ASSIGN:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        Uses collectUses(const Expression& root) {
+            Uses uses;
+            std::vector<Expression*> pending{const_cast<Expression*>(&root)};
+            while (!pending.empty()) {
+                Expression* node = pending.back();
+                pending.pop_back();
+                switch (node->type) {
+                case ExpressionType::IDENTIFIER_EXPR:
+                    uses.variables.emplace_back(static_cast<IdentifierExpr*>(node)->name);
+                    break;
+                case ExpressionType::RESULT_EXPR:
+                    uses.variables.push_back(kResultName);
+                    break;
+                case ExpressionType::UNARY_EXPR:
+                    uses.reads_memory |= static_cast<UnaryExpr*>(node)->op == TokenType::OP_MULTIPLY;
+                    break;
+                case ExpressionType::BINARY_EXPR:
+                    uses.may_trap |= isTrappingOperator(static_cast<BinaryExpr*>(node)->op);
+                    break;
+                case ExpressionType::ARRAY_SUBSCRIPT_EXPR:
+                case ExpressionType::MEMBER_EXPR:
+                    uses.reads_memory = true;
+                    break;
+                case ExpressionType::ASSIGNMENT_EXPR:
+                    uses.may_trap |= isTrappingOperator(static_cast<AssignmentExpr*>(node)->op);
+                    uses.impure = true;
+                    break;
+                case ExpressionType::CALL_EXPR:
+                case ExpressionType::ALLOC_EXPR:
+                    uses.impure = true;
+                    break;
+                default:
+                    break;
+                }
+                forEachChild(*node, [&](std::shared_ptr<Expression>& child) {
+                    if (child) {
+                        pending.push_back(child.get());
+                    }
+                });
+            }
+            return uses;
+        }
+
+        // 语句或表达式执行后可能被修改的东西
+        struct Effects {
+            std::unordered_set<std::string_view> assigned;  // 被赋值或重新声明的变量
+            bool writes_memory = false;                     // 通过指针/数组写内存，或者调用了函数
+        };
+
+        void collectEffects(const Expression& root, Effects& effects) {
+            std::vector<Expression*> pending{const_cast<Expression*>(&root)};
+            while (!pending.empty()) {
+                Expression* node = pending.back();
+                pending.pop_back();
+                if (node->type == ExpressionType::ASSIGNMENT_EXPR) {
+                    auto* target = static_cast<AssignmentExpr*>(node)->left.get();
+                    if (target && target->type == ExpressionType::IDENTIFIER_EXPR) {
+                        effects.assigned.insert(static_cast<IdentifierExpr*>(target)->name);
+                    } else {
+                        effects.writes_memory = true;
+                    }
+                } else if (node->type == ExpressionType::CALL_EXPR) {
+                    effects.writes_memory = true;
+                }
+                forEachChild(*node, [&](std::shared_ptr<Expression>& child) {
+                    if (child) {
+                        pending.push_back(child.get());
+                    }
+                });
+            }
+        }
+
+        void collectEffects(const std::shared_ptr<Expression>& expr, Effects& effects) {
+            if (expr) {
+                collectEffects(*expr, effects);
+            }
+        }
+
+        void collectEffects(const Statement& statement, Effects& effects) {
+            switch (statement.type) {
+            case StatementType::COMPOUND_STMT:
+                for (const auto& child : static_cast<const CompoundStmt&>(statement).statements) {
+                    collectEffects(*child, effects);
+                }
+                break;
+            case StatementType::EXPR_STMT:
+                collectEffects(static_cast<const ExpressionStmt&>(statement).expression, effects);
+                break;
+            case StatementType::IF_STMT: {
+                auto& branch = static_cast<const IfStmt&>(statement);
+                collectEffects(branch.condition, effects);
+                collectEffects(*branch.thenStmt, effects);
+                if (branch.elseStmt) {
+                    collectEffects(*branch.elseStmt, effects);
+                }
+                break;
+            }
+            case StatementType::WHILE_STMT: {
+                auto& loop = static_cast<const WhileStmt&>(statement);
+                collectEffects(loop.condition, effects);
+                collectEffects(*loop.body, effects);
+                for (const auto& invariant : loop.invariants) {
+                    collectEffects(invariant.condition, effects);
+                }
+                break;
+            }
+            case StatementType::FOR_STMT: {
+                auto& loop = static_cast<const ForStmt&>(statement);
+                if (loop.init) {
+                    collectEffects(*loop.init, effects);
+                }
+                collectEffects(loop.condition, effects);
+                collectEffects(loop.increment, effects);
+                collectEffects(*loop.body, effects);
+                for (const auto& invariant : loop.invariants) {
+                    collectEffects(invariant.condition, effects);
+                }
+                break;
+            }
+            case StatementType::DO_WHILE_STMT: {
+                auto& loop = static_cast<const DoWhileStmt&>(statement);
+                collectEffects(*loop.body, effects);
+                collectEffects(loop.condition, effects);
+                break;
+            }
+            case StatementType::RETURN_STMT:
+                collectEffects(static_cast<const ReturnStmt&>(statement).expression, effects);
+                break;
+            case StatementType::DECL_STMT: {
+                auto variable = INFRA::dyn_cast<VariableDecl>(static_cast<const DeclStmt&>(statement).declaration);
+                if (variable) {
+                    effects.assigned.insert(variable->name);
+                    collectEffects(variable->initializer, effects);
+                }
+                break;
+            }
+            case StatementType::ASSERT_STMT:
+                collectEffects(static_cast<const AssertStmt&>(statement).condition, effects);
+                break;
+            default:
+                break;
+            }
+        }
+
+        bool isChangedBy(const Uses& uses, const Effects& effects) {
+            if (uses.impure || (uses.reads_memory && effects.writes_memory)) {
+                return true;
+            }
+            return std::any_of(uses.variables.begin(), uses.variables.end(), [&](std::string_view name) {
+                return effects.assigned.count(name) != 0;
+            });
+        }
+
+        // 语句中是否有跳出当前这层循环的 break，不进入内层循环
+        bool hasBreak(const Statement& statement) {
+            switch (statement.type) {
+            case StatementType::BREAK_STMT:
+                return true;
+            case StatementType::COMPOUND_STMT: {
+                const auto& statements = static_cast<const CompoundStmt&>(statement).statements;
+                return std::any_of(statements.begin(), statements.end(), [](const auto& child) {
+                    return hasBreak(*child);
+                });
+            }
+            case StatementType::IF_STMT: {
+                auto& branch = static_cast<const IfStmt&>(statement);
+                return hasBreak(*branch.thenStmt) || (branch.elseStmt && hasBreak(*branch.elseStmt));
+            }
+            default:
+                return false;
+            }
+        }
+
+        // 语句执行完后是否一定不会落到下一条语句
+        bool endsAbruptly(const Statement& statement) {
+            switch (statement.type) {
+            case StatementType::RETURN_STMT:
+            case StatementType::BREAK_STMT:
+            case StatementType::CONTINUE_STMT:
+                return true;
+            case StatementType::COMPOUND_STMT: {
+                const auto& statements = static_cast<const CompoundStmt&>(statement).statements;
+                return !statements.empty() && endsAbruptly(*statements.back());
+            }
+            case StatementType::IF_STMT: {
+                auto& branch = static_cast<const IfStmt&>(statement);
+                return branch.elseStmt && endsAbruptly(*branch.thenStmt) && endsAbruptly(*branch.elseStmt);
+            }
+            default:
+                return false;
+            }
+        }
+
+        // 结构相同的两个表达式
+        bool sameExpression(const Expression& a, const Expression& b) {
+            std::vector<std::pair<Expression*, Expression*>> pending{
+                {const_cast<Expression*>(&a), const_cast<Expression*>(&b)}};
+            std::vector<Expression*> left_children;
+            std::vector<Expression*> right_children;
+            while (!pending.empty()) {
+                auto [x, y] = pending.back();
+                pending.pop_back();
+                if (!x || !y) {
+                    if (x != y) {
+                        return false;
+                    }
+                    continue;
+                }
+                if (x->type != y->type) {
+                    return false;
+                }
+                bool same = true;
+                switch (x->type) {
+                case ExpressionType::BINARY_EXPR:
+                    same = static_cast<BinaryExpr*>(x)->op == static_cast<BinaryExpr*>(y)->op;
+                    break;
+                case ExpressionType::UNARY_EXPR:
+                    same = static_cast<UnaryExpr*>(x)->op == static_cast<UnaryExpr*>(y)->op;
+                    break;
+                case ExpressionType::ASSIGNMENT_EXPR:
+                    same = static_cast<AssignmentExpr*>(x)->op == static_cast<AssignmentExpr*>(y)->op;
+                    break;
+                case ExpressionType::IDENTIFIER_EXPR:
+                    same = static_cast<IdentifierExpr*>(x)->name == static_cast<IdentifierExpr*>(y)->name;
+                    break;
+                case ExpressionType::INTEGER_LITERAL_EXPR:
+                    same = static_cast<IntegerLiteralExpr*>(x)->value == static_cast<IntegerLiteralExpr*>(y)->value;
+                    break;
+                case ExpressionType::CHAR_LITERAL_EXPR:
+                    same = static_cast<CharLiteralExpr*>(x)->value == static_cast<CharLiteralExpr*>(y)->value;
+                    break;
+                case ExpressionType::BOOL_LITERAL_EXPR:
+                    same = static_cast<BoolLiteralExpr*>(x)->value == static_cast<BoolLiteralExpr*>(y)->value;
+                    break;
+                case ExpressionType::STRING_LITERAL_EXPR:
+                    same = static_cast<StringLiteralExpr*>(x)->value == static_cast<StringLiteralExpr*>(y)->value;
+                    break;
+                case ExpressionType::FLOAT_LITERAL_EXPR:
+                    same = static_cast<FloatLiteralExpr*>(x)->value == static_cast<FloatLiteralExpr*>(y)->value;
+                    break;
+                case ExpressionType::MEMBER_EXPR:
+                    same = static_cast<MemberExpr*>(x)->member == static_cast<MemberExpr*>(y)->member &&
+                           static_cast<MemberExpr*>(x)->arrow == static_cast<MemberExpr*>(y)->arrow;
+                    break;
+                case ExpressionType::ALLOC_EXPR:
+                    same = static_cast<AllocExpr*>(x)->elementType == static_cast<AllocExpr*>(y)->elementType;
+                    break;
+                default:
+                    break;
+                }
+                if (!same) {
+                    return false;
+                }
+                left_children.clear();
+                right_children.clear();
+                forEachChild(*x, [&](std::shared_ptr<Expression>& child) { left_children.push_back(child.get()); });
+                forEachChild(*y, [&](std::shared_ptr<Expression>& child) { right_children.push_back(child.get()); });
+                if (left_children.size() != right_children.size()) {
+                    return false;
+                }
+                for (size_t i = 0; i < left_children.size(); ++i) {
+                    pending.emplace_back(left_children[i], right_children[i]);
+                }
+            }
+            return true;
+        }
+
+        // 交换两边之后等价的比较运算符，例如 a < b 和 b > a
+        std::optional<TokenType> mirroredComparison(TokenType op) {
+            switch (op) {
+            case TokenType::OP_LT: return TokenType::OP_GT;
+            case TokenType::OP_GT: return TokenType::OP_LT;
+            case TokenType::OP_LE: return TokenType::OP_GE;
+            case TokenType::OP_GE: return TokenType::OP_LE;
+            case TokenType::OP_EQ: return TokenType::OP_EQ;
+            case TokenType::OP_NE: return TokenType::OP_NE;
+            default: return std::nullopt;
+            }
+        }
+
+        // 相同，或者是两边交换过的同一个比较
+        bool equivalentCondition(const Expression& a, const Expression& b) {
+            if (sameExpression(a, b)) {
+                return true;
+            }
+            auto x = INFRA::dyn_cast<BinaryExpr>(&a);
+            auto y = INFRA::dyn_cast<BinaryExpr>(&b);
+            if (!x || !y || !x->left || !x->right || !y->left || !y->right) {
+                return false;
+            }
+            auto mirrored = mirroredComparison(x->op);
+            return mirrored && *mirrored == y->op &&
+                   sameExpression(*x->left, *y->right) && sameExpression(*x->right, *y->left);
+        }
+
+        // 没有副作用也不会出错的操作数，自己和自己比较的结果是确定的
+        bool isSimple(const Expression& expr) {
+            switch (expr.type) {
+            case ExpressionType::IDENTIFIER_EXPR:
+            case ExpressionType::RESULT_EXPR:
+            case ExpressionType::INTEGER_LITERAL_EXPR:
+            case ExpressionType::CHAR_LITERAL_EXPR:
+            case ExpressionType::BOOL_LITERAL_EXPR:
+            case ExpressionType::NULL_LITERAL_EXPR:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        int64_t wrap(int64_t value) {
+            return static_cast<int32_t>(static_cast<uint32_t>(value));
+        }
+
+        // 按 C0 的 32 位语义求单个节点的值，子节点的值已经在 values 中
+        std::optional<int64_t> evaluateNode(const Expression& node,
+                                            const std::unordered_map<const Expression*, std::optional<int64_t>>& values) {
+            auto valueOf = [&](const std::shared_ptr<Expression>& child) -> std::optional<int64_t> {
+                if (!child) {
+                    return std::nullopt;
+                }
+                auto it = values.find(child.get());
+                return it == values.end() ? std::nullopt : it->second;
+            };
+
+            switch (node.type) {
+            case ExpressionType::INTEGER_LITERAL_EXPR:
+                return static_cast<const IntegerLiteralExpr&>(node).value;
+            case ExpressionType::CHAR_LITERAL_EXPR:
+                return static_cast<unsigned char>(static_cast<const CharLiteralExpr&>(node).value);
+            case ExpressionType::BOOL_LITERAL_EXPR:
+                return static_cast<const BoolLiteralExpr&>(node).value ? 1 : 0;
+            case ExpressionType::UNARY_EXPR: {
+                auto& unary = static_cast<const UnaryExpr&>(node);
+                auto operand = valueOf(unary.operand);
+                if (!operand) {
+                    return std::nullopt;
+                }
+                switch (unary.op) {
+                case TokenType::OP_NOT: return *operand == 0 ? 1 : 0;
+                case TokenType::OP_MINUS: return wrap(-*operand);
+                case TokenType::OP_BIT_NOT: return wrap(~*operand);
+                default: return std::nullopt;
+                }
+            }
+            case ExpressionType::CONDITIONAL_EXPR: {
+                auto& conditional = static_cast<const ConditionalExpr&>(node);
+                auto condition = valueOf(conditional.condition);
+                if (!condition) {
+                    return std::nullopt;
+                }
+                return *condition != 0 ? valueOf(conditional.thenExpr) : valueOf(conditional.elseExpr);
+            }
+            case ExpressionType::BINARY_EXPR:
+                break;
+            default:
+                return std::nullopt;
+            }
+
+            auto& binary = static_cast<const BinaryExpr&>(node);
+            if (!binary.left || !binary.right) {
+                return std::nullopt;
+            }
+            auto left = valueOf(binary.left);
+            auto right = valueOf(binary.right);
+            // 短路运算只要左边就能确定结果，右边即使会出错也不会被求值
+            if (binary.op == TokenType::OP_LOGICAL_AND) {
+                if (left && *left == 0) {
+                    return 0;
+                }
+                return left && right ? std::optional<int64_t>(*right != 0) : std::nullopt;
+            }
+            if (binary.op == TokenType::OP_LOGICAL_OR) {
+                if (left && *left != 0) {
+                    return 1;
+                }
+                return left && right ? std::optional<int64_t>(*right != 0) : std::nullopt;
+            }
+            // x == x、x <= x 这类和自身的比较
+            if (isSimple(*binary.left) &&
+                sameExpression(*binary.left, *binary.right)) {
+                switch (binary.op) {
+                case TokenType::OP_EQ: case TokenType::OP_LE: case TokenType::OP_GE: return 1;
+                case TokenType::OP_NE: case TokenType::OP_LT: case TokenType::OP_GT: return 0;
+                default: break;
+                }
+            }
+            // 数组长度不会是负数
+            if ((binary.op == TokenType::OP_GE && binary.left->type == ExpressionType::LENGTH_EXPR &&
+                 right && *right == 0) ||
+                (binary.op == TokenType::OP_LE && binary.right->type == ExpressionType::LENGTH_EXPR &&
+                 left && *left == 0)) {
+                return 1;
+            }
+            if (!left || !right) {
+                return std::nullopt;
+            }
+            int64_t l = *left;
+            int64_t r = *right;
+            switch (binary.op) {
+            case TokenType::OP_PLUS: return wrap(l + r);
+            case TokenType::OP_MINUS: return wrap(l - r);
+            case TokenType::OP_MULTIPLY: return wrap(l * r);
+            case TokenType::OP_DIVIDE:
+            case TokenType::OP_MODULO:
+                // 除零和 INT_MIN / -1 在运行时会出错，不能当作常量
+                if (r == 0 || (l == INT32_MIN && r == -1)) {
+                    return std::nullopt;
+                }
+                return binary.op == TokenType::OP_DIVIDE ? l / r : l % r;
+            case TokenType::OP_SHL:
+            case TokenType::OP_SHR:
+                if (r < 0 || r >= 32) {
+                    return std::nullopt;
+                }
+                return binary.op == TokenType::OP_SHL ? wrap(static_cast<int64_t>(static_cast<uint32_t>(l) << r))
+                                                      : l >> r;
+            case TokenType::OP_AND: return wrap(l & r);
+            case TokenType::OP_OR: return wrap(l | r);
+            case TokenType::OP_XOR: return wrap(l ^ r);
+            case TokenType::OP_EQ: return l == r;
+            case TokenType::OP_NE: return l != r;
+            case TokenType::OP_LT: return l < r;
+            case TokenType::OP_GT: return l > r;
+            case TokenType::OP_LE: return l <= r;
+            case TokenType::OP_GE: return l >= r;
+            default: return std::nullopt;
+            }
+        }
+
+        // 按后序遍历求常量值，不随表达式深度递归
+        std::optional<int64_t> constantValue(const Expression& root) {
+            std::vector<const Expression*> order;
+            std::vector<Expression*> pending{const_cast<Expression*>(&root)};
+            while (!pending.empty()) {
+                Expression* node = pending.back();
+                pending.pop_back();
+                order.push_back(node);
+                forEachChild(*node, [&](std::shared_ptr<Expression>& child) {
+                    if (child) {
+                        pending.push_back(child.get());
+                    }
+                });
+            }
+            std::unordered_map<const Expression*, std::optional<int64_t>> values;
+            for (auto it = order.rbegin(); it != order.rend(); ++it) {
+                values[*it] = evaluateNode(**it, values);
+            }
+            return values[&root];
+        }
+
+        bool provablyTrue(const Expression& condition) {
+            auto value = constantValue(condition);
+            return value && *value != 0;
+        }
+
+        // 按 && 拆开条件，保持从左到右的顺序
+        std::vector<std::shared_ptr<Expression>> conjuncts(const std::shared_ptr<Expression>& condition) {
+            std::vector<std::shared_ptr<Expression>> parts;
+            std::vector<std::shared_ptr<Expression>> pending{condition};
+            while (!pending.empty()) {
+                auto expr = std::move(pending.back());
+                pending.pop_back();
+                auto binary = INFRA::dyn_cast<BinaryExpr>(expr);
+                if (binary && binary->op == TokenType::OP_LOGICAL_AND) {
+                    pending.push_back(binary->right);
+                    pending.push_back(binary->left);
+                } else {
+                    parts.push_back(std::move(expr));
+                }
+            }
+            return parts;
+        }
+
+        // 用 && 按顺序把若干个条件连起来
+        std::shared_ptr<Expression> conjoin(const std::vector<std::shared_ptr<Expression>>& parts,
+                                            std::pmr::memory_resource* resource) {
+            std::shared_ptr<Expression> result = parts.front();
+            for (size_t i = 1; i < parts.size(); ++i) {
+                result = makeNode<BinaryExpr>(resource, std::move(result), parts[i], TokenType::OP_LOGICAL_AND);
+                result->offset = parts.front()->offset;
+            }
+            return result;
+        }
+
+        // 复制节点本身，子表达式仍然共享；叶子节点不会被改写，直接返回原节点
+        std::shared_ptr<Expression> shallowCopy(const std::shared_ptr<Expression>& node,
+                                                std::pmr::memory_resource* resource) {
+            switch (node->type) {
+            case ExpressionType::ASSIGNMENT_EXPR:
+                return makeNode<AssignmentExpr>(resource, static_cast<const AssignmentExpr&>(*node));
+            case ExpressionType::BINARY_EXPR:
+                return makeNode<BinaryExpr>(resource, static_cast<const BinaryExpr&>(*node));
+            case ExpressionType::UNARY_EXPR:
+                return makeNode<UnaryExpr>(resource, static_cast<const UnaryExpr&>(*node));
+            case ExpressionType::CALL_EXPR:
+                return makeNode<CallExpr>(resource, static_cast<const CallExpr&>(*node));
+            case ExpressionType::ARRAY_SUBSCRIPT_EXPR:
+                return makeNode<ArraySubscriptExpr>(resource, static_cast<const ArraySubscriptExpr&>(*node));
+            case ExpressionType::MEMBER_EXPR:
+                return makeNode<MemberExpr>(resource, static_cast<const MemberExpr&>(*node));
+            case ExpressionType::CONDITIONAL_EXPR:
+                return makeNode<ConditionalExpr>(resource, static_cast<const ConditionalExpr&>(*node));
+            case ExpressionType::ALLOC_EXPR:
+                return makeNode<AllocExpr>(resource, static_cast<const AllocExpr&>(*node));
+            case ExpressionType::LENGTH_EXPR:
+                return makeNode<LengthExpr>(resource, static_cast<const LengthExpr&>(*node));
+            default:
+                return node;
+            }
+        }
+
+        // 复制条件，并把其中的 \result 换成 replacement
+        std::shared_ptr<Expression> substituteResult(const std::shared_ptr<Expression>& condition,
+                                                     const std::shared_ptr<Expression>& replacement,
+                                                     std::pmr::memory_resource* resource) {
+            std::shared_ptr<Expression> copy = condition;
+            std::vector<std::shared_ptr<Expression>*> pending{&copy};
+            while (!pending.empty()) {
+                std::shared_ptr<Expression>* slot = pending.back();
+                pending.pop_back();
+                if (!*slot) {
+                    continue;
+                }
+                if ((*slot)->type == ExpressionType::RESULT_EXPR) {
+                    *slot = replacement;
+                    continue;
+                }
+                *slot = shallowCopy(*slot, resource);
+                forEachChild(**slot, [&](std::shared_ptr<Expression>& child) {
+                    pending.push_back(&child);
+                });
+            }
+            return copy;
+        }
+    }
+
+    /**
+     * @brief 当前位置一定成立的条件：已经检查过，之后涉及的变量和内存都没有被修改
+     */
+    struct ContractLowering::FactSet {
+        struct Fact {
+            std::shared_ptr<Expression> condition;
+            Uses uses;
+        };
+        std::vector<Fact> facts;
+
+        [[nodiscard]] bool contains(const Expression& condition) const {
+            return std::any_of(facts.begin(), facts.end(), [&](const Fact& fact) {
+                return equivalentCondition(*fact.condition, condition);
+            });
+        }
+
+        // 检查通过之后，条件的每个 && 分量都成立
+        void add(const std::shared_ptr<Expression>& condition) {
+            for (auto& part : conjuncts(condition)) {
+                Uses uses = collectUses(*part);
+                if (!uses.impure && !contains(*part)) {
+                    facts.push_back({std::move(part), std::move(uses)});
+                }
+            }
+        }
+
+        void kill(const Effects& effects) {
+            std::erase_if(facts, [&](const Fact& fact) {
+                return isChangedBy(fact.uses, effects);
+            });
+        }
+
+        void intersect(const FactSet& other) {
+            std::erase_if(facts, [&](const Fact& fact) {
+                return !other.contains(*fact.condition);
+            });
+        }
+    };
+
+    ContractLowering::ContractLowering(std::pmr::memory_resource* resource)
+        : resource(resource) {
+    }
+
+    const ContractStats& ContractLowering::getStats() const {
+        return stats;
+    }
+
+    void ContractLowering::run(FunctionDecl& function) {
+        if (!function.body) {
+            return;
+        }
+        this->function = &function;
+
+        FactSet facts;
+        std::vector<std::shared_ptr<Statement>> statements;
+        for (auto& contract : function.contracts) {
+            if (contract.kind == ContractKind::ENSURES) {
+                // 在每个返回点展开
+                if (provablyTrue(*contract.condition)) {
+                    contract.check = ContractCheck::ELIDED;
+                    ++stats.elided;
+                } else {
+                    contract.check = ContractCheck::EXPANDED;
+                }
+                continue;
+            }
+            auto check = simplifyCheck(contract.condition, facts);
+            if (!check) {
+                contract.check = ContractCheck::ELIDED;
+                ++stats.elided;
+                continue;
+            }
+            contract.check = ContractCheck::EXPANDED;
+            statements.push_back(
+                makeNode<AssertStmt>(resource, check, contract.kind, contract.location, ContractCheck::EXPANDED));
+            statements.back()->offset = check->offset;
+            facts.add(check);
+            ++stats.checked;
+        }
+
+        for (const auto& statement : function.body->statements) {
+            lowerStatement(statement, facts, statements);
+        }
+        // void 函数执行到末尾同样是一个返回点
+        if (function.returnType == "void" && (statements.empty() || !endsAbruptly(*statements.back()))) {
+            lowerReturn(nullptr, facts, statements);
+        }
+        function.body->statements = std::move(statements);
+        this->function = nullptr;
+    }
+
+    std::shared_ptr<Expression> ContractLowering::simplifyCheck(const std::shared_ptr<Expression>& condition,
+                                                                const FactSet& facts) {
+        auto parts = conjuncts(condition);
+        std::vector<std::shared_ptr<Expression>> remaining;
+        for (auto& part : parts) {
+            bool known = provablyTrue(*part) || facts.contains(*part) ||
+                         std::any_of(remaining.begin(), remaining.end(), [&](const auto& kept) {
+                             return sameExpression(*kept, *part);
+                         });
+            if (!known) {
+                remaining.push_back(part);
+            }
+        }
+        if (remaining.empty()) {
+            return nullptr;
+        }
+        if (remaining.size() == parts.size()) {
+            return condition;
+        }
+        // 删掉的分量在这里都已经成立，剩下的分量按原来的顺序重新连起来
+        return conjoin(remaining, resource);
+    }
+
+    void ContractLowering::lowerBlock(CompoundStmt& block, FactSet& facts) {
+        std::vector<std::shared_ptr<Statement>> statements;
+        statements.reserve(block.statements.size());
+        for (const auto& statement : block.statements) {
+            lowerStatement(statement, facts, statements);
+        }
+        block.statements = std::move(statements);
+    }
+
+    void ContractLowering::lowerNested(std::shared_ptr<Statement>& slot, FactSet& facts) {
+        std::vector<std::shared_ptr<Statement>> statements;
+        lowerStatement(slot, facts, statements);
+        if (statements.size() == 1) {
+            slot = std::move(statements.front());
+        } else if (statements.empty()) {
+            slot = makeNode<NullStmt>(resource);
+        } else {
+            slot = makeNode<CompoundStmt>(resource, std::move(statements));
+        }
+    }
+
+    void ContractLowering::lowerStatement(const std::shared_ptr<Statement>& statement, FactSet& facts,
+                                          std::vector<std::shared_ptr<Statement>>& out) {
+        switch (statement->type) {
+        case StatementType::ASSERT_STMT: {
+            auto& assertion = static_cast<AssertStmt&>(*statement);
+            Effects effects;
+            collectEffects(*assertion.condition, effects);
+            facts.kill(effects);
+            auto check = simplifyCheck(assertion.condition, facts);
+            if (!check) {
+                ++stats.elided;
+                return;
+            }
+            assertion.condition = check;
+            assertion.check = ContractCheck::EXPANDED;
+            facts.add(check);
+            ++stats.checked;
+            break;
+        }
+        case StatementType::COMPOUND_STMT: {
+            auto& block = static_cast<CompoundStmt&>(*statement);
+            bool was_empty = block.statements.empty();
+            lowerBlock(block, facts);
+            if (block.statements.empty() && !was_empty) {
+                // 只剩下被删掉的检查
+                return;
+            }
+            break;
+        }
+        case StatementType::IF_STMT: {
+            auto& branch = static_cast<IfStmt&>(*statement);
+            Effects effects;
+            collectEffects(*branch.condition, effects);
+            facts.kill(effects);
+
+            FactSet then_facts = facts;
+            then_facts.add(branch.condition);
+            lowerNested(branch.thenStmt, then_facts);
+            FactSet else_facts = facts;
+            if (branch.elseStmt) {
+                lowerNested(branch.elseStmt, else_facts);
+            }
+            // 以 return/break/continue 结束的分支不会走到 if 之后
+            if (endsAbruptly(*branch.thenStmt)) {
+                facts = std::move(else_facts);
+            } else if (branch.elseStmt && endsAbruptly(*branch.elseStmt)) {
+                facts = std::move(then_facts);
+            } else {
+                then_facts.intersect(else_facts);
+                facts = std::move(then_facts);
+            }
+            break;
+        }
+        case StatementType::WHILE_STMT: {
+            auto& loop = static_cast<WhileStmt&>(*statement);
+            lowerLoop(loop.invariants, loop.condition, nullptr, loop.body, facts, out);
+            break;
+        }
+        case StatementType::FOR_STMT: {
+            auto& loop = static_cast<ForStmt&>(*statement);
+            if (loop.init) {
+                Effects effects;
+                collectEffects(*loop.init, effects);
+                facts.kill(effects);
+            }
+            std::vector<std::shared_ptr<Statement>> hoisted;
+            lowerLoop(loop.invariants, loop.condition, loop.increment, loop.body, facts, hoisted);
+            if (!hoisted.empty() && loop.init) {
+                // 提出的检查要放在初始化之后、第一次判断条件之前，整体包成一个代码块以保持作用域
+                hoisted.insert(hoisted.begin(), std::move(loop.init));
+                loop.init = nullptr;
+                hoisted.push_back(statement);
+                out.push_back(makeNode<CompoundStmt>(resource, std::move(hoisted)));
+                return;
+            }
+            out.insert(out.end(), hoisted.begin(), hoisted.end());
+            break;
+        }
+        case StatementType::DO_WHILE_STMT: {
+            auto& loop = static_cast<DoWhileStmt&>(*statement);
+            Effects effects;
+            collectEffects(*statement, effects);
+            facts.kill(effects);
+            FactSet body_facts = facts;
+            lowerNested(loop.body, body_facts);
+            break;
+        }
+        case StatementType::RETURN_STMT:
+            lowerReturn(statement, facts, out);
+            return;
+        case StatementType::EXPR_STMT:
+        case StatementType::DECL_STMT: {
+            Effects effects;
+            collectEffects(*statement, effects);
+            facts.kill(effects);
+            break;
+        }
+        default:
+            break;
+        }
+        out.push_back(statement);
+    }
+
+    void ContractLowering::lowerLoop(std::vector<Contract>& invariants, const std::shared_ptr<Expression>& condition,
+                                     const std::shared_ptr<Expression>& increment, std::shared_ptr<Statement>& body,
+                                     FactSet& facts, std::vector<std::shared_ptr<Statement>>& hoisted) {
+        // 一次迭代中可能被修改的东西（for 的初始化只执行一次，不算在内）
+        Effects effects;
+        collectEffects(condition, effects);
+        collectEffects(increment, effects);
+        collectEffects(*body, effects);
+        for (const auto& invariant : invariants) {
+            collectEffects(invariant.condition, effects);
+        }
+        Effects condition_effects;
+        collectEffects(condition, condition_effects);
+
+        std::vector<std::shared_ptr<Expression>> each_iteration;
+        // 不变式按顺序、从左到右求值，提出去的分量会先于留在循环里的分量求值。
+        // 留下的分量可能中止程序时，之后的分量一个都不能提；留下的分量不会中止时，
+        // 之后的分量提前失败报的仍然是不变式不成立，只要它自己也不会中止就可以提
+        bool kept_any = false;
+        bool kept_can_trap = false;
+        for (auto& invariant : invariants) {
+            // 按 && 拆开，循环中不会改变的分量第一次判断条件之前检查一次就代表了所有迭代
+            std::vector<std::shared_ptr<Expression>> stable;   // 提到循环之前检查一次
+            std::vector<std::shared_ptr<Expression>> kept;     // 每次迭代检查
+            for (auto& part : conjuncts(invariant.condition)) {
+                Uses uses = collectUses(*part);
+                bool hoistable = !isChangedBy(uses, effects) && !kept_can_trap && (!kept_any || !uses.canTrap());
+                if (!hoistable) {
+                    kept_any = true;
+                    kept_can_trap |= uses.canTrap();
+                }
+                (hoistable ? stable : kept).push_back(std::move(part));
+            }
+            bool hoisted_any = false;
+            if (!stable.empty()) {
+                if (auto check = simplifyCheck(conjoin(stable, resource), facts)) {
+                    hoisted.push_back(makeNode<AssertStmt>(resource, check, ContractKind::LOOP_INVARIANT,
+                                                           invariant.location, ContractCheck::HOISTED));
+                    hoisted.back()->offset = check->offset;
+                    facts.add(check);
+                    hoisted_any = true;
+                    ++stats.hoisted;
+                } else if (kept.empty()) {
+                    ++stats.elided;
+                }
+            }
+            if (kept.empty()) {
+                invariant.check = hoisted_any ? ContractCheck::HOISTED : ContractCheck::ELIDED;
+                continue;
+            }
+            if (!stable.empty()) {
+                invariant.condition = conjoin(kept, resource);
+            }
+            invariant.check = ContractCheck::EACH_ITERATION;
+            ++stats.each_iteration;
+            each_iteration.push_back(invariant.condition);
+        }
+
+        // 提出去的不变式不受循环影响，kill 之后仍然留在 facts 中
+        facts.kill(effects);
+        FactSet body_facts = facts;
+        for (const auto& invariant : each_iteration) {
+            body_facts.add(invariant);
+        }
+        body_facts.kill(condition_effects);
+        if (condition) {
+            body_facts.add(condition);
+        }
+        lowerNested(body, body_facts);
+
+        // 没有 break 时循环只会从循环头退出，每次迭代检查的不变式在循环之后仍然成立
+        if (!hasBreak(*body)) {
+            for (const auto& invariant : each_iteration) {
+                facts.add(invariant);
+            }
+            facts.kill(condition_effects);
+        }
+    }
+
+    void ContractLowering::lowerReturn(const std::shared_ptr<Statement>& statement, FactSet& facts,
+                                       std::vector<std::shared_ptr<Statement>>& out) {
+        std::shared_ptr<Expression> value;
+        if (statement) {
+            value = static_cast<ReturnStmt&>(*statement).expression;
+            Effects effects;
+            collectEffects(value, effects);
+            facts.kill(effects);
+        }
+
+        // 返回值不是简单的变量或常量时，先存进临时变量，保证它只求值一次且在检查之前求值
+        bool use_temporary = value && !isSimple(*value);
+        std::shared_ptr<Expression> result = value;
+        if (use_temporary) {
+            result = makeNode<IdentifierExpr>(resource, std::string(kResultName));
+            result->offset = value->offset;
+        }
+
+        std::vector<std::shared_ptr<Statement>> checks;
+        for (const auto& contract : function->contracts) {
+            if (contract.kind != ContractKind::ENSURES || contract.check == ContractCheck::ELIDED) {
+                continue;
+            }
+            auto condition = result ? substituteResult(contract.condition, result, resource) : contract.condition;
+            auto check = simplifyCheck(condition, facts);
+            if (!check) {
+                ++stats.elided;
+                continue;
+            }
+            checks.push_back(makeNode<AssertStmt>(resource, check, ContractKind::ENSURES, contract.location,
+                                                  ContractCheck::EXPANDED));
+            checks.back()->offset = check->offset;
+            facts.add(check);
+            ++stats.checked;
+        }
+
+        if (checks.empty()) {
+            if (statement) {
+                out.push_back(statement);
+            }
+            return;
+        }
+        // 展开出的语句沿用 return 的位置，没有 return 时用函数的位置
+        uint32_t offset = statement ? statement->offset : function->offset;
+        std::vector<std::shared_ptr<Statement>> expansion;
+        if (use_temporary) {
+            auto temporary = makeNode<VariableDecl>(resource, std::string(kResultName), function->returnType, value);
+            temporary->offset = offset;
+            expansion.push_back(makeNode<DeclStmt>(resource, std::move(temporary)));
+            expansion.back()->offset = offset;
+        }
+        expansion.insert(expansion.end(), checks.begin(), checks.end());
+        if (use_temporary) {
+            expansion.push_back(makeNode<ReturnStmt>(resource, result));
+            expansion.back()->offset = offset;
+        } else if (statement) {
+            expansion.push_back(statement);
+        }
+        out.push_back(makeNode<CompoundStmt>(resource, std::move(expansion)));
+        out.back()->offset = offset;
+    }
+}
@@ -0,0 +1,43 @@
+//
+// Created by 陶子杨 on 25-12-14.
+//
+
+#include "Transform/DeadFunctionElimination.h"
+
+#include <unordered_set>
+#include <vector>
+
+namespace CC::IR {
+    size_t DeadFunctionEliminationPass::run(Module& module, AnalysisManager&) {
+        Function* main = module.getFunction("main");
+        if (main == nullptr) {
+            return 0;
+        }
+
+        std::unordered_set<Function*> reachable{main};
+        std::vector<Function*> worklist{main};
+        while (!worklist.empty()) {
+            Function* function = worklist.back();
+            worklist.pop_back();
+            for (BasicBlock* block : function->getBlocks()) {
+                for (Instruction* instruction = block->front(); instruction; instruction = instruction->getNext()) {
+                    if (instruction->getOpcode() == Opcode::CALL && reachable.insert(instruction->getCallee()).second) {
+                        worklist.push_back(instruction->getCallee());
+                    }
+                }
+            }
+        }
+
+        // 到不了的函数之间可能互相调用，一起删掉即可，不会留下悬空的调用
+        std::vector<Function*> dead;
+        for (const auto& function : module.getFunctions()) {
+            if (!reachable.count(function.get())) {
+                dead.push_back(function.get());
+            }
+        }
+        for (Function* function : dead) {
+            module.eraseFunction(function);
+        }
+        return dead.size();
+    }
+}
@@ -0,0 +1,233 @@
+//
+// Created by 陶子杨 on 25-12-20.
+//
+
+#include "Transform/DeadStoreElimination.h"
+#include "IR/ValueTracking.h"
+#include "Infra/casting.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace CC::IR {
+    namespace {
+        /**
+         * @brief 一点之后不会再被读到的位置编号，有序。all 为真时表示所有位置，是数据流的顶
+         */
+        struct DeadSet {
+            bool all = true;
+            std::vector<uint32_t> locations;
+
+            bool operator==(const DeadSet& other) const = default;
+        };
+
+        bool contains(const DeadSet& set, uint32_t location) {
+            return set.all || std::binary_search(set.locations.begin(), set.locations.end(), location);
+        }
+
+        void insert(DeadSet& set, uint32_t location) {
+            if (set.all) {
+                return;
+            }
+            auto it = std::lower_bound(set.locations.begin(), set.locations.end(), location);
+            if (it == set.locations.end() || *it != location) {
+                set.locations.insert(it, location);
+            }
+        }
+
+        class DeadStoreEliminator {
+        public:
+            DeadStoreEliminator(const CFG& cfg, const DominatorTree& dominators, const AliasAnalysis& aliases)
+                : cfg(cfg), dominators(dominators), aliases(aliases), in(cfg.size()) {
+                for (uint32_t id = 0; id < aliases.getLocationCount(); ++id) {
+                    const MemoryLocation& location = aliases.getLocation(id);
+                    if (auto address = INFRA::dyn_cast<Instruction>(location.address)) {
+                        defined_by[address].push_back(id);
+                    }
+                    if (location.type == Type::VOID && aliases.isLocalObject(location.object)) {
+                        local_objects.push_back(id);
+                    }
+                }
+            }
+
+            size_t run() {
+                if (aliases.getLocationCount() == 0) {
+                    return 0;
+                }
+                const auto& order = cfg.getReversePostOrder();
+                bool changed = true;
+                while (changed) {
+                    changed = false;
+                    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+                        DeadSet state = getExitState(*it);
+                        transfer(cfg.getBlock(*it), state, false);
+                        if (state != in[*it]) {
+                            in[*it] = std::move(state);
+                            changed = true;
+                        }
+                    }
+                }
+
+                for (uint32_t b : order) {
+                    DeadSet state = getExitState(b);
+                    transfer(cfg.getBlock(b), state, true);
+                }
+                for (Instruction* store : dead) {
+                    store->eraseFromParent();
+                }
+                return dead.size();
+            }
+
+        private:
+            /**
+             * @brief 返回时只有没逃逸的对象不会再被读，中止程序之后什么都不会被读，
+             * 其他块取各后继入口的交集
+             */
+            DeadSet getExitState(uint32_t b) const {
+                Instruction* terminator = cfg.getBlock(b)->getTerminator();
+                if (terminator->getOpcode() == Opcode::RET) {
+                    return {false, local_objects};
+                }
+                DeadSet state;
+                for (uint32_t s : cfg.getSuccessors(b)) {
+                    if (in[s].all) {
+                        continue;
+                    }
+                    if (state.all) {
+                        state = in[s];
+                        continue;
+                    }
+                    std::vector<uint32_t> common;
+                    std::set_intersection(state.locations.begin(), state.locations.end(), in[s].locations.begin(),
+                                          in[s].locations.end(), std::back_inserter(common));
+                    state.locations = std::move(common);
+                }
+                return state;
+            }
+
+            /**
+             * @brief 去掉满足条件的位置；集合是全集时先展开成所有编号
+             */
+            template <typename Predicate>
+            void erase(DeadSet& set, Predicate predicate) const {
+                if (set.all) {
+                    set.all = false;
+                    set.locations.resize(aliases.getLocationCount());
+                    for (uint32_t id = 0; id < aliases.getLocationCount(); ++id) {
+                        set.locations[id] = id;
+                    }
+                }
+                std::erase_if(set.locations, predicate);
+            }
+
+            bool isDead(const DeadSet& set, uint32_t location) const {
+                if (contains(set, location)) {
+                    return true;
+                }
+                uint32_t object = aliases.getObjectId(aliases.getLocation(location));
+                return object != AliasAnalysis::kNone && contains(set, object);
+            }
+
+            /**
+             * @brief STORE 不会中止程序：地址一定非空，或者基址已经被支配它的访问证明非空
+             */
+            bool cannotTrap(const Instruction* store) const {
+                const Value* address = store->getOperand(1);
+                if (isKnownNonNull(address)) {
+                    return true;
+                }
+                while (auto field = INFRA::dyn_cast<Instruction>(address)) {
+                    if (field->getOpcode() != Opcode::FIELD_ADDR) {
+                        break;
+                    }
+                    address = field->getOperand(0);
+                }
+                std::vector<const Value*> worklist{address};
+                while (!worklist.empty()) {
+                    const Value* pointer = worklist.back();
+                    worklist.pop_back();
+                    for (Use* use = pointer->getFirstUse(); use; use = use->getNext()) {
+                        const Instruction* user = use->getUser();
+                        bool dereferences = false;
+                        switch (user->getOpcode()) {
+                        case Opcode::FIELD_ADDR:
+                            worklist.push_back(user);
+                            break;
+                        case Opcode::LOAD:
+                        case Opcode::ELEMENT_ADDR:
+                            dereferences = &user->getOperandUse(0) == use;
+                            break;
+                        case Opcode::STORE:
+                            dereferences = &user->getOperandUse(1) == use;
+                            break;
+                        default:
+                            break;
+                        }
+                        if (dereferences && user != store && dominators.dominates(user, store)) {
+                            return true;
+                        }
+                    }
+                }
+                return false;
+            }
+
+            /**
+             * @brief 从块尾往前更新不会再被读到的位置，apply 为真时记下写进这些位置的 STORE
+             */
+            void transfer(BasicBlock* block, DeadSet& state, bool apply) {
+                for (Instruction* instruction = block->back(); instruction; instruction = instruction->getPrev()) {
+                    uint32_t id = aliases.getLocationId(instruction);
+                    switch (instruction->getOpcode()) {
+                    case Opcode::STORE:
+                        if (id == AliasAnalysis::kNone) {
+                            break;
+                        }
+                        if (apply && isDead(state, id) && cannotTrap(instruction)) {
+                            dead.push_back(instruction);
+                        }
+                        insert(state, id);
+                        break;
+                    case Opcode::LOAD:
+                        if (id == AliasAnalysis::kNone) {
+                            state = {false, {}};
+                            break;
+                        }
+                        erase(state, [&](uint32_t location) { return aliases.mayAlias(location, id); });
+                        break;
+                    case Opcode::CALL:
+                        if (AliasAnalysis::callAccessesMemory(instruction)) {
+                            erase(state, [&](uint32_t location) {
+                                return aliases.isAccessibleFromCall(aliases.getLocation(location));
+                            });
+                        }
+                        break;
+                    default:
+                        break;
+                    }
+                    // 再往前，这个地址或对象指的是上一次计算出来的那个
+                    if (auto it = defined_by.find(instruction); it != defined_by.end()) {
+                        const std::vector<uint32_t>& redefined = it->second;
+                        erase(state, [&](uint32_t location) {
+                            return std::find(redefined.begin(), redefined.end(), location) != redefined.end();
+                        });
+                    }
+                }
+            }
+
+            const CFG& cfg;
+            const DominatorTree& dominators;
+            const AliasAnalysis& aliases;
+            std::vector<DeadSet> in;
+            std::unordered_map<const Instruction*, std::vector<uint32_t>> defined_by;   ///< 地址 -> 以它为地址的位置
+            std::vector<uint32_t> local_objects;
+            std::vector<Instruction*> dead;
+        };
+    }
+
+    size_t DeadStoreEliminationPass::run(Function& function, AnalysisManager& analyses) {
+        DeadStoreEliminator eliminator(analyses.get<CFG>(function), analyses.get<DominatorTree>(function),
+                                       analyses.get<AliasAnalysis>(function));
+        return eliminator.run();
+    }
+}
@@ -0,0 +1,389 @@
+//
+// Created by 陶子杨 on 25-12-21.
+//
+
+#include "Transform/DivisionLowering.h"
+#include "IR/IRBuilder.h"
+#include "Infra/casting.h"
+
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <cstdlib>
+#include <vector>
+
+namespace CC::IR {
+    namespace {
+        /**
+         * @brief 值的取值范围 [lower, upper]，另外记下确定不会取到的 0 和 -1
+         */
+        struct Range {
+            int64_t lower = INT32_MIN;
+            int64_t upper = INT32_MAX;
+            bool not_zero = false;
+            bool not_minus_one = false;
+
+            [[nodiscard]] bool contains(int64_t value) const {
+                return lower <= value && value <= upper && !(value == 0 && not_zero) &&
+                       !(value == -1 && not_minus_one);
+            }
+
+            void intersect(const Range& other) {
+                lower = std::max(lower, other.lower);
+                upper = std::min(upper, other.upper);
+                not_zero = not_zero || other.not_zero;
+                not_minus_one = not_minus_one || other.not_minus_one;
+            }
+        };
+
+        Opcode swapComparison(Opcode opcode) {
+            switch (opcode) {
+            case Opcode::LT: return Opcode::GT;
+            case Opcode::LE: return Opcode::GE;
+            case Opcode::GT: return Opcode::LT;
+            case Opcode::GE: return Opcode::LE;
+            default: return opcode;
+            }
+        }
+
+        Opcode negateComparison(Opcode opcode) {
+            switch (opcode) {
+            case Opcode::EQ: return Opcode::NE;
+            case Opcode::NE: return Opcode::EQ;
+            case Opcode::LT: return Opcode::GE;
+            case Opcode::LE: return Opcode::GT;
+            case Opcode::GT: return Opcode::LE;
+            default: return Opcode::LT;
+            }
+        }
+
+        /**
+         * @brief value opcode bound 成立时收紧 range
+         */
+        void refine(Range& range, Opcode opcode, int64_t bound) {
+            switch (opcode) {
+            case Opcode::EQ:
+                range.intersect({bound, bound});
+                break;
+            case Opcode::NE:
+                if (bound == range.lower) {
+                    ++range.lower;
+                } else if (bound == range.upper) {
+                    --range.upper;
+                }
+                range.not_zero = range.not_zero || bound == 0;
+                range.not_minus_one = range.not_minus_one || bound == -1;
+                break;
+            case Opcode::LT: range.upper = std::min(range.upper, bound - 1); break;
+            case Opcode::LE: range.upper = std::min(range.upper, bound); break;
+            case Opcode::GT: range.lower = std::max(range.lower, bound + 1); break;
+            case Opcode::GE: range.lower = std::max(range.lower, bound); break;
+            default: break;
+            }
+        }
+
+        /**
+         * @brief 有符号除以常量的魔数：q = (mulh(x, magic) ± x) >> shift，再对负数加一。
+         * 要求 |divisor| >= 2 且不是 2 的幂
+         */
+        struct Magic {
+            int32_t multiplier;
+            int32_t shift;
+        };
+
+        Magic computeMagic(int32_t divisor) {
+            constexpr uint32_t kTwo31 = 0x80000000U;
+            uint32_t magnitude = divisor < 0 ? 0U - static_cast<uint32_t>(divisor) : static_cast<uint32_t>(divisor);
+            uint32_t t = kTwo31 + (static_cast<uint32_t>(divisor) >> 31);
+            uint32_t limit = t - 1 - t % magnitude;   // |nc|
+            int32_t p = 31;
+            uint32_t q1 = kTwo31 / limit;
+            uint32_t r1 = kTwo31 - q1 * limit;
+            uint32_t q2 = kTwo31 / magnitude;
+            uint32_t r2 = kTwo31 - q2 * magnitude;
+            uint32_t delta = 0;
+            do {
+                ++p;
+                q1 *= 2;
+                r1 *= 2;
+                if (r1 >= limit) {
+                    ++q1;
+                    r1 -= limit;
+                }
+                q2 *= 2;
+                r2 *= 2;
+                if (r2 >= magnitude) {
+                    ++q2;
+                    r2 -= magnitude;
+                }
+                delta = magnitude - r2;
+            } while (q1 < delta || (q1 == delta && r1 == 0));
+            uint32_t multiplier = q2 + 1;
+            if (divisor < 0) {
+                multiplier = 0U - multiplier;
+            }
+            return {static_cast<int32_t>(multiplier), p - 32};
+        }
+
+        class DivisionLowering {
+        public:
+            DivisionLowering(Function& function, const CFG& cfg, const DominatorTree& dominators,
+                             const InductionVariables& induction)
+                : function(function), cfg(cfg), dominators(dominators), induction(induction), builder(function) {}
+
+            size_t run() {
+                std::vector<Instruction*> divisions;
+                for (BasicBlock* block : function.getBlocks()) {
+                    if (!dominators.isReachable(block)) {
+                        continue;
+                    }
+                    for (Instruction* instruction = block->front(); instruction; instruction = instruction->getNext()) {
+                        if (instruction->getOpcode() == Opcode::DIV || instruction->getOpcode() == Opcode::MOD) {
+                            divisions.push_back(instruction);
+                        }
+                    }
+                }
+                size_t changes = 0;
+                for (Instruction* division : divisions) {
+                    if (auto divisor = INFRA::dyn_cast<Constant>(division->getOperand(1))) {
+                        changes += lowerConstant(division, divisor->getValue()) ? 1 : 0;
+                    } else if (!division->isTrapFreeDivision() && isProvenSafe(division)) {
+                        division->setTrapFreeDivision(true);
+                        ++changes;
+                    }
+                }
+                return changes;
+            }
+
+        private:
+            // ---- 值域 ----
+
+            /**
+             * @brief value 在 block 中的取值范围：由定义得到的范围，再用支配 block 的条件收紧
+             */
+            Range getRange(const Value* value, const BasicBlock* block, uint32_t depth = 0) const {
+                Range range = getDefinedRange(value, block, depth);
+                for (const BasicBlock* current = block; current != nullptr;) {
+                    BasicBlock* parent = dominators.getIdom(current);
+                    if (parent == nullptr) {
+                        break;
+                    }
+                    // 只从 parent 的一条出边进入 current 时，这条边的条件在 current 支配的地方都成立
+                    const Instruction* branch = parent->getTerminator();
+                    if (branch->getOpcode() == Opcode::COND_BR && branch->getSuccessor(0) != branch->getSuccessor(1) &&
+                        cfg.getPredecessors(current->getNumber()).size() == 1) {
+                        refineByCondition(range, value, branch->getOperand(0), branch->getSuccessor(0) == current);
+                    }
+                    current = parent;
+                }
+                return range;
+            }
+
+            void refineByCondition(Range& range, const Value* value, const Value* condition, bool holds) const {
+                auto compare = INFRA::dyn_cast<Instruction>(condition);
+                // 取反的条件是 XOR true
+                while (compare != nullptr && compare->getOpcode() == Opcode::XOR) {
+                    auto constant = INFRA::dyn_cast<Constant>(compare->getOperand(1));
+                    if (constant == nullptr || constant->getValue() == 0) {
+                        return;
+                    }
+                    compare = INFRA::dyn_cast<Instruction>(compare->getOperand(0));
+                    holds = !holds;
+                }
+                if (compare == nullptr || !compare->isComparison()) {
+                    return;
+                }
+                Opcode opcode = compare->getOpcode();
+                const Value* other = nullptr;
+                if (compare->getOperand(0) == value) {
+                    other = compare->getOperand(1);
+                } else if (compare->getOperand(1) == value) {
+                    other = compare->getOperand(0);
+                    opcode = swapComparison(opcode);
+                }
+                auto bound = other != nullptr ? INFRA::dyn_cast<Constant>(other) : nullptr;
+                if (bound == nullptr) {
+                    return;
+                }
+                refine(range, holds ? opcode : negateComparison(opcode), bound->getValue());
+            }
+
+            Range getDefinedRange(const Value* value, const BasicBlock* block, uint32_t depth) const {
+                if (auto constant = INFRA::dyn_cast<Constant>(value)) {
+                    return {constant->getValue(), constant->getValue()};
+                }
+                auto instruction = INFRA::dyn_cast<Instruction>(value);
+                if (instruction == nullptr) {
+                    return {};
+                }
+                auto constant = instruction->getOperandCount() == 2
+                                    ? INFRA::dyn_cast<Constant>(instruction->getOperand(1))
+                                    : nullptr;
+                switch (instruction->getOpcode()) {
+                case Opcode::AND:
+                    if (constant != nullptr && constant->getValue() >= 0) {
+                        return {0, constant->getValue()};
+                    }
+                    return {};
+                case Opcode::SHR:
+                    if (constant != nullptr && constant->getValue() > 0 && constant->getValue() < 32) {
+                        return {INT32_MIN >> constant->getValue(), INT32_MAX >> constant->getValue()};
+                    }
+                    return {};
+                case Opcode::MOD:
+                    if (constant != nullptr && constant->getValue() != 0 && constant->getValue() != INT32_MIN) {
+                        int64_t magnitude = std::abs(static_cast<int64_t>(constant->getValue()));
+                        return {1 - magnitude, magnitude - 1};
+                    }
+                    return {};
+                case Opcode::ADD:
+                case Opcode::SUB: {
+                    // 加减常量，不回绕时平移操作数的范围
+                    if (constant == nullptr || depth >= kMaxDepth) {
+                        return {};
+                    }
+                    int64_t offset = instruction->getOpcode() == Opcode::ADD ? constant->getValue()
+                                                                             : -int64_t{constant->getValue()};
+                    Range operand = getRange(instruction->getOperand(0), block, depth + 1);
+                    if (operand.lower + offset < INT32_MIN || operand.upper + offset > INT32_MAX) {
+                        return {};
+                    }
+                    return {operand.lower + offset, operand.upper + offset};
+                }
+                case Opcode::ARRAY_LENGTH:
+                    return {0, INT32_MAX};
+                case Opcode::PHI:
+                    return getInductionRange(instruction, block);
+                default:
+                    return {};
+                }
+            }
+
+            /**
+             * @brief 归纳变量在循环中的范围。头结点和循环外还会看到退出时的值，只有初值一侧可靠
+             */
+            Range getInductionRange(const Instruction* phi, const BasicBlock* block) const {
+                auto range = induction.getRangeInLoop(phi);
+                if (!range) {
+                    return {};
+                }
+                const InductionVariable* variable = induction.getInductionVariable(phi);
+                if (block != phi->getParent() && variable->loop->contains(block)) {
+                    return {range->lower, range->upper};
+                }
+                if (*variable->getConstantStep() > 0) {
+                    return {range->lower, INT32_MAX};
+                }
+                return {INT32_MIN, range->upper};
+            }
+
+            /**
+             * @brief 除数不是 0，并且除数不是 -1 或者被除数不是 INT_MIN
+             */
+            bool isProvenSafe(const Instruction* division) const {
+                const BasicBlock* block = division->getParent();
+                Range divisor = getRange(division->getOperand(1), block);
+                if (divisor.contains(0)) {
+                    return false;
+                }
+                return !divisor.contains(-1) || !getRange(division->getOperand(0), block).contains(INT32_MIN);
+            }
+
+            // ---- 降级 ----
+
+            bool lowerConstant(Instruction* division, int32_t divisor) {
+                if (divisor == 0 || divisor == -1 || divisor == INT32_MIN) {
+                    return false;
+                }
+                Value* dividend = division->getOperand(0);
+                bool remainder = division->getOpcode() == Opcode::MOD;
+                Value* result = nullptr;
+                if (divisor == 1) {
+                    result = remainder ? function.getInt(0) : dividend;
+                } else {
+                    builder.setInsertPoint(division);
+                    bool non_negative = getRange(dividend, division->getParent()).lower >= 0;
+                    auto magnitude = static_cast<uint32_t>(divisor < 0 ? -divisor : divisor);
+                    if (std::has_single_bit(magnitude)) {
+                        result = remainder ? remainderByPowerOfTwo(dividend, magnitude, non_negative)
+                                           : divideByPowerOfTwo(dividend, magnitude, divisor < 0, non_negative);
+                    } else {
+                        // 余数的符号跟着被除数，除以 |d| 和除以 d 的余数相同
+                        int32_t effective = remainder ? static_cast<int32_t>(magnitude) : divisor;
+                        Value* quotient = divideByMagic(dividend, effective, non_negative);
+                        if (remainder) {
+                            Value* product = builder.createBinary(Opcode::MUL, quotient, function.getInt(effective));
+                            result = builder.createBinary(Opcode::SUB, dividend, product);
+                        } else {
+                            result = quotient;
+                        }
+                    }
+                }
+                division->replaceAllUsesWith(result);
+                division->eraseFromParent();
+                return true;
+            }
+
+            /**
+             * @brief 负数加上 2^k - 1 再右移，结果向零取整
+             */
+            Value* roundTowardZero(Value* dividend, uint32_t magnitude, bool non_negative) {
+                if (non_negative) {
+                    return dividend;
+                }
+                Value* sign = builder.createBinary(Opcode::SHR, dividend, function.getInt(31));
+                Value* bias = builder.createBinary(Opcode::AND, sign, function.getInt(static_cast<int32_t>(magnitude - 1)));
+                return builder.createBinary(Opcode::ADD, dividend, bias);
+            }
+
+            Value* divideByPowerOfTwo(Value* dividend, uint32_t magnitude, bool negative, bool non_negative) {
+                Value* biased = roundTowardZero(dividend, magnitude, non_negative);
+                Value* quotient = builder.createBinary(Opcode::SHR, biased, function.getInt(std::countr_zero(magnitude)));
+                return negative ? builder.createBinary(Opcode::SUB, function.getInt(0), quotient) : quotient;
+            }
+
+            Value* remainderByPowerOfTwo(Value* dividend, uint32_t magnitude, bool non_negative) {
+                if (non_negative) {
+                    return builder.createBinary(Opcode::AND, dividend, function.getInt(static_cast<int32_t>(magnitude - 1)));
+                }
+                Value* biased = roundTowardZero(dividend, magnitude, false);
+                Value* truncated = builder.createBinary(Opcode::AND, biased,
+                                                        function.getInt(static_cast<int32_t>(0U - magnitude)));
+                return builder.createBinary(Opcode::SUB, dividend, truncated);
+            }
+
+            Value* divideByMagic(Value* dividend, int32_t divisor, bool non_negative) {
+                Magic magic = computeMagic(divisor);
+                Value* quotient = builder.createBinary(Opcode::MULH, dividend, function.getInt(magic.multiplier));
+                if (divisor > 0 && magic.multiplier < 0) {
+                    quotient = builder.createBinary(Opcode::ADD, quotient, dividend);
+                } else if (divisor < 0 && magic.multiplier > 0) {
+                    quotient = builder.createBinary(Opcode::SUB, quotient, dividend);
+                }
+                if (magic.shift > 0) {
+                    quotient = builder.createBinary(Opcode::SHR, quotient, function.getInt(magic.shift));
+                }
+                // 商是负数时向下取整多减了一，除数为正且被除数非负时商不会是负数
+                if (non_negative && divisor > 0) {
+                    return quotient;
+                }
+                Value* sign = builder.createBinary(Opcode::SHR, quotient, function.getInt(31));
+                return builder.createBinary(Opcode::SUB, quotient, sign);
+            }
+
+            static constexpr uint32_t kMaxDepth = 4;
+
+            Function& function;
+            const CFG& cfg;
+            const DominatorTree& dominators;
+            const InductionVariables& induction;
+            IRBuilder builder;
+        };
+    }
+
+    size_t DivisionLoweringPass::run(Function& function, AnalysisManager& analyses) {
+        DivisionLowering lowering(function, analyses.get<CFG>(function), analyses.get<DominatorTree>(function),
+                                  analyses.get<InductionVariables>(function));
+        return lowering.run();
+    }
+}
@@ -0,0 +1,65 @@
+//
+// Created by 陶子杨 on 25-12-15.
+//
+
+#include "Transform/FunctionAttrs.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace CC::IR {
+    size_t FunctionAttrsPass::run(Module& module, AnalysisManager&) {
+        std::unordered_map<const Function*, bool> pure;
+        std::unordered_map<const Function*, std::vector<const Function*>> callees;
+        for (const auto& function : module.getFunctions()) {
+            bool candidate = !function->isDeclaration();
+            auto& called = callees[function.get()];
+            for (BasicBlock* block : function->getBlocks()) {
+                for (Instruction* instruction = block->front(); instruction && candidate;
+                     instruction = instruction->getNext()) {
+                    switch (instruction->getOpcode()) {
+                    case Opcode::LOAD:
+                    case Opcode::STORE:
+                    case Opcode::ALLOC:
+                    case Opcode::ALLOC_ARRAY:
+                        candidate = false;
+                        break;
+                    case Opcode::CALL:
+                        called.push_back(instruction->getCallee());
+                        break;
+                    default:
+                        // 数组长度在分配之后不会再变，ARRAY_LENGTH 和地址计算都不算读内存
+                        break;
+                    }
+                }
+            }
+            pure[function.get()] = candidate;
+        }
+
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (auto& [function, is_pure] : pure) {
+                if (!is_pure) {
+                    continue;
+                }
+                for (const Function* callee : callees[function]) {
+                    if (!pure[callee]) {
+                        is_pure = false;
+                        changed = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        size_t changes = 0;
+        for (const auto& function : module.getFunctions()) {
+            if (function->isPure() != pure[function.get()]) {
+                function->setPure(pure[function.get()]);
+                ++changes;
+            }
+        }
+        return changes;
+    }
+}
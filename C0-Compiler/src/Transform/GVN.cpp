@@ -0,0 +1,177 @@
+//
+// Created by 陶子杨 on 25-12-15.
+//
+
+#include "Transform/GVN.h"
+#include "IR/ExpressionKey.h"
+
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace CC::IR {
+    namespace {
+        struct CallKey {
+            Function* callee;
+            std::vector<Value*> arguments;
+
+            bool operator==(const CallKey& other) const {
+                return callee == other.callee && arguments == other.arguments;
+            }
+        };
+
+        struct CallKeyHash {
+            size_t operator()(const CallKey& key) const {
+                size_t hash = std::hash<const void*>()(key.callee);
+                for (const Value* argument : key.arguments) {
+                    hash = hash * 31 + std::hash<const void*>()(argument);
+                }
+                return hash;
+            }
+        };
+
+        struct Leader {
+            Instruction* instruction;
+            uint64_t generation;   ///< 只对 LOAD 有意义
+        };
+
+        /**
+         * @brief 离开作用域时可以撤销的哈希表，撤销记录里存被覆盖的旧值
+         */
+        template <typename Key, typename Hash>
+        class ScopedTable {
+        public:
+            [[nodiscard]] const Leader* find(const Key& key) const {
+                auto it = table.find(key);
+                return it == table.end() ? nullptr : &it->second;
+            }
+
+            void insert(const Key& key, Leader leader) {
+                auto [it, inserted] = table.try_emplace(key, leader);
+                if (inserted) {
+                    undo.emplace_back(key, std::nullopt);
+                } else {
+                    undo.emplace_back(key, it->second);
+                    it->second = leader;
+                }
+            }
+
+            [[nodiscard]] size_t mark() const {
+                return undo.size();
+            }
+
+            void rollback(size_t mark) {
+                while (undo.size() > mark) {
+                    auto& [key, previous] = undo.back();
+                    if (previous) {
+                        table[key] = *previous;
+                    } else {
+                        table.erase(key);
+                    }
+                    undo.pop_back();
+                }
+            }
+
+        private:
+            std::unordered_map<Key, Leader, Hash> table;
+            std::vector<std::pair<Key, std::optional<Leader>>> undo;
+        };
+
+        /**
+         * @brief 所有来源（除去自身）都是同一个值时返回它
+         */
+        Value* getUniqueIncoming(const Instruction* phi) {
+            Value* unique = nullptr;
+            for (uint32_t i = 0; i < phi->getOperandCount(); ++i) {
+                Value* incoming = phi->getOperand(i);
+                if (incoming == phi || incoming == unique) {
+                    continue;
+                }
+                if (unique != nullptr) {
+                    return nullptr;
+                }
+                unique = incoming;
+            }
+            return unique;
+        }
+    }
+
+    size_t GVNPass::run(Function& function, AnalysisManager& analyses) {
+        const DominatorTree& dominators = analyses.get<DominatorTree>(function);
+
+        ScopedTable<ExpressionKey, ExpressionKeyHash> expressions;
+        ScopedTable<CallKey, CallKeyHash> calls;
+        std::vector<std::pair<size_t, size_t>> scopes;   // 支配树上每层祖先进入时的撤销位置
+        std::vector<uint64_t> end_generation(function.getBlocks().size(), 0);
+        uint64_t generations = 0;
+        size_t changes = 0;
+
+        for (BasicBlock* block : dominators.getPreorder()) {
+            // 先序中离开了的子树一次性撤销
+            uint32_t level = dominators.getLevel(block);
+            while (scopes.size() > level) {
+                expressions.rollback(scopes.back().first);
+                calls.rollback(scopes.back().second);
+                scopes.pop_back();
+            }
+            scopes.emplace_back(expressions.mark(), calls.mark());
+
+            // 只有直接支配点这一个前驱时中间不可能插进别的写内存的路径，内存状态可以沿用
+            BasicBlock* idom = dominators.getIdom(block);
+            const auto& predecessors = block->getPredecessors();
+            uint64_t generation = idom != nullptr && predecessors.size() == 1 && predecessors.front() == idom
+                                      ? end_generation[idom->getNumber()]
+                                      : ++generations;
+
+            Instruction* next = nullptr;
+            for (Instruction* instruction = block->front(); instruction; instruction = next) {
+                next = instruction->getNext();
+                if (instruction->isPhi()) {
+                    if (Value* unique = getUniqueIncoming(instruction)) {
+                        instruction->replaceAllUsesWith(unique);
+                        instruction->eraseFromParent();
+                        ++changes;
+                    }
+                    continue;
+                }
+
+                if (isExpression(instruction)) {
+                    ExpressionKey key = makeExpressionKey(instruction);
+                    bool is_load = instruction->getOpcode() == Opcode::LOAD;
+                    const Leader* leader = expressions.find(key);
+                    if (leader != nullptr && (!is_load || leader->generation == generation)) {
+                        instruction->replaceAllUsesWith(leader->instruction);
+                        instruction->eraseFromParent();
+                        ++changes;
+                    } else {
+                        expressions.insert(key, {instruction, generation});
+                    }
+                    continue;
+                }
+
+                if (instruction->getOpcode() == Opcode::CALL && instruction->getCallee()->isPure()) {
+                    CallKey key{instruction->getCallee(), {}};
+                    key.arguments.reserve(instruction->getOperandCount());
+                    for (uint32_t i = 0; i < instruction->getOperandCount(); ++i) {
+                        key.arguments.push_back(instruction->getOperand(i));
+                    }
+                    if (const Leader* leader = calls.find(key)) {
+                        instruction->replaceAllUsesWith(leader->instruction);
+                        instruction->eraseFromParent();
+                        ++changes;
+                    } else {
+                        calls.insert(key, {instruction, generation});
+                    }
+                    continue;
+                }
+
+                if (instruction->mayWriteMemory()) {
+                    generation = ++generations;
+                }
+            }
+            end_generation[block->getNumber()] = generation;
+        }
+        return changes;
+    }
+}
@@ -0,0 +1,252 @@
+//
+// Created by 陶子杨 on 25-12-17.
+//
+
+#include "Transform/Inliner.h"
+#include "IR/Cloning.h"
+#include "IR/IRBuilder.h"
+#include "Infra/casting.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace CC::IR {
+    namespace {
+        constexpr int64_t kBaseThreshold = 40;
+        constexpr int64_t kLoopDepthBonus = 40;        // 每层循环，最多算三层
+        constexpr int64_t kSingleCallerBonus = 200;
+        constexpr int64_t kConstantArgumentBonus = 5;
+        constexpr int64_t kFoldableArgumentBonus = 10;  // 常量实参在被调函数里直接参与比较或分支
+        constexpr int64_t kCallOverhead = 3;
+        constexpr size_t kGrowthAllowance = 200;
+
+        /**
+         * @brief 不含 PHI 和无条件跳转的指令数，近似生成的代码量
+         */
+        size_t measure(const Function& function) {
+            size_t size = 0;
+            for (BasicBlock* block : function.getBlocks()) {
+                for (Instruction* instruction = block->front(); instruction; instruction = instruction->getNext()) {
+                    if (!instruction->isPhi() && instruction->getOpcode() != Opcode::BR) {
+                        ++size;
+                    }
+                }
+            }
+            return size;
+        }
+
+        /**
+         * @brief 常量实参在被调函数中被比较、做除数或移位量时，内联后很可能整段被折叠掉
+         */
+        bool feedsFolding(const Argument* argument) {
+            for (Use* use = argument->getFirstUse(); use; use = use->getNext()) {
+                const Instruction* user = use->getUser();
+                if (user->isComparison() || user->getOpcode() == Opcode::COND_BR || user->mayTrap()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief 迭代的 Tarjan 算法，按逆拓扑序（被调函数在前）给出调用图的强连通分量，
+         * 同时标记处在调用环上的函数
+         */
+        std::vector<Function*> orderBottomUp(const Module& module, std::unordered_map<const Function*, bool>& recursive) {
+            constexpr uint32_t kUnvisited = UINT32_MAX;
+            std::unordered_map<const Function*, std::vector<Function*>> callees;
+            std::unordered_map<const Function*, uint32_t> index;
+            std::unordered_map<const Function*, uint32_t> low;
+            std::unordered_map<const Function*, bool> on_stack;
+            for (const auto& function : module.getFunctions()) {
+                auto& called = callees[function.get()];
+                for (BasicBlock* block : function->getBlocks()) {
+                    for (Instruction* instruction = block->front(); instruction; instruction = instruction->getNext()) {
+                        if (instruction->getOpcode() == Opcode::CALL) {
+                            called.push_back(instruction->getCallee());
+                            if (instruction->getCallee() == function.get()) {
+                                recursive[function.get()] = true;
+                            }
+                        }
+                    }
+                }
+                index[function.get()] = kUnvisited;
+            }
+
+            std::vector<Function*> order;
+            std::vector<Function*> stack;
+            std::vector<std::pair<Function*, size_t>> frames;
+            uint32_t next_index = 0;
+            for (const auto& root : module.getFunctions()) {
+                if (index[root.get()] != kUnvisited) {
+                    continue;
+                }
+                auto visit = [&](Function* function) {
+                    index[function] = low[function] = next_index++;
+                    stack.push_back(function);
+                    on_stack[function] = true;
+                    frames.emplace_back(function, 0);
+                };
+                visit(root.get());
+                while (!frames.empty()) {
+                    auto& [function, position] = frames.back();
+                    const auto& called = callees[function];
+                    if (position < called.size()) {
+                        Function* callee = called[position++];
+                        if (index[callee] == kUnvisited) {
+                            visit(callee);
+                        } else if (on_stack[callee]) {
+                            low[function] = std::min(low[function], index[callee]);
+                        }
+                        continue;
+                    }
+                    Function* finished = function;
+                    frames.pop_back();
+                    if (!frames.empty()) {
+                        Function* parent = frames.back().first;
+                        low[parent] = std::min(low[parent], low[finished]);
+                    }
+                    if (low[finished] != index[finished]) {
+                        continue;
+                    }
+                    bool cycle = stack.back() != finished;
+                    Function* member;
+                    do {
+                        member = stack.back();
+                        stack.pop_back();
+                        on_stack[member] = false;
+                        recursive[member] = recursive[member] || cycle;
+                        order.push_back(member);
+                    } while (member != finished);
+                }
+            }
+            return order;
+        }
+    }
+
+    bool inlineCall(Instruction* call) {
+        Function* callee = call->getCallee();
+        if (callee->isDeclaration()) {
+            return false;
+        }
+        BasicBlock* block = call->getParent();
+        Function& caller = *block->getParent();
+        BasicBlock* tail = splitBlock(block, call->getNext());
+
+        CloneMap map;
+        map.foreign = true;
+        for (uint32_t i = 0; i < call->getOperandCount(); ++i) {
+            map.values[callee->getArguments()[i]] = call->getOperand(i);
+        }
+        std::vector<std::pair<BasicBlock*, Value*>> returns;
+        for (BasicBlock* copy : cloneBlocks(caller, callee->getBlocks(), map)) {
+            for (Instruction* instruction = copy->front(); instruction; instruction = instruction->getNext()) {
+                // 副本中的 RET 会换成跳转，原来的尾调用不再是尾调用
+                if (instruction->getOpcode() == Opcode::CALL) {
+                    instruction->setTailCall(false);
+                }
+            }
+            Instruction* ret = copy->getTerminator();
+            if (ret->getOpcode() == Opcode::RET) {
+                returns.emplace_back(copy, ret->getOperandCount() != 0 ? ret->getOperand(0) : nullptr);
+            }
+        }
+
+        IRBuilder builder(caller);
+        for (const auto& [exit, value] : returns) {
+            exit->getTerminator()->eraseFromParent();
+            builder.setInsertPoint(exit);
+            builder.createBr(tail);
+        }
+        if (call->getType() != Type::VOID && call->hasUses()) {
+            Value* result;
+            if (returns.empty()) {
+                // 被调函数不会正常返回，后半块不可达
+                result = caller.getUndef(call->getType());
+            } else if (returns.size() == 1) {
+                result = returns.front().second;
+            } else {
+                Instruction* phi = builder.createPhi(call->getType(), tail);
+                for (const auto& [exit, value] : returns) {
+                    phi->addOperand(value, exit);
+                }
+                result = phi;
+            }
+            call->replaceAllUsesWith(result);
+        }
+        call->eraseFromParent();
+        builder.setInsertPoint(block);
+        builder.createBr(map.blocks.at(callee->getEntryBlock()));
+        return true;
+    }
+
+    size_t InlinerPass::run(Module& module, AnalysisManager&) {
+        std::unordered_map<const Function*, bool> recursive;
+        std::vector<Function*> order = orderBottomUp(module, recursive);
+
+        std::unordered_map<const Function*, size_t> call_sites;
+        std::unordered_map<const Function*, size_t> sizes;
+        for (const auto& function : module.getFunctions()) {
+            sizes[function.get()] = measure(*function);
+            for (BasicBlock* block : function->getBlocks()) {
+                for (Instruction* instruction = block->front(); instruction; instruction = instruction->getNext()) {
+                    if (instruction->getOpcode() == Opcode::CALL) {
+                        ++call_sites[instruction->getCallee()];
+                    }
+                }
+            }
+        }
+
+        size_t inlined = 0;
+        for (Function* caller : order) {
+            if (caller->isDeclaration()) {
+                continue;
+            }
+            size_t& size = sizes[caller];
+            size_t limit = size * 2 + kGrowthAllowance;
+
+            caller->renumber();
+            DominatorTree dominators(*caller);
+            LoopInfo loops(dominators);
+            std::vector<std::pair<Instruction*, uint32_t>> calls;
+            for (BasicBlock* block : caller->getBlocks()) {
+                for (Instruction* instruction = block->front(); instruction; instruction = instruction->getNext()) {
+                    if (instruction->getOpcode() == Opcode::CALL) {
+                        calls.emplace_back(instruction, loops.getLoopDepth(block));
+                    }
+                }
+            }
+
+            // 只看调用者原有的调用点，内联进来的调用在被调函数里已经考虑过
+            for (const auto& [call, depth] : calls) {
+                Function* callee = call->getCallee();
+                if (callee->isDeclaration() || callee == caller || recursive[callee]) {
+                    continue;
+                }
+                int64_t cost = static_cast<int64_t>(sizes[callee]) - kCallOverhead -
+                               static_cast<int64_t>(call->getOperandCount());
+                for (uint32_t i = 0; i < call->getOperandCount(); ++i) {
+                    if (INFRA::isa<Constant>(call->getOperand(i))) {
+                        cost -= feedsFolding(callee->getArguments()[i]) ? kFoldableArgumentBonus
+                                                                         : kConstantArgumentBonus;
+                    }
+                }
+                int64_t threshold = kBaseThreshold + kLoopDepthBonus * std::min<uint32_t>(depth, 3);
+                if (call_sites[callee] == 1 && callee->getName() != "main") {
+                    threshold += kSingleCallerBonus;
+                }
+                if (cost > threshold || size + sizes[callee] > limit) {
+                    continue;
+                }
+                size_t added = sizes[callee];
+                if (inlineCall(call)) {
+                    size += added;
+                    --call_sites[callee];
+                    ++inlined;
+                }
+            }
+        }
+        return inlined;
+    }
+}
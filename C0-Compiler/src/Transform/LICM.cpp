@@ -0,0 +1,151 @@
+//
+// Created by 陶子杨 on 25-12-15.
+//
+
+#include "Transform/LICM.h"
+#include "IR/ValueTracking.h"
+#include "Infra/casting.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace CC::IR {
+    namespace {
+        bool isInvariant(const Loop* loop, const Instruction* instruction) {
+            for (uint32_t i = 0; i < instruction->getOperandCount(); ++i) {
+                auto operand = INFRA::dyn_cast<Instruction>(instruction->getOperand(i));
+                if (operand != nullptr && loop->contains(operand->getParent())) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief 循环中写内存的指令：STORE 写的位置，以及有没有可能读写内存的调用
+         */
+        struct LoopWrites {
+            std::vector<uint32_t> locations;
+            bool calls = false;
+            bool unknown = false;   ///< 有别名分析没有编号的 STORE
+        };
+
+        LoopWrites collectWrites(const Loop* loop, const AliasAnalysis& aliases) {
+            LoopWrites writes;
+            for (BasicBlock* block : loop->getBlocks()) {
+                for (Instruction* instruction = block->front(); instruction; instruction = instruction->getNext()) {
+                    if (instruction->getOpcode() == Opcode::STORE) {
+                        uint32_t id = aliases.getLocationId(instruction);
+                        if (id == AliasAnalysis::kNone) {
+                            writes.unknown = true;
+                        } else {
+                            writes.locations.push_back(id);
+                        }
+                    } else if (instruction->getOpcode() == Opcode::CALL &&
+                               AliasAnalysis::callAccessesMemory(instruction)) {
+                        writes.calls = true;
+                    }
+                }
+            }
+            return writes;
+        }
+
+        /**
+         * @brief 循环中的写都不会改变 load 读的位置
+         */
+        bool isUnclobbered(const Instruction* load, const LoopWrites& writes, const AliasAnalysis& aliases) {
+            uint32_t id = aliases.getLocationId(load);
+            if (id == AliasAnalysis::kNone || writes.unknown ||
+                (writes.calls && aliases.isAccessibleFromCall(aliases.getLocation(id)))) {
+                return false;
+            }
+            return std::none_of(writes.locations.begin(), writes.locations.end(),
+                                [&](uint32_t store) { return aliases.mayAlias(store, id); });
+        }
+
+        /**
+         * @brief 会不会中止程序、读写内存或者调用可能有副作用的函数，决定能否越过它外提可能中止的指令
+         */
+        bool isObservable(const Instruction* instruction) {
+            return instruction->mayTrap() || instruction->mayWriteMemory();
+        }
+
+        enum class Hoistability : uint8_t {
+            NEVER,
+            ALWAYS,          // 不会中止程序，可以投机执行
+            IF_GUARANTEED,   // 可能中止程序，只有进入循环就一定先执行到它时才行
+        };
+
+        Hoistability classify(const Instruction* instruction, const LoopWrites& writes, const AliasAnalysis& aliases) {
+            switch (instruction->getOpcode()) {
+            case Opcode::DIV:
+            case Opcode::MOD:
+            case Opcode::SHL:
+            case Opcode::SHR:
+                // 除法上不会中止的标记依赖原来的位置，外提只能看操作数
+                return instruction->isSafeToSpeculate() ? Hoistability::ALWAYS : Hoistability::IF_GUARANTEED;
+            case Opcode::ELEMENT_ADDR:
+                return Hoistability::IF_GUARANTEED;
+            case Opcode::FIELD_ADDR:
+            case Opcode::ARRAY_LENGTH:
+                return Hoistability::ALWAYS;
+            case Opcode::LOAD:
+                if (!isUnclobbered(instruction, writes, aliases)) {
+                    return Hoistability::NEVER;
+                }
+                return isKnownNonNull(instruction->getOperand(0)) ? Hoistability::ALWAYS
+                                                                  : Hoistability::IF_GUARANTEED;
+            case Opcode::CALL:
+                return instruction->getCallee()->isPure() ? Hoistability::IF_GUARANTEED : Hoistability::NEVER;
+            default:
+                if (instruction->isBinary() || instruction->isComparison()) {
+                    return Hoistability::ALWAYS;
+                }
+                return Hoistability::NEVER;
+            }
+        }
+
+        size_t hoistFrom(Loop* loop, const AliasAnalysis& aliases) {
+            BasicBlock* preheader = loop->getPreheader();
+            if (preheader == nullptr) {
+                return 0;
+            }
+            Instruction* insert_point = preheader->getTerminator();
+            LoopWrites writes = collectWrites(loop, aliases);
+            size_t hoisted = 0;
+            for (BasicBlock* block : loop->getBlocks()) {
+                // 头结点中到目前为止都没有可观察的操作时，可能中止的指令外提后中止的时机不变
+                bool guaranteed = block == loop->getHeader();
+                Instruction* next = nullptr;
+                for (Instruction* instruction = block->front(); instruction; instruction = next) {
+                    next = instruction->getNext();
+                    Hoistability hoistability = instruction->isPhi() || instruction->isTerminator()
+                                                    ? Hoistability::NEVER
+                                                    : classify(instruction, writes, aliases);
+                    bool hoist = isInvariant(loop, instruction) &&
+                                 (hoistability == Hoistability::ALWAYS ||
+                                  (hoistability == Hoistability::IF_GUARANTEED && guaranteed));
+                    if (hoist) {
+                        block->remove(instruction);
+                        preheader->insert(instruction, insert_point);
+                        ++hoisted;
+                    } else if (isObservable(instruction)) {
+                        guaranteed = false;
+                    }
+                }
+            }
+            return hoisted;
+        }
+    }
+
+    size_t LICMPass::run(Function& function, AnalysisManager& analyses) {
+        LoopInfo& loops = analyses.get<LoopInfo>(function);
+        const AliasAnalysis& aliases = analyses.get<AliasAnalysis>(function);
+        size_t hoisted = 0;
+        // 内层循环提到它前置块里的代码，处理外层循环时还可以继续往外提
+        for (Loop* loop : loops.getLoopsInnermostFirst()) {
+            hoisted += hoistFrom(loop, aliases);
+        }
+        return hoisted;
+    }
+}
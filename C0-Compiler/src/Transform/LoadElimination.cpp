@@ -0,0 +1,244 @@
+//
+// Created by 陶子杨 on 25-12-20.
+//
+
+#include "Transform/LoadElimination.h"
+#include "Infra/casting.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace CC::IR {
+    namespace {
+        struct Fact {
+            uint32_t location;
+            Value* value;   ///< 整个对象的事实里是分配指令本身，表示对象里没写过的地方都是 0
+
+            bool operator==(const Fact& other) const = default;
+        };
+
+        /**
+         * @brief 某一点已知的内存内容，按位置编号排序。reached 为假表示还没有算到，是数据流的顶
+         */
+        struct MemoryState {
+            bool reached = false;
+            std::vector<Fact> facts;
+
+            bool operator==(const MemoryState& other) const = default;
+        };
+
+        Value* findFact(const std::vector<Fact>& facts, uint32_t location) {
+            auto it = std::lower_bound(facts.begin(), facts.end(), location,
+                                       [](const Fact& fact, uint32_t id) { return fact.location < id; });
+            return it != facts.end() && it->location == location ? it->value : nullptr;
+        }
+
+        void setFact(std::vector<Fact>& facts, uint32_t location, Value* value) {
+            auto it = std::lower_bound(facts.begin(), facts.end(), location,
+                                       [](const Fact& fact, uint32_t id) { return fact.location < id; });
+            if (it != facts.end() && it->location == location) {
+                it->value = value;
+            } else {
+                facts.insert(it, {location, value});
+            }
+        }
+
+        class LoadEliminator {
+        public:
+            LoadEliminator(Function& function, const CFG& cfg, const DominatorTree& dominators,
+                           const AliasAnalysis& aliases)
+                : function(function), cfg(cfg), dominators(dominators), aliases(aliases), out(cfg.size()) {
+                for (uint32_t id = 0; id < aliases.getLocationCount(); ++id) {
+                    const MemoryLocation& location = aliases.getLocation(id);
+                    uint32_t object = aliases.getObjectId(location);
+                    if (location.type != Type::VOID && object != AliasAnalysis::kNone) {
+                        members[object].push_back(id);
+                    }
+                }
+            }
+
+            size_t run() {
+                if (aliases.getLocationCount() == 0) {
+                    return 0;
+                }
+                bool changed = true;
+                while (changed) {
+                    changed = false;
+                    for (uint32_t b : cfg.getReversePostOrder()) {
+                        MemoryState state = getEntryState(b);
+                        transfer(cfg.getBlock(b), state.facts, false);
+                        if (state != out[b]) {
+                            out[b] = std::move(state);
+                            changed = true;
+                        }
+                    }
+                }
+
+                for (uint32_t b : cfg.getReversePostOrder()) {
+                    MemoryState state = getEntryState(b);
+                    transfer(cfg.getBlock(b), state.facts, true);
+                }
+                for (Instruction* load : dead) {
+                    load->eraseFromParent();
+                }
+                return dead.size();
+            }
+
+        private:
+            /**
+             * @brief 各前驱出口上值相同的事实，去掉地址或值不严格支配本块的
+             */
+            MemoryState getEntryState(uint32_t b) const {
+                MemoryState state;
+                state.reached = true;
+                BasicBlock* block = cfg.getBlock(b);
+                if (block == function.getEntryBlock()) {
+                    return state;
+                }
+                bool first = true;
+                for (uint32_t p : cfg.getPredecessors(b)) {
+                    if (!out[p].reached) {
+                        continue;
+                    }
+                    if (first) {
+                        state.facts = out[p].facts;
+                        first = false;
+                        continue;
+                    }
+                    std::vector<Fact> common;
+                    std::set_intersection(state.facts.begin(), state.facts.end(), out[p].facts.begin(),
+                                          out[p].facts.end(), std::back_inserter(common),
+                                          [](const Fact& a, const Fact& b) {
+                                              return a.location != b.location ? a.location < b.location
+                                                                              : a.value < b.value;
+                                          });
+                    state.facts = std::move(common);
+                }
+                std::erase_if(state.facts, [&](const Fact& fact) {
+                    return !isAvailableIn(aliases.getLocation(fact.location).address, block) ||
+                           !isAvailableIn(fact.value, block);
+                });
+                return state;
+            }
+
+            bool isAvailableIn(const Value* value, const BasicBlock* block) const {
+                auto instruction = INFRA::dyn_cast<Instruction>(value);
+                return instruction == nullptr || dominators.properlyDominates(instruction->getParent(), block);
+            }
+
+            /**
+             * @brief 写 location 之前，可能被它覆盖的整个对象的事实展开成对象里各个位置上的 0
+             */
+            void expandObjects(std::vector<Fact>& facts, uint32_t location) {
+                std::vector<uint32_t> objects;
+                for (const Fact& fact : facts) {
+                    if (members.contains(fact.location) && aliases.mayAlias(fact.location, location)) {
+                        objects.push_back(fact.location);
+                    }
+                }
+                for (uint32_t object : objects) {
+                    std::erase_if(facts, [&](const Fact& fact) { return fact.location == object; });
+                    for (uint32_t member : members.at(object)) {
+                        if (findFact(facts, member) == nullptr) {
+                            setFact(facts, member, getZero(member));
+                        }
+                    }
+                }
+            }
+
+            Value* getZero(uint32_t location) {
+                return function.getConstant(aliases.getLocation(location).type, 0);
+            }
+
+            /**
+             * @brief LOAD 能确定的值：位置上已知的值，或者所在对象新分配之后还没写过
+             */
+            Value* getKnownValue(const std::vector<Fact>& facts, uint32_t location) {
+                if (Value* value = findFact(facts, location)) {
+                    return value;
+                }
+                uint32_t object = aliases.getObjectId(aliases.getLocation(location));
+                if (object == AliasAnalysis::kNone || findFact(facts, object) == nullptr) {
+                    return nullptr;
+                }
+                return getZero(location);
+            }
+
+            Value* resolve(Value* value) const {
+                for (auto it = replaced.find(value); it != replaced.end(); it = replaced.find(value)) {
+                    value = it->second;
+                }
+                return value;
+            }
+
+            /**
+             * @brief 沿块中指令更新已知的内存内容，apply 为真时替换能确定值的 LOAD
+             */
+            void transfer(BasicBlock* block, std::vector<Fact>& facts, bool apply) {
+                for (Instruction* instruction = block->front(); instruction; instruction = instruction->getNext()) {
+                    uint32_t id = aliases.getLocationId(instruction);
+                    switch (instruction->getOpcode()) {
+                    case Opcode::ALLOC:
+                    case Opcode::ALLOC_ARRAY:
+                        setFact(facts, id, instruction);
+                        break;
+                    case Opcode::LOAD: {
+                        if (id == AliasAnalysis::kNone) {
+                            break;
+                        }
+                        Value* known = getKnownValue(facts, id);
+                        if (known == nullptr) {
+                            setFact(facts, id, instruction);
+                        } else {
+                            setFact(facts, id, known);
+                            if (apply) {
+                                Value* value = resolve(known);
+                                instruction->replaceAllUsesWith(value);
+                                replaced.emplace(instruction, value);
+                                dead.push_back(instruction);
+                            }
+                        }
+                        break;
+                    }
+                    case Opcode::STORE:
+                        if (id == AliasAnalysis::kNone) {
+                            facts.clear();
+                            break;
+                        }
+                        expandObjects(facts, id);
+                        std::erase_if(facts, [&](const Fact& fact) {
+                            return fact.location != id && aliases.mayAlias(fact.location, id);
+                        });
+                        setFact(facts, id, instruction->getOperand(0));
+                        break;
+                    case Opcode::CALL:
+                        if (AliasAnalysis::callAccessesMemory(instruction)) {
+                            std::erase_if(facts, [&](const Fact& fact) {
+                                return aliases.isAccessibleFromCall(aliases.getLocation(fact.location));
+                            });
+                        }
+                        break;
+                    default:
+                        break;
+                    }
+                }
+            }
+
+            Function& function;
+            const CFG& cfg;
+            const DominatorTree& dominators;
+            const AliasAnalysis& aliases;
+            std::vector<MemoryState> out;
+            std::unordered_map<uint32_t, std::vector<uint32_t>> members;   ///< 分配点 -> 落在其中的位置
+            std::unordered_map<Value*, Value*> replaced;
+            std::vector<Instruction*> dead;
+        };
+    }
+
+    size_t LoadEliminationPass::run(Function& function, AnalysisManager& analyses) {
+        LoadEliminator eliminator(function, analyses.get<CFG>(function), analyses.get<DominatorTree>(function),
+                                  analyses.get<AliasAnalysis>(function));
+        return eliminator.run();
+    }
+}
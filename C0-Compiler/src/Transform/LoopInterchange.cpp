@@ -0,0 +1,113 @@
+//
+// Created by 陶子杨 on 25-12-22.
+//
+
+#include "Transform/LoopInterchange.h"
+#include "IR/IRBuilder.h"
+#include "Transform/LoopNest.h"
+
+#include <utility>
+#include <vector>
+
+namespace CC::IR {
+    namespace {
+        void setIncomingValue(Instruction* phi, const BasicBlock* from, Value* value) {
+            for (uint32_t i = 0; i < phi->getOperandCount(); ++i) {
+                if (phi->getIncomingBlock(i) == from) {
+                    phi->setOperand(i, value);
+                }
+            }
+        }
+
+        std::vector<Use*> collectUsesIn(Instruction* value, const Loop* loop, const Instruction* except_a,
+                                        const Instruction* except_b) {
+            std::vector<Use*> uses;
+            for (Use* use = value->getFirstUse(); use; use = use->getNext()) {
+                const Instruction* user = use->getUser();
+                if (user != except_a && user != except_b && loop->contains(user->getParent())) {
+                    uses.push_back(use);
+                }
+            }
+            return uses;
+        }
+
+        /**
+         * @brief 把 old 换成一条新的指令，由 create 在它前面生成
+         */
+        template <typename Create>
+        Instruction* replace(Instruction* old, IRBuilder& builder, Create create) {
+            builder.setInsertPoint(old);
+            Instruction* replacement = create();
+            old->replaceAllUsesWith(replacement);
+            old->eraseFromParent();
+            return replacement;
+        }
+
+        void interchange(const LoopNest& nest) {
+            const InductionVariable& outer = *nest.outer.variable;
+            const InductionVariable& inner = *nest.inner.variable;
+            const Loop* inner_loop = nest.inner.loop;
+            BasicBlock* inner_latch = inner_loop->getLatches().front();
+            IRBuilder builder(*inner_latch->getParent());
+
+            // 内层的步进在循环体中还有别的用处时，给回边单独建一个，原来的就只是循环体中的值
+            Instruction* inner_increment = inner.increment;
+            if (!inner_increment->hasOneUse()) {
+                builder.setInsertPoint(inner_latch->getTerminator());
+                inner_increment = builder.createBinary(inner.negated ? Opcode::SUB : Opcode::ADD, inner.phi,
+                                                       inner.step);
+                setIncomingValue(inner.phi, inner_latch, inner_increment);
+            }
+
+            // 循环体看到的两个归纳变量互换
+            auto outer_uses = collectUsesIn(outer.phi, inner_loop, nullptr, nullptr);
+            auto inner_uses = collectUsesIn(inner.phi, inner_loop, inner_increment, nest.inner.compare);
+            for (Use* use : outer_uses) {
+                use->set(inner.phi);
+            }
+            for (Use* use : inner_uses) {
+                use->set(outer.phi);
+            }
+
+            // 再互换两层的初值、步长和退出条件
+            setIncomingValue(outer.phi, nest.outer.loop->getPreheader(), inner.start);
+            setIncomingValue(inner.phi, inner_loop->getPreheader(), outer.start);
+            replace(outer.increment, builder, [&] {
+                return builder.createBinary(inner.negated ? Opcode::SUB : Opcode::ADD, outer.phi, inner.step);
+            });
+            replace(inner_increment, builder, [&] {
+                return builder.createBinary(outer.negated ? Opcode::SUB : Opcode::ADD, inner.phi, outer.step);
+            });
+            Opcode outer_predicate = nest.outer.compare->getOpcode();
+            Opcode inner_predicate = nest.inner.compare->getOpcode();
+            replace(nest.outer.compare, builder, [&] {
+                return builder.createCompare(inner_predicate, outer.phi, nest.inner.bound);
+            });
+            replace(nest.inner.compare, builder, [&] {
+                return builder.createCompare(outer_predicate, inner.phi, nest.outer.bound);
+            });
+        }
+    }
+
+    size_t LoopInterchangePass::run(Function& function, AnalysisManager& analyses) {
+        const LoopInfo& loops = analyses.get<LoopInfo>(function);
+        const InductionVariables& induction = analyses.get<InductionVariables>(function);
+        const DependenceAnalysis& dependences = analyses.get<DependenceAnalysis>(function);
+
+        // 两层的完美嵌套互不相交，先全部分析完再变换
+        std::vector<LoopNest> plans;
+        for (Loop* loop : loops.getLoopsInnermostFirst()) {
+            auto nest = analyzeLoopNest(loop, induction, dependences);
+            if (nest &&
+                countColumnAccesses(*nest, nest->outer.variable->phi) <
+                    countColumnAccesses(*nest, nest->inner.variable->phi) &&
+                isInterchangeLegal(*nest, dependences)) {
+                plans.push_back(std::move(*nest));
+            }
+        }
+        for (const LoopNest& nest : plans) {
+            interchange(nest);
+        }
+        return plans.size();
+    }
+}
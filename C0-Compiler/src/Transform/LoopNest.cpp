@@ -0,0 +1,231 @@
+//
+// Created by 陶子杨 on 25-12-22.
+//
+
+#include "Transform/LoopNest.h"
+#include "Transform/LoopUtils.h"
+#include "Infra/casting.h"
+
+#include <algorithm>
+
+namespace CC::IR {
+    namespace {
+        bool isUsedOnlyIn(const Value* value, const Loop* loop) {
+            for (Use* use = value->getFirstUse(); use; use = use->getNext()) {
+                if (!loop->contains(use->getUser()->getParent())) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief 头结点是唯一的出口，由第一个操作数是归纳变量的比较控制，进入循环走 successor(0)
+         */
+        std::optional<LoopNest::Level> analyzeLevel(const Loop* loop, const Loop* outer,
+                                                    const InductionVariables& induction) {
+            BasicBlock* header = loop->getHeader();
+            auto exiting = loop->getExitingBlocks();
+            if (!isSimpleLoop(loop) || exiting.size() != 1 || exiting.front() != header) {
+                return std::nullopt;
+            }
+            Instruction* branch = header->getTerminator();
+            if (branch->getOpcode() != Opcode::COND_BR || !loop->contains(branch->getSuccessor(0))) {
+                return std::nullopt;
+            }
+            auto compare = INFRA::dyn_cast<Instruction>(branch->getOperand(0));
+            if (compare == nullptr || !compare->isComparison() || compare->getParent() != header ||
+                !compare->hasOneUse()) {
+                return std::nullopt;
+            }
+            auto phi = INFRA::dyn_cast<Instruction>(compare->getOperand(0));
+            const InductionVariable* variable = phi != nullptr ? induction.getInductionVariable(phi) : nullptr;
+            if (variable == nullptr || variable->loop != loop || !induction.getRangeInLoop(phi)) {
+                return std::nullopt;
+            }
+            auto step = variable->getConstantStep();
+            Value* bound = compare->getOperand(1);
+            if (!step || !isLoopInvariant(outer, bound) || !isLoopInvariant(outer, variable->start)) {
+                return std::nullopt;
+            }
+            return LoopNest::Level{loop, variable, compare, bound, *step};
+        }
+
+        bool isReductionOpcode(Opcode opcode) {
+            switch (opcode) {
+            case Opcode::ADD:
+            case Opcode::SUB:
+            case Opcode::MUL:
+            case Opcode::AND:
+            case Opcode::OR:
+            case Opcode::XOR:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        /**
+         * @brief 外层头结点中不是归纳变量的 PHI 必须是归约
+         */
+        std::optional<LoopNest::Reduction> analyzeReduction(Instruction* phi, const LoopNest& nest) {
+            const Loop* outer = nest.outer.loop;
+            const Loop* inner = nest.inner.loop;
+            auto inner_phi = INFRA::dyn_cast<Instruction>(phi->getIncomingValueFor(outer->getLatches().front()));
+            if (inner_phi == nullptr || inner_phi->getParent() != inner->getHeader() || !inner_phi->isPhi() ||
+                inner_phi == nest.inner.variable->phi || inner_phi->getIncomingValueFor(inner->getPreheader()) != phi) {
+                return std::nullopt;
+            }
+            auto update = INFRA::dyn_cast<Instruction>(inner_phi->getIncomingValueFor(inner->getLatches().front()));
+            if (update == nullptr || !inner->contains(update->getParent()) || !isReductionOpcode(update->getOpcode()) ||
+                !update->hasOneUse() || update->getOperand(0) == update->getOperand(1)) {
+                return std::nullopt;
+            }
+            if (update->getOperand(0) != inner_phi && (!update->isCommutative() || update->getOperand(1) != inner_phi)) {
+                return std::nullopt;
+            }
+            // 中间值只用来往下传
+            if (inner_phi->getUseCount() != 2) {
+                return std::nullopt;
+            }
+            for (Use* use = phi->getFirstUse(); use; use = use->getNext()) {
+                const Instruction* user = use->getUser();
+                if (user != inner_phi && outer->contains(user->getParent())) {
+                    return std::nullopt;
+                }
+            }
+            return LoopNest::Reduction{phi, inner_phi, update};
+        }
+
+        /**
+         * @brief 内层循环中的指令：只通过数组访问读写内存，除了越界不会中止程序，结果不在内层循环外使用
+         */
+        bool analyzeBody(LoopNest& nest, const DependenceAnalysis& dependences) {
+            const Loop* inner = nest.inner.loop;
+            for (BasicBlock* block : inner->getBlocks()) {
+                for (Instruction* instruction = block->front(); instruction; instruction = instruction->getNext()) {
+                    switch (instruction->getOpcode()) {
+                    case Opcode::CALL:
+                    case Opcode::ALLOC:
+                    case Opcode::ALLOC_ARRAY:
+                    case Opcode::RET:
+                    case Opcode::ABORT:
+                        return false;
+                    case Opcode::LOAD:
+                    case Opcode::STORE: {
+                        auto access = dependences.getAccess(instruction);
+                        if (!access || (access->write && access->type == Type::PTR)) {
+                            return false;
+                        }
+                        nest.accesses.push_back(std::move(*access));
+                        break;
+                    }
+                    case Opcode::ELEMENT_ADDR:
+                    case Opcode::BR:
+                    case Opcode::COND_BR:
+                        break;
+                    default:
+                        if (instruction->mayTrap() || !instruction->isSafeToSpeculate()) {
+                            return false;
+                        }
+                        break;
+                    }
+                    bool reduction = std::any_of(nest.reductions.begin(), nest.reductions.end(),
+                                                 [&](const auto& r) { return r.inner == instruction; });
+                    if (!reduction && !isUsedOnlyIn(instruction, inner)) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+    }
+
+    std::optional<LoopNest> analyzeLoopNest(const Loop* outer, const InductionVariables& induction,
+                                            const DependenceAnalysis& dependences) {
+        if (outer->getSubLoops().size() != 1 || !outer->getSubLoops().front()->getSubLoops().empty()) {
+            return std::nullopt;
+        }
+        const Loop* inner = outer->getSubLoops().front();
+        auto outer_level = analyzeLevel(outer, outer, induction);
+        auto inner_level = analyzeLevel(inner, outer, induction);
+        if (!outer_level || !inner_level) {
+            return std::nullopt;
+        }
+        LoopNest nest{*outer_level, *inner_level, {}, {}};
+        Instruction* outer_phi = nest.outer.variable->phi;
+        Instruction* outer_increment = nest.outer.variable->increment;
+        if (!outer_increment->hasOneUse() || !isUsedOnlyIn(outer_phi, outer)) {
+            return std::nullopt;
+        }
+
+        // 外层中不属于内层的块
+        for (BasicBlock* block : outer->getBlocks()) {
+            if (inner->contains(block)) {
+                continue;
+            }
+            for (Instruction* instruction = block->front(); instruction; instruction = instruction->getNext()) {
+                if (instruction->isTerminator()) {
+                    if (block != outer->getHeader() && instruction->getOpcode() != Opcode::BR) {
+                        return std::nullopt;
+                    }
+                } else if (instruction->isPhi() && block == outer->getHeader()) {
+                    if (instruction == outer_phi) {
+                        continue;
+                    }
+                    auto reduction = analyzeReduction(instruction, nest);
+                    if (!reduction) {
+                        return std::nullopt;
+                    }
+                    nest.reductions.push_back(*reduction);
+                } else if (instruction != nest.outer.compare && instruction != outer_increment) {
+                    return std::nullopt;
+                }
+            }
+        }
+
+        // 内层头结点的 PHI 只能是归纳变量和归约
+        for (Instruction* phi = inner->getHeader()->front(); phi && phi->isPhi(); phi = phi->getNext()) {
+            bool reduction = std::any_of(nest.reductions.begin(), nest.reductions.end(),
+                                         [&](const auto& r) { return r.inner == phi; });
+            if (phi != nest.inner.variable->phi && !reduction) {
+                return std::nullopt;
+            }
+        }
+        if (!analyzeBody(nest, dependences)) {
+            return std::nullopt;
+        }
+        return nest;
+    }
+
+    bool isInterchangeLegal(const LoopNest& nest, const DependenceAnalysis& dependences) {
+        auto loops = nest.getLoops();
+        for (size_t i = 0; i < nest.accesses.size(); ++i) {
+            for (size_t j = i; j < nest.accesses.size(); ++j) {
+                const ArrayAccess& a = nest.accesses[i];
+                const ArrayAccess& b = nest.accesses[j];
+                if (!a.write && !b.write) {
+                    continue;
+                }
+                auto dependence = dependences.depends(a, b, loops);
+                if (!dependence) {
+                    continue;
+                }
+                uint8_t outer = dependence->directions[0];
+                uint8_t inner = dependence->directions[1];
+                if (((outer & Dependence::kLess) && (inner & Dependence::kGreater)) ||
+                    ((outer & Dependence::kGreater) && (inner & Dependence::kLess))) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    size_t countColumnAccesses(const LoopNest& nest, const Instruction* innermost) {
+        return std::count_if(nest.accesses.begin(), nest.accesses.end(), [&](const ArrayAccess& access) {
+            return access.subscripts.size() == 2 && access.subscripts[0].variable == innermost &&
+                   access.subscripts[1].variable != innermost;
+        });
+    }
+}
@@ -0,0 +1,90 @@
+//
+// Created by 陶子杨 on 25-12-19.
+//
+
+#include "Transform/LoopPeel.h"
+#include "Transform/LoopUtils.h"
+
+namespace CC::IR {
+    namespace {
+        /**
+         * @brief 头结点有 PHI 从回边进来的是循环不变量，且与初值不同
+         */
+        bool hasFirstIterationPhi(const Loop* loop) {
+            BasicBlock* preheader = loop->getPreheader();
+            BasicBlock* latch = loop->getLatches().front();
+            for (Instruction* phi = loop->getHeader()->front(); phi && phi->isPhi(); phi = phi->getNext()) {
+                Value* next = phi->getIncomingValueFor(latch);
+                if (isLoopInvariant(loop, next) && next != phi->getIncomingValueFor(preheader)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void peel(const Loop* loop) {
+            Function& function = *loop->getHeader()->getParent();
+            BasicBlock* header = loop->getHeader();
+            BasicBlock* preheader = loop->getPreheader();
+            BasicBlock* latch = loop->getLatches().front();
+
+            CloneMap map;
+            cloneLoop(loop, map);
+            BasicBlock* first = map.lookup(header);
+            BasicBlock* last = map.lookup(latch);
+
+            // 剥出的一份里 PHI 就是初值
+            for (Instruction* phi = header->front(); phi && phi->isPhi(); phi = phi->getNext()) {
+                auto copy = map.getClone(phi);
+                Value* start = phi->getIncomingValueFor(preheader);
+                copy->replaceAllUsesWith(start);
+                copy->eraseFromParent();
+                map.values[phi] = start;
+            }
+
+            // 前置块 -> 剥出的一份 -> 原来的循环
+            preheader->getTerminator()->setSuccessor(0, first);
+            Instruction* terminator = last->getTerminator();
+            for (uint32_t s = 0; s < terminator->getSuccessorCount(); ++s) {
+                if (terminator->getSuccessor(s) == first) {
+                    terminator->setSuccessor(s, header);
+                }
+            }
+            for (Instruction* phi = header->front(); phi && phi->isPhi(); phi = phi->getNext()) {
+                Value* next = map.lookup(function, phi->getIncomingValueFor(latch));
+                for (uint32_t i = 0; i < phi->getOperandCount(); ++i) {
+                    if (phi->getIncomingBlock(i) == preheader) {
+                        phi->setOperand(i, next);
+                        phi->setIncomingBlock(i, last);
+                    }
+                }
+            }
+        }
+    }
+
+    bool LoopPeelPass::setParameter(std::string_view key, int64_t value) {
+        if (key != "threshold" || value < 0) {
+            return false;
+        }
+        threshold = value;
+        return true;
+    }
+
+    size_t LoopPeelPass::run(Function& function, AnalysisManager& analyses) {
+        const DominatorTree& dominators = analyses.get<DominatorTree>(function);
+        const LoopInfo& loops = analyses.get<LoopInfo>(function);
+
+        std::vector<Loop*> peeled;
+        for (Loop* loop : loops.getLoopsInnermostFirst()) {
+            if (loop->getSubLoops().empty() && isSimpleLoop(loop) &&
+                static_cast<int64_t>(getLoopSize(loop)) <= threshold && hasFirstIterationPhi(loop)) {
+                formLCSSA(loop, dominators);
+                peeled.push_back(loop);
+            }
+        }
+        for (Loop* loop : peeled) {
+            peel(loop);
+        }
+        return peeled.size();
+    }
+}
@@ -0,0 +1,82 @@
+//
+// Created by 陶子杨 on 25-12-15.
+//
+
+#include "Transform/LoopSimplify.h"
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+namespace CC::IR {
+    namespace {
+        /**
+         * @brief 同时包含 block 和 loop 头结点的最内层循环
+         */
+        Loop* getCommonLoop(const LoopInfo& loops, const BasicBlock* block, Loop* loop) {
+            Loop* common = loops.getLoopFor(block);
+            while (common != nullptr && !common->contains(loop)) {
+                common = common->getParent();
+            }
+            return common;
+        }
+
+        BasicBlock* split(BasicBlock* block, std::span<BasicBlock* const> predecessors, DominatorTree* dominators,
+                          DominatorTree* post_dominators) {
+            BasicBlock* middle = splitPredecessors(block, predecessors);
+            for (DominatorTree* tree : {dominators, post_dominators}) {
+                if (tree != nullptr) {
+                    tree->splitPredecessors(block, middle, predecessors);
+                }
+            }
+            return middle;
+        }
+    }
+
+    size_t simplifyLoop(Loop* loop, LoopInfo& loops, DominatorTree* dominators, DominatorTree* post_dominators) {
+        size_t created = 0;
+        BasicBlock* header = loop->getHeader();
+        if (loop->getPreheader() == nullptr) {
+            std::vector<BasicBlock*> outside;
+            for (BasicBlock* predecessor : header->getPredecessors()) {
+                if (!loop->contains(predecessor) &&
+                    std::find(outside.begin(), outside.end(), predecessor) == outside.end()) {
+                    outside.push_back(predecessor);
+                }
+            }
+            // 入口块就是头结点时没有循环外的前驱，这种循环不处理
+            if (!outside.empty()) {
+                loops.addBlock(split(header, outside, dominators, post_dominators), loop->getParent());
+                ++created;
+            }
+        }
+
+        for (BasicBlock* exit : loop->getExitBlocks()) {
+            std::vector<BasicBlock*> inside;
+            bool dedicated = true;
+            for (BasicBlock* predecessor : exit->getPredecessors()) {
+                if (!loop->contains(predecessor)) {
+                    dedicated = false;
+                } else if (std::find(inside.begin(), inside.end(), predecessor) == inside.end()) {
+                    inside.push_back(predecessor);
+                }
+            }
+            if (!dedicated) {
+                loops.addBlock(split(exit, inside, dominators, post_dominators), getCommonLoop(loops, exit, loop));
+                ++created;
+            }
+        }
+        return created;
+    }
+
+    size_t LoopSimplifyPass::run(Function& function, AnalysisManager& analyses) {
+        LoopInfo& loops = analyses.get<LoopInfo>(function);
+        DominatorTree* dominators = analyses.getCached<DominatorTree>(function);
+        PostDominatorTree* post_dominators = analyses.getCached<PostDominatorTree>(function);
+        size_t created = 0;
+        for (Loop* loop : loops.getLoopsInnermostFirst()) {
+            created += simplifyLoop(loop, loops, dominators, post_dominators);
+        }
+        return created;
+    }
+}
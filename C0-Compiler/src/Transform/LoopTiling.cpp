@@ -0,0 +1,156 @@
+//
+// Created by 陶子杨 on 25-12-22.
+//
+
+#include "Transform/LoopTiling.h"
+#include "IR/IRBuilder.h"
+#include "Transform/LoopNest.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace CC::IR {
+    namespace {
+        void replaceIncomingBlock(BasicBlock* block, const BasicBlock* from, BasicBlock* to) {
+            for (Instruction* phi = block->front(); phi && phi->isPhi(); phi = phi->getNext()) {
+                for (uint32_t i = 0; i < phi->getOperandCount(); ++i) {
+                    if (phi->getIncomingBlock(i) == from) {
+                        phi->setIncomingBlock(i, to);
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief 有访问的行下标随内层变化、最后一维随外层变化，也就是内层循环按列走
+         */
+        bool hasColumnWalk(const LoopNest& nest) {
+            return std::any_of(nest.accesses.begin(), nest.accesses.end(), [&](const ArrayAccess& access) {
+                return access.subscripts.size() == 2 && access.subscripts[0].variable == nest.inner.variable->phi &&
+                       access.subscripts[1].variable == nest.outer.variable->phi;
+            });
+        }
+
+        /**
+         * @brief 在外层循环外面套一层条带循环 TH，它从前置块进入、经 TP 进入外层循环，
+         * 外层循环结束后经 TL 回到 TH 开始下一条带
+         */
+        void tile(const LoopNest& nest, int32_t size) {
+            const Loop* outer = nest.outer.loop;
+            const Loop* inner = nest.inner.loop;
+            const InductionVariable& variable = *nest.inner.variable;
+            BasicBlock* preheader = outer->getPreheader();
+            BasicBlock* header = outer->getHeader();
+            BasicBlock* latch = outer->getLatches().front();
+            Instruction* exit_branch = header->getTerminator();
+            BasicBlock* exit = exit_branch->getSuccessor(1);
+            Value* bound = nest.inner.bound;
+            Function& function = *header->getParent();
+            IRBuilder builder(function);
+
+            // 归约的结果在嵌套之后改用条带循环中的值
+            std::vector<std::vector<Use*>> outside_uses;
+            for (const LoopNest::Reduction& reduction : nest.reductions) {
+                auto& uses = outside_uses.emplace_back();
+                for (Use* use = reduction.outer->getFirstUse(); use; use = use->getNext()) {
+                    if (!outer->contains(use->getUser()->getParent())) {
+                        uses.push_back(use);
+                    }
+                }
+            }
+
+            BasicBlock* tile_header = function.createBlock();
+            BasicBlock* tile_preheader = function.createBlock();
+            BasicBlock* tile_latch = function.createBlock();
+            Instruction* start = builder.createPhi(Type::INT, tile_header);
+            std::vector<Instruction*> carried;
+            for (size_t r = 0; r < nest.reductions.size(); ++r) {
+                Instruction* phi = nest.reductions[r].outer;
+                Instruction* value = builder.createPhi(phi->getType(), tile_header);
+                value->addOperand(phi->getIncomingValueFor(preheader), preheader);
+                value->addOperand(phi, tile_latch);
+                for (Use* use : outside_uses[r]) {
+                    use->set(value);
+                }
+                carried.push_back(value);
+            }
+            builder.setInsertPoint(tile_header);
+            builder.createCondBr(builder.createCompare(Opcode::LT, start, bound), tile_preheader, exit);
+            builder.setInsertPoint(tile_preheader);
+            builder.createBr(header);
+            builder.setInsertPoint(tile_latch);
+            builder.createBr(tile_header);
+
+            // 前置块 -> TH -> TP -> 外层循环 -> TL -> TH，TH 退出到原来的出口块
+            preheader->getTerminator()->setSuccessor(0, tile_header);
+            exit_branch->setSuccessor(1, tile_latch);
+            replaceIncomingBlock(header, preheader, tile_preheader);
+            replaceIncomingBlock(exit, header, tile_header);
+            for (size_t r = 0; r < nest.reductions.size(); ++r) {
+                Instruction* phi = nest.reductions[r].outer;
+                for (uint32_t i = 0; i < phi->getOperandCount(); ++i) {
+                    if (phi->getIncomingBlock(i) == tile_preheader) {
+                        phi->setOperand(i, carried[r]);
+                    }
+                }
+            }
+
+            // 下一条带从这一条带内层循环退出时的 j 开始；外层一次都没执行时整个嵌套都不执行，直接到 m
+            Instruction* next = builder.createPhi(Type::INT, header);
+            next->addOperand(bound, tile_preheader);
+            next->addOperand(variable.phi, latch);
+            start->addOperand(variable.start, preheader);
+            start->addOperand(next, tile_latch);
+
+            // 内层循环从 jj 开始，最多走 size 次
+            for (uint32_t i = 0; i < variable.phi->getOperandCount(); ++i) {
+                if (variable.phi->getIncomingBlock(i) == inner->getPreheader()) {
+                    variable.phi->setOperand(i, start);
+                }
+            }
+            Instruction* branch = inner->getHeader()->getTerminator();
+            builder.setInsertPoint(branch);
+            Instruction* offset = builder.createBinary(Opcode::SUB, variable.phi, start);
+            Instruction* within = builder.createCompare(Opcode::LT, offset, function.getInt(size));
+            branch->setOperand(0, builder.createBinary(Opcode::AND, nest.inner.compare, within));
+        }
+    }
+
+    bool LoopTilingPass::setParameter(std::string_view key, int64_t value) {
+        if (key != "size" || value < 1 || value > INT32_MAX) {
+            return false;
+        }
+        size = value;
+        return true;
+    }
+
+    size_t LoopTilingPass::run(Function& function, AnalysisManager& analyses) {
+        const DominatorTree& dominators = analyses.get<DominatorTree>(function);
+        const LoopInfo& loops = analyses.get<LoopInfo>(function);
+        const InductionVariables& induction = analyses.get<InductionVariables>(function);
+        const DependenceAnalysis& dependences = analyses.get<DependenceAnalysis>(function);
+
+        std::vector<LoopNest> plans;
+        for (Loop* loop : loops.getLoopsInnermostFirst()) {
+            auto nest = analyzeLoopNest(loop, induction, dependences);
+            if (!nest || nest->inner.step != 1 || nest->inner.compare->getOpcode() != Opcode::LT ||
+                !hasColumnWalk(*nest)) {
+                continue;
+            }
+            // 内层退出时的 j 要在外层的回边源上可用
+            const Loop* inner = nest->inner.loop;
+            auto count = induction.getBackedgeTakenCount(inner);
+            if ((count && *count <= size) ||
+                !dominators.dominates(inner->getHeader(), loop->getLatches().front()) ||
+                !isInterchangeLegal(*nest, dependences)) {
+                continue;
+            }
+            plans.push_back(std::move(*nest));
+        }
+        for (const LoopNest& nest : plans) {
+            tile(nest, static_cast<int32_t>(size));
+        }
+        return plans.size();
+    }
+}
@@ -0,0 +1,270 @@
+//
+// Created by 陶子杨 on 25-12-19.
+//
+
+#include "Transform/LoopUnroll.h"
+#include "IR/CFG.h"
+#include "IR/IRBuilder.h"
+#include "Transform/LoopUtils.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace CC::IR {
+    namespace {
+        struct UnrollPlan {
+            Loop* loop;
+            uint32_t count;   ///< 循环体的份数，包括原来的一份
+            uint32_t taken;   ///< 回边次数
+            bool full;
+            const InductionVariable* variable;   ///< 回边次数未知时控制循环的归纳变量，此时生成余数循环
+        };
+
+        /**
+         * @brief 头结点用归纳变量和循环不变的界比较、决定是否退出，并且头结点不写内存时，
+         * 返回这个归纳变量：余数循环会重新执行主循环最后一次头结点的检查
+         */
+        const InductionVariable* findControlVariable(const Loop* loop, const InductionVariables& variables) {
+            BasicBlock* header = loop->getHeader();
+            if (loop->getExitingBlocks().front() != header) {
+                return nullptr;
+            }
+            for (Instruction* instruction = header->front(); instruction; instruction = instruction->getNext()) {
+                if (instruction->mayWriteMemory()) {
+                    return nullptr;
+                }
+            }
+            Instruction* condition = &INFRA::cast<Instruction>(*header->getTerminator()->getOperand(0));
+            for (const InductionVariable& variable : variables.getInductionVariables(loop)) {
+                if (variables.getRangeInLoop(variable.phi)) {
+                    Value* bound = condition->getOperand(condition->getOperand(0) == variable.phi ? 1 : 0);
+                    return isLoopInvariant(loop, bound) ? &variable : nullptr;
+                }
+            }
+            return nullptr;
+        }
+
+        /**
+         * @brief 头结点 PHI 在第 k 份中的副本换成第 k - 1 份从回边带过来的值
+         */
+        void resolveHeaderPhis(const Loop* loop, const CloneMap& previous, CloneMap& current) {
+            Function& function = *loop->getHeader()->getParent();
+            BasicBlock* latch = loop->getLatches().front();
+            for (Instruction* phi = loop->getHeader()->front(); phi && phi->isPhi(); phi = phi->getNext()) {
+                auto copy = current.getClone(phi);
+                Value* value = previous.lookup(function, phi->getIncomingValueFor(latch));
+                copy->replaceAllUsesWith(value);
+                copy->eraseFromParent();
+                current.values[phi] = value;
+            }
+        }
+
+        void unroll(const UnrollPlan& plan) {
+            const Loop* loop = plan.loop;
+            Function& function = *loop->getHeader()->getParent();
+            BasicBlock* header = loop->getHeader();
+            BasicBlock* latch = loop->getLatches().front();
+            Instruction* branch = loop->getExitingBlocks().front()->getTerminator();
+            uint32_t stay = loop->contains(branch->getSuccessor(0)) ? 0 : 1;
+
+            // maps[0] 是空映射，代表原来的一份
+            std::vector<CloneMap> maps(plan.count);
+            for (uint32_t k = 1; k < plan.count; ++k) {
+                cloneLoop(loop, maps[k]);
+                resolveHeaderPhis(loop, maps[k - 1], maps[k]);
+            }
+
+            // 第 k 份的回边改到第 k + 1 份的头结点，最后一份回到原来的头结点
+            for (uint32_t k = 0; k + 1 < plan.count; ++k) {
+                Instruction* terminator = maps[k].lookup(latch)->getTerminator();
+                for (uint32_t s = 0; s < terminator->getSuccessorCount(); ++s) {
+                    if (terminator->getSuccessor(s) == maps[k].lookup(header)) {
+                        terminator->setSuccessor(s, maps[k + 1].lookup(header));
+                    }
+                }
+            }
+            const CloneMap& last = maps[plan.count - 1];
+            Instruction* last_latch = last.lookup(latch)->getTerminator();
+            for (uint32_t s = 0; s < last_latch->getSuccessorCount(); ++s) {
+                if (last_latch->getSuccessor(s) == last.lookup(header)) {
+                    last_latch->setSuccessor(s, header);
+                }
+            }
+            for (Instruction* phi = header->front(); phi && phi->isPhi(); phi = phi->getNext()) {
+                for (uint32_t i = 0; i < phi->getOperandCount(); ++i) {
+                    if (phi->getIncomingBlock(i) == latch) {
+                        phi->setOperand(i, last.lookup(function, phi->getOperand(i)));
+                        phi->setIncomingBlock(i, last.lookup(latch));
+                    }
+                }
+            }
+
+            for (uint32_t k = 0; k < plan.count; ++k) {
+                auto copy = k == 0 ? branch : maps[k].getClone(branch);
+                if (plan.full) {
+                    foldBranch(copy, k == plan.taken ? 1 - stay : stay);
+                } else if (k != plan.taken % plan.count) {
+                    foldBranch(copy, stay);
+                }
+            }
+        }
+
+        /**
+         * @brief 回边次数未知时展开成主循环和余数循环
+         *
+         * 以 i < n、步长 s 为例，前置块先算出 limit = n - (factor - 1) * s，没有回绕时进入主循环，
+         * 否则直接进入余数循环。主循环由 factor 份副本组成，只在第一份的头结点检查 i < limit，
+         * 成立时这一轮的 factor 次迭代都不会越过 n。检查不成立时转入原来的循环，
+         * 它作为余数循环执行剩下的不足 factor 次迭代，即迭代次数除以 factor 的余数
+         */
+        void unrollWithRemainder(const UnrollPlan& plan) {
+            const Loop* loop = plan.loop;
+            const InductionVariable& variable = *plan.variable;
+            Function& function = *loop->getHeader()->getParent();
+            BasicBlock* header = loop->getHeader();
+            BasicBlock* preheader = loop->getPreheader();
+            BasicBlock* latch = loop->getLatches().front();
+            Instruction* branch = header->getTerminator();
+            Instruction* condition = &INFRA::cast<Instruction>(*branch->getOperand(0));
+            uint32_t bound_index = condition->getOperand(0) == variable.phi ? 1 : 0;
+            Value* bound = condition->getOperand(bound_index);
+            BasicBlock* exit = branch->getSuccessor(loop->contains(branch->getSuccessor(0)) ? 1 : 0);
+            int32_t step = *variable.getConstantStep();
+            IRBuilder builder(function);
+
+            builder.setInsertPoint(preheader->getTerminator());
+            Instruction* limit = builder.createBinary(
+                Opcode::SUB, bound, function.getInt(static_cast<int32_t>(plan.count - 1) * step));
+            Instruction* enter = builder.createCompare(step > 0 ? Opcode::LT : Opcode::GT, limit, bound);
+
+            // 主循环的 factor 份副本首尾相接，最后一份回到第一份
+            std::vector<CloneMap> maps(plan.count);
+            for (uint32_t k = 0; k < plan.count; ++k) {
+                cloneLoop(loop, maps[k]);
+                if (k > 0) {
+                    resolveHeaderPhis(loop, maps[k - 1], maps[k]);
+                }
+            }
+            BasicBlock* first = maps[0].lookup(header);
+            for (uint32_t k = 0; k < plan.count; ++k) {
+                Instruction* terminator = maps[k].lookup(latch)->getTerminator();
+                BasicBlock* next = maps[(k + 1) % plan.count].lookup(header);
+                for (uint32_t s = 0; s < terminator->getSuccessorCount(); ++s) {
+                    if (terminator->getSuccessor(s) == maps[k].lookup(header)) {
+                        terminator->setSuccessor(s, next);
+                    }
+                }
+            }
+            const CloneMap& last = maps[plan.count - 1];
+            for (Instruction* phi = header->front(); phi && phi->isPhi(); phi = phi->getNext()) {
+                Instruction* copy = maps[0].getClone(phi);
+                for (uint32_t i = 0; i < copy->getOperandCount(); ++i) {
+                    if (copy->getIncomingBlock(i) == maps[0].lookup(latch)) {
+                        copy->setOperand(i, last.lookup(function, phi->getIncomingValueFor(latch)));
+                        copy->setIncomingBlock(i, last.lookup(latch));
+                    }
+                }
+            }
+            for (uint32_t k = 1; k < plan.count; ++k) {
+                Instruction* copy = maps[k].getClone(branch);
+                foldBranch(copy, loop->contains(branch->getSuccessor(0)) ? 0 : 1);
+            }
+
+            // 第一份改为和 limit 比较，不成立时带着当前的值进入余数循环
+            Instruction* check = maps[0].getClone(branch);
+            builder.setInsertPoint(check);
+            Value* tested = maps[0].lookup(function, variable.phi);
+            check->setOperand(0, builder.createCompare(condition->getOpcode(), bound_index == 1 ? tested : limit,
+                                                       bound_index == 1 ? limit : tested));
+            exit->removePredecessor(first);
+            for (uint32_t s = 0; s < check->getSuccessorCount(); ++s) {
+                if (check->getSuccessor(s) == exit) {
+                    check->setSuccessor(s, header);
+                }
+            }
+            for (Instruction* phi = header->front(); phi && phi->isPhi(); phi = phi->getNext()) {
+                phi->addOperand(maps[0].lookup(function, phi), first);
+            }
+
+            // 前置块按 limit 是否回绕选择主循环或余数循环，两者各自得到专用的前置块
+            preheader->getTerminator()->eraseFromParent();
+            builder.setInsertPoint(preheader);
+            builder.createCondBr(enter, first, header);
+            splitEdge(preheader, first);
+            BasicBlock* const entries[] = {preheader, first};
+            splitPredecessors(header, entries);
+        }
+    }
+
+    bool LoopUnrollPass::setParameter(std::string_view key, int64_t value) {
+        if (value < 0) {
+            return false;
+        }
+        if (key == "full-threshold") {
+            full_threshold = value;
+        } else if (key == "threshold") {
+            threshold = value;
+        } else if (key == "factor" && value >= 1) {
+            factor = value;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    size_t LoopUnrollPass::run(Function& function, AnalysisManager& analyses) {
+        const DominatorTree& dominators = analyses.get<DominatorTree>(function);
+        const LoopInfo& loops = analyses.get<LoopInfo>(function);
+        const InductionVariables& variables = analyses.get<InductionVariables>(function);
+
+        // 先在 CFG 还没变的时候选好循环并建立 LCSSA，再逐个展开。
+        // 最内层循环互不相交，展开一个不影响其余循环的块和归纳变量
+        std::vector<UnrollPlan> plans;
+        for (Loop* loop : loops.getLoopsInnermostFirst()) {
+            if (!loop->getSubLoops().empty() || !isSimpleLoop(loop)) {
+                continue;
+            }
+            std::optional<uint32_t> taken = variables.getBackedgeTakenCount(loop);
+            auto exiting = loop->getExitingBlocks();
+            if (exiting.size() != 1 ||
+                (exiting.front() != loop->getHeader() && exiting.front() != loop->getLatches().front()) ||
+                exiting.front()->getTerminator()->getOpcode() != Opcode::COND_BR) {
+                continue;
+            }
+            auto size = static_cast<int64_t>(std::max<size_t>(getLoopSize(loop), 1));
+            UnrollPlan plan{loop, 0, taken.value_or(0), false, nullptr};
+            int64_t count = std::min(factor, threshold / size);
+            if (taken && (static_cast<int64_t>(*taken) + 1) * size <= full_threshold) {
+                plan.count = *taken + 1;
+                plan.full = true;
+            } else if (taken) {
+                if (count < 2 || *taken < count) {
+                    continue;
+                }
+                plan.count = static_cast<uint32_t>(count);
+            } else {
+                plan.variable = findControlVariable(loop, variables);
+                // limit = n - (factor - 1) * 步长本身不能溢出
+                if (count < 2 || plan.variable == nullptr ||
+                    (count - 1) * std::abs(int64_t{*plan.variable->getConstantStep()}) > INT32_MAX) {
+                    continue;
+                }
+                plan.count = static_cast<uint32_t>(count);
+            }
+            formLCSSA(loop, dominators);
+            plans.push_back(plan);
+        }
+
+        for (const UnrollPlan& plan : plans) {
+            if (plan.variable != nullptr) {
+                unrollWithRemainder(plan);
+            } else {
+                unroll(plan);
+            }
+        }
+        if (!plans.empty()) {
+            function.removeUnreachableBlocks();
+        }
+        return plans.size();
+    }
+}
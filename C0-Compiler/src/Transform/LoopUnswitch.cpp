@@ -0,0 +1,84 @@
+//
+// Created by 陶子杨 on 25-12-19.
+//
+
+#include "Transform/LoopUnswitch.h"
+#include "IR/IRBuilder.h"
+#include "Transform/LoopUtils.h"
+#include "Infra/casting.h"
+
+#include <algorithm>
+
+namespace CC::IR {
+    namespace {
+        /**
+         * @brief 循环中第一个条件不变、也不是常量的 COND_BR
+         */
+        Instruction* findInvariantBranch(const Loop* loop) {
+            for (BasicBlock* block : loop->getBlocks()) {
+                Instruction* branch = block->getTerminator();
+                if (branch->getOpcode() != Opcode::COND_BR) {
+                    continue;
+                }
+                Value* condition = branch->getOperand(0);
+                if ((INFRA::isa<Instruction>(condition) || INFRA::isa<Argument>(condition)) &&
+                    isLoopInvariant(loop, condition)) {
+                    return branch;
+                }
+            }
+            return nullptr;
+        }
+
+        void unswitch(const Loop* loop, Instruction* branch) {
+            Function& function = *loop->getHeader()->getParent();
+            BasicBlock* preheader = loop->getPreheader();
+
+            CloneMap map;
+            cloneLoop(loop, map);
+            // 副本头结点的 PHI 本来就保留着来自前置块的项，补上这条边就行
+            preheader->getTerminator()->eraseFromParent();
+            IRBuilder builder(function);
+            builder.setInsertPoint(preheader);
+            builder.createCondBr(branch->getOperand(0), loop->getHeader(), map.lookup(loop->getHeader()));
+
+            foldBranch(map.getClone(branch), 1);
+            foldBranch(branch, 0);
+        }
+    }
+
+    bool LoopUnswitchPass::setParameter(std::string_view key, int64_t value) {
+        if (key != "threshold" || value < 0) {
+            return false;
+        }
+        threshold = value;
+        return true;
+    }
+
+    size_t LoopUnswitchPass::run(Function& function, AnalysisManager& analyses) {
+        const DominatorTree& dominators = analyses.get<DominatorTree>(function);
+        const LoopInfo& loops = analyses.get<LoopInfo>(function);
+
+        // 处理过的循环互不嵌套，复制一个不会影响另一个
+        std::vector<std::pair<Loop*, Instruction*>> plans;
+        for (Loop* loop : loops.getLoopsInnermostFirst()) {
+            bool nested = std::any_of(plans.begin(), plans.end(), [&](const auto& plan) {
+                return loop->contains(plan.first);
+            });
+            if (nested || !isSimpleLoop(loop) || static_cast<int64_t>(getLoopSize(loop)) > threshold) {
+                continue;
+            }
+            Instruction* branch = findInvariantBranch(loop);
+            if (branch != nullptr) {
+                formLCSSA(loop, dominators);
+                plans.emplace_back(loop, branch);
+            }
+        }
+        for (const auto& [loop, branch] : plans) {
+            unswitch(loop, branch);
+        }
+        if (!plans.empty()) {
+            function.removeUnreachableBlocks();
+        }
+        return plans.size();
+    }
+}
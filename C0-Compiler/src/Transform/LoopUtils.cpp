@@ -0,0 +1,182 @@
+//
+// Created by 陶子杨 on 25-12-19.
+//
+
+#include "Transform/LoopUtils.h"
+#include "IR/IRBuilder.h"
+#include "Infra/casting.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+namespace CC::IR {
+    size_t getLoopSize(const Loop* loop) {
+        size_t size = 0;
+        for (BasicBlock* block : loop->getBlocks()) {
+            for (Instruction* instruction = block->getFirstNonPhi(); instruction; instruction = instruction->getNext()) {
+                ++size;
+            }
+        }
+        return size;
+    }
+
+    bool isSimpleLoop(const Loop* loop) {
+        BasicBlock* preheader = loop->getPreheader();
+        auto latches = loop->getLatches();
+        return preheader != nullptr && preheader->getTerminator()->getOpcode() == Opcode::BR &&
+               latches.size() == 1 && loop->getHeader()->countPredecessor(latches.front()) == 1 &&
+               loop->hasDedicatedExits();
+    }
+
+    namespace {
+        /**
+         * @brief 把一个循环中的定义接到循环外的使用上，按需在出口块和汇合点建立 PHI（Braun 等人的按需 SSA 构造）。
+         * 出口是专用的，从循环外的使用往回走一定先遇到出口块，不会走进循环
+         */
+        class ExitValues {
+        public:
+            ExitValues(const Loop* loop, Instruction* definition, const DominatorTree& dominators)
+                : loop(loop), definition(definition), dominators(dominators),
+                  builder(*definition->getParent()->getParent()) {}
+
+            /**
+             * @brief block 开头可用的值；循环外没有别的定义，也就是 block 末尾的值
+             */
+            Value* getValueAt(BasicBlock* block) {
+                if (auto it = values.find(block); it != values.end()) {
+                    return it->second;
+                }
+                Function& function = *block->getParent();
+                if (loop->contains(block)) {
+                    return definition;
+                }
+                if (!dominators.isReachable(block)) {
+                    return function.getUndef(definition->getType());
+                }
+                const auto& predecessors = block->getPredecessors();
+                bool exit = loop->contains(predecessors.front());
+                if (!exit && predecessors.size() == 1) {
+                    Value* value = getValueAt(predecessors.front());
+                    values[block] = value;
+                    return value;
+                }
+                // 先登记再求各前驱的值，循环外的环会走回这里
+                Instruction* phi = builder.createPhi(definition->getType(), block);
+                values[block] = phi;
+                for (BasicBlock* predecessor : predecessors) {
+                    Value* value;
+                    if (exit) {
+                        // 不被定义支配的出口边上这个值不会被用到
+                        value = dominators.dominates(definition->getParent(), predecessor)
+                                    ? definition
+                                    : static_cast<Value*>(function.getUndef(definition->getType()));
+                    } else {
+                        value = getValueAt(predecessor);
+                    }
+                    phi->addOperand(value, predecessor);
+                }
+                if (exit) {
+                    return phi;
+                }
+                merges.insert(phi);
+                removeIfTrivial(phi);
+                // 删掉平凡的 PHI 时会连带删掉用到它的 PHI，以登记的值为准
+                return values.at(block);
+            }
+
+        private:
+            /**
+             * @brief 汇合点的 PHI 各项都相同（不算自己和 undef）时换成那个值。
+             * 否则经过别的循环时会在它的头结点留下 PHI，破坏那个循环的 LCSSA 形式
+             */
+            void removeIfTrivial(Instruction* phi) {
+                Value* same = nullptr;
+                for (uint32_t i = 0; i < phi->getOperandCount(); ++i) {
+                    Value* operand = phi->getOperand(i);
+                    if (operand == phi || operand == same || INFRA::isa<Undef>(operand)) {
+                        continue;
+                    }
+                    if (same != nullptr) {
+                        return;
+                    }
+                    same = operand;
+                }
+                if (same == nullptr) {
+                    same = phi->getParent()->getParent()->getUndef(phi->getType());
+                }
+                std::vector<Instruction*> users;
+                for (Use* use = phi->getFirstUse(); use; use = use->getNext()) {
+                    if (use->getUser() != phi && merges.count(use->getUser()) != 0) {
+                        users.push_back(use->getUser());
+                    }
+                }
+                phi->replaceAllUsesWith(same);
+                phi->eraseFromParent();
+                merges.erase(phi);
+                for (auto& [block, value] : values) {
+                    if (value == phi) {
+                        value = same;
+                    }
+                }
+                // 用到它的 PHI 可能因此也变得平凡
+                for (Instruction* user : users) {
+                    if (merges.count(user) != 0) {
+                        removeIfTrivial(user);
+                    }
+                }
+            }
+
+            const Loop* loop;
+            Instruction* definition;
+            const DominatorTree& dominators;
+            IRBuilder builder;
+            std::unordered_map<BasicBlock*, Value*> values;
+            std::unordered_set<Instruction*> merges;   ///< 建在汇合点、还没有删掉的 PHI
+        };
+    }
+
+    void formLCSSA(const Loop* loop, const DominatorTree& dominators) {
+        for (BasicBlock* block : loop->getBlocks()) {
+            for (Instruction* instruction = block->front(); instruction; instruction = instruction->getNext()) {
+                // 先收集再改写，改写会修改使用链表
+                std::vector<std::pair<Use*, BasicBlock*>> outside;
+                for (Use* use = instruction->getFirstUse(); use; use = use->getNext()) {
+                    Instruction* user = use->getUser();
+                    BasicBlock* at = user->getParent();
+                    if (user->isPhi()) {
+                        // PHI 的使用位置在来源块末尾，来源块在循环中时它本身就在出口块里
+                        at = user->getIncomingBlock(static_cast<uint32_t>(use - &user->getOperandUse(0)));
+                    }
+                    if (!loop->contains(at)) {
+                        outside.emplace_back(use, at);
+                    }
+                }
+                if (outside.empty()) {
+                    continue;
+                }
+                ExitValues exits(loop, instruction, dominators);
+                for (const auto& [use, at] : outside) {
+                    use->set(exits.getValueAt(at));
+                }
+            }
+        }
+    }
+
+    std::vector<BasicBlock*> cloneLoop(const Loop* loop, CloneMap& map) {
+        Function& function = *loop->getHeader()->getParent();
+        std::vector<BasicBlock*> copies = cloneBlocks(function, loop->getBlocks(), map);
+        for (BasicBlock* exit : loop->getExitBlocks()) {
+            for (Instruction* phi = exit->front(); phi && phi->isPhi(); phi = phi->getNext()) {
+                // 之前的副本补上的项来源不在循环中，不会重复
+                uint32_t count = phi->getOperandCount();
+                for (uint32_t i = 0; i < count; ++i) {
+                    BasicBlock* from = phi->getIncomingBlock(i);
+                    if (loop->contains(from)) {
+                        phi->addOperand(map.lookup(function, phi->getOperand(i)), map.lookup(from));
+                    }
+                }
+            }
+        }
+        return copies;
+    }
+}
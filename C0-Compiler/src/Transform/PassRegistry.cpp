@@ -0,0 +1,204 @@
+//
+// Created by 陶子杨 on 25-12-13.
+//
+
+#include "Transform/PassRegistry.h"
+#include "Transform/ADCE.h"
+#include "Transform/DeadFunctionElimination.h"
+#include "Transform/DeadStoreElimination.h"
+#include "Transform/DivisionLowering.h"
+#include "Transform/FunctionAttrs.h"
+#include "Transform/GVN.h"
+#include "Transform/Inliner.h"
+#include "Transform/LICM.h"
+#include "Transform/LoopInterchange.h"
+#include "Transform/LoadElimination.h"
+#include "Transform/LoopPeel.h"
+#include "Transform/LoopSimplify.h"
+#include "Transform/LoopTiling.h"
+#include "Transform/LoopUnroll.h"
+#include "Transform/LoopUnswitch.h"
+#include "Transform/SCCP.h"
+#include "Transform/StrengthReduction.h"
+#include "Transform/TailRecursion.h"
+
+#include <charconv>
+
+namespace CC::IR {
+    namespace {
+        class RemoveUnreachableBlocksPass final : public FunctionPass {
+        public:
+            [[nodiscard]] const char* getName() const override {
+                return "remove-unreachable";
+            }
+
+            size_t run(Function& function, AnalysisManager&) override {
+                return function.removeUnreachableBlocks();
+            }
+        };
+
+        class SplitCriticalEdgesPass final : public FunctionPass {
+        public:
+            [[nodiscard]] const char* getName() const override {
+                return "split-critical-edges";
+            }
+
+            /**
+             * @brief 已经算好的支配树和后支配树随拆边增量更新，不用作废重算
+             */
+            [[nodiscard]] AnalysisSet getPreserved() const override {
+                return {AnalysisKind::DOMINATOR_TREE, AnalysisKind::POST_DOMINATOR_TREE};
+            }
+
+            size_t run(Function& function, AnalysisManager& analyses) override {
+                return splitCriticalEdges(function, analyses.getCached<DominatorTree>(function),
+                                          analyses.getCached<PostDominatorTree>(function));
+            }
+        };
+
+        struct PassInfo {
+            std::string_view name;
+            std::unique_ptr<Pass> (*create)();
+        };
+
+        template <typename T>
+        std::unique_ptr<Pass> make() {
+            return std::make_unique<T>();
+        }
+
+        // 新的 pass 在这里登记，名称要与 getName 一致
+        const PassInfo kPasses[] = {
+            {"remove-unreachable", make<RemoveUnreachableBlocksPass>},
+            {"split-critical-edges", make<SplitCriticalEdgesPass>},
+            {"sccp", make<SCCPPass>},
+            {"adce", make<ADCEPass>},
+            {"dead-functions", make<DeadFunctionEliminationPass>},
+            {"function-attrs", make<FunctionAttrsPass>},
+            {"gvn", make<GVNPass>},
+            {"load-elim", make<LoadEliminationPass>},
+            {"dse", make<DeadStoreEliminationPass>},
+            {"loop-simplify", make<LoopSimplifyPass>},
+            {"licm", make<LICMPass>},
+            {"inline", make<InlinerPass>},
+            {"tail-recursion", make<TailRecursionPass>},
+            {"strength-reduce", make<StrengthReductionPass>},
+            {"loop-unswitch", make<LoopUnswitchPass>},
+            {"loop-peel", make<LoopPeelPass>},
+            {"loop-unroll", make<LoopUnrollPass>},
+            {"loop-interchange", make<LoopInterchangePass>},
+            {"loop-tile", make<LoopTilingPass>},
+            {"lower-division", make<DivisionLoweringPass>},
+        };
+
+        // -O1 只做便宜的清理和标量优化，-O2 在此之上加入更花时间的优化
+        constexpr std::string_view kO1Pipeline = "remove-unreachable,sccp,adce,inline,dead-functions,sccp,adce,tail-recursion,function-attrs,gvn,"
+                                                 "loop-simplify,licm,load-elim,dse,lower-division,adce";
+        constexpr std::string_view kO2Pipeline = "remove-unreachable,sccp,adce,inline,dead-functions,sccp,adce,tail-recursion,function-attrs,gvn,"
+                                                 "loop-simplify,loop-interchange,loop-tile,loop-simplify,licm,load-elim,dse,"
+                                                 "loop-unswitch,loop-simplify,loop-peel,loop-simplify,loop-unroll,sccp,gvn,"
+                                                 "load-elim,dse,loop-simplify,strength-reduce,lower-division,gvn,adce";
+
+        std::string_view trim(std::string_view text) {
+            while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+                text.remove_prefix(1);
+            }
+            while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+                text.remove_suffix(1);
+            }
+            return text;
+        }
+
+        /**
+         * @brief 解析 key=value;key=value 形式的参数，值是十进制整数
+         */
+        bool applyParameters(Pass& pass, std::string_view parameters, std::string& error) {
+            while (!parameters.empty()) {
+                size_t semicolon = parameters.find(';');
+                std::string_view item = trim(parameters.substr(0, semicolon));
+                parameters = semicolon == std::string_view::npos ? std::string_view()
+                                                                 : parameters.substr(semicolon + 1);
+                if (item.empty()) {
+                    continue;
+                }
+                size_t equals = item.find('=');
+                int64_t value = 0;
+                std::string_view key = trim(item.substr(0, equals));
+                std::string_view text = equals == std::string_view::npos ? std::string_view()
+                                                                         : trim(item.substr(equals + 1));
+                auto [end, status] = std::from_chars(text.data(), text.data() + text.size(), value);
+                if (text.empty() || status != std::errc() || end != text.data() + text.size()) {
+                    error = "pass '" + std::string(pass.getName()) + "' 的参数格式应为 key=整数: " + std::string(item);
+                    return false;
+                }
+                if (!pass.setParameter(key, value)) {
+                    error = "pass '" + std::string(pass.getName()) + "' 没有参数 '" + std::string(key) + "'";
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    std::string_view getDefaultPipeline(int level) {
+        if (level <= 0) {
+            return "";
+        }
+        return level == 1 ? kO1Pipeline : kO2Pipeline;
+    }
+
+    std::unique_ptr<Pass> createPass(std::string_view name) {
+        for (const PassInfo& info : kPasses) {
+            if (info.name == name) {
+                return info.create();
+            }
+        }
+        return nullptr;
+    }
+
+    std::vector<std::string_view> getPassNames() {
+        std::vector<std::string_view> names;
+        for (const PassInfo& info : kPasses) {
+            names.push_back(info.name);
+        }
+        return names;
+    }
+
+    bool parsePipeline(std::string_view spec, PassManager& manager, std::string& error) {
+        std::vector<std::unique_ptr<Pass>> parsed;
+        while (!spec.empty()) {
+            size_t comma = spec.find(',');
+            std::string_view item = trim(spec.substr(0, comma));
+            spec = comma == std::string_view::npos ? std::string_view() : spec.substr(comma + 1);
+            if (item.empty()) {
+                continue;
+            }
+            std::string_view name = item;
+            std::string_view parameters;
+            if (size_t bracket = item.find('<'); bracket != std::string_view::npos) {
+                if (item.back() != '>') {
+                    error = "pass 参数缺少 '>': " + std::string(item);
+                    return false;
+                }
+                name = trim(item.substr(0, bracket));
+                parameters = item.substr(bracket + 1, item.size() - bracket - 2);
+            }
+            auto pass = createPass(name);
+            if (!pass) {
+                error = "未知的 pass '" + std::string(name) + "'，可用的有:";
+                for (std::string_view known : getPassNames()) {
+                    error += " ";
+                    error += known;
+                }
+                return false;
+            }
+            if (!applyParameters(*pass, parameters, error)) {
+                return false;
+            }
+            parsed.push_back(std::move(pass));
+        }
+        for (auto& pass : parsed) {
+            manager.addPass(std::move(pass));
+        }
+        return true;
+    }
+}
@@ -0,0 +1,258 @@
+//
+// Created by 陶子杨 on 25-12-13.
+//
+
+#include "Transform/SCCP.h"
+#include "IR/ConstantFolding.h"
+#include "Infra/casting.h"
+
+#include <unordered_set>
+#include <vector>
+
+namespace CC::IR {
+    namespace {
+        struct LatticeValue {
+            enum State : uint8_t {
+                UNKNOWN,       // 还没有算到，可能是任何值
+                CONSTANT,
+                OVERDEFINED,   // 运行时才能确定
+            };
+
+            State state = UNKNOWN;
+            int32_t value = 0;
+
+            bool operator==(const LatticeValue& other) const {
+                return state == other.state && (state != CONSTANT || value == other.value);
+            }
+        };
+
+        constexpr LatticeValue kOverdefined{LatticeValue::OVERDEFINED, 0};
+
+        LatticeValue constant(int32_t value) {
+            return {LatticeValue::CONSTANT, value};
+        }
+
+        class Solver {
+        public:
+            explicit Solver(Function& function)
+                : function(function), lattice(function.getInstructionCount()),
+                  executable(function.getBlocks().size(), 0) {}
+
+            void solve() {
+                markBlock(function.getEntryBlock());
+                while (!block_worklist.empty() || !value_worklist.empty()) {
+                    while (!block_worklist.empty()) {
+                        BasicBlock* block = block_worklist.back();
+                        block_worklist.pop_back();
+                        for (Instruction* instruction = block->front(); instruction;
+                             instruction = instruction->getNext()) {
+                            visit(instruction);
+                        }
+                    }
+                    while (!value_worklist.empty()) {
+                        Instruction* instruction = value_worklist.back();
+                        value_worklist.pop_back();
+                        for (Use* use = instruction->getFirstUse(); use; use = use->getNext()) {
+                            Instruction* user = use->getUser();
+                            if (executable[user->getParent()->getNumber()]) {
+                                visit(user);
+                            }
+                        }
+                    }
+                }
+            }
+
+            /**
+             * @brief 按求解结果改写函数，返回改动数
+             */
+            size_t rewrite() {
+                size_t changes = 0;
+                const std::vector<BasicBlock*> blocks = function.getBlocks();
+                for (BasicBlock* block : blocks) {
+                    if (!executable[block->getNumber()]) {
+                        continue;
+                    }
+                    Instruction* terminator = block->getTerminator();
+                    if (terminator->getOpcode() == Opcode::COND_BR) {
+                        LatticeValue condition = get(terminator->getOperand(0));
+                        if (condition.state == LatticeValue::CONSTANT) {
+                            foldBranch(terminator, condition.value != 0 ? 0 : 1);
+                            ++changes;
+                            cfg_changed = true;
+                        }
+                    }
+                }
+                for (BasicBlock* block : blocks) {
+                    if (!executable[block->getNumber()]) {
+                        continue;
+                    }
+                    Instruction* next = nullptr;
+                    for (Instruction* instruction = block->front(); instruction; instruction = next) {
+                        next = instruction->getNext();
+                        if (instruction->getType() == Type::VOID) {
+                            continue;
+                        }
+                        LatticeValue value = lattice[instruction->getNumber()];
+                        if (value.state != LatticeValue::CONSTANT) {
+                            continue;
+                        }
+                        instruction->replaceAllUsesWith(function.getConstant(instruction->getType(), value.value));
+                        // 结果是常量说明这条除法或移位不会中止，可以和其他纯运算一样删掉
+                        instruction->eraseFromParent();
+                        ++changes;
+                    }
+                }
+                size_t removed = function.removeUnreachableBlocks();
+                if (removed != 0) {
+                    cfg_changed = true;
+                }
+                return changes + removed;
+            }
+
+            [[nodiscard]] bool isCFGChanged() const {
+                return cfg_changed;
+            }
+
+        private:
+            LatticeValue get(Value* value) const {
+                if (auto constant_value = INFRA::dyn_cast<Constant>(value)) {
+                    return constant(constant_value->getValue());
+                }
+                if (auto instruction = INFRA::dyn_cast<Instruction>(value)) {
+                    return lattice[instruction->getNumber()];
+                }
+                // 参数、字符串和 undef 都当作运行时的值
+                return kOverdefined;
+            }
+
+            void mark(Instruction* instruction, LatticeValue value) {
+                LatticeValue& current = lattice[instruction->getNumber()];
+                if (current == value || current.state == LatticeValue::OVERDEFINED) {
+                    return;
+                }
+                current = value;
+                value_worklist.push_back(instruction);
+            }
+
+            void markBlock(BasicBlock* block) {
+                if (!executable[block->getNumber()]) {
+                    executable[block->getNumber()] = 1;
+                    block_worklist.push_back(block);
+                }
+            }
+
+            static uint64_t edgeKey(const BasicBlock* from, const BasicBlock* to) {
+                return (uint64_t(from->getNumber()) << 32) | to->getNumber();
+            }
+
+            void markEdge(BasicBlock* from, BasicBlock* to) {
+                if (!executable_edges.insert(edgeKey(from, to)).second) {
+                    return;
+                }
+                if (!executable[to->getNumber()]) {
+                    markBlock(to);
+                    return;
+                }
+                // 已经可执行的块多了一条可执行的入边，只有 PHI 需要重新合并
+                for (Instruction* phi = to->front(); phi && phi->isPhi(); phi = phi->getNext()) {
+                    visit(phi);
+                }
+            }
+
+            void visit(Instruction* instruction) {
+                switch (instruction->getOpcode()) {
+                case Opcode::PHI:
+                    visitPhi(instruction);
+                    return;
+                case Opcode::BR:
+                    markEdge(instruction->getParent(), instruction->getSuccessor(0));
+                    return;
+                case Opcode::COND_BR: {
+                    LatticeValue condition = get(instruction->getOperand(0));
+                    if (condition.state == LatticeValue::CONSTANT) {
+                        markEdge(instruction->getParent(), instruction->getSuccessor(condition.value != 0 ? 0 : 1));
+                    } else if (condition.state == LatticeValue::OVERDEFINED) {
+                        markEdge(instruction->getParent(), instruction->getSuccessor(0));
+                        markEdge(instruction->getParent(), instruction->getSuccessor(1));
+                    }
+                    return;
+                }
+                default:
+                    break;
+                }
+                if (instruction->getType() == Type::VOID) {
+                    return;
+                }
+                if (instruction->isBinary() || instruction->isComparison()) {
+                    mark(instruction, evaluate(instruction));
+                } else {
+                    mark(instruction, kOverdefined);
+                }
+            }
+
+            void visitPhi(Instruction* phi) {
+                LatticeValue result;
+                for (uint32_t i = 0; i < phi->getOperandCount(); ++i) {
+                    if (!executable_edges.count(edgeKey(phi->getIncomingBlock(i), phi->getParent()))) {
+                        continue;
+                    }
+                    LatticeValue value = get(phi->getOperand(i));
+                    if (value.state == LatticeValue::UNKNOWN) {
+                        continue;
+                    }
+                    if (value.state == LatticeValue::OVERDEFINED ||
+                        (result.state == LatticeValue::CONSTANT && result.value != value.value)) {
+                        result = kOverdefined;
+                        break;
+                    }
+                    result = value;
+                }
+                mark(phi, result);
+            }
+
+            LatticeValue evaluate(const Instruction* instruction) const {
+                Opcode opcode = instruction->getOpcode();
+                LatticeValue left = get(instruction->getOperand(0));
+                LatticeValue right = get(instruction->getOperand(1));
+                if (left.state == LatticeValue::CONSTANT && right.state == LatticeValue::CONSTANT) {
+                    auto folded = foldBinary(opcode, left.value, right.value);
+                    return folded ? constant(*folded) : kOverdefined;
+                }
+                // 一边是吸收元时不管另一边是什么结果都确定：x * 0、x & 0、x | 全 1
+                int32_t all_ones = instruction->getType() == Type::BOOL ? 1 : -1;
+                for (const LatticeValue& side : {left, right}) {
+                    if (side.state != LatticeValue::CONSTANT) {
+                        continue;
+                    }
+                    if ((opcode == Opcode::MUL || opcode == Opcode::AND) && side.value == 0) {
+                        return constant(0);
+                    }
+                    if (opcode == Opcode::OR && side.value == all_ones) {
+                        return constant(all_ones);
+                    }
+                }
+                if (left.state == LatticeValue::OVERDEFINED || right.state == LatticeValue::OVERDEFINED) {
+                    return kOverdefined;
+                }
+                return {};
+            }
+
+            Function& function;
+            std::vector<LatticeValue> lattice;   ///< 按指令编号
+            std::vector<char> executable;        ///< 按基本块编号
+            std::unordered_set<uint64_t> executable_edges;
+            std::vector<BasicBlock*> block_worklist;
+            std::vector<Instruction*> value_worklist;
+            bool cfg_changed = false;
+        };
+    }
+
+    size_t SCCPPass::run(Function& function, AnalysisManager&) {
+        function.renumber();
+        Solver solver(function);
+        solver.solve();
+        size_t changes = solver.rewrite();
+        cfg_changed = solver.isCFGChanged();
+        return changes;
+    }
+}
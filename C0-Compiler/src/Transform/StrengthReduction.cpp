@@ -0,0 +1,104 @@
+//
+// Created by 陶子杨 on 25-12-16.
+//
+
+#include "Transform/StrengthReduction.h"
+#include "IR/ConstantFolding.h"
+#include "IR/IRBuilder.h"
+#include "Infra/casting.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace CC::IR {
+    namespace {
+        /**
+         * @brief 两个常量直接折叠，否则在插入点生成乘法
+         */
+        Value* multiply(Function& function, IRBuilder& builder, Value* left, Value* right) {
+            auto constant_left = INFRA::dyn_cast<Constant>(left);
+            auto constant_right = INFRA::dyn_cast<Constant>(right);
+            if (constant_left != nullptr && constant_right != nullptr) {
+                return function.getInt(*foldBinary(Opcode::MUL, constant_left->getValue(), constant_right->getValue()));
+            }
+            return builder.createBinary(Opcode::MUL, left, right);
+        }
+
+        bool isTrivialFactor(const Value* value) {
+            auto constant = INFRA::dyn_cast<Constant>(value);
+            return constant != nullptr && (constant->getValue() == 0 || constant->getValue() == 1);
+        }
+
+        /**
+         * @brief 为 iv * factor 新建归纳变量，返回它在头结点的 PHI
+         */
+        Instruction* reduce(Function& function, const Loop* loop, const InductionVariable& variable, Value* factor) {
+            BasicBlock* preheader = loop->getPreheader();
+            BasicBlock* latch = loop->getLatches().front();
+            IRBuilder builder(function);
+            builder.setInsertPoint(preheader->getTerminator());
+            Value* initial = multiply(function, builder, variable.start, factor);
+            Value* delta = multiply(function, builder, variable.step, factor);
+
+            Instruction* phi = builder.createPhi(Type::INT, loop->getHeader());
+            builder.setInsertPoint(variable.increment->getNext());
+            Instruction* next = builder.createBinary(variable.negated ? Opcode::SUB : Opcode::ADD, phi, delta);
+            phi->addOperand(initial, preheader);
+            phi->addOperand(next, latch);
+            return phi;
+        }
+    }
+
+    size_t StrengthReductionPass::run(Function& function, AnalysisManager& analyses) {
+        LoopInfo& loops = analyses.get<LoopInfo>(function);
+        const InductionVariables& induction = analyses.get<InductionVariables>(function);
+        size_t changes = 0;
+        for (Loop* loop : loops.getLoopsInnermostFirst()) {
+            const auto& variables = induction.getInductionVariables(loop);
+            std::vector<char> merged(variables.size(), 0);
+            for (size_t i = 0; i < variables.size(); ++i) {
+                for (size_t j = i + 1; j < variables.size(); ++j) {
+                    const InductionVariable& a = variables[i];
+                    const InductionVariable& b = variables[j];
+                    if (!merged[j] && a.start == b.start && a.step == b.step && a.negated == b.negated) {
+                        // b 的递增变成 a + step，和 a 的递增重复，留给 GVN
+                        b.phi->replaceAllUsesWith(a.phi);
+                        b.phi->eraseFromParent();
+                        merged[j] = 1;
+                        ++changes;
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < variables.size(); ++i) {
+                if (merged[i]) {
+                    continue;
+                }
+                const InductionVariable& variable = variables[i];
+                std::vector<std::pair<Instruction*, Value*>> products;
+                for (Use* use = variable.phi->getFirstUse(); use; use = use->getNext()) {
+                    Instruction* user = use->getUser();
+                    if (user->getOpcode() != Opcode::MUL || !loop->contains(user->getParent())) {
+                        continue;
+                    }
+                    Value* factor = user->getOperand(user->getOperand(0) == variable.phi ? 1 : 0);
+                    if (factor != variable.phi && isLoopInvariant(loop, factor) && !isTrivialFactor(factor)) {
+                        products.emplace_back(user, factor);
+                    }
+                }
+                // 合并归纳变量之后同一个乘积可能出现多次，只建一个新的归纳变量
+                std::unordered_map<Value*, Instruction*> reduced;
+                for (const auto& [product, factor] : products) {
+                    Instruction*& phi = reduced[factor];
+                    if (phi == nullptr) {
+                        phi = reduce(function, loop, variable, factor);
+                    }
+                    product->replaceAllUsesWith(phi);
+                    product->eraseFromParent();
+                    ++changes;
+                }
+            }
+        }
+        return changes;
+    }
+}
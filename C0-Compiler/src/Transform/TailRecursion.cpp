@@ -0,0 +1,175 @@
+//
+// Created by 陶子杨 on 25-12-18.
+//
+
+#include "Transform/TailRecursion.h"
+#include "IR/IRBuilder.h"
+#include "Infra/casting.h"
+
+#include <vector>
+
+namespace CC::IR {
+    namespace {
+        /**
+         * @brief 一处可以改成跳转的递归调用
+         */
+        struct TailSite {
+            Instruction* call;
+            Instruction* ret;
+            Instruction* accumulate;   ///< return x op f(...) 中的 op，没有时为 nullptr
+        };
+
+        /**
+         * @brief call 的结果只被紧跟着的 ret 返回（或者两者都是 void）
+         */
+        bool returnsDirectly(const Instruction* call, const Instruction* ret) {
+            if (ret == nullptr || ret->getOpcode() != Opcode::RET) {
+                return false;
+            }
+            if (ret->getOperandCount() == 0) {
+                return call->getType() == Type::VOID;
+            }
+            return ret->getOperand(0) == call && call->getFirstUse()->getNext() == nullptr;
+        }
+
+        bool isAccumulator(Opcode opcode) {
+            return opcode == Opcode::ADD || opcode == Opcode::MUL;
+        }
+
+        Constant* getIdentity(Function& function, Opcode opcode) {
+            return function.getInt(opcode == Opcode::ADD ? 0 : 1);
+        }
+
+        /**
+         * @brief 识别 call; ret 和 call; op; ret 两种形式
+         */
+        bool matchSite(Function& function, Instruction* ret, TailSite& site) {
+            Instruction* previous = ret->getPrev();
+            if (previous == nullptr) {
+                return false;
+            }
+            if (previous->getOpcode() == Opcode::CALL) {
+                site = {previous, ret, nullptr};
+                return previous->getCallee() == &function && returnsDirectly(previous, ret);
+            }
+            Instruction* call = previous->getPrev();
+            if (!isAccumulator(previous->getOpcode()) || call == nullptr || call->getOpcode() != Opcode::CALL ||
+                call->getCallee() != &function || ret->getOperandCount() == 0 || ret->getOperand(0) != previous) {
+                return false;
+            }
+            // 结果只在 op 中用一次，另一个操作数在调用之前就算好了
+            if (!call->hasUses() || call->getFirstUse()->getNext() != nullptr ||
+                previous->getFirstUse()->getNext() != nullptr ||
+                (previous->getOperand(0) != call && previous->getOperand(1) != call)) {
+                return false;
+            }
+            site = {call, ret, previous};
+            return true;
+        }
+    }
+
+    size_t TailRecursionPass::run(Function& function, AnalysisManager&) {
+        cfg_changed = false;
+        std::vector<TailSite> sites;
+        std::vector<Instruction*> returns;
+        Opcode accumulator = Opcode::ADD;
+        bool accumulates = false;
+        for (BasicBlock* block : function.getBlocks()) {
+            Instruction* ret = block->getTerminator();
+            if (ret->getOpcode() != Opcode::RET) {
+                continue;
+            }
+            TailSite site{};
+            // 同一个函数里只用一种累加运算，运算不同的递归调用保持原样
+            if (matchSite(function, ret, site) &&
+                (site.accumulate == nullptr || !accumulates || site.accumulate->getOpcode() == accumulator)) {
+                if (site.accumulate != nullptr) {
+                    accumulator = site.accumulate->getOpcode();
+                    accumulates = true;
+                }
+                sites.push_back(site);
+            } else {
+                returns.push_back(ret);
+            }
+        }
+
+        size_t changes = 0;
+        if (!sites.empty()) {
+            IRBuilder builder(function);
+            BasicBlock* entry = function.getEntryBlock();
+            BasicBlock* header = splitBlock(entry, entry->front());
+            builder.setInsertPoint(entry);
+            builder.createBr(header);
+
+            // 每次都原样传回自己的参数不需要 PHI
+            const auto& arguments = function.getArguments();
+            std::vector<Instruction*> phis(arguments.size(), nullptr);
+            for (uint32_t i = 0; i < arguments.size(); ++i) {
+                bool invariant = true;
+                for (const TailSite& site : sites) {
+                    invariant = invariant && site.call->getOperand(i) == arguments[i];
+                }
+                if (invariant) {
+                    continue;
+                }
+                phis[i] = builder.createPhi(arguments[i]->getType(), header);
+                arguments[i]->replaceAllUsesWith(phis[i]);
+                phis[i]->addOperand(arguments[i], entry);
+            }
+            Instruction* sum = nullptr;
+            if (accumulates) {
+                sum = builder.createPhi(function.getReturnType(), header);
+                sum->addOperand(getIdentity(function, accumulator), entry);
+            }
+
+            for (const TailSite& site : sites) {
+                BasicBlock* block = site.call->getParent();
+                Value* next_sum = sum;
+                if (site.accumulate != nullptr) {
+                    // x op f(...) 改成 sum op x，作为下一次迭代的累加器
+                    uint32_t index = site.accumulate->getOperand(0) == site.call ? 0 : 1;
+                    site.accumulate->setOperand(index, sum);
+                    next_sum = site.accumulate;
+                }
+                site.ret->eraseFromParent();
+                for (uint32_t i = 0; i < phis.size(); ++i) {
+                    if (phis[i] != nullptr) {
+                        phis[i]->addOperand(site.call->getOperand(i), block);
+                    }
+                }
+                site.call->eraseFromParent();
+                builder.setInsertPoint(block);
+                builder.createBr(header);
+                if (sum != nullptr) {
+                    sum->addOperand(next_sum, block);
+                }
+            }
+
+            // 其他返回点把累加器合进返回值
+            if (sum != nullptr) {
+                Constant* identity = getIdentity(function, accumulator);
+                for (Instruction* ret : returns) {
+                    if (ret->getOperand(0) == identity) {
+                        ret->setOperand(0, sum);
+                        continue;
+                    }
+                    builder.setInsertPoint(ret);
+                    Instruction* result = builder.createBinary(accumulator, sum, ret->getOperand(0));
+                    ret->setOperand(0, result);
+                }
+            }
+            changes += sites.size();
+            cfg_changed = true;
+        }
+
+        for (Instruction* ret : returns) {
+            Instruction* call = ret->getPrev();
+            if (call != nullptr && call->getOpcode() == Opcode::CALL && !call->isTailCall() &&
+                returnsDirectly(call, ret)) {
+                call->setTailCall(true);
+                ++changes;
+            }
+        }
+        return changes;
+    }
+}
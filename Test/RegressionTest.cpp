@@ -0,0 +1,388 @@
+//
+// Created by 陶子杨 on 25-12-22.
+//
+// .c0 回归输入的驱动：执行文件中 "运行：" 给出的编译命令，检查退出码和输出
+//
+// 运行：RegressionTest <C0_Compiler 的路径> <输入文件>，全部检查通过时返回 0
+//
+// 输入文件中以下列前缀开头的注释行是指令，其余注释（包括 "期望：" 的说明）都不看：
+//   // 运行：C0_Compiler 参数... 文件名   开始一次编译，C0_Compiler 和输入文件名换成实际路径，
+//                                        含有特殊字符的参数可以用双引号括起来
+//   // 退出码：N                         这次编译的退出码，默认为 0
+//   // 检查：文本                        输出中在上一处匹配之后出现这段文本
+//   // 检查无：文本                      上一处匹配和下一处匹配之间（没有下一处时直到末尾）不出现这段文本
+// 检查文本中的 {{名字}} 是占位符，匹配输出中的一个名字：% 或 @ 后接字母、数字、下划线或点，
+// 或者不以数字开头的这样一串字符，例如 %12、%n、bb3，但不匹配常量 0、1。
+// 同一次编译中占位符第一次匹配时记下名字，之后同名的占位符必须匹配同样的名字，
+// 检查因此可以描述 "内层循环的 PHI 是行下标" 这样的结构，而不依赖具体的编号。
+// 记下了新名字的检查在后面的检查失败时换到下一处出现重试；"检查无：" 中还没有记下的占位符匹配任意名字
+// 输出是标准输出后接标准错误；比较时每行首尾的空白去掉，行内连续的空白当作一个空格
+//
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+    constexpr std::string_view kRunPrefix = "// 运行：";
+    constexpr std::string_view kExitCodePrefix = "// 退出码：";
+    constexpr std::string_view kCheckPrefix = "// 检查：";
+    constexpr std::string_view kCheckNotPrefix = "// 检查无：";
+    constexpr std::string_view kPlaceholderOpen = "{{";
+    constexpr std::string_view kPlaceholderClose = "}}";
+
+    using Bindings = std::map<std::string, std::string, std::less<>>;
+
+    struct Check {
+        bool negative = false;
+        std::string text;
+    };
+
+    struct Run {
+        std::string command;
+        int exit_code = 0;
+        std::vector<Check> checks;
+    };
+
+    std::string trim(std::string_view text) {
+        size_t begin = text.find_first_not_of(" \t\r");
+        if (begin == std::string_view::npos) {
+            return "";
+        }
+        size_t end = text.find_last_not_of(" \t\r");
+        return std::string(text.substr(begin, end - begin + 1));
+    }
+
+    // 每行去掉首尾空白，行内连续的空白合成一个空格
+    std::string normalize(std::string_view text) {
+        std::string result;
+        std::istringstream lines{std::string(text)};
+        std::string line;
+        while (std::getline(lines, line)) {
+            bool space = false;
+            for (char c : trim(line)) {
+                if (c == ' ' || c == '\t') {
+                    space = true;
+                    continue;
+                }
+                if (space) {
+                    result += ' ';
+                    space = false;
+                }
+                result += c;
+            }
+            result += '\n';
+        }
+        return result;
+    }
+
+    std::string quote(std::string_view argument) {
+        std::string result = "'";
+        for (char c : argument) {
+            if (c == '\'') {
+                result += "'\\''";
+            } else {
+                result += c;
+            }
+        }
+        return result + "'";
+    }
+
+    /**
+     * @brief 按空白拆开 "运行：" 之后的命令，把编译器和输入文件名换成实际路径后拼成 shell 命令
+     */
+    std::string buildCommand(std::string_view line, const std::string& compiler, const std::filesystem::path& input) {
+        std::vector<std::string> arguments;
+        std::string current;
+        bool quoted = false;
+        bool pending = false;
+        for (char c : line) {
+            if (c == '"') {
+                quoted = !quoted;
+                pending = true;
+            } else if ((c == ' ' || c == '\t') && !quoted) {
+                if (pending) {
+                    arguments.push_back(std::move(current));
+                    current.clear();
+                    pending = false;
+                }
+            } else {
+                current += c;
+                pending = true;
+            }
+        }
+        if (pending) {
+            arguments.push_back(std::move(current));
+        }
+
+        std::string command;
+        for (const auto& argument : arguments) {
+            if (!command.empty()) {
+                command += ' ';
+            }
+            if (argument == "C0_Compiler") {
+                command += quote(compiler);
+            } else if (argument == input.filename().string()) {
+                command += quote(input.string());
+            } else {
+                command += quote(argument);
+            }
+        }
+        return command;
+    }
+
+    std::vector<Run> parseRuns(const std::filesystem::path& input, const std::string& compiler) {
+        std::ifstream file(input);
+        std::vector<Run> runs;
+        std::string line;
+        while (std::getline(file, line)) {
+            std::string_view text = line;
+            if (text.starts_with(kRunPrefix)) {
+                runs.push_back({buildCommand(text.substr(kRunPrefix.size()), compiler, input), 0, {}});
+                continue;
+            }
+            bool is_exit_code = text.starts_with(kExitCodePrefix);
+            bool is_check = text.starts_with(kCheckPrefix);
+            bool is_check_not = text.starts_with(kCheckNotPrefix);
+            if (!is_exit_code && !is_check && !is_check_not) {
+                continue;
+            }
+            if (runs.empty()) {
+                std::cerr << input.string() << ": 指令出现在第一个 \"运行：\" 之前: " << line << "\n";
+                std::exit(2);
+            }
+            if (is_exit_code) {
+                runs.back().exit_code = std::atoi(line.c_str() + kExitCodePrefix.size());
+                continue;
+            }
+            // normalize 在行末加了换行，检查文本去掉它，匹配可以落在一行的中间
+            std::string pattern = normalize(text.substr(is_check ? kCheckPrefix.size() : kCheckNotPrefix.size()));
+            if (!pattern.empty()) {
+                pattern.pop_back();
+            }
+            runs.back().checks.push_back({is_check_not, std::move(pattern)});
+        }
+        return runs;
+    }
+
+    std::string readFile(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        std::ostringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+
+    // output 中从 at 开始的名字的长度，不是名字时为 0。常量不是名字
+    size_t nameLength(const std::string& output, size_t at) {
+        auto isNameChar = [&](size_t i) {
+            return i < output.size() &&
+                   (std::isalnum(static_cast<unsigned char>(output[i])) || output[i] == '_' || output[i] == '.');
+        };
+        size_t end = at;
+        if (end < output.size() && (output[end] == '%' || output[end] == '@')) {
+            ++end;
+        } else if (!isNameChar(end) || std::isdigit(static_cast<unsigned char>(output[end]))) {
+            return 0;
+        }
+        size_t first = end;
+        while (isNameChar(end)) {
+            ++end;
+        }
+        return end == first ? 0 : end - at;
+    }
+
+    /**
+     * @brief pattern 是否恰好从 output 的 at 处开始出现，返回匹配的末尾。
+     * 新记下的占位符写进 bindings；bind 为 false 时还没记下的占位符匹配任意名字且不记下
+     */
+    std::optional<size_t> matchAt(const std::string& output, size_t at, std::string_view pattern, Bindings& bindings,
+                                  bool bind) {
+        Bindings added;
+        while (!pattern.empty()) {
+            size_t open = pattern.find(kPlaceholderOpen);
+            size_t close = open == std::string_view::npos ? open : pattern.find(kPlaceholderClose, open);
+            std::string_view literal = pattern.substr(0, close == std::string_view::npos ? pattern.size() : open);
+            if (output.compare(at, literal.size(), literal) != 0) {
+                return std::nullopt;
+            }
+            at += literal.size();
+            if (close == std::string_view::npos) {
+                break;
+            }
+            std::string_view name = pattern.substr(open + kPlaceholderOpen.size(), close - open - kPlaceholderOpen.size());
+            pattern.remove_prefix(close + kPlaceholderClose.size());
+
+            const std::string* bound = nullptr;
+            if (auto it = bindings.find(name); it != bindings.end()) {
+                bound = &it->second;
+            } else if (auto added_it = added.find(name); added_it != added.end()) {
+                bound = &added_it->second;
+            }
+            if (bound != nullptr) {
+                if (output.compare(at, bound->size(), *bound) != 0 || nameLength(output, at) != bound->size()) {
+                    return std::nullopt;
+                }
+                at += bound->size();
+                continue;
+            }
+            size_t length = nameLength(output, at);
+            if (length == 0) {
+                return std::nullopt;
+            }
+            if (bind) {
+                added.emplace(name, output.substr(at, length));
+            }
+            at += length;
+        }
+        bindings.merge(added);
+        return at;
+    }
+
+    /**
+     * @brief pattern 在 position 之后第一次出现的起点和末尾
+     */
+    std::optional<std::pair<size_t, size_t>> find(const std::string& output, std::string_view pattern, size_t position,
+                                                  Bindings& bindings, bool bind) {
+        std::string_view prefix = pattern.substr(0, pattern.find(kPlaceholderOpen));
+        for (size_t at = output.find(prefix, position); at != std::string::npos; at = output.find(prefix, at + 1)) {
+            if (auto end = matchAt(output, at, pattern, bindings, bind)) {
+                return std::make_pair(at, *end);
+            }
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * @brief 按顺序匹配检查。记下新名字的检查在后面的检查失败时换到下一处出现重试，
+     * 例如第一个 phi 的操作数不对时再看后面的 phi
+     */
+    class Matcher {
+    public:
+        Matcher(const std::string& output, const std::vector<Check>& checks) : output(output), checks(checks) {}
+
+        /**
+         * @brief 全部通过时返回空，否则返回第一次尝试（每个检查都取最早的一处出现）中失败的检查的描述
+         */
+        std::string run() {
+            return matchFrom(0, 0, {}) ? "" : problem;
+        }
+
+    private:
+        bool matchFrom(size_t index, size_t position, const Bindings& bindings) {
+            size_t next = index;
+            while (next < checks.size() && checks[next].negative) {
+                ++next;
+            }
+            auto violates = [&](size_t end) -> const Check* {
+                Bindings unused = bindings;
+                for (size_t i = index; i < next; ++i) {
+                    auto found = find(output, checks[i].text, position, unused, false);
+                    if (found && found->second <= end) {
+                        return &checks[i];
+                    }
+                }
+                return nullptr;
+            };
+            if (next == checks.size()) {
+                if (const Check* negative = violates(output.size())) {
+                    fail("检查无：" + negative->text + "  出现了");
+                    return false;
+                }
+                return true;
+            }
+
+            const Check& check = checks[next];
+            for (size_t from = position;;) {
+                Bindings candidate = bindings;
+                auto found = find(output, check.text, from, candidate, true);
+                if (!found) {
+                    fail("检查：" + check.text + "  没有出现");
+                    return false;
+                }
+                if (const Check* negative = violates(found->first)) {
+                    fail("检查无：" + negative->text + "  出现在 \"" + check.text + "\" 之前");
+                    return false;
+                }
+                if (matchFrom(next + 1, found->second, candidate)) {
+                    return true;
+                }
+                // 没有记下新名字时换一处出现只会给后面的检查留下更少的输出
+                if (candidate.size() == bindings.size()) {
+                    return false;
+                }
+                from = found->first + 1;
+            }
+        }
+
+        void fail(std::string description) {
+            if (problem.empty()) {
+                problem = std::move(description);
+            }
+        }
+
+        const std::string& output;
+        const std::vector<Check>& checks;
+        std::string problem;
+    };
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "用法: " << argv[0] << " <C0_Compiler 的路径> <输入文件>\n";
+        return 2;
+    }
+    std::string compiler = argv[1];
+    std::filesystem::path input = std::filesystem::weakly_canonical(argv[2]);
+    std::vector<Run> runs = parseRuns(input, compiler);
+    if (runs.empty()) {
+        std::cerr << input.string() << ": 没有 \"运行：\" 指令\n";
+        return 2;
+    }
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string stem = "c0-regression-" + std::to_string(getpid());
+    std::filesystem::path stdout_path = directory / (stem + ".out");
+    std::filesystem::path stderr_path = directory / (stem + ".err");
+
+    int failures = 0;
+    for (const Run& run : runs) {
+        std::string command = run.command + " > " + quote(stdout_path.string()) + " 2> " + quote(stderr_path.string());
+        int status = std::system(command.c_str());
+        int exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        std::string output = readFile(stdout_path) + readFile(stderr_path);
+
+        std::string problem;
+        if (exit_code != run.exit_code) {
+            problem = "退出码是 " + std::to_string(exit_code) + "，应为 " + std::to_string(run.exit_code);
+        } else {
+            std::string normalized = normalize(output);
+            problem = Matcher(normalized, run.checks).run();
+        }
+        if (!problem.empty()) {
+            ++failures;
+            std::cerr << "失败: " << run.command << "\n  " << problem << "\n--- 输出 ---\n" << output << "------------\n";
+        }
+    }
+    std::filesystem::remove(stdout_path);
+    std::filesystem::remove(stderr_path);
+
+    if (failures != 0) {
+        std::cerr << failures << " / " << runs.size() << " 次编译的检查没有通过\n";
+        return 1;
+    }
+    std::cout << runs.size() << " 次编译的检查全部通过\n";
+    return 0;
+}
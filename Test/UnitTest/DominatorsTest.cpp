@@ -0,0 +1,172 @@
+//
+// Created by 陶子杨 on 25-12-20.
+//
+// 支配树增量更新的单元测试：在随机 CFG 上反复加边、删边、拆边，每一步之后
+// 用 verify() 和从头计算的结果比较，支配树和后支配树都检查
+//
+// 运行：DominatorsTest [轮数]，全部一致时返回 0，否则输出出错的种子和操作
+//
+
+#include "IR/CFG.h"
+#include "IR/Dominators.h"
+#include "IR/IRBuilder.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace CC::IR;
+
+namespace {
+    class RandomCFG {
+    public:
+        explicit RandomCFG(uint32_t seed) : random(seed), function("f", Type::INT, {Type::BOOL}, {"c"}), builder(function) {
+            uint32_t count = 2 + random() % 24;
+            for (uint32_t i = 0; i < count; ++i) {
+                function.createBlock();
+            }
+            for (BasicBlock* block : function.getBlocks()) {
+                builder.setInsertPoint(block);
+                switch (random() % 4) {
+                    case 0: builder.createRet(function.getInt(0)); break;
+                    case 1: builder.createBr(pick()); break;
+                    default: builder.createCondBr(condition(), pick(), pick()); break;
+                }
+            }
+        }
+
+        Function& getFunction() {
+            return function;
+        }
+
+        /**
+         * @brief 随机改动一条边并通知两棵树，返回操作的描述
+         */
+        std::string mutate(DominatorTree& dominators, DominatorTree& post_dominators) {
+            BasicBlock* block = pick();
+            Instruction* terminator = block->getTerminator();
+            switch (terminator->getOpcode()) {
+                case Opcode::RET: {
+                    // ret 改成 br：加一条边，同时不再是出口
+                    BasicBlock* target = pick();
+                    replace(block)->createBr(target);
+                    update(dominators, post_dominators, [&](DominatorTree& tree) { tree.insertEdge(block, target); });
+                    return "insert " + name(block) + " -> " + name(target);
+                }
+                case Opcode::BR: {
+                    BasicBlock* target = terminator->getSuccessor(0);
+                    if (random() % 3 == 0) {
+                        // br 改成 ret：删一条边，变成出口
+                        replace(block)->createRet(function.getInt(0));
+                        update(dominators, post_dominators, [&](DominatorTree& tree) { tree.deleteEdge(block, target); });
+                        return "delete " + name(block) + " -> " + name(target);
+                    }
+                    if (random() % 2 == 0) {
+                        BasicBlock* middle = splitEdge(block, target);
+                        update(dominators, post_dominators, [&](DominatorTree& tree) { tree.splitEdge(block, middle, target); });
+                        return "split " + name(block) + " -> " + name(middle) + " -> " + name(target);
+                    }
+                    BasicBlock* added = pick();
+                    replace(block)->createCondBr(condition(), target, added);
+                    update(dominators, post_dominators, [&](DominatorTree& tree) { tree.insertEdge(block, added); });
+                    return "insert " + name(block) + " -> " + name(added);
+                }
+                default: {
+                    BasicBlock* kept = terminator->getSuccessor(0);
+                    BasicBlock* removed = terminator->getSuccessor(1);
+                    replace(block)->createBr(kept);
+                    update(dominators, post_dominators, [&](DominatorTree& tree) { tree.deleteEdge(block, removed); });
+                    return "delete " + name(block) + " -> " + name(removed) + "（保留到 " + name(kept) + " 的边）";
+                }
+            }
+        }
+
+        /**
+         * @brief 把一个块的部分前驱改接到新块上，按 loop-simplify 的方式逐条通知两棵树
+         */
+        std::string splitSome(DominatorTree& dominators, DominatorTree& post_dominators) {
+            BasicBlock* block = pick();
+            std::vector<BasicBlock*> predecessors;
+            for (BasicBlock* predecessor : block->getPredecessors()) {
+                if (random() % 2 == 0 && std::find(predecessors.begin(), predecessors.end(), predecessor) == predecessors.end()) {
+                    predecessors.push_back(predecessor);
+                }
+            }
+            if (predecessors.empty()) {
+                return "skip";
+            }
+            BasicBlock* middle = splitPredecessors(block, predecessors);
+            update(dominators, post_dominators,
+                   [&](DominatorTree& tree) { tree.splitPredecessors(block, middle, predecessors); });
+            return "split " + std::to_string(predecessors.size()) + " predecessors of " + name(block) + " into " + name(middle);
+        }
+
+    private:
+        template <typename Update>
+        static void update(DominatorTree& dominators, DominatorTree& post_dominators, Update&& apply) {
+            apply(dominators);
+            apply(post_dominators);
+        }
+
+        IRBuilder* replace(BasicBlock* block) {
+            // 随机 CFG 中没有 PHI，直接换掉终结指令
+            block->getTerminator()->eraseFromParent();
+            builder.setInsertPoint(block);
+            return &builder;
+        }
+
+        BasicBlock* pick() {
+            const auto& blocks = function.getBlocks();
+            return blocks[random() % blocks.size()];
+        }
+
+        Value* condition() {
+            return function.getArguments().front();
+        }
+
+        static std::string name(const BasicBlock* block) {
+            return "bb" + std::to_string(block->getNumber());
+        }
+
+        std::mt19937 random;
+        Function function;
+        IRBuilder builder;
+    };
+
+    bool check(const DominatorTree& tree, uint32_t seed, const std::string& operation) {
+        if (tree.verify()) {
+            return true;
+        }
+        std::cerr << "种子 " << seed << (tree.isPostDominator() ? " 后支配树" : " 支配树") << " 在 " << operation
+                  << " 之后与从头计算的结果不一致\n";
+        return false;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t rounds = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 500;
+    uint32_t failures = 0;
+    for (uint32_t seed = 0; seed < rounds; ++seed) {
+        RandomCFG cfg(seed);
+        DominatorTree dominators(cfg.getFunction());
+        PostDominatorTree post_dominators(cfg.getFunction());
+        std::mt19937 random(seed);
+        for (uint32_t step = 0; step < 40; ++step) {
+            std::string operation = random() % 4 == 0 ? cfg.splitSome(dominators, post_dominators)
+                                                       : cfg.mutate(dominators, post_dominators);
+            if (!check(dominators, seed, operation) || !check(post_dominators, seed, operation)) {
+                ++failures;
+                break;
+            }
+        }
+    }
+    if (failures != 0) {
+        std::cerr << failures << " / " << rounds << " 个随机 CFG 的增量更新出错\n";
+        return 1;
+    }
+    std::cout << rounds << " 个随机 CFG 的增量更新全部与从头计算一致\n";
+    return 0;
+}